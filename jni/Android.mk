@@ -16,14 +16,32 @@
 LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
+# Benchmark sources shared by the JNI library and the standalone executable.
+NN_BENCHMARK_SRC_FILES := run_tflite.cpp latency_stats.cpp convergence.cpp output_error.cpp async_validation.cpp output_arena.cpp cpu_affinity.cpp op_profiler.cpp mapped_dataset.cpp input_prefetcher.cpp sysfs_sensors.cpp tensor_dump_writer.cpp native_evaluators.cpp arrival_process.cpp memory_footprint.cpp
+
 LOCAL_MODULE := libnnbenchmark_jni
-LOCAL_SRC_FILES := benchmark_jni.cpp run_tflite.cpp
+LOCAL_SRC_FILES := benchmark_jni.cpp image_preprocessor.cpp scenario_runner.cpp $(NN_BENCHMARK_SRC_FILES)
 LOCAL_C_INCLUDES := external/flatbuffers/include external/tensorflow
-LOCAL_SHARED_LIBRARIES := libandroid liblog
+LOCAL_SHARED_LIBRARIES := libandroid libjnigraphics liblog libz
 LOCAL_STATIC_LIBRARIES := libtflite_static
 LOCAL_CFLAGS := -Wno-sign-compare -Wno-unused-parameter
 LOCAL_SDK_VERSION := 27
 LOCAL_NDK_STL_VARIANT := c++_static
 
 include $(BUILD_SHARED_LIBRARY)
+
+# Standalone benchmark, runs without the app, see benchmark_main.cpp.
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := nnbenchmark
+LOCAL_MODULE_TAGS := tests
+LOCAL_SRC_FILES := benchmark_main.cpp csv_result.cpp $(NN_BENCHMARK_SRC_FILES)
+LOCAL_C_INCLUDES := external/flatbuffers/include external/tensorflow
+LOCAL_SHARED_LIBRARIES := libandroid liblog libz
+LOCAL_STATIC_LIBRARIES := libtflite_static
+LOCAL_CFLAGS := -Wno-sign-compare -Wno-unused-parameter
+LOCAL_SDK_VERSION := 27
+LOCAL_NDK_STL_VARIANT := c++_static
+
+include $(BUILD_EXECUTABLE)
 include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -0,0 +1,54 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arrival_process.h"
+
+#include "run_tflite.h"
+
+ArrivalProcess::ArrivalProcess(float ratePerSec, int distribution,
+                               long long startTimeNsec, long long endTimeNsec,
+                               uint32_t seed)
+    : mIntervalNsec(1e9 / ratePerSec),
+      mPoisson(distribution == ARRIVAL_POISSON),
+      mEndTimeNsec(endTimeNsec),
+      mNextArrivalNsec(static_cast<double>(startTimeNsec)),
+      mRandom(seed),
+      mExponential(1.0 / mIntervalNsec) {}
+
+bool ArrivalProcess::next(long long* arrivalTimeNsec) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return nextLocked(arrivalTimeNsec);
+}
+
+int ArrivalProcess::drain() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  int count = 0;
+  long long arrivalTimeNsec;
+  while (nextLocked(&arrivalTimeNsec)) {
+    ++count;
+  }
+  return count;
+}
+
+bool ArrivalProcess::nextLocked(long long* arrivalTimeNsec) {
+  if (mNextArrivalNsec >= mEndTimeNsec) {
+    return false;
+  }
+  *arrivalTimeNsec = static_cast<long long>(mNextArrivalNsec);
+  // Accumulated in double, so that rounding doesn't drift the rate.
+  mNextArrivalNsec += mPoisson ? mExponential(mRandom) : mIntervalNsec;
+  return true;
+}
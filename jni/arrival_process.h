@@ -0,0 +1,53 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_ARRIVAL_PROCESS_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_ARRIVAL_PROCESS_H
+
+#include <cstdint>
+#include <mutex>
+#include <random>
+
+// Request arrival times of an open-loop benchmark. The schedule only depends
+// on the rate and the start time, not on how fast requests are served, so
+// that latencies measured from the scheduled arrivals include the time
+// requests spend waiting behind a slow inference (no coordinated omission).
+class ArrivalProcess {
+ public:
+  // distribution is one of the ARRIVAL_* values of run_tflite.h. Arrivals
+  // start at startTimeNsec and stop before endTimeNsec.
+  ArrivalProcess(float ratePerSec, int distribution, long long startTimeNsec,
+                 long long endTimeNsec, uint32_t seed);
+
+  // Scheduled time of the next request, false once the schedule has ended.
+  // Thread safe, every request is handed out once.
+  bool next(long long* arrivalTimeNsec);
+  // Consumes the rest of the schedule, returns the number of requests in it.
+  int drain();
+
+ private:
+  bool nextLocked(long long* arrivalTimeNsec);
+
+  std::mutex mMutex;
+  const double mIntervalNsec;
+  const bool mPoisson;
+  const long long mEndTimeNsec;
+  double mNextArrivalNsec;
+  std::mt19937 mRandom;
+  std::exponential_distribution<double> mExponential;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_ARRIVAL_PROCESS_H
@@ -0,0 +1,103 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "async_validation.h"
+
+AsyncValidationPipeline::AsyncValidationPipeline(
+    const std::vector<size_t>& outputSizes, int depth, Processor processor,
+    ResultSink resultSink)
+    : mProcessor(std::move(processor)), mResultSink(std::move(resultSink)) {
+  for (int i = 0; i < depth; ++i) {
+    mJobs.emplace_back(new Job());
+    Job* job = mJobs.back().get();
+    job->outputs.resize(outputSizes.size());
+    for (int j = 0; j < outputSizes.size(); ++j) {
+      job->outputs[j].resize(outputSizes[j]);
+    }
+    mFreeJobs.push_back(job);
+  }
+  mWorker = std::thread(&AsyncValidationPipeline::workerLoop, this);
+}
+
+AsyncValidationPipeline::~AsyncValidationPipeline() { finish(); }
+
+AsyncValidationPipeline::Job* AsyncValidationPipeline::acquire() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mJobFreed.wait(lock, [this] { return mFailed || !mFreeJobs.empty(); });
+  if (mFailed) {
+    return nullptr;
+  }
+  Job* job = mFreeJobs.front();
+  mFreeJobs.pop_front();
+  return job;
+}
+
+void AsyncValidationPipeline::submit(Job* job) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPendingJobs.push_back(job);
+  }
+  mJobSubmitted.notify_one();
+}
+
+bool AsyncValidationPipeline::finish() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mJobSubmitted.notify_one();
+  if (mWorker.joinable()) {
+    mWorker.join();
+  }
+  return !mFailed;
+}
+
+void AsyncValidationPipeline::workerLoop() {
+  while (true) {
+    Job* job;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mJobSubmitted.wait(lock,
+                         [this] { return mStopping || !mPendingJobs.empty(); });
+      if (mPendingJobs.empty()) {
+        return;
+      }
+      job = mPendingJobs.front();
+      mPendingJobs.pop_front();
+    }
+
+    // Jobs after a failure are only drained, not processed.
+    bool failed;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      failed = mFailed;
+    }
+    if (!failed) {
+      if (mProcessor(job)) {
+        mResultSink(job->result);
+      } else {
+        failed = true;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mFailed = mFailed || failed;
+      mFreeJobs.push_back(job);
+    }
+    mJobFreed.notify_one();
+  }
+}
@@ -0,0 +1,81 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_ASYNC_VALIDATION_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_ASYNC_VALIDATION_H
+
+#include "run_tflite.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Moves output validation (golden output errors, saving inference outputs)
+// off the inference thread. The inference thread copies the output tensors
+// into one of a fixed pool of snapshot buffers, a single worker thread then
+// processes the snapshots and passes the completed results to the result sink
+// in submission order.
+class AsyncValidationPipeline {
+ public:
+  struct Job {
+    // Golden outputs, owned by the caller and valid until finish().
+    const InferenceInOut* data;
+    InferenceResult result;
+    // Output tensor contents at the end of the inference.
+    std::vector<std::vector<uint8_t>> outputs;
+  };
+  // Fills in job->result from job->outputs, returns false on failure.
+  using Processor = std::function<bool(Job* job)>;
+  using ResultSink = std::function<void(const InferenceResult&)>;
+
+  // Snapshot buffers are allocated once, from the output tensor sizes.
+  AsyncValidationPipeline(const std::vector<size_t>& outputSizes, int depth,
+                          Processor processor, ResultSink resultSink);
+  ~AsyncValidationPipeline();
+
+  // Returns a free job, blocks while all snapshot buffers are in flight.
+  // Returns nullptr once processing of an earlier job failed.
+  Job* acquire();
+  void submit(Job* job);
+  // Waits for all submitted jobs and stops the worker. Returns false if any
+  // job failed.
+  bool finish();
+  // Set as soon as a job failed, lets the inference thread stop early.
+  const std::atomic<bool>& failed() const { return mFailed; }
+
+ private:
+  void workerLoop();
+
+  Processor mProcessor;
+  ResultSink mResultSink;
+  std::vector<std::unique_ptr<Job>> mJobs;
+
+  std::mutex mMutex;
+  std::condition_variable mJobFreed;
+  std::condition_variable mJobSubmitted;
+  std::deque<Job*> mFreeJobs;
+  std::deque<Job*> mPendingJobs;
+  bool mStopping = false;
+  std::atomic<bool> mFailed{false};
+  std::thread mWorker;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_ASYNC_VALIDATION_H
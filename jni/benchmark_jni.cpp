@@ -14,15 +14,23 @@
  * limitations under the License.
  */
 
+#include "image_preprocessor.h"
+#include "mapped_dataset.h"
+#include "native_evaluators.h"
 #include "run_tflite.h"
+#include "scenario_runner.h"
+#include "sysfs_sensors.h"
+#include "tensor_dump_writer.h"
 
 #include <jni.h>
+#include <memory>
 #include <string>
 #include <iomanip>
 #include <sstream>
 #include <fcntl.h>
 
 #include <android/asset_manager_jni.h>
+#include <android/bitmap.h>
 #include <android/log.h>
 #include <android/sharedmem.h>
 #include <sys/mman.h>
@@ -37,19 +45,33 @@ Java_com_android_nn_benchmark_core_NNTestBase_initModel(
         jstring _modelFileName,
         jboolean _useNnApi,
         jboolean _enableIntermediateTensorsDump,
-        jstring _nnApiDeviceName) {
+        jstring _nnApiDeviceName,
+        jstring _nnApiCacheDir,
+        jint _executionPreference,
+        jboolean _allowFp16,
+        jint _maxDelegatedPartitions,
+        jboolean _disallowNnApiCpu) {
+    DelegateOptions delegateOptions;
+    if (_nnApiDeviceName != NULL) {
+        const char *nnApiDeviceName = env->GetStringUTFChars(_nnApiDeviceName, NULL);
+        delegateOptions.deviceName = nnApiDeviceName;
+        env->ReleaseStringUTFChars(_nnApiDeviceName, nnApiDeviceName);
+    }
+    if (_nnApiCacheDir != NULL) {
+        const char *nnApiCacheDir = env->GetStringUTFChars(_nnApiCacheDir, NULL);
+        delegateOptions.cacheDir = nnApiCacheDir;
+        env->ReleaseStringUTFChars(_nnApiCacheDir, nnApiCacheDir);
+    }
+    delegateOptions.executionPreference = _executionPreference;
+    delegateOptions.allowFp16 = _allowFp16;
+    delegateOptions.maxDelegatedPartitions = _maxDelegatedPartitions;
+    delegateOptions.disallowNnapiCpu = _disallowNnApiCpu;
+
     const char *modelFileName = env->GetStringUTFChars(_modelFileName, NULL);
-    const char *nnApiDeviceName =
-        _nnApiDeviceName == NULL
-            ? NULL
-            : env->GetStringUTFChars(_nnApiDeviceName, NULL);
     void *handle =
         BenchmarkModel::create(modelFileName, _useNnApi,
-                               _enableIntermediateTensorsDump, nnApiDeviceName);
+                               _enableIntermediateTensorsDump, delegateOptions);
     env->ReleaseStringUTFChars(_modelFileName, modelFileName);
-    if (_nnApiDeviceName != NULL) {
-        env->ReleaseStringUTFChars(_nnApiDeviceName, nnApiDeviceName);
-    }
 
     return (jlong)(uintptr_t)handle;
 }
@@ -65,6 +87,36 @@ Java_com_android_nn_benchmark_core_NNTestBase_destroyModel(
     delete(model);
 }
 
+extern "C"
+JNIEXPORT jboolean
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_loadMappedDataset(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jstring _datasetPath) {
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+    const char *datasetPath = env->GetStringUTFChars(_datasetPath, NULL);
+    std::unique_ptr<MappedDataset> dataset = MappedDataset::open(datasetPath);
+    env->ReleaseStringUTFChars(_datasetPath, datasetPath);
+    if (!dataset) {
+        return false;
+    }
+    model->setMappedDataset(std::move(dataset));
+    return true;
+}
+
+extern "C"
+JNIEXPORT jboolean
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_mappedDatasetHasGoldenOutputs(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle) {
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+    return model->mappedDataset() != nullptr && model->mappedDataset()->hasGoldenOutputs();
+}
+
 extern "C"
 JNIEXPORT jboolean
 JNICALL
@@ -72,40 +124,153 @@ Java_com_android_nn_benchmark_core_NNTestBase_resizeInputTensors(
         JNIEnv *env,
         jobject /* this */,
         jlong _modelHandle,
-        jintArray _inputShape) {
+        jobjectArray _inputShapes) {
     BenchmarkModel* model = (BenchmarkModel *) _modelHandle;
-    jint* shapePtr = env->GetIntArrayElements(_inputShape, nullptr);
-    jsize shapeLen = env->GetArrayLength(_inputShape);
+    jsize inputsCount = env->GetArrayLength(_inputShapes);
 
-    std::vector<int> shape(shapePtr, shapePtr + shapeLen);
-    return model->resizeInputTensors(std::move(shape));
+    std::vector<std::vector<int>> shapes;
+    shapes.reserve(inputsCount);
+    for (jsize i = 0; i < inputsCount; ++i) {
+        jintArray inputShape =
+                static_cast<jintArray>(env->GetObjectArrayElement(_inputShapes, i));
+        if (env->ExceptionCheck() || inputShape == nullptr) { return false; }
+        jint* shapePtr = env->GetIntArrayElements(inputShape, nullptr);
+        jsize shapeLen = env->GetArrayLength(inputShape);
+        shapes.emplace_back(shapePtr, shapePtr + shapeLen);
+        env->ReleaseIntArrayElements(inputShape, shapePtr, JNI_ABORT);
+        env->DeleteLocalRef(inputShape);
+    }
+    return model->resizeInputTensors(std::move(shapes));
 }
 
+extern "C"
+JNIEXPORT jboolean
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_setNumThreads(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jint numThreads) {
+    BenchmarkModel* model = (BenchmarkModel *) _modelHandle;
+    return model->setNumThreads(numThreads);
+}
+
+extern "C"
+JNIEXPORT jboolean
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_setCpuAffinity(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jint cores,
+        jlong explicitMask) {
+    BenchmarkModel* model = (BenchmarkModel *) _modelHandle;
+    return model->setCpuAffinity(cores, static_cast<uint64_t>(explicitMask));
+}
+
+extern "C"
+JNIEXPORT jboolean
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_setConvergence(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jfloat targetRelativeWidth,
+        jfloat confidence,
+        jfloat quantile,
+        jint minInferences,
+        jint maxInferences,
+        jfloat minTimeSec,
+        jfloat maxTimeSec) {
+    BenchmarkModel* model = (BenchmarkModel *) _modelHandle;
+    ConvergenceOptions options;
+    options.targetRelativeWidth = targetRelativeWidth;
+    options.confidence = confidence;
+    options.quantile = quantile;
+    options.minInferences = minInferences;
+    options.maxInferences = maxInferences;
+    options.minTimeSec = minTimeSec;
+    options.maxTimeSec = maxTimeSec;
+    return model->setConvergence(options);
+}
+
+namespace {
+
+// Detaches threads attached by getThreadEnv() when they exit.
+struct ThreadDetacher {
+    JavaVM* vm = nullptr;
+    ~ThreadDetacher() {
+        if (vm != nullptr) {
+            vm->DetachCurrentThread();
+        }
+    }
+};
+thread_local ThreadDetacher threadDetacher;
+
+// JNIEnv of the calling thread. Threads unknown to the VM (like the
+// FLAG_PREFETCH_INPUTS producer) are attached. attached is set on every call
+// from a thread attached here, not only on the call that attached it.
+JNIEnv* getThreadEnv(JavaVM* vm, bool* attached) {
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+        *attached = threadDetacher.vm != nullptr;
+        return env;
+    }
+    *attached = false;
+    if (vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+        return nullptr;
+    }
+    threadDetacher.vm = vm;
+    *attached = true;
+    return env;
+}
+
+}  // namespace
+
 /** RAII container for a list of InferenceInOutSequence to handle JNI data release in destructor. */
 class InferenceInOutSequenceList {
 public:
+    // If mappedDataset is set, its data is used and inOutDataList is ignored.
     InferenceInOutSequenceList(JNIEnv *env,
                                const jobject& inOutDataList,
-                               bool expectGoldenOutputs);
+                               bool expectGoldenOutputs,
+                               const MappedDataset* mappedDataset = nullptr);
     ~InferenceInOutSequenceList();
 
     bool isValid() const { return mValid; }
 
-    const std::vector<InferenceInOutSequence>& data() const { return mData; }
+    const std::vector<InferenceInOutSequence>& data() const {
+        return mMappedDataset != nullptr ? mMappedDataset->data() : mData;
+    }
 
 private:
     JNIEnv *mEnv;  // not owned.
+    const MappedDataset* mMappedDataset;  // not owned.
+    // Global reference to the Java list, input creators are looked up through
+    // it so that they can be called from any thread.
+    jobject mInOutDataList = nullptr;
 
     std::vector<InferenceInOutSequence> mData;
-    std::vector<jbyteArray> mInputArrays;
+    std::vector<jobjectArray> mInputArrays;
     std::vector<jobjectArray> mOutputArrays;
     bool mValid;
 };
 
 InferenceInOutSequenceList::InferenceInOutSequenceList(JNIEnv *env,
                                                        const jobject& inOutDataList,
-                                                       bool expectGoldenOutputs)
-    : mEnv(env), mValid(false) {
+                                                       bool expectGoldenOutputs,
+                                                       const MappedDataset* mappedDataset)
+    : mEnv(env), mMappedDataset(mappedDataset), mValid(false) {
+
+    if (mappedDataset != nullptr) {
+        if (expectGoldenOutputs && !mappedDataset->hasGoldenOutputs()) {
+            jclass iaeClass = mEnv->FindClass("java/lang/IllegalArgumentException");
+            mEnv->ThrowNew(iaeClass, "Expected golden output for every input");
+            return;
+        }
+        mValid = true;
+        return;
+    }
 
     jclass list_class = env->FindClass("java/util/List");
     if (list_class == nullptr) { return; }
@@ -126,13 +291,15 @@ InferenceInOutSequenceList::InferenceInOutSequenceList(JNIEnv *env,
 
     jclass inout_class = env->FindClass("com/android/nn/benchmark/core/InferenceInOut");
     if (inout_class == nullptr) { return; }
-    jfieldID inout_input = env->GetFieldID(inout_class, "mInput", "[B");
-    if (inout_input == nullptr) { return; }
+    jfieldID inout_inputs = env->GetFieldID(inout_class, "mInputs", "[[B");
+    if (inout_inputs == nullptr) { return; }
     jfieldID inout_expectedOutputs = env->GetFieldID(inout_class, "mExpectedOutputs", "[[B");
     if (inout_expectedOutputs == nullptr) { return; }
-    jfieldID inout_inputCreator = env->GetFieldID(inout_class, "mInputCreator",
-            "Lcom/android/nn/benchmark/core/InferenceInOut$InputCreatorInterface;");
-    if (inout_inputCreator == nullptr) { return; }
+    jfieldID inout_inputCreators = env->GetFieldID(inout_class, "mInputCreators",
+            "[Lcom/android/nn/benchmark/core/InferenceInOut$InputCreatorInterface;");
+    if (inout_inputCreators == nullptr) { return; }
+    jfieldID inout_expectedClass = env->GetFieldID(inout_class, "mExpectedClass", "I");
+    if (inout_expectedClass == nullptr) { return; }
 
 
 
@@ -145,6 +312,8 @@ InferenceInOutSequenceList::InferenceInOutSequenceList(JNIEnv *env,
     if (inputCreator_class == nullptr) { return; }
     jmethodID createInput_method = env->GetMethodID(inputCreator_class, "createInput", "(Ljava/nio/ByteBuffer;)V");
     if (createInput_method == nullptr) { return; }
+    JavaVM* vm = nullptr;
+    if (env->GetJavaVM(&vm) != JNI_OK) { return; }
 
     for (int seq_index = 0; seq_index < data_count; ++seq_index) {
         jobject inOutSeq = mEnv->CallObjectMethod(inOutDataList, list_get, seq_index);
@@ -160,34 +329,88 @@ InferenceInOutSequenceList::InferenceInOutSequenceList(JNIEnv *env,
             jobject inout = mEnv->CallObjectMethod(inOutSeq, inOutSeq_get, i);
             if (mEnv->ExceptionCheck()) { return; }
 
-            uint8_t* input_data = nullptr;
-            size_t input_len = 0;
-            std::function<bool(uint8_t*, size_t)> inputCreator;
-            jbyteArray input = static_cast<jbyteArray>(
-                    mEnv->GetObjectField(inout, inout_input));
-            mInputArrays.push_back(input);
-            if (input != nullptr) {
-                input_data = reinterpret_cast<uint8_t*>(
-                        mEnv->GetByteArrayElements(input, NULL));
-                input_len = mEnv->GetArrayLength(input);
-            } else {
-                inputCreator = [env, inout, inout_inputCreator, createInput_method](
-                        uint8_t* buffer, size_t length) {
-                    jobject byteBuffer = env->NewDirectByteBuffer(buffer, length);
-                    if (byteBuffer == nullptr) { return false; }
-                    jobject creator = env->GetObjectField(inout, inout_inputCreator);
-                    if (creator == nullptr) { return false; }
-                    env->CallVoidMethod(creator, createInput_method, byteBuffer);
-                    env->DeleteLocalRef(byteBuffer);
-                    if (env->ExceptionCheck()) { return false; }
-                    return true;
-                };
-            }
-
+            jobjectArray inputs = static_cast<jobjectArray>(
+                    mEnv->GetObjectField(inout, inout_inputs));
+            jobjectArray inputCreators = static_cast<jobjectArray>(
+                    mEnv->GetObjectField(inout, inout_inputCreators));
             jobjectArray expectedOutputs = static_cast<jobjectArray>(
                     mEnv->GetObjectField(inout, inout_expectedOutputs));
+            mInputArrays.push_back(inputs);
             mOutputArrays.push_back(expectedOutputs);
-            seq.push_back({input_data, input_len, {}, inputCreator});
+            seq.push_back({});
+            seq.back().expectedClass = mEnv->GetIntField(inout, inout_expectedClass);
+
+            // Add inputs to sequence added above. Every input is either given
+            // as a byte array or created on demand by its input creator.
+            if (inputs == nullptr && inputCreators == nullptr) {
+                jclass iaeClass = mEnv->FindClass("java/lang/IllegalArgumentException");
+                mEnv->ThrowNew(iaeClass, "Neither inputs nor input creators given");
+                return;
+            }
+            jsize inputsLength = inputs != nullptr ? mEnv->GetArrayLength(inputs)
+                                                   : mEnv->GetArrayLength(inputCreators);
+            auto& inferenceInputs = seq.back().inputs;
+            inferenceInputs.resize(inputsLength);
+            for (jsize j = 0; j < inputsLength; ++j) {
+                jbyteArray input = inputs != nullptr
+                        ? static_cast<jbyteArray>(mEnv->GetObjectArrayElement(inputs, j))
+                        : nullptr;
+                if (env->ExceptionCheck()) { return; }
+                if (input != nullptr) {
+                    inferenceInputs[j].ptr = reinterpret_cast<uint8_t*>(
+                            mEnv->GetByteArrayElements(input, NULL));
+                    inferenceInputs[j].size = mEnv->GetArrayLength(input);
+                    continue;
+                }
+                if (inputCreators == nullptr) {
+                    jclass iaeClass = mEnv->FindClass("java/lang/IllegalArgumentException");
+                    mEnv->ThrowNew(iaeClass, "Null input array without input creator");
+                    return;
+                }
+                if (mInOutDataList == nullptr) {
+                    mInOutDataList = mEnv->NewGlobalRef(inOutDataList);
+                    if (mInOutDataList == nullptr) { return; }
+                }
+                // Called once per inference, possibly on another thread, so
+                // all local references it creates are dropped with its frame.
+                jobject list = mInOutDataList;
+                inferenceInputs[j].createInput =
+                        [vm, list, list_get, inOutSeq_get, inout_inputCreators,
+                         createInput_method, seq_index, i, j](
+                        uint8_t* buffer, size_t length) {
+                    bool attached;
+                    JNIEnv* env = getThreadEnv(vm, &attached);
+                    if (env == nullptr) { return false; }
+                    if (env->PushLocalFrame(8) != JNI_OK) { return false; }
+                    bool success = false;
+                    jobject inOutSeq = env->CallObjectMethod(list, list_get, seq_index);
+                    jobject inout = inOutSeq != nullptr && !env->ExceptionCheck()
+                            ? env->CallObjectMethod(inOutSeq, inOutSeq_get, i)
+                            : nullptr;
+                    jobjectArray creators = inout != nullptr && !env->ExceptionCheck()
+                            ? static_cast<jobjectArray>(
+                                    env->GetObjectField(inout, inout_inputCreators))
+                            : nullptr;
+                    jobject creator = creators != nullptr
+                            ? env->GetObjectArrayElement(creators, j)
+                            : nullptr;
+                    jobject byteBuffer = creator != nullptr
+                            ? env->NewDirectByteBuffer(buffer, length)
+                            : nullptr;
+                    if (byteBuffer != nullptr) {
+                        env->CallVoidMethod(creator, createInput_method, byteBuffer);
+                        success = !env->ExceptionCheck();
+                    }
+                    // Nobody on an attached thread would see the exception, and
+                    // detaching with it pending would crash the app.
+                    if (attached && env->ExceptionCheck()) {
+                        env->ExceptionDescribe();
+                        env->ExceptionClear();
+                    }
+                    env->PopLocalFrame(nullptr);
+                    return success;
+                };
+            }
 
             // Add expected output to sequence added above
             if (expectedOutputs != nullptr) {
@@ -219,7 +442,11 @@ InferenceInOutSequenceList::InferenceInOutSequenceList(JNIEnv *env,
                     return;
                 }
             }
+            // Input creators look their objects up again when called.
+            mEnv->DeleteLocalRef(inputCreators);
+            mEnv->DeleteLocalRef(inout);
         }
+        mEnv->DeleteLocalRef(inOutSeq);
     }
     mValid = true;
 }
@@ -227,13 +454,22 @@ InferenceInOutSequenceList::InferenceInOutSequenceList(JNIEnv *env,
 InferenceInOutSequenceList::~InferenceInOutSequenceList() {
     // Note that we may land here with a pending JNI exception so cannot call
     // java objects.
+    if (mInOutDataList != nullptr) {
+        mEnv->DeleteGlobalRef(mInOutDataList);
+    }
     int arrayIndex = 0;
     for (int seq_index = 0; seq_index < mData.size(); ++seq_index) {
         for (int i = 0; i < mData[seq_index].size(); ++i) {
-            jbyteArray input = mInputArrays[arrayIndex];
-            if (input != nullptr) {
-                mEnv->ReleaseByteArrayElements(
-                        input, reinterpret_cast<jbyte*>(mData[seq_index][i].input), JNI_ABORT);
+            jobjectArray inputs = mInputArrays[arrayIndex];
+            if (inputs != nullptr) {
+                const auto& inferenceInputs = mData[seq_index][i].inputs;
+                for (jsize j = 0; j < inferenceInputs.size(); ++j) {
+                    if (inferenceInputs[j].ptr == nullptr) { continue; }
+                    jbyteArray input = static_cast<jbyteArray>(
+                            mEnv->GetObjectArrayElement(inputs, j));
+                    mEnv->ReleaseByteArrayElements(
+                            input, reinterpret_cast<jbyte*>(inferenceInputs[j].ptr), JNI_ABORT);
+                }
             }
             jobjectArray expectedOutputs = mOutputArrays[arrayIndex];
             if (expectedOutputs != nullptr) {
@@ -258,6 +494,37 @@ InferenceInOutSequenceList::~InferenceInOutSequenceList() {
     }
 }
 
+extern "C"
+JNIEXPORT jfloatArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runWarmup(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jint warmupInferencesMaxCount,
+        jfloat warmupTimeoutSec) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    InferenceInOutSequenceList data(env, inOutDataList, /*expectGoldenOutputs=*/false,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    std::vector<float> warmupTimes;
+    if (!model->warmup(data.data(), warmupInferencesMaxCount, warmupTimeoutSec,
+                       &warmupTimes)) {
+        return nullptr;
+    }
+
+    jfloatArray warmupTimesArray = env->NewFloatArray(warmupTimes.size());
+    if (env->ExceptionCheck()) { return nullptr; }
+    env->SetFloatArrayRegion(warmupTimesArray, 0, warmupTimes.size(), warmupTimes.data());
+    return warmupTimesArray;
+}
+
 extern "C"
 JNIEXPORT jboolean
 JNICALL
@@ -280,13 +547,15 @@ Java_com_android_nn_benchmark_core_NNTestBase_runBenchmark(
 
     jclass result_class = env->FindClass("com/android/nn/benchmark/core/InferenceResult");
     if (result_class == nullptr) { return false; }
-    jmethodID result_ctor = env->GetMethodID(result_class, "<init>", "(F[F[F[[BII)V");
+    jmethodID result_ctor = env->GetMethodID(result_class, "<init>",
+                                             "(FFF[F[FLjava/nio/ByteBuffer;I[IIIF)V");
     if (result_ctor == nullptr) { return false; }
 
     std::vector<InferenceResult> result;
 
     const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
-    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs);
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
     if (!data.isValid()) {
         return false;
     }
@@ -296,8 +565,38 @@ Java_com_android_nn_benchmark_core_NNTestBase_runBenchmark(
 
     // Generate results
     if (success) {
+        // All saved outputs are passed in a single direct ByteBuffer, every result
+        // references its slice by offset.
+        jobject inferenceOutputs = nullptr;
+        jintArray outputSizesArray = nullptr;
+        if ((flags & FLAG_DISCARD_INFERENCE_OUTPUT) == 0) {
+            const OutputArena& savedOutputs = model->savedOutputs();
+            if (savedOutputs.size() > INT32_MAX) {
+                jclass iseClass = env->FindClass("java/lang/IllegalStateException");
+                env->ThrowNew(iseClass, "Saved inference outputs don't fit into a ByteBuffer");
+                return false;
+            }
+            jclass byteBuffer_class = env->FindClass("java/nio/ByteBuffer");
+            if (byteBuffer_class == nullptr) { return false; }
+            jmethodID byteBuffer_allocateDirect = env->GetStaticMethodID(
+                    byteBuffer_class, "allocateDirect", "(I)Ljava/nio/ByteBuffer;");
+            if (byteBuffer_allocateDirect == nullptr) { return false; }
+            inferenceOutputs = env->CallStaticObjectMethod(
+                    byteBuffer_class, byteBuffer_allocateDirect,
+                    static_cast<jint>(savedOutputs.size()));
+            if (env->ExceptionCheck() || inferenceOutputs == nullptr) { return false; }
+            void* inferenceOutputsPtr = env->GetDirectBufferAddress(inferenceOutputs);
+            if (inferenceOutputsPtr == nullptr) { return false; }
+            memcpy(inferenceOutputsPtr, savedOutputs.data(), savedOutputs.size());
+
+            std::vector<jint> outputSizes(savedOutputs.outputSizes().begin(),
+                                          savedOutputs.outputSizes().end());
+            outputSizesArray = env->NewIntArray(outputSizes.size());
+            if (env->ExceptionCheck()) { return false; }
+            env->SetIntArrayRegion(outputSizesArray, 0, outputSizes.size(), outputSizes.data());
+        }
+
         for (const InferenceResult &rentry : result) {
-            jobjectArray inferenceOutputs = nullptr;
             jfloatArray meanSquareErrorArray = nullptr;
             jfloatArray maxSingleErrorArray = nullptr;
 
@@ -322,56 +621,1015 @@ Java_com_android_nn_benchmark_core_NNTestBase_runBenchmark(
                 }
             }
 
-            if ((flags & FLAG_DISCARD_INFERENCE_OUTPUT) == 0) {
-                jclass byteArrayClass = env->FindClass("[B");
-
-                inferenceOutputs = env->NewObjectArray(
-                    rentry.inferenceOutputs.size(),
-                    byteArrayClass, nullptr);
-
-                for (int i = 0;i < rentry.inferenceOutputs.size();++i) {
-                    jbyteArray inferenceOutput = nullptr;
-                    inferenceOutput = env->NewByteArray(rentry.inferenceOutputs[i].size());
-                    if (env->ExceptionCheck()) { return false; }
-                    jbyte *bytes = env->GetByteArrayElements(inferenceOutput, nullptr);
-                    memcpy(bytes, &rentry.inferenceOutputs[i][0], rentry.inferenceOutputs[i].size());
-                    env->ReleaseByteArrayElements(inferenceOutput, bytes, 0);
-                    env->SetObjectArrayElement(inferenceOutputs, i, inferenceOutput);
-                }
-            }
-
+            const jint outputsOffset = rentry.inferenceOutputsSlot == OutputArena::kNoSlot
+                    ? -1
+                    : static_cast<jint>(rentry.inferenceOutputsSlot);
             jobject object = env->NewObject(
                 result_class, result_ctor, rentry.computeTimeSec,
-                meanSquareErrorArray, maxSingleErrorArray, inferenceOutputs,
-                rentry.inputOutputSequenceIndex, rentry.inputOutputIndex);
+                rentry.inputTimeSec, rentry.outputTimeSec, meanSquareErrorArray, maxSingleErrorArray,
+                outputsOffset >= 0 ? inferenceOutputs : nullptr, outputsOffset, outputSizesArray,
+                rentry.inputOutputSequenceIndex, rentry.inputOutputIndex, rentry.resetTimeSec);
             if (env->ExceptionCheck() || object == NULL) { return false; }
 
             env->CallBooleanMethod(resultList, list_add, object);
             if (env->ExceptionCheck()) { return false; }
+
+            // Results can be numerous, don't exhaust the local reference table.
+            env->DeleteLocalRef(object);
+            if (meanSquareErrorArray != nullptr) { env->DeleteLocalRef(meanSquareErrorArray); }
+            if (maxSingleErrorArray != nullptr) { env->DeleteLocalRef(maxSingleErrorArray); }
         }
     }
 
     return success;
 }
 
+/**
+ * Converts the non-empty buckets of histogram into Java arrays of bucket lower bounds and
+ * counts, returns false on failure.
+ */
+bool createHistogramArrays(JNIEnv *env, const LatencyHistogram& histogram,
+                           jfloatArray* bucketLowerBoundsArray, jintArray* bucketCountsArray) {
+    std::vector<float> bucketLowerBoundsSec;
+    std::vector<jint> bucketCounts;
+    for (int i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+        if (histogram.bucketCount(i) > 0) {
+            bucketLowerBoundsSec.push_back(LatencyHistogram::bucketLowerBound(i) / 1e9);
+            bucketCounts.push_back(histogram.bucketCount(i));
+        }
+    }
+    *bucketLowerBoundsArray = env->NewFloatArray(bucketLowerBoundsSec.size());
+    if (env->ExceptionCheck()) { return false; }
+    env->SetFloatArrayRegion(*bucketLowerBoundsArray, 0, bucketLowerBoundsSec.size(),
+                             bucketLowerBoundsSec.data());
+    *bucketCountsArray = env->NewIntArray(bucketCounts.size());
+    if (env->ExceptionCheck()) { return false; }
+    env->SetIntArrayRegion(*bucketCountsArray, 0, bucketCounts.size(), bucketCounts.data());
+    return true;
+}
+
+/** Converts InferenceSummary into its Java counterpart, returns null on failure. */
+jobject createInferenceSummaryObject(JNIEnv *env, const InferenceSummary& summary) {
+    jclass summary_class = env->FindClass("com/android/nn/benchmark/core/InferenceSummary");
+    if (summary_class == nullptr) { return nullptr; }
+    jmethodID summary_ctor = env->GetMethodID(summary_class, "<init>",
+                                              "(IFFFFFFFFFFFFFF[F[IFIFFIFFIF)V");
+    if (summary_ctor == nullptr) { return nullptr; }
+
+    // Only non-empty histogram buckets are passed to java.
+    jfloatArray bucketLowerBoundsArray;
+    jintArray bucketCountsArray;
+    if (!createHistogramArrays(env, summary.computeTime.histogram(), &bucketLowerBoundsArray,
+                               &bucketCountsArray)) {
+        return nullptr;
+    }
+
+    const LatencyStats& computeTime = summary.computeTime;
+    jobject object = env->NewObject(
+        summary_class, summary_ctor,
+        static_cast<jint>(computeTime.count()),
+        static_cast<jfloat>(computeTime.totalSec()),
+        static_cast<jfloat>(summary.totalInputTimeSec),
+        static_cast<jfloat>(summary.totalOutputTimeSec),
+        static_cast<jfloat>(computeTime.meanSec()),
+        static_cast<jfloat>(computeTime.stdDevSec()),
+        computeTime.minSec(),
+        computeTime.maxSec(),
+        computeTime.percentileSec(0.5),
+        computeTime.percentileSec(0.9),
+        computeTime.percentileSec(0.95),
+        computeTime.percentileSec(0.99),
+        computeTime.percentileSec(0.999),
+        static_cast<jfloat>(summary.sumOfMSEs),
+        summary.maxSingleError,
+        bucketLowerBoundsArray,
+        bucketCountsArray,
+        static_cast<jfloat>(summary.wallTimeSec),
+        static_cast<jint>(summary.firstStepTime.count()),
+        static_cast<jfloat>(summary.firstStepTime.meanSec()),
+        summary.firstStepTime.percentileSec(0.99),
+        static_cast<jint>(summary.laterStepTime.count()),
+        static_cast<jfloat>(summary.laterStepTime.meanSec()),
+        summary.laterStepTime.percentileSec(0.99),
+        static_cast<jint>(summary.resetTime.count()),
+        static_cast<jfloat>(summary.resetTime.meanSec()));
+    if (env->ExceptionCheck()) { return nullptr; }
+    return object;
+}
+
+/** Converts a list of InferenceSummary into a Java array, returns null on failure. */
+jobjectArray createInferenceSummaryArray(JNIEnv *env,
+                                         const std::vector<InferenceSummary>& summaries) {
+    jclass summary_class = env->FindClass("com/android/nn/benchmark/core/InferenceSummary");
+    if (summary_class == nullptr) { return nullptr; }
+    jobjectArray summariesArray = env->NewObjectArray(summaries.size(), summary_class, nullptr);
+    if (env->ExceptionCheck()) { return nullptr; }
+    for (int k = 0; k < summaries.size(); ++k) {
+        jobject summary = createInferenceSummaryObject(env, summaries[k]);
+        if (summary == nullptr) { return nullptr; }
+        env->SetObjectArrayElement(summariesArray, k, summary);
+        env->DeleteLocalRef(summary);
+    }
+    return summariesArray;
+}
+
 extern "C"
-JNIEXPORT void
+JNIEXPORT jobject
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runBenchmarkStreaming(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jint inferencesSeqMaxCount,
+        jfloat timeoutSec,
+        jint flags) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    InferenceSummary summary;
+    if (!model->benchmarkStreaming(data.data(), inferencesSeqMaxCount, timeoutSec, flags,
+                                   &summary)) {
+        return nullptr;
+    }
+    return createInferenceSummaryObject(env, summary);
+}
+
+/** Converts the result of a sustained benchmark into a SustainedProfile, null on failure. */
+jobject createSustainedProfileObject(JNIEnv *env, const InferenceSummary& summary,
+                                     const std::vector<std::string>& sensorNames,
+                                     const std::vector<SustainedWindow>& windows) {
+    jclass profile_class = env->FindClass("com/android/nn/benchmark/core/SustainedProfile");
+    if (profile_class == nullptr) { return nullptr; }
+    jmethodID profile_ctor = env->GetMethodID(
+            profile_class, "<init>",
+            "(Lcom/android/nn/benchmark/core/InferenceSummary;[Ljava/lang/String;"
+            "[Lcom/android/nn/benchmark/core/SustainedProfile$Window;)V");
+    if (profile_ctor == nullptr) { return nullptr; }
+    jclass window_class = env->FindClass("com/android/nn/benchmark/core/SustainedProfile$Window");
+    if (window_class == nullptr) { return nullptr; }
+    jmethodID window_ctor = env->GetMethodID(window_class, "<init>", "(FFIFFF[F)V");
+    if (window_ctor == nullptr) { return nullptr; }
+    jclass string_class = env->FindClass("java/lang/String");
+    if (string_class == nullptr) { return nullptr; }
+
+    jobject summaryObject = createInferenceSummaryObject(env, summary);
+    if (summaryObject == nullptr) { return nullptr; }
+
+    jobjectArray namesArray = env->NewObjectArray(sensorNames.size(), string_class, nullptr);
+    if (env->ExceptionCheck()) { return nullptr; }
+    for (int i = 0; i < sensorNames.size(); ++i) {
+        jstring name = env->NewStringUTF(sensorNames[i].c_str());
+        if (name == nullptr) { return nullptr; }
+        env->SetObjectArrayElement(namesArray, i, name);
+        env->DeleteLocalRef(name);
+    }
+
+    jobjectArray windowsArray = env->NewObjectArray(windows.size(), window_class, nullptr);
+    if (env->ExceptionCheck()) { return nullptr; }
+    for (int i = 0; i < windows.size(); ++i) {
+        const SustainedWindow& window = windows[i];
+        jfloatArray sensorValues = env->NewFloatArray(window.sensorValues.size());
+        if (env->ExceptionCheck()) { return nullptr; }
+        env->SetFloatArrayRegion(sensorValues, 0, window.sensorValues.size(),
+                                 window.sensorValues.data());
+        jobject windowObject = env->NewObject(
+                window_class, window_ctor,
+                window.startTimeSec,
+                window.durationSec,
+                static_cast<jint>(window.count),
+                window.meanTimeSec,
+                window.p99TimeSec,
+                window.maxTimeSec,
+                sensorValues);
+        if (env->ExceptionCheck()) { return nullptr; }
+        env->SetObjectArrayElement(windowsArray, i, windowObject);
+        env->DeleteLocalRef(windowObject);
+        env->DeleteLocalRef(sensorValues);
+    }
+
+    jobject object = env->NewObject(profile_class, profile_ctor, summaryObject, namesArray,
+                                    windowsArray);
+    if (env->ExceptionCheck()) { return nullptr; }
+    return object;
+}
+
+extern "C"
+JNIEXPORT jobject
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runBenchmarkSustained(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jfloat durationSec,
+        jfloat windowSec,
+        jboolean readSensors,
+        jint flags) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    SysfsSensors sensors;
+    if (readSensors) {
+        sensors = SysfsSensors::discover();
+    }
+    InferenceSummary summary;
+    std::vector<SustainedWindow> windows;
+    if (!model->benchmarkSustained(data.data(), durationSec, windowSec, flags,
+                                   readSensors ? &sensors : nullptr, &summary, &windows)) {
+        return nullptr;
+    }
+    return createSustainedProfileObject(env, summary, sensors.names(), windows);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runBenchmarkConcurrent(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jint threadsCount,
+        jint inferencesSeqMaxCount,
+        jfloat timeoutSec,
+        jint flags) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkConcurrent(data.data(), threadsCount, inferencesSeqMaxCount,
+                                    timeoutSec, flags, &summaries)) {
+        return nullptr;
+    }
+
+    return createInferenceSummaryArray(env, summaries);
+}
+
+/** Converts the results of an open-loop sweep into an OpenLoopSummary array, null on failure. */
+jobjectArray createOpenLoopSummaryArray(JNIEnv *env,
+                                        const std::vector<OpenLoopSummary>& summaries) {
+    jclass summary_class = env->FindClass("com/android/nn/benchmark/core/OpenLoopSummary");
+    if (summary_class == nullptr) { return nullptr; }
+    jmethodID summary_ctor = env->GetMethodID(
+            summary_class, "<init>",
+            "(FLcom/android/nn/benchmark/core/InferenceSummary;FFFFFFFFFFII)V");
+    if (summary_ctor == nullptr) { return nullptr; }
+
+    jobjectArray summariesArray = env->NewObjectArray(summaries.size(), summary_class, nullptr);
+    if (env->ExceptionCheck()) { return nullptr; }
+    for (int k = 0; k < summaries.size(); ++k) {
+        const OpenLoopSummary& summary = summaries[k];
+        jobject serviceObject = createInferenceSummaryObject(env, summary.service);
+        if (serviceObject == nullptr) { return nullptr; }
+        const LatencyStats& queueTime = summary.queueTime;
+        const LatencyStats& responseTime = summary.responseTime;
+        jobject object = env->NewObject(
+                summary_class, summary_ctor,
+                summary.arrivalRate,
+                serviceObject,
+                static_cast<jfloat>(queueTime.meanSec()),
+                queueTime.percentileSec(0.5),
+                queueTime.percentileSec(0.9),
+                queueTime.percentileSec(0.99),
+                static_cast<jfloat>(responseTime.meanSec()),
+                responseTime.percentileSec(0.5),
+                responseTime.percentileSec(0.9),
+                responseTime.percentileSec(0.99),
+                responseTime.maxSec(),
+                summary.throughput,
+                static_cast<jint>(responseTime.count()),
+                static_cast<jint>(summary.dropped));
+        if (env->ExceptionCheck()) { return nullptr; }
+        env->SetObjectArrayElement(summariesArray, k, object);
+        env->DeleteLocalRef(object);
+        env->DeleteLocalRef(serviceObject);
+    }
+    return summariesArray;
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runBenchmarkOpenLoop(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jfloatArray _arrivalRates,
+        jint distribution,
+        jint threadsCount,
+        jfloat durationSec,
+        jint flags) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    jfloat* arrivalRatesPtr = env->GetFloatArrayElements(_arrivalRates, nullptr);
+    std::vector<float> arrivalRates(arrivalRatesPtr,
+                                    arrivalRatesPtr + env->GetArrayLength(_arrivalRates));
+    env->ReleaseFloatArrayElements(_arrivalRates, arrivalRatesPtr, JNI_ABORT);
+
+    const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    std::vector<OpenLoopSummary> summaries;
+    if (!model->benchmarkOpenLoopSweep(data.data(), arrivalRates, distribution, threadsCount,
+                                       durationSec, flags, &summaries)) {
+        return nullptr;
+    }
+    return createOpenLoopSummaryArray(env, summaries);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runScenario(
+        JNIEnv *env,
+        jclass /* clazz */,
+        jlongArray _modelHandles,
+        jobjectArray inOutDataLists,
+        jintArray _flags,
+        jfloatArray _ratesPerSec,
+        jintArray _priorities,
+        jint schedule,
+        jfloat durationSec) {
+
+    // One model per array index.
+    const jsize modelsCount = env->GetArrayLength(_modelHandles);
+    if (env->GetArrayLength(inOutDataLists) != modelsCount ||
+        env->GetArrayLength(_flags) != modelsCount ||
+        env->GetArrayLength(_ratesPerSec) != modelsCount ||
+        env->GetArrayLength(_priorities) != modelsCount) {
+        return nullptr;
+    }
+    std::vector<jlong> modelHandles(modelsCount);
+    std::vector<jint> flags(modelsCount);
+    std::vector<jfloat> ratesPerSec(modelsCount);
+    std::vector<jint> priorities(modelsCount);
+    env->GetLongArrayRegion(_modelHandles, 0, modelsCount, modelHandles.data());
+    env->GetIntArrayRegion(_flags, 0, modelsCount, flags.data());
+    env->GetFloatArrayRegion(_ratesPerSec, 0, modelsCount, ratesPerSec.data());
+    env->GetIntArrayRegion(_priorities, 0, modelsCount, priorities.data());
+
+    std::vector<std::unique_ptr<InferenceInOutSequenceList>> data;
+    std::vector<ScenarioModel> models(modelsCount);
+    for (int k = 0; k < modelsCount; ++k) {
+        BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(modelHandles[k]);
+        jobject inOutDataList = env->GetObjectArrayElement(inOutDataLists, k);
+        const bool expectGoldenOutputs = (flags[k] & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+        data.emplace_back(new InferenceInOutSequenceList(env, inOutDataList,
+                                                         expectGoldenOutputs,
+                                                         model->mappedDataset()));
+        env->DeleteLocalRef(inOutDataList);
+        if (!data.back()->isValid()) {
+            return nullptr;
+        }
+        models[k].model = model;
+        models[k].inOutData = &data.back()->data();
+        models[k].flags = flags[k];
+        models[k].ratePerSec = ratesPerSec[k];
+        models[k].priority = priorities[k];
+    }
+
+    std::vector<ScenarioModelResult> results;
+    if (!runScenario(models, schedule, durationSec, &results)) {
+        return nullptr;
+    }
+    // Alone and shared summaries of every model, in model order.
+    std::vector<InferenceSummary> summaries;
+    for (const auto& result : results) {
+        summaries.push_back(result.alone);
+        summaries.push_back(result.shared);
+    }
+    return createInferenceSummaryArray(env, summaries);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runBenchmarkThreadSweep(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jint maxThreads,
+        jint inferencesSeqMaxCount,
+        jfloat timeoutSec,
+        jint flags) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkThreadSweep(data.data(), maxThreads, inferencesSeqMaxCount,
+                                     timeoutSec, flags, &summaries)) {
+        return nullptr;
+    }
+    return createInferenceSummaryArray(env, summaries);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runBenchmarkBatchSweep(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jintArray _batchSizes,
+        jint batchesMaxCount,
+        jfloat timeoutSec,
+        jint flags) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    jint* batchSizesPtr = env->GetIntArrayElements(_batchSizes, nullptr);
+    std::vector<int> batchSizes(batchSizesPtr, batchSizesPtr + env->GetArrayLength(_batchSizes));
+    env->ReleaseIntArrayElements(_batchSizes, batchSizesPtr, JNI_ABORT);
+
+    const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkBatchSweep(data.data(), batchSizes, batchesMaxCount, timeoutSec,
+                                    flags, &summaries)) {
+        return nullptr;
+    }
+    return createInferenceSummaryArray(env, summaries);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runBenchmarkExecutionModes(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jintArray _modes,
+        jint inferencesSeqMaxCount,
+        jfloat timeoutSec,
+        jint flags) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    jint* modesPtr = env->GetIntArrayElements(_modes, nullptr);
+    std::vector<int> modes(modesPtr, modesPtr + env->GetArrayLength(_modes));
+    env->ReleaseIntArrayElements(_modes, modesPtr, JNI_ABORT);
+
+    const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkExecutionModes(data.data(), modes, inferencesSeqMaxCount, timeoutSec,
+                                        flags, &summaries)) {
+        return nullptr;
+    }
+    return createInferenceSummaryArray(env, summaries);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runBenchmarkDelegateOptionsSweep(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jintArray _executionPreferences,
+        jbooleanArray _allowFp16,
+        jintArray _maxDelegatedPartitions,
+        jbooleanArray _disallowNnApiCpu,
+        jint inferencesSeqMaxCount,
+        jfloat timeoutSec,
+        jint flags) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    // One options entry per array index.
+    const jsize optionsCount = env->GetArrayLength(_executionPreferences);
+    if (env->GetArrayLength(_allowFp16) != optionsCount ||
+        env->GetArrayLength(_maxDelegatedPartitions) != optionsCount ||
+        env->GetArrayLength(_disallowNnApiCpu) != optionsCount) {
+        return nullptr;
+    }
+    std::vector<jint> executionPreferences(optionsCount);
+    std::vector<jboolean> allowFp16(optionsCount);
+    std::vector<jint> maxDelegatedPartitions(optionsCount);
+    std::vector<jboolean> disallowNnApiCpu(optionsCount);
+    env->GetIntArrayRegion(_executionPreferences, 0, optionsCount, executionPreferences.data());
+    env->GetBooleanArrayRegion(_allowFp16, 0, optionsCount, allowFp16.data());
+    env->GetIntArrayRegion(_maxDelegatedPartitions, 0, optionsCount,
+                           maxDelegatedPartitions.data());
+    env->GetBooleanArrayRegion(_disallowNnApiCpu, 0, optionsCount, disallowNnApiCpu.data());
+    std::vector<DelegateOptions> options(optionsCount);
+    for (int k = 0; k < optionsCount; ++k) {
+        options[k].executionPreference = executionPreferences[k];
+        options[k].allowFp16 = allowFp16[k];
+        options[k].maxDelegatedPartitions = maxDelegatedPartitions[k];
+        options[k].disallowNnapiCpu = disallowNnApiCpu[k];
+    }
+
+    const bool expectGoldenOutputs = (flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0;
+    InferenceInOutSequenceList data(env, inOutDataList, expectGoldenOutputs,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkDelegateOptionsSweep(data.data(), options, inferencesSeqMaxCount,
+                                              timeoutSec, flags, &summaries)) {
+        return nullptr;
+    }
+    return createInferenceSummaryArray(env, summaries);
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_getOperatorProfiles(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle) {
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    jclass profile_class = env->FindClass("com/android/nn/benchmark/core/OperatorProfile");
+    if (profile_class == nullptr) { return nullptr; }
+    jmethodID profile_ctor = env->GetMethodID(profile_class, "<init>",
+                                              "(Ljava/lang/String;IZIFFF)V");
+    if (profile_ctor == nullptr) { return nullptr; }
+
+    const std::vector<OpProfile> profiles = model->operatorProfiles();
+    jobjectArray profilesArray = env->NewObjectArray(profiles.size(), profile_class, nullptr);
+    if (env->ExceptionCheck()) { return nullptr; }
+    for (int i = 0; i < profiles.size(); ++i) {
+        const OpProfile& profile = profiles[i];
+        jstring opName = env->NewStringUTF(profile.opName.c_str());
+        if (env->ExceptionCheck()) { return nullptr; }
+        jobject object = env->NewObject(
+            profile_class, profile_ctor,
+            opName,
+            static_cast<jint>(profile.nodeIndex),
+            static_cast<jboolean>(profile.delegated),
+            static_cast<jint>(profile.count),
+            static_cast<jfloat>(profile.totalTimeSec),
+            profile.minTimeSec,
+            profile.maxTimeSec);
+        if (env->ExceptionCheck()) { return nullptr; }
+        env->SetObjectArrayElement(profilesArray, i, object);
+        env->DeleteLocalRef(object);
+        env->DeleteLocalRef(opName);
+    }
+    return profilesArray;
+}
+
+jobject createStartupProfileObject(JNIEnv *env, const StartupProfile& profile) {
+    jclass profile_class = env->FindClass("com/android/nn/benchmark/core/StartupProfile");
+    if (profile_class == nullptr) { return nullptr; }
+    jmethodID profile_ctor = env->GetMethodID(profile_class, "<init>", "(FFFFFF)V");
+    if (profile_ctor == nullptr) { return nullptr; }
+    jobject object = env->NewObject(
+        profile_class, profile_ctor,
+        profile.modelLoadTimeSec,
+        profile.interpreterBuildTimeSec,
+        profile.delegateApplyTimeSec,
+        profile.inputResizeTimeSec,
+        profile.firstInferenceTimeSec,
+        profile.destroyTimeSec);
+    if (env->ExceptionCheck()) { return nullptr; }
+    return object;
+}
+
+extern "C"
+JNIEXPORT jobject
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_getStartupProfile(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle) {
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+    return createStartupProfileObject(env, model->startupProfile());
+}
+
+/** Converts a MemorySnapshot into its Java counterpart, returns null on failure. */
+jobject createMemorySnapshotObject(JNIEnv *env, const MemorySnapshot& snapshot) {
+    jclass snapshot_class = env->FindClass(
+            "com/android/nn/benchmark/core/MemoryProfile$Snapshot");
+    if (snapshot_class == nullptr) { return nullptr; }
+    jmethodID snapshot_ctor = env->GetMethodID(snapshot_class, "<init>", "(JJJ)V");
+    if (snapshot_ctor == nullptr) { return nullptr; }
+    jobject object = env->NewObject(
+        snapshot_class, snapshot_ctor,
+        static_cast<jlong>(snapshot.rssKb),
+        static_cast<jlong>(snapshot.pssKb),
+        static_cast<jlong>(snapshot.heapBytes));
+    if (env->ExceptionCheck()) { return nullptr; }
+    return object;
+}
+
+extern "C"
+JNIEXPORT jobject
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_getMemoryProfile(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle) {
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+    const MemoryProfile& profile = model->memoryProfile();
+
+    jclass profile_class = env->FindClass("com/android/nn/benchmark/core/MemoryProfile");
+    if (profile_class == nullptr) { return nullptr; }
+    jmethodID profile_ctor = env->GetMethodID(
+            profile_class, "<init>",
+            "(JLcom/android/nn/benchmark/core/MemoryProfile$Snapshot;"
+            "Lcom/android/nn/benchmark/core/MemoryProfile$Snapshot;"
+            "Lcom/android/nn/benchmark/core/MemoryProfile$Snapshot;"
+            "Lcom/android/nn/benchmark/core/MemoryProfile$Snapshot;JJ)V");
+    if (profile_ctor == nullptr) { return nullptr; }
+
+    jobject snapshots[4];
+    const MemorySnapshot* profileSnapshots[4] = {
+            &profile.beforeCreate, &profile.afterCreate, &profile.afterFirstInference,
+            &profile.steadyState};
+    for (int i = 0; i < 4; ++i) {
+        snapshots[i] = createMemorySnapshotObject(env, *profileSnapshots[i]);
+        if (snapshots[i] == nullptr) { return nullptr; }
+    }
+    jobject object = env->NewObject(
+        profile_class, profile_ctor,
+        static_cast<jlong>(profile.arenaBytes),
+        snapshots[0],
+        snapshots[1],
+        snapshots[2],
+        snapshots[3],
+        static_cast<jlong>(profile.peakHeapBytes),
+        static_cast<jlong>(profile.peakRssKb));
+    if (env->ExceptionCheck()) { return nullptr; }
+    return object;
+}
+
+extern "C"
+JNIEXPORT jobject
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_getConvergenceStatus(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle) {
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+    const ConvergenceStatus& status = model->convergenceStatus();
+
+    jclass status_class = env->FindClass("com/android/nn/benchmark/core/ConvergenceStatus");
+    if (status_class == nullptr) { return nullptr; }
+    jmethodID status_ctor = env->GetMethodID(status_class, "<init>", "(ZIFFF)V");
+    if (status_ctor == nullptr) { return nullptr; }
+    jobject object = env->NewObject(
+        status_class, status_ctor,
+        static_cast<jboolean>(status.converged),
+        static_cast<jint>(status.inferences),
+        status.totalTimeSec,
+        status.estimateSec,
+        status.relativeWidth);
+    if (env->ExceptionCheck()) { return nullptr; }
+    return object;
+}
+
+extern "C"
+JNIEXPORT jobjectArray
+JNICALL
+Java_com_android_nn_benchmark_core_NNTestBase_runColdStartBenchmark(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong _modelHandle,
+        jobject inOutDataList,
+        jint iterations) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    InferenceInOutSequenceList data(env, inOutDataList, /*expectGoldenOutputs=*/false,
+                                    model->mappedDataset());
+    if (!data.isValid()) {
+        return nullptr;
+    }
+    if (data.data().empty() || data.data()[0].empty()) {
+        return nullptr;
+    }
+
+    std::vector<StartupProfile> profiles;
+    if (!model->benchmarkColdStart(data.data()[0][0], iterations, &profiles)) {
+        return nullptr;
+    }
+
+    jclass profile_class = env->FindClass("com/android/nn/benchmark/core/StartupProfile");
+    if (profile_class == nullptr) { return nullptr; }
+    jobjectArray profilesArray = env->NewObjectArray(profiles.size(), profile_class, nullptr);
+    if (env->ExceptionCheck()) { return nullptr; }
+    for (int i = 0; i < profiles.size(); ++i) {
+        jobject profile = createStartupProfileObject(env, profiles[i]);
+        if (profile == nullptr) { return nullptr; }
+        env->SetObjectArrayElement(profilesArray, i, profile);
+        env->DeleteLocalRef(profile);
+    }
+    return profilesArray;
+}
+
+extern "C"
+JNIEXPORT jboolean
 JNICALL
 Java_com_android_nn_benchmark_core_NNTestBase_dumpAllLayers(
         JNIEnv *env,
         jobject /* this */,
         jlong _modelHandle,
         jstring dumpPath,
-        jobject inOutDataList) {
+        jobject inOutDataList,
+        jboolean compress,
+        jobjectArray tensorNames,
+        jintArray tensorIndices) {
 
     BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
 
-    InferenceInOutSequenceList data(env, inOutDataList, /*expectGoldenOutputs=*/false);
+    InferenceInOutSequenceList data(env, inOutDataList, /*expectGoldenOutputs=*/false,
+                                    model->mappedDataset());
     if (!data.isValid()) {
-        return;
+        return false;
+    }
+
+    TensorDumpOptions options;
+    options.compress = compress;
+    if (tensorNames != nullptr) {
+        const jsize namesCount = env->GetArrayLength(tensorNames);
+        for (jsize i = 0; i < namesCount; ++i) {
+            jstring name = static_cast<jstring>(env->GetObjectArrayElement(tensorNames, i));
+            const char *nameStr = env->GetStringUTFChars(name, nullptr);
+            options.names.push_back(nameStr);
+            env->ReleaseStringUTFChars(name, nameStr);
+            env->DeleteLocalRef(name);
+        }
+    }
+    if (tensorIndices != nullptr) {
+        options.indices.resize(env->GetArrayLength(tensorIndices));
+        env->GetIntArrayRegion(tensorIndices, 0, options.indices.size(),
+                               options.indices.data());
     }
 
     const char *dumpPathStr = env->GetStringUTFChars(dumpPath, JNI_FALSE);
-    model->dumpAllLayers(dumpPathStr, data.data());
+    const bool success = model->dumpAllLayers(dumpPathStr, data.data(), options);
     env->ReleaseStringUTFChars(dumpPath, dumpPathStr);
+    return success;
+}
+
+extern "C"
+JNIEXPORT jboolean
+JNICALL
+Java_com_android_nn_benchmark_core_ImagePreprocessing_preprocessBitmap(
+        JNIEnv *env,
+        jclass /* clazz */,
+        jobject bitmap,
+        jfloat cropFraction,
+        jfloat mean,
+        jfloat stdDev,
+        jint dataSize,
+        jfloat quantScale,
+        jfloat quantZeroPoint,
+        jint outputSize,
+        jobject outputBuffer) {
+
+    uint8_t* output = static_cast<uint8_t*>(env->GetDirectBufferAddress(outputBuffer));
+    if (output == nullptr) { return false; }
+    size_t outputLength = env->GetDirectBufferCapacity(outputBuffer);
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        return false;
+    }
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        return false;
+    }
+
+    ImagePreprocessing preprocessing;
+    preprocessing.cropFraction = cropFraction;
+    preprocessing.outputSize = outputSize;
+    preprocessing.mean = mean;
+    preprocessing.std = stdDev;
+    preprocessing.dataSize = dataSize;
+    preprocessing.quantScale = quantScale;
+    preprocessing.quantZeroPoint = quantZeroPoint;
+    const bool success = preprocessImage(static_cast<const uint8_t*>(pixels), info.width,
+                                         info.height, info.stride, preprocessing, output,
+                                         outputLength);
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return success;
+}
+
+extern "C"
+JNIEXPORT jfloatArray
+JNICALL
+Java_com_android_nn_benchmark_core_LatencyPercentiles_compute(
+        JNIEnv *env,
+        jclass /* clazz */,
+        jfloatArray latenciesSec,
+        jfloatArray quantiles) {
+
+    LatencyStats stats;
+    jsize latenciesCount = env->GetArrayLength(latenciesSec);
+    jfloat* latencies = env->GetFloatArrayElements(latenciesSec, nullptr);
+    if (latencies == nullptr) { return nullptr; }
+    for (jsize i = 0; i < latenciesCount; ++i) {
+        stats.add(latencies[i]);
+    }
+    env->ReleaseFloatArrayElements(latenciesSec, latencies, JNI_ABORT);
+
+    jsize quantilesCount = env->GetArrayLength(quantiles);
+    std::vector<jfloat> quantileValues(quantilesCount);
+    env->GetFloatArrayRegion(quantiles, 0, quantilesCount, quantileValues.data());
+    std::vector<jfloat> percentiles(quantilesCount);
+    for (jsize i = 0; i < quantilesCount; ++i) {
+        percentiles[i] = stats.percentileSec(quantileValues[i]);
+    }
+    jfloatArray percentilesArray = env->NewFloatArray(quantilesCount);
+    if (env->ExceptionCheck()) { return nullptr; }
+    env->SetFloatArrayRegion(percentilesArray, 0, quantilesCount, percentiles.data());
+    return percentilesArray;
+}
+
+extern "C"
+JNIEXPORT jobject
+JNICALL
+Java_com_android_nn_benchmark_core_LatencyHistogram_compute(
+        JNIEnv *env,
+        jclass /* clazz */,
+        jfloatArray latenciesSec) {
+
+    LatencyStats stats;
+    jsize latenciesCount = env->GetArrayLength(latenciesSec);
+    jfloat* latencies = env->GetFloatArrayElements(latenciesSec, nullptr);
+    if (latencies == nullptr) { return nullptr; }
+    for (jsize i = 0; i < latenciesCount; ++i) {
+        stats.add(latencies[i]);
+    }
+    env->ReleaseFloatArrayElements(latenciesSec, latencies, JNI_ABORT);
+
+    jclass histogram_class = env->FindClass("com/android/nn/benchmark/core/LatencyHistogram");
+    if (histogram_class == nullptr) { return nullptr; }
+    jmethodID histogram_ctor = env->GetMethodID(histogram_class, "<init>", "([F[I)V");
+    if (histogram_ctor == nullptr) { return nullptr; }
+    jfloatArray bucketLowerBoundsArray;
+    jintArray bucketCountsArray;
+    if (!createHistogramArrays(env, stats.histogram(), &bucketLowerBoundsArray,
+                               &bucketCountsArray)) {
+        return nullptr;
+    }
+    jobject object = env->NewObject(histogram_class, histogram_ctor, bucketLowerBoundsArray,
+                                    bucketCountsArray);
+    if (env->ExceptionCheck()) { return nullptr; }
+    return object;
+}
+
+namespace {
+
+jobjectArray createStringArray(JNIEnv *env, const std::vector<std::string>& strings) {
+    jclass string_class = env->FindClass("java/lang/String");
+    if (string_class == nullptr) { return nullptr; }
+    jobjectArray array = env->NewObjectArray(strings.size(), string_class, nullptr);
+    if (env->ExceptionCheck()) { return nullptr; }
+    for (int i = 0; i < strings.size(); ++i) {
+        jstring string = env->NewStringUTF(strings[i].c_str());
+        if (string == nullptr) { return nullptr; }
+        env->SetObjectArrayElement(array, i, string);
+        env->DeleteLocalRef(string);
+    }
+    return array;
+}
+
+}  // namespace
+
+extern "C"
+JNIEXPORT jboolean
+JNICALL
+Java_com_android_nn_benchmark_core_NativeEvaluator_isSupported(
+        JNIEnv *env,
+        jclass /* clazz */,
+        jstring className) {
+
+    const char *classNameStr = env->GetStringUTFChars(className, nullptr);
+    const bool supported = NativeEvaluator::isSupported(classNameStr);
+    env->ReleaseStringUTFChars(className, classNameStr);
+    return supported;
+}
+
+extern "C"
+JNIEXPORT jboolean
+JNICALL
+Java_com_android_nn_benchmark_core_NativeEvaluator_setup(
+        JNIEnv *env,
+        jclass /* clazz */,
+        jlong _modelHandle,
+        jstring className,
+        jint targetOutputIndex,
+        jfloat expectedTop1,
+        jfloatArray outputMean,
+        jfloatArray outputStdDev) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+
+    NativeEvaluatorConfig config;
+    const char *classNameStr = env->GetStringUTFChars(className, nullptr);
+    config.className = classNameStr;
+    env->ReleaseStringUTFChars(className, classNameStr);
+    config.targetOutputIndex = targetOutputIndex;
+    config.expectedTop1 = expectedTop1;
+    if (outputMean != nullptr && outputStdDev != nullptr) {
+        config.outputMean.resize(env->GetArrayLength(outputMean));
+        env->GetFloatArrayRegion(outputMean, 0, config.outputMean.size(),
+                                 config.outputMean.data());
+        config.outputStdDev.resize(env->GetArrayLength(outputStdDev));
+        env->GetFloatArrayRegion(outputStdDev, 0, config.outputStdDev.size(),
+                                 config.outputStdDev.data());
+    }
+
+    std::unique_ptr<NativeEvaluator> evaluator = NativeEvaluator::create(config);
+    if (!evaluator) {
+        return false;
+    }
+    model->setNativeEvaluator(std::move(evaluator));
+    return true;
+}
+
+extern "C"
+JNIEXPORT jobject
+JNICALL
+Java_com_android_nn_benchmark_core_NativeEvaluator_getResults(
+        JNIEnv *env,
+        jclass /* clazz */,
+        jlong _modelHandle) {
+
+    BenchmarkModel* model = reinterpret_cast<BenchmarkModel*>(_modelHandle);
+    if (model->nativeEvaluator() == nullptr) {
+        return nullptr;
+    }
+    std::vector<std::string> keys;
+    std::vector<float> values;
+    std::vector<std::string> validationErrors;
+    model->nativeEvaluator()->getResults(&keys, &values, &validationErrors);
+
+    jclass results_class = env->FindClass(
+            "com/android/nn/benchmark/core/NativeEvaluator$Results");
+    if (results_class == nullptr) { return nullptr; }
+    jmethodID results_ctor = env->GetMethodID(results_class, "<init>",
+            "([Ljava/lang/String;[F[Ljava/lang/String;)V");
+    if (results_ctor == nullptr) { return nullptr; }
+
+    jobjectArray keysArray = createStringArray(env, keys);
+    if (keysArray == nullptr) { return nullptr; }
+    jfloatArray valuesArray = env->NewFloatArray(values.size());
+    if (env->ExceptionCheck()) { return nullptr; }
+    env->SetFloatArrayRegion(valuesArray, 0, values.size(), values.data());
+    jobjectArray validationErrorsArray = createStringArray(env, validationErrors);
+    if (validationErrorsArray == nullptr) { return nullptr; }
+
+    jobject object = env->NewObject(results_class, results_ctor, keysArray, valuesArray,
+                                    validationErrorsArray);
+    if (env->ExceptionCheck()) { return nullptr; }
+    return object;
 }
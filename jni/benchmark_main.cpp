@@ -0,0 +1,584 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Standalone benchmark executable. Runs the models of a model list on their
+// memory mapped datasets (see MappedDataset) through BenchmarkModel, without
+// the Java harness and its JIT, GC and app scheduling noise, and writes the
+// results in the CSVWriter format, so that results/generate_result.py works
+// on them unchanged. See kUsage for the options and the model list format.
+
+#include "cpu_affinity.h"
+#include "csv_result.h"
+#include "mapped_dataset.h"
+#include "run_tflite.h"
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char kUsage[] =
+    "Usage: nnbenchmark [options] <model list>\n"
+    "\n"
+    "The model list has one model per line, '#' starts a comment:\n"
+    "  <name> <model .tflite> <dataset .nnbd> [<input shape>...]\n"
+    "Input shapes are comma separated dimensions, one per model input, e.g.\n"
+    "1,224,224,3. Without them the model's own input shapes are used.\n"
+    "Datasets are written by MappedDatasetWriter, the app leaves one per\n"
+    "model in its cache directory when run with mapped datasets. Relative\n"
+    "paths are relative to the model list.\n"
+    "\n"
+    "Options:\n"
+    "  --output <file>        Append the results to file, default stdout\n"
+    "  --models <names>       Comma separated list of models to run\n"
+    "  --nnapi                Run with the NNAPI delegate\n"
+    "  --nnapi-device <name>  NNAPI device to run on\n"
+    "  --warmup <sec>         Warmup time, default 0.3\n"
+    "  --time <sec>           Benchmark time, default 1\n"
+    "  --complete-set         Run every inference of the dataset once\n"
+    "  --threads <n>          TFLite CPU threads\n"
+    "  --cpu-cores <set>      Pin to all, big or little cores\n"
+    "  --zero-copy            Bind inputs to NNAPI shared memory\n"
+    "  --async-validation     Check golden outputs on another thread\n"
+    "  --prefetch             Prepare inputs on another thread\n"
+    "  --sample-peak-heap     Sample the heap during the run for its peak\n"
+    "  --convergence <width>  Stop once the 95% confidence interval of the\n"
+    "                         mean latency is within width (relative) of\n"
+    "                         it, or at the benchmark time\n"
+    "  --convergence-quantile <q>\n"
+    "                         Converge on latency quantile q instead\n"
+    "Benchmark modes, default is a streaming benchmark:\n"
+    "  --concurrent <n>       n interpreters at once\n"
+    "  --open-loop <rates>    Comma separated arrival rates per second,\n"
+    "                         served by --concurrent interpreters\n"
+    "  --poisson              Poisson open-loop arrivals\n"
+    "  --thread-sweep <max>   Every thread count from 1 to max\n"
+    "  --batch-sweep <sizes>  Comma separated batch sizes\n"
+    "  --execution-modes      NNAPI synchronous vs burst executions\n";
+
+// Same defaults as BenchmarkTestBase.
+const float kWarmupSeconds = 0.3f;
+const float kRuntimeSeconds = 1.0f;
+const float kCompleteSetTimeoutSeconds = 300.0f;
+// Max sequence count of timed runs, same as NNTestBase.
+const int kMaxSequences = 0xFFFFFFF;
+
+struct ModelEntry {
+  std::string name;
+  std::string modelFile;
+  std::string datasetFile;
+  std::vector<std::vector<int>> inputShapes;
+};
+
+struct Options {
+  std::string output;
+  std::vector<std::string> models;
+  bool useNnapi = false;
+  DelegateOptions delegateOptions;
+  float warmupSec = kWarmupSeconds;
+  float runtimeSec = kRuntimeSeconds;
+  bool completeInputSet = false;
+  int numThreads = -1;
+  int cpuCores = -1;
+  int flags = FLAG_DISCARD_INFERENCE_OUTPUT;
+  int concurrentInferences = 1;
+  std::vector<float> arrivalRates;
+  bool poisson = false;
+  int threadSweepMax = 0;
+  std::vector<int> batchSizes;
+  bool executionModes = false;
+  bool convergence = false;
+  ConvergenceOptions convergenceOptions;
+};
+
+std::vector<std::string> split(const std::string& value, char separator) {
+  std::vector<std::string> parts;
+  std::stringstream stream(value);
+  std::string part;
+  while (std::getline(stream, part, separator)) {
+    if (!part.empty()) {
+      parts.push_back(part);
+    }
+  }
+  return parts;
+}
+
+bool parseInts(const std::string& value, std::vector<int>* ints) {
+  for (const std::string& part : split(value, ',')) {
+    char* end;
+    const long parsed = strtol(part.c_str(), &end, 10);
+    if (*end != '\0' || parsed <= 0 || parsed > INT_MAX) {
+      return false;
+    }
+    ints->push_back(parsed);
+  }
+  return !ints->empty();
+}
+
+bool parseFloats(const std::string& value, std::vector<float>* floats) {
+  for (const std::string& part : split(value, ',')) {
+    char* end;
+    const float parsed = strtof(part.c_str(), &end);
+    if (*end != '\0' || !(parsed > 0.0f)) {
+      return false;
+    }
+    floats->push_back(parsed);
+  }
+  return !floats->empty();
+}
+
+bool parseFloat(const char* value, float* parsed) {
+  std::vector<float> floats;
+  if (!parseFloats(value, &floats) || floats.size() != 1) {
+    return false;
+  }
+  *parsed = floats[0];
+  return true;
+}
+
+bool parseInt(const char* value, int* parsed) {
+  std::vector<int> ints;
+  if (!parseInts(value, &ints) || ints.size() != 1) {
+    return false;
+  }
+  *parsed = ints[0];
+  return true;
+}
+
+bool parseOptions(int argc, char** argv, Options* options,
+                  std::string* modelList) {
+  enum {
+    kOutput = 1000,
+    kModels,
+    kNnapi,
+    kNnapiDevice,
+    kWarmup,
+    kTime,
+    kCompleteSet,
+    kThreads,
+    kCpuCores,
+    kZeroCopy,
+    kAsyncValidation,
+    kPrefetch,
+    kSamplePeakHeap,
+    kConcurrent,
+    kOpenLoop,
+    kPoisson,
+    kThreadSweep,
+    kBatchSweep,
+    kExecutionModes,
+    kConvergence,
+    kConvergenceQuantile,
+  };
+  static const struct option kOptions[] = {
+      {"output", required_argument, nullptr, kOutput},
+      {"models", required_argument, nullptr, kModels},
+      {"nnapi", no_argument, nullptr, kNnapi},
+      {"nnapi-device", required_argument, nullptr, kNnapiDevice},
+      {"warmup", required_argument, nullptr, kWarmup},
+      {"time", required_argument, nullptr, kTime},
+      {"complete-set", no_argument, nullptr, kCompleteSet},
+      {"threads", required_argument, nullptr, kThreads},
+      {"cpu-cores", required_argument, nullptr, kCpuCores},
+      {"zero-copy", no_argument, nullptr, kZeroCopy},
+      {"async-validation", no_argument, nullptr, kAsyncValidation},
+      {"prefetch", no_argument, nullptr, kPrefetch},
+      {"sample-peak-heap", no_argument, nullptr, kSamplePeakHeap},
+      {"concurrent", required_argument, nullptr, kConcurrent},
+      {"open-loop", required_argument, nullptr, kOpenLoop},
+      {"poisson", no_argument, nullptr, kPoisson},
+      {"thread-sweep", required_argument, nullptr, kThreadSweep},
+      {"batch-sweep", required_argument, nullptr, kBatchSweep},
+      {"execution-modes", no_argument, nullptr, kExecutionModes},
+      {"convergence", required_argument, nullptr, kConvergence},
+      {"convergence-quantile", required_argument, nullptr,
+       kConvergenceQuantile},
+      {nullptr, 0, nullptr, 0},
+  };
+
+  int option;
+  while ((option = getopt_long(argc, argv, "", kOptions, nullptr)) != -1) {
+    bool valid = true;
+    switch (option) {
+      case kOutput:
+        options->output = optarg;
+        break;
+      case kModels:
+        options->models = split(optarg, ',');
+        break;
+      case kNnapi:
+        options->useNnapi = true;
+        break;
+      case kNnapiDevice:
+        options->delegateOptions.deviceName = optarg;
+        break;
+      case kWarmup: {
+        // 0 is valid here, for a single warmup inference.
+        char* end;
+        options->warmupSec = strtof(optarg, &end);
+        valid = *optarg != '\0' && *end == '\0' && options->warmupSec >= 0.0f;
+        break;
+      }
+      case kTime:
+        valid = parseFloat(optarg, &options->runtimeSec);
+        break;
+      case kCompleteSet:
+        options->completeInputSet = true;
+        break;
+      case kThreads:
+        valid = parseInt(optarg, &options->numThreads);
+        break;
+      case kCpuCores:
+        if (strcmp(optarg, "all") == 0) {
+          options->cpuCores = CPU_CORES_ALL;
+        } else if (strcmp(optarg, "big") == 0) {
+          options->cpuCores = CPU_CORES_BIG;
+        } else if (strcmp(optarg, "little") == 0) {
+          options->cpuCores = CPU_CORES_LITTLE;
+        } else {
+          valid = false;
+        }
+        break;
+      case kZeroCopy:
+        options->flags |= FLAG_ZERO_COPY_INPUT;
+        break;
+      case kAsyncValidation:
+        options->flags |= FLAG_ASYNC_VALIDATION;
+        break;
+      case kPrefetch:
+        options->flags |= FLAG_PREFETCH_INPUTS;
+        break;
+      case kSamplePeakHeap:
+        options->flags |= FLAG_SAMPLE_PEAK_HEAP;
+        break;
+      case kConcurrent:
+        valid = parseInt(optarg, &options->concurrentInferences);
+        break;
+      case kOpenLoop:
+        valid = parseFloats(optarg, &options->arrivalRates);
+        break;
+      case kPoisson:
+        options->poisson = true;
+        break;
+      case kThreadSweep:
+        valid = parseInt(optarg, &options->threadSweepMax);
+        break;
+      case kBatchSweep:
+        valid = parseInts(optarg, &options->batchSizes);
+        break;
+      case kExecutionModes:
+        options->executionModes = true;
+        break;
+      case kConvergence:
+        options->convergence = true;
+        valid = parseFloat(optarg,
+                           &options->convergenceOptions.targetRelativeWidth);
+        break;
+      case kConvergenceQuantile:
+        valid = parseFloat(optarg, &options->convergenceOptions.quantile) &&
+                options->convergenceOptions.quantile < 1.0f;
+        break;
+      default:
+        return false;
+    }
+    if (!valid) {
+      fprintf(stderr, "Invalid value for --%s: %s\n",
+              kOptions[option - kOutput].name, optarg);
+      return false;
+    }
+  }
+  if (optind != argc - 1) {
+    return false;
+  }
+  *modelList = argv[optind];
+  if (!options->useNnapi && (options->flags & FLAG_ZERO_COPY_INPUT)) {
+    fprintf(stderr, "--zero-copy needs --nnapi\n");
+    return false;
+  }
+  if (!options->useNnapi && options->executionModes) {
+    fprintf(stderr, "--execution-modes needs --nnapi\n");
+    return false;
+  }
+  if (!options->convergence && options->convergenceOptions.quantile >= 0.0f) {
+    fprintf(stderr, "--convergence-quantile needs --convergence\n");
+    return false;
+  }
+  // The benchmark time bounds convergence runs.
+  options->convergenceOptions.maxTimeSec = options->runtimeSec;
+  return true;
+}
+
+bool parseModelList(const std::string& path, std::vector<ModelEntry>* models) {
+  std::ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "Failed to open the model list %s\n", path.c_str());
+    return false;
+  }
+  const size_t slash = path.rfind('/');
+  const std::string directory =
+      slash == std::string::npos ? "" : path.substr(0, slash + 1);
+  auto resolve = [&directory](const std::string& file) {
+    return file[0] == '/' ? file : directory + file;
+  };
+
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line)) {
+    ++lineNumber;
+    line = line.substr(0, line.find('#'));
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (stream >> field) {
+      fields.push_back(field);
+    }
+    if (fields.empty()) {
+      continue;
+    }
+    if (fields.size() < 3) {
+      fprintf(stderr, "%s:%d: expected <name> <model> <dataset>\n",
+              path.c_str(), lineNumber);
+      return false;
+    }
+    ModelEntry entry;
+    entry.name = fields[0];
+    entry.modelFile = resolve(fields[1]);
+    entry.datasetFile = resolve(fields[2]);
+    for (int i = 3; i < fields.size(); ++i) {
+      std::vector<int> shape;
+      if (!parseInts(fields[i], &shape)) {
+        fprintf(stderr, "%s:%d: invalid input shape %s\n", path.c_str(),
+                lineNumber, fields[i].c_str());
+        return false;
+      }
+      entry.inputShapes.push_back(shape);
+    }
+    models->push_back(entry);
+  }
+  return true;
+}
+
+int testSetSize(const std::vector<InferenceInOutSequence>& data) {
+  int size = 0;
+  for (const InferenceInOutSequence& sequence : data) {
+    size += sequence.size();
+  }
+  return size;
+}
+
+// Runs the benchmark mode selected by options, with the same precedence as
+// NNBenchmark. Only the streaming benchmark stops early at convergence, all
+// other modes always run for the benchmark time.
+bool runBenchmark(BenchmarkModel* model, const ModelEntry& entry,
+                  const Options& options, CsvResult* result) {
+  const std::vector<InferenceInOutSequence>& data =
+      model->mappedDataset()->data();
+  int flags = options.flags;
+  if (!model->mappedDataset()->hasGoldenOutputs()) {
+    flags |= FLAG_IGNORE_GOLDEN_OUTPUT;
+  }
+  const std::string backend =
+      options.useNnapi ? kBackendTfliteNnapi : kBackendTfliteCpu;
+  const float runtimeSec = options.runtimeSec;
+
+  if (!options.arrivalRates.empty()) {
+    std::vector<OpenLoopSummary> summaries;
+    if (!model->benchmarkOpenLoopSweep(
+            data, options.arrivalRates,
+            options.poisson ? ARRIVAL_POISSON : ARRIVAL_FIXED_INTERVAL,
+            options.concurrentInferences, runtimeSec, flags, &summaries)) {
+      return false;
+    }
+    *result = CsvResult::fromOpenLoopSummaries(entry.name, backend,
+                                               testSetSize(data), summaries);
+  } else if (options.concurrentInferences > 1) {
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkConcurrent(data, options.concurrentInferences,
+                                    kMaxSequences, runtimeSec, flags,
+                                    &summaries)) {
+      return false;
+    }
+    *result = CsvResult::fromConcurrentInferenceSummaries(
+        entry.name, backend, testSetSize(data), summaries);
+  } else if (options.threadSweepMax > 0) {
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkThreadSweep(data, options.threadSweepMax,
+                                     kMaxSequences, runtimeSec, flags,
+                                     &summaries)) {
+      return false;
+    }
+    *result = CsvResult::fromThreadSweepSummaries(entry.name, backend,
+                                                  testSetSize(data), summaries);
+  } else if (options.executionModes) {
+    const std::vector<int> modes = {EXECUTION_MODE_SYNC, EXECUTION_MODE_BURST};
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkExecutionModes(data, modes, kMaxSequences, runtimeSec,
+                                        flags, &summaries)) {
+      return false;
+    }
+    *result = CsvResult::fromExecutionModeSummaries(
+        entry.name, backend, testSetSize(data), modes, summaries);
+  } else if (!options.batchSizes.empty()) {
+    std::vector<InferenceSummary> summaries;
+    if (!model->benchmarkBatchSweep(data, options.batchSizes, kMaxSequences,
+                                    runtimeSec, flags, &summaries)) {
+      return false;
+    }
+    *result = CsvResult::fromBatchSweepSummaries(
+        entry.name, backend, testSetSize(data), options.batchSizes, summaries);
+  } else {
+    InferenceSummary summary;
+    const bool ok =
+        options.completeInputSet
+            ? model->benchmarkStreaming(data, data.size(),
+                                        kCompleteSetTimeoutSeconds,
+                                        flags | FLAG_IGNORE_CONVERGENCE,
+                                        &summary)
+            : model->benchmarkStreaming(data, kMaxSequences, runtimeSec,
+                                        flags, &summary);
+    if (!ok) {
+      return false;
+    }
+    *result = CsvResult::fromInferenceSummary(entry.name, backend,
+                                              testSetSize(data), summary, {},
+                                              {});
+    result->hasConvergenceStatus =
+        options.convergence && !options.completeInputSet;
+    result->convergenceStatus = model->convergenceStatus();
+  }
+  result->hasMemoryProfile = true;
+  result->memoryProfile = model->memoryProfile();
+  return true;
+}
+
+bool runModel(const ModelEntry& entry, const Options& options, FILE* output) {
+  std::unique_ptr<BenchmarkModel> model(
+      BenchmarkModel::create(entry.modelFile.c_str(), options.useNnapi,
+                             /*enable_intermediate_tensors_dump=*/false,
+                             options.delegateOptions));
+  if (!model) {
+    fprintf(stderr, "%s: failed to create the model\n", entry.name.c_str());
+    return false;
+  }
+  if (!entry.inputShapes.empty() &&
+      !model->resizeInputTensors(entry.inputShapes)) {
+    fprintf(stderr, "%s: failed to resize the inputs\n", entry.name.c_str());
+    return false;
+  }
+  if (options.numThreads != -1 && !model->setNumThreads(options.numThreads)) {
+    fprintf(stderr, "%s: failed to set the thread count\n",
+            entry.name.c_str());
+    return false;
+  }
+  if (options.cpuCores != -1 && !model->setCpuAffinity(options.cpuCores, 0)) {
+    fprintf(stderr, "%s: failed to set the CPU affinity\n",
+            entry.name.c_str());
+    return false;
+  }
+  if (options.convergence &&
+      !model->setConvergence(options.convergenceOptions)) {
+    fprintf(stderr, "%s: invalid convergence options\n", entry.name.c_str());
+    return false;
+  }
+  std::unique_ptr<MappedDataset> dataset =
+      MappedDataset::open(entry.datasetFile.c_str());
+  if (!dataset || dataset->data().empty()) {
+    fprintf(stderr, "%s: failed to open the dataset %s\n", entry.name.c_str(),
+            entry.datasetFile.c_str());
+    return false;
+  }
+  model->setMappedDataset(std::move(dataset));
+
+  // Same warmup as NNBenchmark, for the warmup time or a single inference.
+  std::vector<float> warmupTimesSec;
+  if (!model->warmup(model->mappedDataset()->data(),
+                     options.warmupSec > 0.0f ? INT_MAX : 1, options.warmupSec,
+                     &warmupTimesSec)) {
+    fprintf(stderr, "%s: warmup failed\n", entry.name.c_str());
+    return false;
+  }
+
+  CsvResult result;
+  if (!runBenchmark(model.get(), entry, options, &result)) {
+    fprintf(stderr, "%s: benchmark failed\n", entry.name.c_str());
+    return false;
+  }
+  const std::string line = result.toCsvLine();
+  fputs(line.c_str(), output);
+  fflush(output);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  std::string modelList;
+  if (!parseOptions(argc, argv, &options, &modelList)) {
+    fputs(kUsage, stderr);
+    return 1;
+  }
+  std::vector<ModelEntry> models;
+  if (!parseModelList(modelList, &models)) {
+    return 1;
+  }
+
+  FILE* output = stdout;
+  if (!options.output.empty()) {
+    // Appended like CSVWriter, so that runs can be collected in one file.
+    output = fopen(options.output.c_str(), "a");
+    if (output == nullptr) {
+      fprintf(stderr, "Failed to open %s\n", options.output.c_str());
+      return 1;
+    }
+  }
+  fputs(csvHeader().c_str(), output);
+
+  // Failed models are reported and skipped, like failed instrumentation
+  // tests, the exit status tells whether any failed.
+  int failures = 0;
+  bool found = options.models.empty();
+  for (const ModelEntry& entry : models) {
+    if (!options.models.empty() &&
+        std::find(options.models.begin(), options.models.end(), entry.name) ==
+            options.models.end()) {
+      continue;
+    }
+    found = true;
+    if (!runModel(entry, options, output)) {
+      ++failures;
+    }
+  }
+  if (output != stdout) {
+    fclose(output);
+  }
+  if (!found) {
+    fprintf(stderr, "No model of the list matches --models\n");
+    return 1;
+  }
+  return failures == 0 ? 0 : 2;
+}
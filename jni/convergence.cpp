@@ -0,0 +1,117 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "convergence.h"
+
+#include <android/log.h>
+
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "NN_BENCHMARK"
+
+namespace {
+
+// Standard normal quantile of p in (0, 0.5], Abramowitz and Stegun 26.2.23
+// (absolute error below 4.5e-4, returned negated).
+double normalQuantileLowerTail(double p) {
+  const double t = std::sqrt(-2.0 * std::log(p));
+  return t - (2.515517 + t * (0.802853 + t * 0.010328)) /
+                 (1.0 + t * (1.432788 + t * (0.189269 + t * 0.001308)));
+}
+
+}  // namespace
+
+bool ConvergenceOptions::validate() const {
+  if (!(targetRelativeWidth > 0.0f) || !(confidence > 0.0f) ||
+      !(confidence < 1.0f) || quantile == 0.0f || quantile >= 1.0f ||
+      minInferences < 0 || maxInferences < 0 || minTimeSec < 0.0f ||
+      maxTimeSec < 0.0f) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Invalid convergence options: width %f, confidence "
+                        "%f, quantile %f, inferences %d-%d, time %f-%f",
+                        targetRelativeWidth, confidence, quantile,
+                        minInferences, maxInferences, minTimeSec, maxTimeSec);
+    return false;
+  }
+  return true;
+}
+
+ConvergenceTracker::ConvergenceTracker(const ConvergenceOptions& options)
+    : mOptions(options),
+      mZ(normalQuantileLowerTail((1.0 - options.confidence) / 2.0)) {}
+
+bool ConvergenceTracker::add(float computeTimeSec) {
+  mStats.add(computeTimeSec);
+  const uint64_t count = mStats.count();
+  if ((mOptions.maxInferences > 0 &&
+       count >= static_cast<uint64_t>(mOptions.maxInferences)) ||
+      (mOptions.maxTimeSec > 0.0f &&
+       mStats.totalSec() >= mOptions.maxTimeSec)) {
+    return true;
+  }
+  if (!pastMinBounds()) {
+    return false;
+  }
+  if (mOptions.quantile > 0.0f) {
+    if (count < mNextCheck) {
+      return false;
+    }
+    mNextCheck = count + std::max<uint64_t>(1, count / 16);
+  }
+  return status().converged;
+}
+
+ConvergenceStatus ConvergenceTracker::status() const {
+  ConvergenceStatus status;
+  const uint64_t count = mStats.count();
+  status.inferences = count;
+  status.totalTimeSec = mStats.totalSec();
+  if (count < 2) {
+    return status;
+  }
+  const double n = static_cast<double>(count);
+  double halfWidth;
+  if (mOptions.quantile < 0.0f) {
+    status.estimateSec = mStats.meanSec();
+    // Sample standard deviation from the population one.
+    const double stdDev = mStats.stdDevSec() * std::sqrt(n / (n - 1.0));
+    halfWidth = mZ * stdDev / std::sqrt(n);
+  } else {
+    const double q = mOptions.quantile;
+    const double rankSpread = mZ * std::sqrt(n * q * (1.0 - q));
+    status.estimateSec = mStats.percentileSec(q);
+    // The interval isn't bounded by order statistics yet.
+    if (n * q - rankSpread < 1.0 || n * q + rankSpread > n) {
+      return status;
+    }
+    const float lower = mStats.percentileSec(q - rankSpread / n);
+    const float upper = mStats.percentileSec(q + rankSpread / n);
+    halfWidth = (upper - lower) / 2.0;
+  }
+  if (status.estimateSec <= 0.0f) {
+    return status;
+  }
+  status.relativeWidth = static_cast<float>(halfWidth / status.estimateSec);
+  status.converged = pastMinBounds() &&
+                     status.relativeWidth <= mOptions.targetRelativeWidth;
+  return status;
+}
+
+bool ConvergenceTracker::pastMinBounds() const {
+  return mStats.count() >= static_cast<uint64_t>(mOptions.minInferences) &&
+         mStats.totalSec() >= mOptions.minTimeSec;
+}
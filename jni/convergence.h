@@ -0,0 +1,86 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_CONVERGENCE_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_CONVERGENCE_H
+
+#include "latency_stats.h"
+
+#include <cstdint>
+
+// Stopping rule of convergence driven benchmark runs, see
+// BenchmarkModel::setConvergence(). The run stops once the confidence
+// interval of the estimated latency is narrow enough, within the bounds.
+struct ConvergenceOptions {
+  // Target half-width of the confidence interval, relative to the estimate.
+  float targetRelativeWidth = 0.02f;
+  // Confidence level of the interval, in (0, 1).
+  float confidence = 0.95f;
+  // Latency quantile (0.0 - 1.0, exclusive) to estimate, negative for the
+  // mean.
+  float quantile = -1.0f;
+  // Bounds on the number of inferences and on their total compute time,
+  // 0 for none. The min bounds apply before the interval is looked at.
+  int minInferences = 10;
+  int maxInferences = 0;
+  float minTimeSec = 0.0f;
+  float maxTimeSec = 0.0f;
+
+  // Logs and returns false if the options can't be used.
+  bool validate() const;
+};
+
+// Where a convergence driven run stopped.
+struct ConvergenceStatus {
+  bool converged = false;
+  uint64_t inferences = 0;
+  float totalTimeSec = 0.0f;
+  // Mean or quantile latency.
+  float estimateSec = 0.0f;
+  // Half-width of the confidence interval relative to the estimate, -1 while
+  // there are too few inferences to bound it.
+  float relativeWidth = -1.0f;
+};
+
+// Tracks the confidence interval of the inference latencies of a run.
+//
+// The mean interval is the normal approximation, z * s / sqrt(n). Quantile
+// intervals are distribution free, between the order statistics of ranks
+// n * q -/+ z * sqrt(n * q * (1 - q)). Both assume independent samples, the
+// min bounds are there to get past warmup and frequency ramp up effects.
+class ConvergenceTracker {
+ public:
+  explicit ConvergenceTracker(const ConvergenceOptions& options);
+
+  // Adds the latency of an inference, returns true once the run should stop:
+  // converged or past a max bound.
+  bool add(float computeTimeSec);
+  // Status of the inferences added so far.
+  ConvergenceStatus status() const;
+
+ private:
+  bool pastMinBounds() const;
+
+  ConvergenceOptions mOptions;
+  // Standard normal quantile of the confidence level.
+  double mZ;
+  LatencyStats mStats;
+  // Quantile intervals aren't O(1), they are only re-evaluated every 1/16th
+  // growth of the sample count.
+  uint64_t mNextCheck = 0;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_CONVERGENCE_H
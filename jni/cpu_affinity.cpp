@@ -0,0 +1,137 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpu_affinity.h"
+
+#include <android/log.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#define LOG_TAG "NN_BENCHMARK"
+
+namespace {
+
+constexpr int kMaxCpus = 64;
+
+int getCpusCount() {
+  long count = sysconf(_SC_NPROCESSORS_CONF);
+  return static_cast<int>(std::max(1L, std::min<long>(count, kMaxCpus)));
+}
+
+// Returns 0 if unknown (offline CPU, no cpufreq driver).
+long getCpuMaxFreqKhz(int cpu) {
+  char path[128];
+  snprintf(path, sizeof(path),
+           "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return 0;
+  }
+  long freq = 0;
+  if (fscanf(file, "%ld", &freq) != 1) {
+    freq = 0;
+  }
+  fclose(file);
+  return freq;
+}
+
+}  // namespace
+
+uint64_t getCpuCoresMask(int cores, uint64_t explicitMask) {
+  const int cpusCount = getCpusCount();
+  const uint64_t allCpus =
+      cpusCount >= 64 ? ~0ULL : ((1ULL << cpusCount) - 1);
+  switch (cores) {
+    case CPU_CORES_ALL:
+      return allCpus;
+    case CPU_CORES_EXPLICIT:
+      return explicitMask;
+    case CPU_CORES_BIG:
+    case CPU_CORES_LITTLE: {
+      std::vector<long> freqs(cpusCount);
+      long minFreq = 0;
+      long maxFreq = 0;
+      for (int cpu = 0; cpu < cpusCount; ++cpu) {
+        freqs[cpu] = getCpuMaxFreqKhz(cpu);
+        if (freqs[cpu] > 0) {
+          minFreq = minFreq == 0 ? freqs[cpu] : std::min(minFreq, freqs[cpu]);
+          maxFreq = std::max(maxFreq, freqs[cpu]);
+        }
+      }
+      if (maxFreq == 0) {
+        __android_log_print(ANDROID_LOG_WARN, LOG_TAG,
+                            "No cpufreq info, using all cores");
+        return allCpus;
+      }
+      const long wantedFreq = cores == CPU_CORES_BIG ? maxFreq : minFreq;
+      uint64_t mask = 0;
+      for (int cpu = 0; cpu < cpusCount; ++cpu) {
+        if (freqs[cpu] == wantedFreq) {
+          mask |= 1ULL << cpu;
+        }
+      }
+      return mask;
+    }
+    default:
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Unknown CPU cores set %d",
+                          cores);
+      return 0;
+  }
+}
+
+bool setCurrentThreadAffinity(uint64_t mask) {
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (int cpu = 0; cpu < kMaxCpus; ++cpu) {
+    if (mask & (1ULL << cpu)) {
+      CPU_SET(cpu, &cpuSet);
+    }
+  }
+  // pid 0 is the calling thread.
+  if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Failed to set CPU affinity to 0x%llx",
+                        static_cast<unsigned long long>(mask));
+    return false;
+  }
+  return true;
+}
+
+ScopedCpuAffinity::ScopedCpuAffinity(uint64_t mask) {
+  if (mask == 0) {
+    return;
+  }
+  CPU_ZERO(&mPreviousCpuSet);
+  if (sched_getaffinity(0, sizeof(mPreviousCpuSet), &mPreviousCpuSet) != 0) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Failed to get the CPU affinity");
+    mOk = false;
+    return;
+  }
+  mOk = setCurrentThreadAffinity(mask);
+  mRestore = mOk;
+}
+
+ScopedCpuAffinity::~ScopedCpuAffinity() {
+  if (mRestore &&
+      sched_setaffinity(0, sizeof(mPreviousCpuSet), &mPreviousCpuSet) != 0) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Failed to restore the CPU affinity");
+  }
+}
@@ -0,0 +1,64 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_CPU_AFFINITY_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_CPU_AFFINITY_H
+
+#include <sched.h>
+
+#include <cstdint>
+
+/** CPU core sets for the benchmark thread affinity, same values as in NNTestBase. */
+const int CPU_CORES_ALL = 0;
+/** Cores with the highest max frequency (big cores on big.LITTLE). */
+const int CPU_CORES_BIG = 1;
+/** Cores with the lowest max frequency (little cores on big.LITTLE). */
+const int CPU_CORES_LITTLE = 2;
+/** Explicit CPU mask, bit N is CPU N. */
+const int CPU_CORES_EXPLICIT = 3;
+
+// Returns the CPU mask for one of the CPU_CORES_* sets, explicitMask is only
+// used by CPU_CORES_EXPLICIT. Big/little cores are told apart by their
+// cpufreq max frequency; without cpufreq info all cores are returned.
+// Returns 0 for an unknown core set.
+uint64_t getCpuCoresMask(int cores, uint64_t explicitMask);
+
+// Pins the calling thread to the CPUs in mask. Threads created afterwards
+// by this thread inherit the affinity.
+bool setCurrentThreadAffinity(uint64_t mask);
+
+// Pins the calling thread to the CPUs in mask for the lifetime of the
+// object, then restores its previous affinity, so that the caller (e.g. a
+// Java thread calling through JNI) isn't left pinned. A mask of 0 leaves the
+// affinity alone. Threads created in between keep the mask.
+class ScopedCpuAffinity {
+ public:
+  explicit ScopedCpuAffinity(uint64_t mask);
+  ~ScopedCpuAffinity();
+
+  ScopedCpuAffinity(const ScopedCpuAffinity&) = delete;
+  ScopedCpuAffinity& operator=(const ScopedCpuAffinity&) = delete;
+
+  // False if the mask couldn't be applied.
+  bool ok() const { return mOk; }
+
+ private:
+  bool mOk = true;
+  bool mRestore = false;
+  cpu_set_t mPreviousCpuSet;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_CPU_AFFINITY_H
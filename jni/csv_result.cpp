@@ -0,0 +1,420 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "csv_result.h"
+
+#include <sys/system_properties.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+const char kBackendTfliteNnapi[] = "TFLite_NNAPI";
+const char kBackendTfliteCpu[] = "TFLite_CPU";
+
+namespace {
+
+// Same as CSVWriter.RESULT_FORMAT_COMMENT.
+const char kResultFormatComment[] =
+    "#testInfo,backendType"
+    ",iterations,totalTimeSec,maxSingleError,testSetSize,evaluatorsCount"
+    ",timeFreqStartSec,timeFreqStepSec,evaluatorKey1,evaluatorKey1,..."
+    ",timeFreqBucket1,...,validationError1,...,p50TimeSec,p90TimeSec,p95TimeSec"
+    ",p99TimeSec,maxTimeSec,arenaBytes,beforeCreateRssKb,beforeCreatePssKb"
+    ",beforeCreateHeapBytes,afterCreateRssKb,afterCreatePssKb,afterCreateHeapBytes"
+    ",firstInferenceRssKb,firstInferencePssKb,firstInferenceHeapBytes,steadyRssKb"
+    ",steadyPssKb,steadyHeapBytes,peakHeapBytes,peakRssKb,firstStepCount"
+    ",firstStepMeanTimeSec,firstStepP99TimeSec,laterStepCount,laterStepMeanTimeSec"
+    ",laterStepP99TimeSec,resetCount,resetMeanTimeSec,converged"
+    ",convergenceEstimateSec,convergenceRelativeWidth,histogramBucketsCount"
+    ",histogramBucket1Sec,histogramCount1,...";
+
+// Shortest representation that reads back as the same float, in decimal
+// notation in the same range as Java's Float.toString() and with its ".0"
+// suffix for integral values, so evaluator keys embedding values match.
+std::string formatFloat(float value) {
+  char buffer[64];
+  int precision = 1;
+  for (; precision <= 9; ++precision) {
+    snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    if (strtof(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  const float magnitude = std::fabs(value);
+  if (strchr(buffer, 'e') != nullptr && magnitude >= 1e-3f &&
+      magnitude < 1e7f) {
+    const int exponent = static_cast<int>(std::floor(std::log10(magnitude)));
+    snprintf(buffer, sizeof(buffer), "%.*f",
+             std::max(0, precision - 1 - exponent), value);
+  }
+  std::string result = buffer;
+  if (std::isfinite(value) &&
+      result.find_first_of(".e") == std::string::npos) {
+    result += ".0";
+  }
+  return result;
+}
+
+// Same as BenchmarkResult.addToTimeFreq(), re-bins the histogram of summary.
+void addToTimeFreq(const InferenceSummary& summary, float startSec,
+                   float stepSec, std::vector<float>* timeFreqSec) {
+  const LatencyHistogram& histogram = summary.computeTime.histogram();
+  for (int i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+    if (histogram.bucketCount(i) == 0) {
+      continue;
+    }
+    int index = 0;
+    if (stepSec > 0.0f) {
+      const float bucketSec = LatencyHistogram::bucketLowerBound(i) / 1e9;
+      index = static_cast<int>((bucketSec - startSec) / stepSec);
+      index = std::max(0, std::min(CsvResult::kTimeFreqBuckets - 1, index));
+    }
+    (*timeFreqSec)[index] += histogram.bucketCount(i);
+  }
+}
+
+float meanSec(const InferenceSummary& summary) {
+  return summary.computeTime.meanSec();
+}
+
+float p90Sec(const InferenceSummary& summary) {
+  return summary.computeTime.percentileSec(0.9);
+}
+
+// Index of the summary with the lowest mean latency.
+int fastest(const std::vector<InferenceSummary>& summaries) {
+  int best = 0;
+  for (int k = 1; k < summaries.size(); ++k) {
+    if (meanSec(summaries[k]) < meanSec(summaries[best])) {
+      best = k;
+    }
+  }
+  return best;
+}
+
+// Same as OpenLoopSummary.isSustained().
+bool isSustained(const OpenLoopSummary& summary) {
+  return summary.dropped == 0 &&
+         summary.throughput >= 0.95f * summary.arrivalRate;
+}
+
+}  // namespace
+
+CsvResult CsvResult::fromInferenceSummary(
+    const std::string& testInfo, const std::string& backendType,
+    int testSetSize, const InferenceSummary& summary,
+    const std::vector<std::string>& keys, const std::vector<float>& values) {
+  const LatencyStats& computeTime = summary.computeTime;
+  CsvResult result;
+  result.testInfo = testInfo;
+  result.backendType = backendType;
+  result.iterations = computeTime.count();
+  result.totalTimeSec = computeTime.totalSec();
+  result.maxSingleError = summary.maxSingleError;
+  result.testSetSize = testSetSize;
+  result.evaluatorKeys = keys;
+  result.evaluatorValues = values;
+  result.timeFreqStartSec = computeTime.minSec();
+  result.timeFreqStepSec =
+      (computeTime.maxSec() - computeTime.minSec()) / (kTimeFreqBuckets - 1);
+  result.timeFreqSec.assign(kTimeFreqBuckets, 0.0f);
+  addToTimeFreq(summary, result.timeFreqStartSec, result.timeFreqStepSec,
+                &result.timeFreqSec);
+  result.p50TimeSec = computeTime.percentileSec(0.5);
+  result.p90TimeSec = computeTime.percentileSec(0.9);
+  result.p95TimeSec = computeTime.percentileSec(0.95);
+  result.p99TimeSec = computeTime.percentileSec(0.99);
+  result.maxTimeSec = computeTime.maxSec();
+  result.hasStepLatencies = true;
+  result.firstStepCount = summary.firstStepTime.count();
+  result.firstStepMeanTimeSec = summary.firstStepTime.meanSec();
+  result.firstStepP99TimeSec = summary.firstStepTime.percentileSec(0.99);
+  result.laterStepCount = summary.laterStepTime.count();
+  result.laterStepMeanTimeSec = summary.laterStepTime.meanSec();
+  result.laterStepP99TimeSec = summary.laterStepTime.percentileSec(0.99);
+  result.resetCount = summary.resetTime.count();
+  result.resetMeanTimeSec = summary.resetTime.meanSec();
+  result.latencyHistogram = computeTime.histogram();
+  return result;
+}
+
+CsvResult CsvResult::fromThreadSweepSummaries(
+    const std::string& testInfo, const std::string& backendType,
+    int testSetSize, const std::vector<InferenceSummary>& summaries) {
+  const int best = fastest(summaries);
+  std::vector<std::string> keys = {"best_threads"};
+  std::vector<float> values = {static_cast<float>(best + 1)};
+  for (int n = 0; n < summaries.size(); ++n) {
+    const std::string prefix = "threads_" + std::to_string(n + 1);
+    keys.push_back(prefix + "_mean");
+    values.push_back(meanSec(summaries[n]));
+    keys.push_back(prefix + "_p90");
+    values.push_back(p90Sec(summaries[n]));
+    keys.push_back(prefix + "_speedup");
+    values.push_back(meanSec(summaries[n]) > 0.0f
+                         ? meanSec(summaries[0]) / meanSec(summaries[n])
+                         : 0.0f);
+  }
+  return fromInferenceSummary(testInfo, backendType, testSetSize,
+                              summaries[best], keys, values);
+}
+
+CsvResult CsvResult::fromExecutionModeSummaries(
+    const std::string& testInfo, const std::string& backendType,
+    int testSetSize, const std::vector<int>& modes,
+    const std::vector<InferenceSummary>& summaries) {
+  std::vector<std::string> keys;
+  std::vector<float> values;
+  const int modesCount = modes.size();
+  const int rounds = summaries.size() / modesCount - 1;
+  for (int k = 0; k < modesCount; ++k) {
+    const std::string prefix =
+        modes[k] == EXECUTION_MODE_BURST ? "burst" : "sync";
+    keys.push_back(prefix + "_mean");
+    values.push_back(meanSec(summaries[k]));
+    keys.push_back(prefix + "_p50");
+    values.push_back(summaries[k].computeTime.percentileSec(0.5));
+    keys.push_back(prefix + "_p90");
+    values.push_back(p90Sec(summaries[k]));
+    // Differences within a round, the drift between rounds cancels out.
+    float sumDelta = 0.0f;
+    float minDelta = std::numeric_limits<float>::max();
+    float maxDelta = std::numeric_limits<float>::lowest();
+    for (int r = 0; r < rounds; ++r) {
+      const int round = (1 + r) * modesCount;
+      const float delta =
+          meanSec(summaries[round + k]) - meanSec(summaries[round]);
+      sumDelta += delta;
+      minDelta = std::min(minDelta, delta);
+      maxDelta = std::max(maxDelta, delta);
+    }
+    keys.push_back(prefix + "_overhead_delta");
+    values.push_back(rounds > 0 ? sumDelta / rounds : 0.0f);
+    keys.push_back(prefix + "_overhead_delta_min");
+    values.push_back(rounds > 0 ? minDelta : 0.0f);
+    keys.push_back(prefix + "_overhead_delta_max");
+    values.push_back(rounds > 0 ? maxDelta : 0.0f);
+  }
+  return fromInferenceSummary(testInfo, backendType, testSetSize, summaries[0],
+                              keys, values);
+}
+
+CsvResult CsvResult::fromBatchSweepSummaries(
+    const std::string& testInfo, const std::string& backendType,
+    int testSetSize, const std::vector<int>& batchSizes,
+    const std::vector<InferenceSummary>& summaries) {
+  std::vector<float> samplesPerSec(summaries.size());
+  int best = 0;
+  for (int b = 0; b < summaries.size(); ++b) {
+    const LatencyStats& computeTime = summaries[b].computeTime;
+    samplesPerSec[b] = computeTime.totalSec() > 0.0
+                           ? batchSizes[b] * computeTime.count() /
+                                 computeTime.totalSec()
+                           : 0.0f;
+    if (samplesPerSec[b] > samplesPerSec[best]) {
+      best = b;
+    }
+  }
+
+  std::vector<std::string> keys = {"best_batch"};
+  std::vector<float> values = {static_cast<float>(batchSizes[best])};
+  for (int b = 0; b < summaries.size(); ++b) {
+    const std::string prefix = "batch_" + std::to_string(batchSizes[b]);
+    keys.push_back(prefix + "_sample_latency");
+    values.push_back(meanSec(summaries[b]) / batchSizes[b]);
+    keys.push_back(prefix + "_samples_per_sec");
+    values.push_back(samplesPerSec[b]);
+  }
+  return fromInferenceSummary(testInfo, backendType, testSetSize,
+                              summaries[best], keys, values);
+}
+
+CsvResult CsvResult::fromConcurrentInferenceSummaries(
+    const std::string& testInfo, const std::string& backendType,
+    int testSetSize, const std::vector<InferenceSummary>& summaries) {
+  CsvResult result;
+  result.testInfo = testInfo;
+  result.backendType = backendType;
+  result.testSetSize = testSetSize;
+  float minTime = std::numeric_limits<float>::max();
+  float maxTime = 0.0f;
+  double wallTime = 0.0;
+  for (const InferenceSummary& summary : summaries) {
+    result.iterations += summary.computeTime.count();
+    result.totalTimeSec += summary.computeTime.totalSec();
+    result.maxSingleError =
+        std::max(result.maxSingleError, summary.maxSingleError);
+    minTime = std::min(minTime, summary.computeTime.minSec());
+    maxTime = std::max(maxTime, summary.computeTime.maxSec());
+    wallTime = std::max(wallTime, summary.wallTimeSec);
+  }
+
+  result.timeFreqStartSec = minTime;
+  result.timeFreqStepSec = (maxTime - minTime) / (kTimeFreqBuckets - 1);
+  result.timeFreqSec.assign(kTimeFreqBuckets, 0.0f);
+  for (const InferenceSummary& summary : summaries) {
+    addToTimeFreq(summary, minTime, result.timeFreqStepSec,
+                  &result.timeFreqSec);
+    result.latencyHistogram.merge(summary.computeTime.histogram());
+  }
+
+  result.evaluatorKeys = {"concurrent_threads", "throughput_per_sec"};
+  result.evaluatorValues = {
+      static_cast<float>(summaries.size()),
+      wallTime > 0.0 ? static_cast<float>(result.iterations / wallTime)
+                     : 0.0f};
+  for (int k = 0; k < summaries.size(); ++k) {
+    const LatencyStats& computeTime = summaries[k].computeTime;
+    const std::string prefix = "thread_" + std::to_string(k);
+    result.evaluatorKeys.push_back(prefix + "_mean");
+    result.evaluatorValues.push_back(computeTime.meanSec());
+    result.evaluatorKeys.push_back(prefix + "_p90");
+    result.evaluatorValues.push_back(computeTime.percentileSec(0.9));
+    result.evaluatorKeys.push_back(prefix + "_p99");
+    result.evaluatorValues.push_back(computeTime.percentileSec(0.99));
+    result.evaluatorKeys.push_back(prefix + "_max");
+    result.evaluatorValues.push_back(computeTime.maxSec());
+  }
+  return result;
+}
+
+CsvResult CsvResult::fromOpenLoopSummaries(
+    const std::string& testInfo, const std::string& backendType,
+    int testSetSize, const std::vector<OpenLoopSummary>& summaries) {
+  int best = -1;
+  for (int k = 0; k < summaries.size(); ++k) {
+    if (isSustained(summaries[k]) &&
+        (best < 0 || summaries[k].arrivalRate > summaries[best].arrivalRate)) {
+      best = k;
+    }
+  }
+
+  std::vector<std::string> keys = {"max_sustained_rate"};
+  std::vector<float> values = {best >= 0 ? summaries[best].arrivalRate : 0.0f};
+  for (const OpenLoopSummary& summary : summaries) {
+    const std::string prefix = "rate_" + formatFloat(summary.arrivalRate);
+    keys.push_back(prefix + "_throughput");
+    values.push_back(summary.throughput);
+    keys.push_back(prefix + "_queue_mean");
+    values.push_back(summary.queueTime.meanSec());
+    keys.push_back(prefix + "_queue_p99");
+    values.push_back(summary.queueTime.percentileSec(0.99));
+    keys.push_back(prefix + "_response_p50");
+    values.push_back(summary.responseTime.percentileSec(0.5));
+    keys.push_back(prefix + "_response_p90");
+    values.push_back(summary.responseTime.percentileSec(0.9));
+    keys.push_back(prefix + "_response_p99");
+    values.push_back(summary.responseTime.percentileSec(0.99));
+    keys.push_back(prefix + "_dropped");
+    values.push_back(summary.dropped);
+  }
+  return fromInferenceSummary(testInfo, backendType, testSetSize,
+                              summaries[std::max(best, 0)].service, keys,
+                              values);
+}
+
+std::string CsvResult::toCsvLine() const {
+  std::string line = testInfo + "," + backendType + "," +
+                     std::to_string(iterations) + "," +
+                     formatFloat(totalTimeSec) + "," +
+                     formatFloat(maxSingleError) + "," +
+                     std::to_string(testSetSize) + "," +
+                     formatFloat(timeFreqStartSec) + "," +
+                     formatFloat(timeFreqStepSec) + "," +
+                     std::to_string(evaluatorKeys.size()) + "," +
+                     std::to_string(timeFreqSec.size()) + "," +
+                     std::to_string(validationErrors.size());
+  for (const std::string& key : evaluatorKeys) {
+    line += "," + key;
+  }
+  for (float value : evaluatorValues) {
+    line += "," + formatFloat(value);
+  }
+  for (float value : timeFreqSec) {
+    line += "," + formatFloat(value);
+  }
+  for (std::string validationError : validationErrors) {
+    std::replace(validationError.begin(), validationError.end(), ',', ' ');
+    line += "," + validationError;
+  }
+  for (float value :
+       {p50TimeSec, p90TimeSec, p95TimeSec, p99TimeSec, maxTimeSec}) {
+    line += "," + formatFloat(value);
+  }
+
+  // Same order as MemoryProfile.toCsvValues().
+  const MemoryProfile& m = memoryProfile;
+  for (long long value :
+       {m.arenaBytes, m.beforeCreate.rssKb, m.beforeCreate.pssKb,
+        m.beforeCreate.heapBytes, m.afterCreate.rssKb, m.afterCreate.pssKb,
+        m.afterCreate.heapBytes, m.afterFirstInference.rssKb,
+        m.afterFirstInference.pssKb, m.afterFirstInference.heapBytes,
+        m.steadyState.rssKb, m.steadyState.pssKb, m.steadyState.heapBytes,
+        m.peakHeapBytes, m.peakRssKb}) {
+    line += "," + std::to_string(hasMemoryProfile ? value : -1);
+  }
+
+  // Same order as StepLatencies.toCsvValues().
+  for (float value :
+       {static_cast<float>(firstStepCount), firstStepMeanTimeSec,
+        firstStepP99TimeSec, static_cast<float>(laterStepCount),
+        laterStepMeanTimeSec, laterStepP99TimeSec,
+        static_cast<float>(resetCount), resetMeanTimeSec}) {
+    line += "," + formatFloat(hasStepLatencies ? value : -1.0f);
+  }
+
+  // Same order as ConvergenceStatus.toCsvValues().
+  const ConvergenceStatus& c = convergenceStatus;
+  for (float value : {c.converged ? 1.0f : 0.0f, c.estimateSec,
+                      c.relativeWidth}) {
+    line += "," + formatFloat(hasConvergenceStatus ? value : -1.0f);
+  }
+
+  // Same as LatencyHistogram in java, bucket lower bounds in seconds.
+  std::string histogramLine;
+  int histogramBuckets = 0;
+  for (int i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+    if (latencyHistogram.bucketCount(i) == 0) {
+      continue;
+    }
+    ++histogramBuckets;
+    histogramLine +=
+        "," + formatFloat(LatencyHistogram::bucketLowerBound(i) / 1e9) + "," +
+        std::to_string(latencyHistogram.bucketCount(i));
+  }
+  line += "," + std::to_string(histogramBuckets) + histogramLine;
+  line += "\n";
+  return line;
+}
+
+std::string csvHeader() {
+  char date[32];
+  const time_t now = time(nullptr);
+  struct tm local;
+  localtime_r(&now, &local);
+  strftime(date, sizeof(date), "%Y%m%d_%H%M%S", &local);
+  // Build.DISPLAY
+  char display[PROP_VALUE_MAX] = "";
+  __system_property_get("ro.build.display.id", display);
+  return std::string(date) + "," + display + "\n" + kResultFormatComment +
+         "\n";
+}
@@ -0,0 +1,107 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_CSV_RESULT_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_CSV_RESULT_H
+
+#include "run_tflite.h"
+
+#include <string>
+#include <vector>
+
+// Backend names of the result lines, same as BenchmarkResult.BACKEND_*.
+extern const char kBackendTfliteNnapi[];
+extern const char kBackendTfliteCpu[];
+
+// One benchmark result in the CSV schema of
+// com.android.nn.benchmark.util.CSVWriter, for producing results without the
+// Java harness. The fromX() builders mirror the BenchmarkResult builders of
+// the same name, so results/generate_result.py can't tell the two apart.
+struct CsvResult {
+  // Buckets of the latency histogram of a result line, same as
+  // BenchmarkResult.TIME_FREQ_ARRAY_SIZE.
+  static constexpr int kTimeFreqBuckets = 32;
+
+  std::string testInfo;
+  std::string backendType;
+  int iterations = 0;
+  float totalTimeSec = 0.0f;
+  float maxSingleError = 0.0f;
+  int testSetSize = 0;
+  std::vector<std::string> evaluatorKeys;
+  std::vector<float> evaluatorValues;
+  float timeFreqStartSec = 0.0f;
+  float timeFreqStepSec = 0.0f;
+  std::vector<float> timeFreqSec;
+  std::vector<std::string> validationErrors;
+  // 0 when not measured, like BenchmarkResult.
+  float p50TimeSec = 0.0f;
+  float p90TimeSec = 0.0f;
+  float p95TimeSec = 0.0f;
+  float p99TimeSec = 0.0f;
+  float maxTimeSec = 0.0f;
+  // Memory columns are -1 without one.
+  bool hasMemoryProfile = false;
+  MemoryProfile memoryProfile;
+  // Same as StepLatencies, from the first/later step and reset statistics of
+  // InferenceSummary. Columns are -1 for results without them.
+  bool hasStepLatencies = false;
+  int firstStepCount = 0;
+  float firstStepMeanTimeSec = 0.0f;
+  float firstStepP99TimeSec = 0.0f;
+  int laterStepCount = 0;
+  float laterStepMeanTimeSec = 0.0f;
+  float laterStepP99TimeSec = 0.0f;
+  int resetCount = 0;
+  float resetMeanTimeSec = 0.0f;
+  // Same as ConvergenceStatus, columns are -1 for fixed time or size runs.
+  bool hasConvergenceStatus = false;
+  ConvergenceStatus convergenceStatus;
+  // Same as BenchmarkResult.mLatencyHistogram, only its non-empty buckets
+  // are written. Empty for results without per-inference latencies.
+  LatencyHistogram latencyHistogram;
+
+  static CsvResult fromInferenceSummary(
+      const std::string& testInfo, const std::string& backendType,
+      int testSetSize, const InferenceSummary& summary,
+      const std::vector<std::string>& keys, const std::vector<float>& values);
+  static CsvResult fromThreadSweepSummaries(
+      const std::string& testInfo, const std::string& backendType,
+      int testSetSize, const std::vector<InferenceSummary>& summaries);
+  static CsvResult fromExecutionModeSummaries(
+      const std::string& testInfo, const std::string& backendType,
+      int testSetSize, const std::vector<int>& modes,
+      const std::vector<InferenceSummary>& summaries);
+  static CsvResult fromBatchSweepSummaries(
+      const std::string& testInfo, const std::string& backendType,
+      int testSetSize, const std::vector<int>& batchSizes,
+      const std::vector<InferenceSummary>& summaries);
+  static CsvResult fromConcurrentInferenceSummaries(
+      const std::string& testInfo, const std::string& backendType,
+      int testSetSize, const std::vector<InferenceSummary>& summaries);
+  static CsvResult fromOpenLoopSummaries(
+      const std::string& testInfo, const std::string& backendType,
+      int testSetSize, const std::vector<OpenLoopSummary>& summaries);
+
+  // Same as BenchmarkResult.toCsvLine(), newline terminated.
+  std::string toCsvLine() const;
+};
+
+// Device info line and format comment written by CSVWriter.writeHeader().
+std::string csvHeader();
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_CSV_RESULT_H
@@ -0,0 +1,211 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "image_preprocessor.h"
+
+#include <android/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define LOG_TAG "NN_BENCHMARK"
+
+namespace {
+
+// Bilinear source sample of an output coordinate, pixel centers aligned.
+struct Sample {
+  int index0;
+  int index1;
+  float weight1;
+};
+
+std::vector<Sample> bilinearSamples(int inputSize, int outputSize) {
+  std::vector<Sample> samples(outputSize);
+  const float scale = static_cast<float>(inputSize) / outputSize;
+  for (int i = 0; i < outputSize; ++i) {
+    float position = std::max(0.f, (i + 0.5f) * scale - 0.5f);
+    int index0 = std::min(static_cast<int>(position), inputSize - 1);
+    samples[i].index0 = index0;
+    samples[i].index1 = std::min(index0 + 1, inputSize - 1);
+    samples[i].weight1 = position - index0;
+  }
+  return samples;
+}
+
+// Vertical interpolation of count RGBA pixels of two rows into 4 floats per
+// pixel.
+void interpolateRows(const uint8_t* row0, const uint8_t* row1, float weight1,
+                     int count, float* out) {
+  int i = 0;
+#if defined(__aarch64__)
+  const float32x4_t weight = vdupq_n_f32(weight1);
+  for (; i + 4 <= count; i += 4) {
+    uint8x16_t pixels0 = vld1q_u8(row0 + i * 4);
+    uint8x16_t pixels1 = vld1q_u8(row1 + i * 4);
+    uint16x8_t wide0[2] = {vmovl_u8(vget_low_u8(pixels0)),
+                           vmovl_high_u8(pixels0)};
+    uint16x8_t wide1[2] = {vmovl_u8(vget_low_u8(pixels1)),
+                           vmovl_high_u8(pixels1)};
+    for (int half = 0; half < 2; ++half) {
+      float32x4_t low0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide0[half])));
+      float32x4_t high0 = vcvtq_f32_u32(vmovl_high_u16(wide0[half]));
+      float32x4_t low1 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide1[half])));
+      float32x4_t high1 = vcvtq_f32_u32(vmovl_high_u16(wide1[half]));
+      float* pixelOut = out + (i + half * 2) * 4;
+      vst1q_f32(pixelOut, vfmaq_f32(low0, vsubq_f32(low1, low0), weight));
+      vst1q_f32(pixelOut + 4,
+                vfmaq_f32(high0, vsubq_f32(high1, high0), weight));
+    }
+  }
+#endif
+  for (int k = i * 4; k < count * 4; ++k) {
+    float value0 = row0[k];
+    out[k] = value0 + (row1[k] - value0) * weight1;
+  }
+}
+
+// Horizontal interpolation and normalization of one output row. Every value
+// v becomes v * multiplier + offset.
+void writeFloatRow(const float* row, const std::vector<Sample>& samples,
+                   float multiplier, float offset, float* out) {
+  const int count = samples.size();
+  int i = 0;
+#if defined(__aarch64__)
+  const float32x4_t multiplierVec = vdupq_n_f32(multiplier);
+  const float32x4_t offsetVec = vdupq_n_f32(offset);
+  // The 4th lane of every pixel is overwritten by the next one, the last
+  // pixel is left to the scalar loop.
+  for (; i + 1 < count; ++i) {
+    float32x4_t pixel0 = vld1q_f32(row + samples[i].index0 * 4);
+    float32x4_t pixel1 = vld1q_f32(row + samples[i].index1 * 4);
+    float32x4_t pixel = vfmaq_n_f32(pixel0, vsubq_f32(pixel1, pixel0),
+                                    samples[i].weight1);
+    vst1q_f32(out + i * 3, vfmaq_f32(offsetVec, pixel, multiplierVec));
+  }
+#endif
+  for (; i < count; ++i) {
+    const float* pixel0 = row + samples[i].index0 * 4;
+    const float* pixel1 = row + samples[i].index1 * 4;
+    for (int c = 0; c < 3; ++c) {
+      float value = pixel0[c] + (pixel1[c] - pixel0[c]) * samples[i].weight1;
+      out[i * 3 + c] = value * multiplier + offset;
+    }
+  }
+}
+
+void writeQuantizedRow(const float* row, const std::vector<Sample>& samples,
+                       float multiplier, float offset, uint8_t* out) {
+  const int count = samples.size();
+  int i = 0;
+#if defined(__aarch64__)
+  const float32x4_t multiplierVec = vdupq_n_f32(multiplier);
+  const float32x4_t offsetVec = vdupq_n_f32(offset);
+  const int32x4_t zero = vdupq_n_s32(0);
+  const int32x4_t max = vdupq_n_s32(255);
+  for (; i < count; ++i) {
+    float32x4_t pixel0 = vld1q_f32(row + samples[i].index0 * 4);
+    float32x4_t pixel1 = vld1q_f32(row + samples[i].index1 * 4);
+    float32x4_t pixel = vfmaq_n_f32(pixel0, vsubq_f32(pixel1, pixel0),
+                                    samples[i].weight1);
+    int32x4_t quantized = vminq_s32(
+        vmaxq_s32(vcvtq_s32_f32(vfmaq_f32(offsetVec, pixel, multiplierVec)),
+                  zero),
+        max);
+    uint16x4_t narrow = vmovn_u32(vreinterpretq_u32_s32(quantized));
+    uint32_t packed = vget_lane_u32(
+        vreinterpret_u32_u8(vmovn_u16(vcombine_u16(narrow, narrow))), 0);
+    out[i * 3] = packed & 0xff;
+    out[i * 3 + 1] = (packed >> 8) & 0xff;
+    out[i * 3 + 2] = (packed >> 16) & 0xff;
+  }
+#endif
+  for (; i < count; ++i) {
+    const float* pixel0 = row + samples[i].index0 * 4;
+    const float* pixel1 = row + samples[i].index1 * 4;
+    for (int c = 0; c < 3; ++c) {
+      float value = pixel0[c] + (pixel1[c] - pixel0[c]) * samples[i].weight1;
+      int quantized = static_cast<int>(value * multiplier + offset);
+      out[i * 3 + c] = static_cast<uint8_t>(std::min(std::max(quantized, 0), 255));
+    }
+  }
+}
+
+}  // namespace
+
+bool preprocessImage(const uint8_t* rgba, int width, int height, int stride,
+                     const ImagePreprocessing& preprocessing, uint8_t* output,
+                     size_t outputLength) {
+  const int outputSize = preprocessing.outputSize;
+  const int cropSize =
+      static_cast<int>(preprocessing.cropFraction * std::min(width, height));
+  if (outputSize <= 0 || cropSize <= 0 || cropSize > std::min(width, height)) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Can't crop %dx%d image to %d for size %d", width,
+                        height, cropSize, outputSize);
+    return false;
+  }
+  const bool quantized = preprocessing.dataSize == 1;
+  if (!quantized && preprocessing.dataSize != 4) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Unsupported preprocessing data size %d",
+                        preprocessing.dataSize);
+    return false;
+  }
+  const size_t rowValues = static_cast<size_t>(outputSize) * 3;
+  if (outputLength < rowValues * outputSize * preprocessing.dataSize) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Preprocessing output too small: %zu bytes",
+                        outputLength);
+    return false;
+  }
+
+  // Same centered crop as the Java Inception preprocessor.
+  const int cropX = width / 2 - cropSize / 2;
+  const int cropY = height / 2 - cropSize / 2;
+  const std::vector<Sample> xSamples = bilinearSamples(cropSize, outputSize);
+  const std::vector<Sample> ySamples = bilinearSamples(cropSize, outputSize);
+
+  // Normalization and quantization folded into one multiply-add.
+  float multiplier = 1.f / preprocessing.std;
+  float offset = -preprocessing.mean / preprocessing.std;
+  if (quantized) {
+    multiplier /= preprocessing.quantScale;
+    offset = offset / preprocessing.quantScale + preprocessing.quantZeroPoint;
+  }
+
+  std::vector<float> row(static_cast<size_t>(cropSize) * 4);
+  for (int y = 0; y < outputSize; ++y) {
+    const Sample& sample = ySamples[y];
+    const uint8_t* row0 =
+        rgba + static_cast<size_t>(cropY + sample.index0) * stride + cropX * 4;
+    const uint8_t* row1 =
+        rgba + static_cast<size_t>(cropY + sample.index1) * stride + cropX * 4;
+    interpolateRows(row0, row1, sample.weight1, cropSize, row.data());
+    if (quantized) {
+      writeQuantizedRow(row.data(), xSamples, multiplier, offset,
+                        output + y * rowValues);
+    } else {
+      writeFloatRow(row.data(), xSamples, multiplier, offset,
+                    reinterpret_cast<float*>(output) + y * rowValues);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,49 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_IMAGE_PREPROCESSOR_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_IMAGE_PREPROCESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// How a decoded image becomes a [1, outputSize, outputSize, 3] input tensor.
+// The defaults are those of the Inception preprocessor.
+struct ImagePreprocessing {
+  // Side of the centered square crop, as a fraction of the smaller image
+  // dimension.
+  float cropFraction = 0.875f;
+  int outputSize = 0;
+  // Pixel values v in [0, 255] become (v - mean) / std.
+  float mean = 127.5f;
+  float std = 127.5f;
+  // 4 for float32 output, 1 for uint8 output quantized with quantScale and
+  // quantZeroPoint.
+  int dataSize = 4;
+  float quantScale = 0.f;
+  float quantZeroPoint = 0.f;
+};
+
+// Crops, bilinearly resizes and normalizes an RGBA_8888 image (stride in
+// bytes) into output, which holds outputSize * outputSize * 3 values.
+// Quantized values are truncated towards zero and saturated to [0, 255].
+// NEON vectorized on aarch64. Returns false if the image can't be cropped or
+// output is too small.
+bool preprocessImage(const uint8_t* rgba, int width, int height, int stride,
+                     const ImagePreprocessing& preprocessing, uint8_t* output,
+                     size_t outputLength);
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_IMAGE_PREPROCESSOR_H
@@ -0,0 +1,143 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input_prefetcher.h"
+
+#include <android/log.h>
+
+#define LOG_TAG "NN_BENCHMARK"
+
+InputPrefetcher::InputPrefetcher(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    int seqInferencesMaxCount, const std::vector<size_t>& inputSizes,
+    int depth) {
+  for (int i = 0; i < depth; ++i) {
+    mSlots.emplace_back(new Slot());
+    Slot* slot = mSlots.back().get();
+    slot->inputs.resize(inputSizes.size());
+    for (int j = 0; j < inputSizes.size(); ++j) {
+      slot->inputs[j].resize(inputSizes[j]);
+    }
+    mFreeSlots.push_back(slot);
+  }
+  mProducer = std::thread(&InputPrefetcher::producerLoop, this,
+                          std::cref(inOutData), seqInferencesMaxCount);
+}
+
+InputPrefetcher::~InputPrefetcher() { stop(); }
+
+bool InputPrefetcher::needed(
+    const std::vector<InferenceInOutSequence>& inOutData) {
+  for (const auto& seq : inOutData) {
+    for (const auto& data : seq) {
+      for (const auto& input : data.inputs) {
+        if (input.ptr == nullptr) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+const InputPrefetcher::Slot* InputPrefetcher::acquire() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mSlotFilled.wait(lock,
+                   [this] { return mProducerDone || !mFilledSlots.empty(); });
+  if (mFilledSlots.empty()) {
+    return nullptr;
+  }
+  Slot* slot = mFilledSlots.front();
+  mFilledSlots.pop_front();
+  return slot;
+}
+
+void InputPrefetcher::release(const Slot* slot) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFreeSlots.push_back(const_cast<Slot*>(slot));
+  }
+  mSlotFreed.notify_one();
+}
+
+void InputPrefetcher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mSlotFreed.notify_one();
+  if (mProducer.joinable()) {
+    mProducer.join();
+  }
+}
+
+void InputPrefetcher::producerLoop(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    int seqInferencesMaxCount) {
+  bool success = true;
+  bool stopped = false;
+  for (int seqInferenceIndex = 0;
+       success && !stopped && seqInferenceIndex < seqInferencesMaxCount;
+       ++seqInferenceIndex) {
+    const InferenceInOutSequence& seq =
+        inOutData[seqInferenceIndex % inOutData.size()];
+    for (int i = 0; success && !stopped && i < seq.size(); ++i) {
+      Slot* slot;
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mSlotFreed.wait(lock,
+                        [this] { return mStopping || !mFreeSlots.empty(); });
+        if (mStopping) {
+          stopped = true;
+          break;
+        }
+        slot = mFreeSlots.front();
+        mFreeSlots.pop_front();
+      }
+
+      slot->data = &seq[i];
+      slot->success = true;
+      const auto& inputs = seq[i].inputs;
+      for (int j = 0; j < inputs.size() && j < slot->inputs.size(); ++j) {
+        if (inputs[j].ptr != nullptr) {
+          continue;
+        }
+        if (!inputs[j].createInput(slot->inputs[j].data(),
+                                   slot->inputs[j].size())) {
+          __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                              "Prefetched input %d creation failed", j);
+          slot->success = false;
+          break;
+        }
+      }
+      // A failed slot is still handed over, so that the inference thread
+      // reports the failure at the right inference.
+      success = slot->success;
+
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFilledSlots.push_back(slot);
+      }
+      mSlotFilled.notify_one();
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mProducerDone = true;
+  }
+  mSlotFilled.notify_one();
+}
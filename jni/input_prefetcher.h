@@ -0,0 +1,78 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_INPUT_PREFETCHER_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_INPUT_PREFETCHER_H
+
+#include "run_tflite.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs the input creators of a benchmark ahead of the inferences. A producer
+// thread walks inOutData in benchmark order (sequence seqInferenceIndex %
+// size, then its inferences in order, for seqInferencesMaxCount sequences)
+// and fills a fixed ring of slots with the created inputs. The inference
+// thread takes the slots in the same order and only copies the inputs into
+// the input tensors. Inputs given as data are not touched.
+class InputPrefetcher {
+ public:
+  struct Slot {
+    // Inference the inputs were created for.
+    const InferenceInOut* data;
+    // Created input contents, empty for inputs given as data.
+    std::vector<std::vector<uint8_t>> inputs;
+    bool success;
+  };
+
+  // Slot buffers are allocated once, from the input tensor sizes. The
+  // producer starts right away.
+  InputPrefetcher(const std::vector<InferenceInOutSequence>& inOutData,
+                  int seqInferencesMaxCount,
+                  const std::vector<size_t>& inputSizes, int depth);
+  ~InputPrefetcher();
+
+  // True if any input of inOutData has to be created.
+  static bool needed(const std::vector<InferenceInOutSequence>& inOutData);
+
+  // Returns the next slot in benchmark order, blocks until it is filled.
+  // Returns nullptr if the producer is done.
+  const Slot* acquire();
+  void release(const Slot* slot);
+  // Stops the producer, remaining slots are dropped.
+  void stop();
+
+ private:
+  void producerLoop(const std::vector<InferenceInOutSequence>& inOutData,
+                    int seqInferencesMaxCount);
+
+  std::vector<std::unique_ptr<Slot>> mSlots;
+
+  std::mutex mMutex;
+  std::condition_variable mSlotFreed;
+  std::condition_variable mSlotFilled;
+  std::deque<Slot*> mFreeSlots;
+  std::deque<Slot*> mFilledSlots;
+  bool mStopping = false;
+  bool mProducerDone = false;
+  std::thread mProducer;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_INPUT_PREFETCHER_H
@@ -0,0 +1,162 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "latency_stats.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() : mBuckets(kBucketCount, 0), mCount(0) {}
+
+int LatencyHistogram::bucketIndex(uint64_t valueNsec) {
+  if (valueNsec < kSubBucketCount) {
+    return static_cast<int>(valueNsec);
+  }
+  int msb = 63 - __builtin_clzll(valueNsec);
+  if (msb > kMaxValueBits) {
+    return kBucketCount - 1;
+  }
+  // valueNsec >> shift is always in [kSubBucketHalfCount, kSubBucketCount).
+  int shift = msb - (kSubBucketBits - 1);
+  return kSubBucketCount + (shift - 1) * kSubBucketHalfCount +
+         static_cast<int>((valueNsec >> shift) - kSubBucketHalfCount);
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(int index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+  int shift = (index - kSubBucketCount) / kSubBucketHalfCount + 1;
+  uint64_t subBucket =
+      (index - kSubBucketCount) % kSubBucketHalfCount + kSubBucketHalfCount;
+  return subBucket << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+  if (index < kSubBucketCount) {
+    return index + 1;
+  }
+  int shift = (index - kSubBucketCount) / kSubBucketHalfCount + 1;
+  return bucketLowerBound(index) + (1ULL << shift);
+}
+
+void LatencyHistogram::add(uint64_t valueNsec) {
+  mBuckets[bucketIndex(valueNsec)]++;
+  mCount++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  for (int i = 0; i < kBucketCount; ++i) {
+    mBuckets[i] += other.mBuckets[i];
+  }
+  mCount += other.mCount;
+}
+
+void LatencyHistogram::clear() {
+  std::fill(mBuckets.begin(), mBuckets.end(), 0);
+  mCount = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+  if (mCount == 0) {
+    return 0;
+  }
+  // Rank of the sample we look for, 1-based.
+  uint64_t rank = static_cast<uint64_t>(std::ceil(q * mCount));
+  rank = std::max<uint64_t>(1, std::min(rank, mCount));
+  uint64_t seen = 0;
+  for (int i = 0; i < kBucketCount; ++i) {
+    seen += mBuckets[i];
+    if (seen >= rank) {
+      return (bucketLowerBound(i) + bucketUpperBound(i) - 1) / 2;
+    }
+  }
+  return bucketLowerBound(kBucketCount - 1);
+}
+
+LatencyStats::LatencyStats() { clear(); }
+
+void LatencyStats::clear() {
+  mCount = 0;
+  mTotal = 0.0;
+  mMean = 0.0;
+  mM2 = 0.0;
+  mMin = FLT_MAX;
+  mMax = 0.0f;
+  mHistogram.clear();
+  mExactSamples.clear();
+}
+
+void LatencyStats::add(float valueSec) {
+  mCount++;
+  mTotal += valueSec;
+  double delta = valueSec - mMean;
+  mMean += delta / mCount;
+  mM2 += delta * (valueSec - mMean);
+  mMin = std::min(mMin, valueSec);
+  mMax = std::max(mMax, valueSec);
+  mHistogram.add(static_cast<uint64_t>(std::max(0.0f, valueSec) * 1e9));
+  if (mCount <= kExactSampleLimit) {
+    mExactSamples.push_back(valueSec);
+  } else if (!mExactSamples.empty()) {
+    std::vector<float>().swap(mExactSamples);
+  }
+}
+
+void LatencyStats::merge(const LatencyStats& other) {
+  if (other.mCount == 0) {
+    return;
+  }
+  const uint64_t count = mCount + other.mCount;
+  // Chan et al. pairwise update of Welford's state.
+  const double delta = other.mMean - mMean;
+  mM2 += other.mM2 + delta * delta * mCount * other.mCount / count;
+  mMean += delta * other.mCount / count;
+  mTotal += other.mTotal;
+  mMin = std::min(mMin, other.mMin);
+  mMax = std::max(mMax, other.mMax);
+  mHistogram.merge(other.mHistogram);
+  if (exactPercentiles() && other.exactPercentiles() &&
+      count <= kExactSampleLimit) {
+    mExactSamples.insert(mExactSamples.end(), other.mExactSamples.begin(),
+                         other.mExactSamples.end());
+  } else {
+    std::vector<float>().swap(mExactSamples);
+  }
+  mCount = count;
+}
+
+double LatencyStats::stdDevSec() const {
+  return mCount > 0 ? std::sqrt(mM2 / mCount) : 0.0;
+}
+
+float LatencyStats::percentileSec(double q) const {
+  if (mCount == 0) {
+    return 0.0f;
+  }
+  if (exactPercentiles()) {
+    // Same rank as LatencyHistogram::percentile().
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * mCount));
+    rank = std::max<uint64_t>(1, std::min(rank, mCount));
+    std::vector<float> samples(mExactSamples);
+    std::nth_element(samples.begin(), samples.begin() + (rank - 1),
+                     samples.end());
+    return samples[rank - 1];
+  }
+  float value = static_cast<float>(mHistogram.percentile(q) / 1e9);
+  return std::max(mMin, std::min(mMax, value));
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_LATENCY_STATS_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_LATENCY_STATS_H
+
+#include <cstdint>
+#include <vector>
+
+// Fixed-memory latency histogram with log-linear buckets (HDR histogram
+// style). Values below kSubBucketCount nanoseconds get exact buckets, above
+// that every power of two range is split into kSubBucketCount / 2 linear
+// buckets, which bounds the relative error of a bucket to ~1.6%.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 7;
+  static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+  static constexpr int kSubBucketHalfCount = kSubBucketCount / 2;
+  // Largest tracked value is 2^kMaxValueBits nsec (~18 minutes), anything
+  // above is clamped into the last bucket.
+  static constexpr int kMaxValueBits = 40;
+  static constexpr int kBucketCount =
+      kSubBucketCount +
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBucketHalfCount;
+
+  LatencyHistogram();
+
+  void add(uint64_t valueNsec);
+  // Adds all values of other.
+  void merge(const LatencyHistogram& other);
+  void clear();
+
+  uint64_t count() const { return mCount; }
+  // Value at quantile q (0.0 - 1.0), mid-point of the matching bucket.
+  uint64_t percentile(double q) const;
+
+  // Bucket iteration, used to export the histogram.
+  uint64_t bucketCount(int index) const { return mBuckets[index]; }
+  static uint64_t bucketLowerBound(int index);
+  static uint64_t bucketUpperBound(int index);
+  static int bucketIndex(uint64_t valueNsec);
+
+ private:
+  std::vector<uint64_t> mBuckets;
+  uint64_t mCount;
+};
+
+// Running latency statistics, constant memory regardless of sample count.
+// The first kExactSampleLimit samples are also kept as they are, so that
+// percentiles of short runs are exact instead of histogram bucket mid-points.
+class LatencyStats {
+ public:
+  static constexpr uint64_t kExactSampleLimit = 4096;
+
+  LatencyStats();
+
+  void add(float valueSec);
+  // Adds all samples of other, as if they had been added one by one (but
+  // for rounding). Percentiles remain exact if both are.
+  void merge(const LatencyStats& other);
+  void clear();
+
+  uint64_t count() const { return mCount; }
+  double totalSec() const { return mTotal; }
+  double meanSec() const { return mMean; }
+  // Population standard deviation, same as BenchmarkResult.fromInferenceResults.
+  double stdDevSec() const;
+  float minSec() const { return mCount > 0 ? mMin : 0.0f; }
+  float maxSec() const { return mMax; }
+  // Value at quantile q (0.0 - 1.0), nearest rank. Exact up to
+  // kExactSampleLimit samples, from the histogram (clamped to the observed
+  // min/max) above that.
+  float percentileSec(double q) const;
+  bool exactPercentiles() const { return mCount <= kExactSampleLimit; }
+
+  const LatencyHistogram& histogram() const { return mHistogram; }
+
+ private:
+  uint64_t mCount;
+  double mTotal;
+  // Welford's online algorithm state.
+  double mMean;
+  double mM2;
+  float mMin;
+  float mMax;
+  LatencyHistogram mHistogram;
+  // Dropped once the limit is exceeded.
+  std::vector<float> mExactSamples;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_LATENCY_STATS_H
@@ -0,0 +1,155 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mapped_dataset.h"
+
+#include <android/log.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+
+#define LOG_TAG "NN_BENCHMARK"
+
+namespace {
+
+const char kMagic[4] = {'N', 'N', 'B', 'D'};
+const uint32_t kVersion = 1;
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t sequencesCount;
+  uint32_t inputsCount;
+  uint32_t outputsCount;
+  uint32_t inferencesCount;
+};
+
+struct BlobEntry {
+  uint64_t offset;
+  uint64_t size;
+};
+
+}  // namespace
+
+std::unique_ptr<MappedDataset> MappedDataset::open(const char* path) {
+  std::unique_ptr<MappedDataset> dataset(new MappedDataset());
+  if (!dataset->init(path)) {
+    return nullptr;
+  }
+  return dataset;
+}
+
+MappedDataset::~MappedDataset() {
+  if (mMapping != nullptr) {
+    munmap(mMapping, mMappingSize);
+  }
+}
+
+bool MappedDataset::init(const char* path) {
+  int fd = ::open(path, O_RDONLY);
+  if (fd == -1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open dataset %s",
+                        path);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  mMappingSize = st.st_size;
+  void* mapping = mMappingSize > 0
+      ? mmap(nullptr, mMappingSize, PROT_READ, MAP_PRIVATE, fd, 0)
+      : MAP_FAILED;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to map dataset %s",
+                        path);
+    return false;
+  }
+  mMapping = static_cast<uint8_t*>(mapping);
+
+  Header header;
+  if (mMappingSize < sizeof(header)) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Truncated dataset %s",
+                        path);
+    return false;
+  }
+  memcpy(&header, mMapping, sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Unsupported dataset format %s", path);
+    return false;
+  }
+
+  const uint64_t blobsPerInference =
+      static_cast<uint64_t>(header.inputsCount) + header.outputsCount;
+  const uint64_t indexSize =
+      sizeof(header) + sizeof(uint32_t) * uint64_t{header.sequencesCount} +
+      sizeof(BlobEntry) * blobsPerInference * header.inferencesCount;
+  if (indexSize > mMappingSize) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Truncated dataset %s",
+                        path);
+    return false;
+  }
+  const uint8_t* sequenceSizes = mMapping + sizeof(header);
+  const uint8_t* entries =
+      sequenceSizes + sizeof(uint32_t) * header.sequencesCount;
+
+  mOutputsCount = header.outputsCount;
+  mData.resize(header.sequencesCount);
+  uint64_t inferenceIndex = 0;
+  for (uint32_t s = 0; s < header.sequencesCount; ++s) {
+    uint32_t sequenceSize;
+    memcpy(&sequenceSize, sequenceSizes + sizeof(uint32_t) * s,
+           sizeof(sequenceSize));
+    if (inferenceIndex + sequenceSize > header.inferencesCount) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Inconsistent dataset index %s", path);
+      return false;
+    }
+    mData[s].resize(sequenceSize);
+    for (InferenceInOut& inOut : mData[s]) {
+      inOut.inputs.resize(header.inputsCount);
+      inOut.outputs.resize(header.outputsCount);
+      for (uint64_t b = 0; b < blobsPerInference; ++b) {
+        BlobEntry entry;
+        memcpy(&entry,
+               entries + sizeof(BlobEntry) *
+                             (inferenceIndex * blobsPerInference + b),
+               sizeof(entry));
+        if (entry.offset > mMappingSize ||
+            entry.size > mMappingSize - entry.offset) {
+          __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                              "Dataset blob out of bounds %s", path);
+          return false;
+        }
+        uint8_t* ptr = mMapping + entry.offset;
+        if (b < header.inputsCount) {
+          inOut.inputs[b].ptr = ptr;
+          inOut.inputs[b].size = entry.size;
+        } else {
+          inOut.outputs[b - header.inputsCount] = {ptr, entry.size};
+        }
+      }
+      ++inferenceIndex;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,61 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_MAPPED_DATASET_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_MAPPED_DATASET_H
+
+#include "run_tflite.h"
+
+#include <memory>
+#include <vector>
+
+// Binary dataset container, memory mapped read-only so inputs and golden
+// outputs are paged in on demand and can be reclaimed by the kernel, instead
+// of being resident in the Java heap. Written by
+// com.android.nn.benchmark.util.MappedDatasetWriter.
+//
+// Layout, all integers little endian:
+//   char[4] magic "NNBD"
+//   uint32 version (1)
+//   uint32 sequences count
+//   uint32 inputs per inference
+//   uint32 outputs per inference (0 if there are no golden outputs)
+//   uint32 total inferences count
+//   uint32[sequences count] inferences count of every sequence
+//   {uint64 offset, uint64 size}[total inferences][inputs + outputs]
+//     file offset and size of every input, then of every golden output
+//   blobs
+class MappedDataset {
+ public:
+  static std::unique_ptr<MappedDataset> open(const char* path);
+  ~MappedDataset();
+
+  // Inputs and golden outputs point into the mapping, valid as long as the
+  // dataset.
+  const std::vector<InferenceInOutSequence>& data() const { return mData; }
+  bool hasGoldenOutputs() const { return mOutputsCount > 0; }
+
+ private:
+  MappedDataset() = default;
+  bool init(const char* path);
+
+  uint8_t* mMapping = nullptr;
+  size_t mMappingSize = 0;
+  uint32_t mOutputsCount = 0;
+  std::vector<InferenceInOutSequence> mData;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_MAPPED_DATASET_H
@@ -0,0 +1,132 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory_footprint.h"
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Sum of the "<key>: <value> kB" lines of a procfs file, -1 if there are
+// none.
+long long sumProcKb(const char* path, const char* key) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return -1;
+  }
+  const size_t keyLength = strlen(key);
+  long long total = -1;
+  char line[256];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    long long value;
+    if (strncmp(line, key, keyLength) == 0 && line[keyLength] == ':' &&
+        sscanf(line + keyLength + 1, "%lld", &value) == 1) {
+      total = std::max(total, 0LL) + value;
+    }
+  }
+  fclose(file);
+  return total;
+}
+
+long long readRssKb() {
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (file == nullptr) {
+    return -1;
+  }
+  long long sizePages, residentPages;
+  const bool success =
+      fscanf(file, "%lld %lld", &sizePages, &residentPages) == 2;
+  fclose(file);
+  return success ? residentPages * (sysconf(_SC_PAGESIZE) / 1024) : -1;
+}
+
+long long readPssKb() {
+  // smaps_rollup is only there on 4.14+ kernels, summing smaps is slower but
+  // gives the same value.
+  const long long pssKb = sumProcKb("/proc/self/smaps_rollup", "Pss");
+  return pssKb >= 0 ? pssKb : sumProcKb("/proc/self/smaps", "Pss");
+}
+
+// Writing 5 to clear_refs resets VmHWM to the current RSS.
+bool resetPeakRss() {
+  FILE* file = fopen("/proc/self/clear_refs", "w");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool success = fputs("5", file) >= 0;
+  return fclose(file) == 0 && success;
+}
+
+}  // namespace
+
+long long currentHeapBytes() {
+  const struct mallinfo info = mallinfo();
+  return info.uordblks > 0 ? static_cast<long long>(info.uordblks) : -1;
+}
+
+MemorySnapshot MemorySnapshot::take() {
+  MemorySnapshot snapshot;
+  snapshot.rssKb = readRssKb();
+  snapshot.pssKb = readPssKb();
+  snapshot.heapBytes = currentHeapBytes();
+  return snapshot;
+}
+
+MemoryWatermark::MemoryWatermark(bool sampleHeap)
+    : mPeakHeapBytes(currentHeapBytes()) {
+  mPeakRssReset = resetPeakRss();
+  if (sampleHeap) {
+    mThread = std::thread(&MemoryWatermark::sampleLoop, this);
+  }
+}
+
+MemoryWatermark::~MemoryWatermark() {
+  long long peakHeapBytes, peakRssKb;
+  stop(&peakHeapBytes, &peakRssKb);
+}
+
+void MemoryWatermark::stop(long long* peakHeapBytes, long long* peakRssKb) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mStopRequested.notify_one();
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+  const long long heapBytes = currentHeapBytes();
+  *peakHeapBytes = heapBytes >= 0 ? std::max(mPeakHeapBytes.load(), heapBytes)
+                                  : -1;
+  *peakRssKb = mPeakRssReset ? sumProcKb("/proc/self/status", "VmHWM") : -1;
+}
+
+void MemoryWatermark::sampleLoop() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (!mStopRequested.wait_for(
+      lock, std::chrono::milliseconds(kSamplingPeriodMs),
+      [this] { return mStopping; })) {
+    const long long heapBytes = currentHeapBytes();
+    if (heapBytes > mPeakHeapBytes) {
+      mPeakHeapBytes = heapBytes;
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_MEMORY_FOOTPRINT_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_MEMORY_FOOTPRINT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Memory use of the whole process at one point in time, from procfs and the
+// allocator. Values that can't be read are -1.
+struct MemorySnapshot {
+  // Resident set size
+  long long rssKb = -1;
+  // Proportional set size, shared pages split between their users. Reading
+  // it walks every mapping of the process, which takes milliseconds.
+  long long pssKb = -1;
+  // Bytes allocated through malloc and still in use
+  long long heapBytes = -1;
+
+  static MemorySnapshot take();
+};
+
+// Malloc'd bytes in use currently, -1 if the allocator can't tell.
+long long currentHeapBytes();
+
+// High-water marks of the process memory between construction and stop().
+// The peak RSS is the kernel's exact VmHWM, reset at construction through
+// /proc/self/clear_refs, and only reported if that reset is permitted.
+// The heap is read at construction and stop() only, unless sampleHeap is
+// set: a background thread then also reads it every kSamplingPeriodMs. That
+// catches peaks in between, short lived ones can still be missed, but the
+// thread competes with the benchmark for the CPU and the allocator lock.
+class MemoryWatermark {
+ public:
+  static constexpr int kSamplingPeriodMs = 2;
+
+  explicit MemoryWatermark(bool sampleHeap);
+  ~MemoryWatermark();
+
+  // Stops sampling and returns the peaks, -1 if they couldn't be measured.
+  void stop(long long* peakHeapBytes, long long* peakRssKb);
+
+ private:
+  void sampleLoop();
+
+  std::mutex mMutex;
+  std::condition_variable mStopRequested;
+  bool mStopping = false;
+  bool mPeakRssReset = false;
+  std::atomic<long long> mPeakHeapBytes;
+  std::thread mThread;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_MEMORY_FOOTPRINT_H
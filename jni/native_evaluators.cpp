@@ -0,0 +1,445 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "native_evaluators.h"
+
+#include <android/log.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#define LOG_TAG "NN_BENCHMARK"
+
+namespace {
+
+// Reads float32 or uint8 values as floats, like IOUtils.readFloats() in Java.
+bool readFloats(TfLiteType type, const uint8_t* data, size_t bytes,
+                std::vector<float>* values) {
+  if (type == kTfLiteFloat32) {
+    values->resize(bytes / sizeof(float));
+    memcpy(values->data(), data, values->size() * sizeof(float));
+    return true;
+  }
+  if (type == kTfLiteUInt8) {
+    values->assign(data, data + bytes);
+    return true;
+  }
+  __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                      "Unsupported evaluator output type %d", (int)type);
+  return false;
+}
+
+std::string formatValue(const char* message, float value) {
+  char buffer[128];
+  snprintf(buffer, sizeof(buffer), "%s%g", message, value);
+  return buffer;
+}
+
+// Top-k accuracy of a classifier, see evaluators/TopK.java.
+class TopKEvaluator : public NativeEvaluator {
+ public:
+  explicit TopKEvaluator(const NativeEvaluatorConfig& config)
+      : mTargetOutputIndex(config.targetOutputIndex),
+        mExpectedTop1(config.expectedTop1) {}
+
+  void reset() override {
+    mTotal = 0;
+    std::fill(mTopK, mTopK + kTopK, 0);
+  }
+
+  bool add(const InferenceInOut& data, int inputOutputIndex,
+           int sequenceLength,
+           const std::vector<EvaluatorOutput>& outputs) override {
+    if (sequenceLength != 1 || inputOutputIndex != 0) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Only one item in InferenceInOutSequence supported "
+                          "by TopK evaluator");
+      return false;
+    }
+    if (data.expectedClass < 0) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "TopK expected class not set");
+      return false;
+    }
+    if (mTargetOutputIndex >= outputs.size()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "TopK output %d out of range", mTargetOutputIndex);
+      return false;
+    }
+    const EvaluatorOutput& output = outputs[mTargetOutputIndex];
+    if (!readFloats(output.type, output.data, output.bytes, &mProbabilities)) {
+      return false;
+    }
+    if (data.expectedClass >= mProbabilities.size()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "TopK expected class %d out of range",
+                          data.expectedClass);
+      return false;
+    }
+
+    // The rank of the expected class is all that matters, no need to sort.
+    // Ties rank the lower class index first.
+    const float expected = mProbabilities[data.expectedClass];
+    int rank = 0;
+    for (int i = 0; i < mProbabilities.size() && rank < kTopK; ++i) {
+      if (mProbabilities[i] > expected ||
+          (mProbabilities[i] == expected && i < data.expectedClass)) {
+        ++rank;
+      }
+    }
+    for (int k = rank; k < kTopK; ++k) {
+      mTopK[k]++;
+    }
+    mTotal++;
+    return true;
+  }
+
+  void getResults(std::vector<std::string>* keys, std::vector<float>* values,
+                  std::vector<std::string>* validationErrors) const override {
+    for (int k = 0; k < kTopK; ++k) {
+      keys->push_back("top_" + std::to_string(k + 1));
+      values->push_back(static_cast<float>(mTopK[k]) / mTotal);
+    }
+
+    if (mExpectedTop1 > 0.0f) {
+      const float top1 = static_cast<float>(mTopK[0]) / mTotal;
+      if (top1 < mExpectedTop1 - kValidationTop1Threshold) {
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer),
+                 "Top 1 value is far below the validation threshold %.2f%%",
+                 mExpectedTop1 * 100.0);
+        validationErrors->push_back(buffer);
+      }
+    }
+  }
+
+ private:
+  static constexpr int kTopK = 5;
+  static constexpr float kValidationTop1Threshold = 0.05f;
+
+  const int mTargetOutputIndex;
+  const float mExpectedTop1;
+  int mTotal = 0;
+  int mTopK[kTopK] = {};
+  std::vector<float> mProbabilities;
+};
+
+// Collects the outputs and golden outputs of a sequence and evaluates them
+// once the sequence is complete, see evaluators/BaseSequenceEvaluator.java.
+// Incomplete sequences, cut by the benchmark timeout, are not evaluated.
+class SequenceEvaluator : public NativeEvaluator {
+ public:
+  explicit SequenceEvaluator(const NativeEvaluatorConfig& config)
+      : mTargetOutputIndex(config.targetOutputIndex),
+        mOutputMean(config.outputMean),
+        mOutputStdDev(config.outputStdDev) {}
+
+  bool add(const InferenceInOut& data, int inputOutputIndex,
+           int sequenceLength,
+           const std::vector<EvaluatorOutput>& outputs) override {
+    if (inputOutputIndex == 0) {
+      mOutputs.clear();
+      mExpectedOutputs.clear();
+    }
+    if (mTargetOutputIndex >= outputs.size() ||
+        mTargetOutputIndex >= data.outputs.size()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Sequence evaluator needs output %d and its golden "
+                          "output",
+                          mTargetOutputIndex);
+      return false;
+    }
+    const EvaluatorOutput& output = outputs[mTargetOutputIndex];
+    const InferenceOutput& expected = data.outputs[mTargetOutputIndex];
+    if (!appendFrame(output.type, output.data, output.bytes, &mOutputs) ||
+        !appendFrame(output.type, expected.ptr, expected.size,
+                     &mExpectedOutputs)) {
+      return false;
+    }
+    if (mOutputs.size() != mExpectedOutputs.size()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Golden/actual output size mismatch");
+      return false;
+    }
+    if (inputOutputIndex == sequenceLength - 1) {
+      evaluateSequence(mOutputs, mExpectedOutputs, sequenceLength,
+                       mOutputs.size() / sequenceLength);
+    }
+    return true;
+  }
+
+ protected:
+  // One per failed sequence, like the Java evaluators.
+  std::vector<std::string> mValidationErrors;
+
+  // outputs and expectedOutputs hold frames frames of frameSize values.
+  virtual void evaluateSequence(const std::vector<float>& outputs,
+                                const std::vector<float>& expectedOutputs,
+                                int frames, int frameSize) = 0;
+
+ private:
+  bool appendFrame(TfLiteType type, const uint8_t* data, size_t bytes,
+                   std::vector<float>* frames) {
+    if (!readFloats(type, data, bytes, &mFrame)) {
+      return false;
+    }
+    if (!mOutputMean.empty()) {
+      if (mFrame.size() != mOutputMean.size()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "Invalid number of values: %zu", mFrame.size());
+        return false;
+      }
+      for (int i = 0; i < mFrame.size(); ++i) {
+        mFrame[i] = mFrame[i] * mOutputStdDev[i] + mOutputMean[i];
+      }
+    }
+    frames->insert(frames->end(), mFrame.begin(), mFrame.end());
+    return true;
+  }
+
+  const int mTargetOutputIndex;
+  const std::vector<float> mOutputMean;
+  const std::vector<float> mOutputStdDev;
+  std::vector<float> mFrame;
+  std::vector<float> mOutputs;
+  std::vector<float> mExpectedOutputs;
+};
+
+// Phone error rate of a speech recognizer, see
+// evaluators/PhoneErrorRate.java.
+class PhoneErrorRateEvaluator : public SequenceEvaluator {
+ public:
+  using SequenceEvaluator::SequenceEvaluator;
+
+  void reset() override {
+    mMaxPER = 0.0f;
+    mValidationErrors.clear();
+  }
+
+  void getResults(std::vector<std::string>* keys, std::vector<float>* values,
+                  std::vector<std::string>* validationErrors) const override {
+    keys->push_back("max_phone_error_rate");
+    values->push_back(mMaxPER);
+    validationErrors->insert(validationErrors->end(),
+                             mValidationErrors.begin(),
+                             mValidationErrors.end());
+  }
+
+ protected:
+  void evaluateSequence(const std::vector<float>& outputs,
+                        const std::vector<float>& expectedOutputs, int frames,
+                        int frameSize) override {
+    std::vector<int> outputPhones(frames);
+    std::vector<int> expectedPhones(frames);
+    for (int i = 0; i < frames; ++i) {
+      outputPhones[i] = indexOfLargest(&outputs[i * frameSize], frameSize);
+      expectedPhones[i] =
+          indexOfLargest(&expectedOutputs[i * frameSize], frameSize);
+    }
+    const float per = static_cast<float>(
+        editDistance(outputPhones, expectedPhones) * 100.0 / frames);
+    if (per > kPhoneErrorRateLimit) {
+      mValidationErrors.push_back(
+          formatValue("Phone error rate exceeded the limit: ", per));
+    }
+    mMaxPER = std::max(mMaxPER, per);
+  }
+
+ private:
+  static constexpr float kPhoneErrorRateLimit = 5.0f;  // 5%
+
+  static int indexOfLargest(const float* items, int count) {
+    int index = -1;
+    float largest = -FLT_MAX;
+    for (int i = 0; i < count; ++i) {
+      if (items[i] > largest) {
+        index = i;
+        largest = items[i];
+      }
+    }
+    return index;
+  }
+
+  // Levenshtein distance, with a single row of the distance matrix.
+  static int editDistance(const std::vector<int>& a,
+                          const std::vector<int>& b) {
+    std::vector<int> row(b.size() + 1);
+    for (int j = 0; j <= b.size(); ++j) {
+      row[j] = j;
+    }
+    for (int i = 1; i <= a.size(); ++i) {
+      int diagonal = row[0];
+      row[0] = i;
+      for (int j = 1; j <= b.size(); ++j) {
+        const int substitution = diagonal + (a[i - 1] == b[j - 1] ? 0 : 1);
+        diagonal = row[j];
+        row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), substitution);
+      }
+    }
+    return row[b.size()];
+  }
+
+  float mMaxPER = 0.0f;
+};
+
+// Mel-cep distortion and log F0 error of the TTS model, see
+// evaluators/MelCepLogF0.java.
+class MelCepLogF0Evaluator : public SequenceEvaluator {
+ public:
+  using SequenceEvaluator::SequenceEvaluator;
+
+  void reset() override {
+    mMaxMelCepDistortion = 0.0f;
+    mMaxLogF0Error = 0.0f;
+    mValidationErrors.clear();
+  }
+
+  void getResults(std::vector<std::string>* keys, std::vector<float>* values,
+                  std::vector<std::string>* validationErrors) const override {
+    keys->push_back("max_mel_cep_distortion");
+    values->push_back(mMaxMelCepDistortion);
+    keys->push_back("max_log_f0_error");
+    values->push_back(mMaxLogF0Error);
+    validationErrors->insert(validationErrors->end(),
+                             mValidationErrors.begin(),
+                             mValidationErrors.end());
+  }
+
+ protected:
+  void evaluateSequence(const std::vector<float>& outputs,
+                        const std::vector<float>& expectedOutputs, int frames,
+                        int frameSize) override {
+    if (frameSize < kFramesPerInference * kFrameOutputDimension) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "MelCepLogF0 output too small: %d", frameSize);
+      mValidationErrors.push_back("MelCepLogF0 output too small");
+      return;
+    }
+    const float melCepDistortion =
+        calculateMelCepDistortion(outputs, expectedOutputs, frames, frameSize);
+    if (melCepDistortion > kMelCepDistortionLimit) {
+      mValidationErrors.push_back(formatValue(
+          "Mel-cep distortion exceeded the limit: ", melCepDistortion));
+    }
+    mMaxMelCepDistortion = std::max(mMaxMelCepDistortion, melCepDistortion);
+
+    const float logF0Error =
+        calculateLogF0Error(outputs, expectedOutputs, frames, frameSize);
+    if (logF0Error > kLogF0ErrorLimit) {
+      mValidationErrors.push_back(
+          formatValue("Log F0 error exceeded the limit: ", logF0Error));
+    }
+    mMaxLogF0Error = std::max(mMaxLogF0Error, logF0Error);
+  }
+
+ private:
+  static constexpr float kMelCepDistortionLimit = 4.0f;
+  static constexpr float kLogF0ErrorLimit = 0.01f;
+  // The TTS model predicts 4 frames per inference. For each frame, there are
+  // 40 amplitude values, 7 aperiodicity values, 1 log F0 value and 1 voicing
+  // value.
+  static constexpr int kFramesPerInference = 4;
+  static constexpr int kAmplitudeDimension = 40;
+  static constexpr int kAperiodicityDimension = 7;
+  static constexpr int kLogF0Dimension = 1;
+  static constexpr int kVoicingDimension = 1;
+  static constexpr int kFrameOutputDimension =
+      kAmplitudeDimension + kAperiodicityDimension + kLogF0Dimension +
+      kVoicingDimension;
+  // Frames with a voicing value above the threshold are voiced.
+  static constexpr float kVoicedThreshold = 0.0f;
+
+  static float calculateMelCepDistortion(
+      const std::vector<float>& outputs,
+      const std::vector<float>& expectedOutputs, int inferences,
+      int inferenceSize) {
+    float squaredError = 0.0f;
+    for (int inference = 0; inference < inferences; ++inference) {
+      const float* output = &outputs[inference * inferenceSize];
+      const float* expected = &expectedOutputs[inference * inferenceSize];
+      for (int frame = 0; frame < kFramesPerInference; ++frame) {
+        // Mel-cep distortion skips the first amplitude element.
+        for (int amplitude = 1; amplitude < kAmplitudeDimension; ++amplitude) {
+          const int i = frame * kFrameOutputDimension + amplitude;
+          const float error = output[i] - expected[i];
+          squaredError += error * error;
+        }
+      }
+    }
+    return std::sqrt(squaredError / (inferences * kFramesPerInference *
+                                     (kAmplitudeDimension - 1)));
+  }
+
+  static float calculateLogF0Error(const std::vector<float>& outputs,
+                                   const std::vector<float>& expectedOutputs,
+                                   int inferences, int inferenceSize) {
+    float squaredError = 0.0f;
+    int count = 0;
+    for (int inference = 0; inference < inferences; ++inference) {
+      const float* output = &outputs[inference * inferenceSize];
+      const float* expected = &expectedOutputs[inference * inferenceSize];
+      for (int frame = 0; frame < kFramesPerInference; ++frame) {
+        const int f0Index = frame * kFrameOutputDimension +
+                            kAmplitudeDimension + kAperiodicityDimension;
+        const int voicedIndex = f0Index + kLogF0Dimension;
+        if (output[voicedIndex] > kVoicedThreshold &&
+            expected[voicedIndex] > kVoicedThreshold) {
+          const float error = output[f0Index] - expected[f0Index];
+          squaredError += error * error;
+          ++count;
+        }
+      }
+    }
+    return count > 0 ? std::sqrt(squaredError / count) : 0.0f;
+  }
+
+  float mMaxMelCepDistortion = 0.0f;
+  float mMaxLogF0Error = 0.0f;
+};
+
+}  // namespace
+
+std::unique_ptr<NativeEvaluator> NativeEvaluator::create(
+    const NativeEvaluatorConfig& config) {
+  if (config.outputMean.size() != config.outputStdDev.size()) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Output mean/std dev count mismatch");
+    return nullptr;
+  }
+  std::unique_ptr<NativeEvaluator> evaluator;
+  if (config.className == "TopK") {
+    evaluator.reset(new TopKEvaluator(config));
+  } else if (config.className == "PhoneErrorRate") {
+    evaluator.reset(new PhoneErrorRateEvaluator(config));
+  } else if (config.className == "MelCepLogF0") {
+    evaluator.reset(new MelCepLogF0Evaluator(config));
+  } else {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "No native evaluator named %s",
+                        config.className.c_str());
+    return nullptr;
+  }
+  evaluator->reset();
+  return evaluator;
+}
+
+bool NativeEvaluator::isSupported(const std::string& className) {
+  return className == "TopK" || className == "PhoneErrorRate" ||
+         className == "MelCepLogF0";
+}
@@ -0,0 +1,77 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_NATIVE_EVALUATORS_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_NATIVE_EVALUATORS_H
+
+#include "run_tflite.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Configuration of a native evaluator, mirrors the Java EvaluatorConfig.
+struct NativeEvaluatorConfig {
+  // Name of the Java evaluator in com.android.nn.benchmark.evaluators.
+  std::string className;
+  // Model output the evaluator looks at.
+  int targetOutputIndex = 0;
+  // TopK only, top 1 accuracy below this (minus a margin) is a validation
+  // error. 0 to disable.
+  float expectedTop1 = 0.0f;
+  // Optional per element de-normalization of the sequence evaluator outputs
+  // and golden outputs, value * stdDev + mean.
+  std::vector<float> outputMean;
+  std::vector<float> outputStdDev;
+};
+
+// One model output tensor after an inference.
+struct EvaluatorOutput {
+  TfLiteType type;
+  const uint8_t* data;
+  size_t bytes;
+};
+
+// Accuracy evaluator running on the output tensors during the benchmark, so
+// that accuracy runs don't need to keep every inference output. Computes the
+// same metrics, keys and validation errors as the Java evaluator of the same
+// name.
+class NativeEvaluator {
+ public:
+  // Returns nullptr if className has no native implementation.
+  static std::unique_ptr<NativeEvaluator> create(
+      const NativeEvaluatorConfig& config);
+  // Whether className has a native implementation.
+  static bool isSupported(const std::string& className);
+
+  virtual ~NativeEvaluator() {}
+
+  // Drops the results of the previous benchmark run.
+  virtual void reset() = 0;
+  // Called for every inference, in benchmark order. data is the inference
+  // input/golden output, sequenceLength the length of its sequence.
+  // Returns false if the outputs can't be evaluated.
+  virtual bool add(const InferenceInOut& data, int inputOutputIndex,
+                   int sequenceLength,
+                   const std::vector<EvaluatorOutput>& outputs) = 0;
+  // Metrics and validation errors of the inferences added since the last
+  // reset().
+  virtual void getResults(std::vector<std::string>* keys,
+                          std::vector<float>* values,
+                          std::vector<std::string>* validationErrors) const = 0;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_NATIVE_EVALUATORS_H
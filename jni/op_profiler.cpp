@@ -0,0 +1,94 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "op_profiler.h"
+
+#include <time.h>
+#include <algorithm>
+
+namespace {
+
+long long currentTimeInNsec() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((ts.tv_sec * 1000000000LL) + ts.tv_nsec);
+}
+
+}  // namespace
+
+uint32_t OpProfiler::BeginEvent(const char* tag, EventType event_type,
+                                uint32_t event_metadata) {
+  if (event_type == EventType::DEFAULT) {
+    return 0;
+  }
+  const bool delegated =
+      event_type == EventType::DELEGATE_OPERATOR_INVOKE_EVENT;
+  addProfile(tag, delegated, event_metadata);
+  ++mOpenEventsCount;
+  mOpenEvents.push_back({delegated, event_metadata, currentTimeInNsec()});
+  return mOpenEvents.size();
+}
+
+void OpProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == 0 || event_handle > mOpenEvents.size()) {
+    return;
+  }
+  const OpenEvent& event = mOpenEvents[event_handle - 1];
+  const float timeSec =
+      static_cast<float>((currentTimeInNsec() - event.startTimeNsec) / 1e9);
+  OpProfile& profile = nodeProfiles(event.delegated)[event.nodeIndex];
+  profile.minTimeSec =
+      profile.count == 0 ? timeSec : std::min(profile.minTimeSec, timeSec);
+  profile.maxTimeSec = std::max(profile.maxTimeSec, timeSec);
+  profile.totalTimeSec += timeSec;
+  ++profile.count;
+  if (--mOpenEventsCount == 0) {
+    mOpenEvents.clear();
+  }
+}
+
+void OpProfiler::addProfile(const char* tag, bool delegated,
+                            uint32_t nodeIndex) {
+  std::vector<OpProfile>& profiles = nodeProfiles(delegated);
+  if (nodeIndex >= profiles.size()) {
+    profiles.resize(nodeIndex + 1);
+  }
+  OpProfile& profile = profiles[nodeIndex];
+  if (profile.nodeIndex == -1) {
+    profile.opName = tag != nullptr ? tag : "";
+    profile.nodeIndex = nodeIndex;
+    profile.delegated = delegated;
+  }
+}
+
+void OpProfiler::reset() {
+  mOpProfiles.clear();
+  mDelegatedOpProfiles.clear();
+  mOpenEvents.clear();
+  mOpenEventsCount = 0;
+}
+
+std::vector<OpProfile> OpProfiler::profiles() const {
+  std::vector<OpProfile> profiles;
+  for (const auto* nodeProfiles : {&mOpProfiles, &mDelegatedOpProfiles}) {
+    for (const OpProfile& profile : *nodeProfiles) {
+      if (profile.count > 0) {
+        profiles.push_back(profile);
+      }
+    }
+  }
+  return profiles;
+}
@@ -0,0 +1,78 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_OP_PROFILER_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_OP_PROFILER_H
+
+#include "tensorflow/lite/core/api/profiler.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Aggregated execution time of a single graph node across inferences.
+struct OpProfile {
+  // Operator name, for delegate kernels the delegate name
+  std::string opName;
+  int nodeIndex = -1;
+  // True for operators executed inside a delegate kernel
+  // (DELEGATE_OPERATOR_INVOKE_EVENT)
+  bool delegated = false;
+  int count = 0;
+  double totalTimeSec = 0.0;
+  float minTimeSec = 0.0f;
+  float maxTimeSec = 0.0f;
+};
+
+// TFLite profiler keeping per-node time statistics instead of a list of
+// events, so its memory use doesn't grow with the number of inferences.
+// Interpreter-level (DEFAULT) events are ignored. Not thread safe, a
+// profiler may only be attached to a single interpreter.
+class OpProfiler : public tflite::Profiler {
+ public:
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      uint32_t event_metadata) override;
+  void EndEvent(uint32_t event_handle) override;
+
+  // Drops all statistics.
+  void reset();
+  // Statistics of every node that ran, ordered by event type and node index.
+  std::vector<OpProfile> profiles() const;
+
+ private:
+  // Profiles are referenced by index, the vectors may grow while an event
+  // is open.
+  struct OpenEvent {
+    bool delegated;
+    uint32_t nodeIndex;
+    long long startTimeNsec;
+  };
+
+  std::vector<OpProfile>& nodeProfiles(bool delegated) {
+    return delegated ? mDelegatedOpProfiles : mOpProfiles;
+  }
+  // Creates the profile of the node if it's the first event for it.
+  void addProfile(const char* tag, bool delegated, uint32_t nodeIndex);
+
+  // Indexed by node index.
+  std::vector<OpProfile> mOpProfiles;
+  std::vector<OpProfile> mDelegatedOpProfiles;
+  // Handle N is mOpenEvents[N - 1], cleared once no event is open anymore.
+  std::vector<OpenEvent> mOpenEvents;
+  int mOpenEventsCount = 0;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_OP_PROFILER_H
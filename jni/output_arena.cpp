@@ -0,0 +1,52 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "output_arena.h"
+
+#include <algorithm>
+
+void OutputArena::configure(const std::vector<size_t>& outputSizes) {
+  mOutputSizes = outputSizes;
+  mOutputOffsets.clear();
+  mSlotSize = 0;
+  for (size_t outputSize : mOutputSizes) {
+    mOutputOffsets.push_back(mSlotSize);
+    mSlotSize += outputSize;
+  }
+  mData.clear();
+  mSize = 0;
+}
+
+void OutputArena::reset(size_t expectedInferences) {
+  mSize = 0;
+  if (mSlotSize == 0) {
+    return;
+  }
+  size_t reservedSlots = std::min(expectedInferences,
+                                  std::max<size_t>(1, kMaxReservedBytes / mSlotSize));
+  if (mData.size() < reservedSlots * mSlotSize) {
+    mData.resize(reservedSlots * mSlotSize);
+  }
+}
+
+size_t OutputArena::allocateSlot() {
+  size_t offset = mSize;
+  mSize += mSlotSize;
+  if (mData.size() < mSize) {
+    mData.resize(std::max(mSize, mData.size() * 2));
+  }
+  return offset;
+}
@@ -0,0 +1,60 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_OUTPUT_ARENA_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_OUTPUT_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Storage for saved inference outputs. All outputs of an inference are
+// stored back to back in one slot, and slots of consecutive inferences are
+// contiguous, so the whole arena can be handed over to Java in one copy.
+// Slots are addressed by offset, which stays valid when the arena grows.
+class OutputArena {
+ public:
+  static constexpr size_t kNoSlot = SIZE_MAX;
+
+  // Sets the output tensor sizes, drops all saved outputs.
+  void configure(const std::vector<size_t>& outputSizes);
+  // Drops all saved outputs and preallocates room for expectedInferences
+  // slots, capped to kMaxReservedBytes.
+  void reset(size_t expectedInferences);
+  // Returns the offset of a new slot for one inference.
+  size_t allocateSlot();
+
+  uint8_t* output(size_t slotOffset, int outputIndex) {
+    return mData.data() + slotOffset + mOutputOffsets[outputIndex];
+  }
+
+  const std::vector<size_t>& outputSizes() const { return mOutputSizes; }
+  const uint8_t* data() const { return mData.data(); }
+  size_t size() const { return mSize; }
+
+ private:
+  static constexpr size_t kMaxReservedBytes = 64 * 1024 * 1024;
+
+  std::vector<size_t> mOutputSizes;
+  // Offset of every output within a slot.
+  std::vector<size_t> mOutputOffsets;
+  size_t mSlotSize = 0;
+  std::vector<uint8_t> mData;
+  // Used bytes of mData.
+  size_t mSize = 0;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_OUTPUT_ARENA_H
@@ -0,0 +1,200 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "output_error.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+float halfToFloat(uint16_t half) {
+  uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    // Inf or NaN.
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  } else {
+    // Zero or subnormal.
+    float value = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign ? -value : value;
+  }
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Scalar tail shared by the integer kernels.
+template <typename T>
+void integerErrorTail(const T* output, const T* expected, size_t begin,
+                      size_t end, uint64_t* sum, uint32_t* max) {
+  for (size_t i = begin; i < end; ++i) {
+    uint32_t err = std::abs(static_cast<int32_t>(output[i]) -
+                            static_cast<int32_t>(expected[i]));
+    *sum += static_cast<uint64_t>(err) * err;
+    *max = std::max(*max, err);
+  }
+}
+
+#if defined(__aarch64__)
+// |output - expected| for 16 bytes is at most 255, so the squares fit into
+// 16 bits and are widened pairwise into the 64 bit accumulator.
+inline void accumulateAbsDiffU8(uint8x16_t absDiff, uint64x2_t* sum,
+                                uint8x16_t* max) {
+  *max = vmaxq_u8(*max, absDiff);
+  uint16x8_t squaresLow = vmull_u8(vget_low_u8(absDiff), vget_low_u8(absDiff));
+  uint16x8_t squaresHigh = vmull_high_u8(absDiff, absDiff);
+  uint32x4_t squares = vpaddlq_u16(squaresLow);
+  squares = vpadalq_u16(squares, squaresHigh);
+  *sum = vpadalq_u32(*sum, squares);
+}
+#endif
+
+}  // namespace
+
+OutputErrorStats outputErrorUInt8(const uint8_t* output,
+                                  const uint8_t* expected, size_t count) {
+  size_t i = 0;
+  uint64_t sum = 0;
+  uint32_t max = 0;
+#if defined(__aarch64__)
+  uint64x2_t sumVec = vdupq_n_u64(0);
+  uint8x16_t maxVec = vdupq_n_u8(0);
+  for (; i + 16 <= count; i += 16) {
+    accumulateAbsDiffU8(vabdq_u8(vld1q_u8(output + i), vld1q_u8(expected + i)),
+                        &sumVec, &maxVec);
+  }
+  sum = vaddvq_u64(sumVec);
+  max = vmaxvq_u8(maxVec);
+#endif
+  integerErrorTail(output, expected, i, count, &sum, &max);
+  return {static_cast<double>(sum), static_cast<float>(max)};
+}
+
+OutputErrorStats outputErrorInt8(const int8_t* output, const int8_t* expected,
+                                 size_t count) {
+  size_t i = 0;
+  uint64_t sum = 0;
+  uint32_t max = 0;
+#if defined(__aarch64__)
+  uint64x2_t sumVec = vdupq_n_u64(0);
+  uint8x16_t maxVec = vdupq_n_u8(0);
+  for (; i + 16 <= count; i += 16) {
+    // The signed absolute difference wraps in 8 bits, read as unsigned it is
+    // exact.
+    uint8x16_t absDiff = vreinterpretq_u8_s8(
+        vabdq_s8(vld1q_s8(output + i), vld1q_s8(expected + i)));
+    accumulateAbsDiffU8(absDiff, &sumVec, &maxVec);
+  }
+  sum = vaddvq_u64(sumVec);
+  max = vmaxvq_u8(maxVec);
+#endif
+  integerErrorTail(output, expected, i, count, &sum, &max);
+  return {static_cast<double>(sum), static_cast<float>(max)};
+}
+
+OutputErrorStats outputErrorInt16(const int16_t* output,
+                                  const int16_t* expected, size_t count) {
+  size_t i = 0;
+  uint64_t sum = 0;
+  uint32_t max = 0;
+#if defined(__aarch64__)
+  uint64x2_t sumVec = vdupq_n_u64(0);
+  uint16x8_t maxVec = vdupq_n_u16(0);
+  for (; i + 8 <= count; i += 8) {
+    uint16x8_t absDiff = vreinterpretq_u16_s16(
+        vabdq_s16(vld1q_s16(output + i), vld1q_s16(expected + i)));
+    maxVec = vmaxq_u16(maxVec, absDiff);
+    uint32x4_t squaresLow =
+        vmull_u16(vget_low_u16(absDiff), vget_low_u16(absDiff));
+    uint32x4_t squaresHigh = vmull_high_u16(absDiff, absDiff);
+    sumVec = vpadalq_u32(sumVec, squaresLow);
+    sumVec = vpadalq_u32(sumVec, squaresHigh);
+  }
+  sum = vaddvq_u64(sumVec);
+  max = vmaxvq_u16(maxVec);
+#endif
+  integerErrorTail(output, expected, i, count, &sum, &max);
+  return {static_cast<double>(sum), static_cast<float>(max)};
+}
+
+OutputErrorStats outputErrorFloat32(const float* output, const float* expected,
+                                    size_t count) {
+  size_t i = 0;
+  double sum = 0.0;
+  float max = 0.0f;
+#if defined(__aarch64__)
+  float64x2_t sumVec = vdupq_n_f64(0.0);
+  float32x4_t maxVec = vdupq_n_f32(0.0f);
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t diff = vsubq_f32(vld1q_f32(output + i), vld1q_f32(expected + i));
+    maxVec = vmaxq_f32(maxVec, vabsq_f32(diff));
+    float64x2_t diffLow = vcvt_f64_f32(vget_low_f32(diff));
+    float64x2_t diffHigh = vcvt_high_f64_f32(diff);
+    sumVec = vfmaq_f64(sumVec, diffLow, diffLow);
+    sumVec = vfmaq_f64(sumVec, diffHigh, diffHigh);
+  }
+  sum = vaddvq_f64(sumVec);
+  max = vmaxvq_f32(maxVec);
+#endif
+  for (; i < count; ++i) {
+    double err = static_cast<double>(output[i]) - expected[i];
+    sum += err * err;
+    max = std::max(max, static_cast<float>(std::fabs(err)));
+  }
+  return {sum, max};
+}
+
+OutputErrorStats outputErrorFloat16(const uint16_t* output,
+                                    const uint16_t* expected, size_t count) {
+  size_t i = 0;
+  double sum = 0.0;
+  float max = 0.0f;
+#if defined(__aarch64__)
+  float64x2_t sumVec = vdupq_n_f64(0.0);
+  float32x4_t maxVec = vdupq_n_f32(0.0f);
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t out = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(output + i)));
+    float32x4_t exp =
+        vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(expected + i)));
+    float32x4_t diff = vsubq_f32(out, exp);
+    maxVec = vmaxq_f32(maxVec, vabsq_f32(diff));
+    float64x2_t diffLow = vcvt_f64_f32(vget_low_f32(diff));
+    float64x2_t diffHigh = vcvt_high_f64_f32(diff);
+    sumVec = vfmaq_f64(sumVec, diffLow, diffLow);
+    sumVec = vfmaq_f64(sumVec, diffHigh, diffHigh);
+  }
+  sum = vaddvq_f64(sumVec);
+  max = vmaxvq_f32(maxVec);
+#endif
+  for (; i < count; ++i) {
+    double err = static_cast<double>(halfToFloat(output[i])) -
+                 halfToFloat(expected[i]);
+    sum += err * err;
+    max = std::max(max, static_cast<float>(std::fabs(err)));
+  }
+  return {sum, max};
+}
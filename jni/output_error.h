@@ -0,0 +1,43 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_OUTPUT_ERROR_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_OUTPUT_ERROR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Error of an inference output against its golden output.
+struct OutputErrorStats {
+  double sumSquaredError = 0.0;
+  float maxAbsError = 0.0f;
+};
+
+// Element-wise error kernels, NEON vectorized on aarch64. Integer kernels
+// accumulate exactly in 64 bits, float kernels accumulate in double.
+OutputErrorStats outputErrorUInt8(const uint8_t* output,
+                                  const uint8_t* expected, size_t count);
+OutputErrorStats outputErrorInt8(const int8_t* output, const int8_t* expected,
+                                 size_t count);
+OutputErrorStats outputErrorInt16(const int16_t* output,
+                                  const int16_t* expected, size_t count);
+OutputErrorStats outputErrorFloat32(const float* output, const float* expected,
+                                    size_t count);
+// Float16 values are passed as their raw IEEE 754 half precision bits.
+OutputErrorStats outputErrorFloat16(const uint16_t* output,
+                                    const uint16_t* expected, size_t count);
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_OUTPUT_ERROR_H
@@ -16,13 +16,34 @@
 
 #include "run_tflite.h"
 
-#include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
+#include "arrival_process.h"
+#include "async_validation.h"
+#include "cpu_affinity.h"
+#include "input_prefetcher.h"
+#include "mapped_dataset.h"
+#include "native_evaluators.h"
+#include "output_error.h"
+#include "sysfs_sensors.h"
+#include "tensor_dump_writer.h"
+
 #include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/nnapi/nnapi_implementation.h"
 
 #include <android/log.h>
+#include <android/sharedmem.h>
 #include <dlfcn.h>
-#include <sys/time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <cstdio>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 #define LOG_TAG "NN_BENCHMARK"
 
@@ -32,12 +53,17 @@
     assert(false);                                                       \
   } while (0)
 
+// Monotonic clock, not affected by wall-clock adjustments (NTP etc).
+long long currentTimeInNsec() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((ts.tv_sec * 1000000000LL) + ts.tv_nsec);
+}
+
 namespace {
 
-long long currentTimeInUsec() {
-  timeval tv;
-  gettimeofday(&tv, NULL);
-  return ((tv.tv_sec * 1000000L) + tv.tv_usec);
+float nsecToSec(long long nsec) {
+  return static_cast<float>(static_cast<double>(nsec) / 1000000000.0);
 }
 
 // Workaround for build systems that make difficult to pick the correct NDK API
@@ -60,28 +86,183 @@ TraceFunc setupTraceFunc() {
 }
 static TraceFunc kTraceFunc{setupTraceFunc()};
 
+// Number of inferences that can be waiting for asynchronous validation before
+// the inference thread blocks.
+constexpr int kAsyncValidationDepth = 4;
+
+// Number of inferences FLAG_PREFETCH_INPUTS creates inputs for ahead of the
+// inference thread.
+constexpr int kInputPrefetchDepth = 8;
+
+// Number of tensors dumpAllLayers() can have waiting for the I/O thread.
+constexpr int kTensorDumpDepth = 16;
+
+// Called by the NNAPI delegate if a CPU op needs to read an input tensor that
+// is bound to shared memory.
+TfLiteStatus copySharedMemoryToHost(TfLiteTensor* tensor,
+                                    ANeuralNetworksMemory* memory,
+                                    size_t memory_offset, size_t byte_size,
+                                    void* callback_context) {
+  const uint8_t* hostPtr = reinterpret_cast<const uint8_t*>(callback_context);
+  memcpy(tensor->data.raw, hostPtr + memory_offset, byte_size);
+  return kTfLiteOk;
+}
+
+// Golden output error of a single output, output_raw may be the output
+// tensor itself or a copy of its contents.
+void computeOutputError(TfLiteType type, const uint8_t* output_raw,
+                        size_t output_bytes, const uint8_t* expected_data,
+                        size_t length, InferenceResult* result,
+                        int output_index) {
+  if (output_bytes != length) {
+    FATAL("Wrong size of output tensor, expected %zu, is %zu", output_bytes,
+          length);
+  }
+
+  size_t elements_count = 0;
+  OutputErrorStats error;
+  switch (type) {
+    case kTfLiteUInt8:
+      elements_count = length;
+      error = outputErrorUInt8(output_raw, expected_data, elements_count);
+      break;
+    case kTfLiteInt8:
+      elements_count = length;
+      error = outputErrorInt8(reinterpret_cast<const int8_t*>(output_raw),
+                              reinterpret_cast<const int8_t*>(expected_data),
+                              elements_count);
+      break;
+    case kTfLiteInt16:
+      elements_count = length / sizeof(int16_t);
+      error = outputErrorInt16(reinterpret_cast<const int16_t*>(output_raw),
+                               reinterpret_cast<const int16_t*>(expected_data),
+                               elements_count);
+      break;
+    case kTfLiteFloat16:
+      elements_count = length / sizeof(uint16_t);
+      error = outputErrorFloat16(
+          reinterpret_cast<const uint16_t*>(output_raw),
+          reinterpret_cast<const uint16_t*>(expected_data), elements_count);
+      break;
+    case kTfLiteFloat32:
+      elements_count = length / sizeof(float);
+      error = outputErrorFloat32(reinterpret_cast<const float*>(output_raw),
+                                 reinterpret_cast<const float*>(expected_data),
+                                 elements_count);
+      break;
+    default:
+      FATAL("Output sensor type %d not supported", type);
+  }
+  result->meanSquareErrors[output_index] =
+      elements_count > 0 ? error.sumSquaredError / elements_count : 0.0f;
+  result->maxSingleErrors[output_index] = error.maxAbsError;
+}
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+
+// FNV-1a hash step.
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Hash of the model file contents, for NNAPI compilation cache tokens. The
+// cache is only valid for the exact same model, so the token has to change
+// with every model update.
+bool hashModelFile(const char* modelfile, uint64_t* hash) {
+  int fd = open(modelfile, O_RDONLY);
+  if (fd == -1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to open model %s",
+                        modelfile);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to stat model %s",
+                        modelfile);
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to map model %s",
+                        modelfile);
+    return false;
+  }
+
+  *hash = hashBytes(kFnvOffsetBasis, data, st.st_size);
+  munmap(data, st.st_size);
+  return true;
+}
+
+// NNAPI compilation cache token, as hex. Every delegate option that changes
+// the compiled model is part of it.
+std::string modelToken(uint64_t modelFileHash, const DelegateOptions& options) {
+  uint64_t hash = modelFileHash;
+  hash = hashBytes(hash, options.deviceName.data(), options.deviceName.size());
+  hash = hashBytes(hash, &options.executionPreference,
+                   sizeof(options.executionPreference));
+  hash = hashBytes(hash, &options.allowFp16, sizeof(options.allowFp16));
+  hash = hashBytes(hash, &options.maxDelegatedPartitions,
+                   sizeof(options.maxDelegatedPartitions));
+  hash = hashBytes(hash, &options.disallowNnapiCpu,
+                   sizeof(options.disallowNnapiCpu));
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+  return hex;
+}
+
 }  // namespace
 
 BenchmarkModel* BenchmarkModel::create(const char* modelfile, bool use_nnapi,
                                        bool enable_intermediate_tensors_dump,
-                                       const char* nnapi_device_name) {
+                                       const DelegateOptions& delegate_options) {
     BenchmarkModel* model = new BenchmarkModel();
     if (!model->init(modelfile, use_nnapi, enable_intermediate_tensors_dump,
-                     nnapi_device_name)) {
+                     delegate_options)) {
       delete model;
       return nullptr;
     }
     return model;
 }
 
+std::unique_ptr<BenchmarkModel> BenchmarkModel::createReplica() const {
+  return createReplica(mDelegateOptions);
+}
+
+std::unique_ptr<BenchmarkModel> BenchmarkModel::createReplica(
+    const DelegateOptions& options) const {
+  std::unique_ptr<BenchmarkModel> replica(new BenchmarkModel());
+  replica->mTfliteModel = mTfliteModel;
+  replica->mUseNnapi = mUseNnapi;
+  replica->mEnableIntermediateTensorsDump = mEnableIntermediateTensorsDump;
+  replica->mDelegateOptions = options;
+  replica->mModelFileHash = mModelFileHash;
+  replica->mNumThreads = mNumThreads;
+  replica->mCpuAffinityMask = mCpuAffinityMask;
+  if (!replica->initInterpreter()) {
+    return nullptr;
+  }
+  if (!mInputShapes.empty() && !replica->applyInputShapes(mInputShapes)) {
+    return nullptr;
+  }
+  return replica;
+}
+
 bool BenchmarkModel::init(const char* modelfile, bool use_nnapi,
                           bool enable_intermediate_tensors_dump,
-                          const char* nnapi_device_name) {
+                          const DelegateOptions& delegate_options) {
   __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "BenchmarkModel %s",
                       modelfile);
 
+  mMemoryProfile.beforeCreate = MemorySnapshot::take();
   // Memory map the model. NOTE this needs lifetime greater than or equal
   // to interpreter context.
+  long long loadStartTime = currentTimeInNsec();
   mTfliteModel = tflite::FlatBufferModel::BuildFromFile(modelfile);
   if (!mTfliteModel) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to load model %s",
@@ -89,6 +270,30 @@ bool BenchmarkModel::init(const char* modelfile, bool use_nnapi,
     return false;
   }
 
+  mModelFile = modelfile;
+  mUseNnapi = use_nnapi;
+  mEnableIntermediateTensorsDump = enable_intermediate_tensors_dump;
+  mDelegateOptions = delegate_options;
+  // Hashing the model is part of the startup cost of caching.
+  if (use_nnapi && !delegate_options.cacheDir.empty() &&
+      !hashModelFile(modelfile, &mModelFileHash)) {
+    return false;
+  }
+  mStartupProfile.modelLoadTimeSec =
+      nsecToSec(currentTimeInNsec() - loadStartTime);
+  if (!initInterpreter(&mStartupProfile)) {
+    return false;
+  }
+  mMemoryProfile.afterCreate = MemorySnapshot::take();
+  return true;
+}
+
+bool BenchmarkModel::initInterpreter(StartupProfile* profile) {
+  const char* nnapi_device_name = mDelegateOptions.deviceName.empty()
+                                      ? nullptr
+                                      : mDelegateOptions.deviceName.c_str();
+
+  long long buildStartTime = currentTimeInNsec();
   tflite::ops::builtin::BuiltinOpResolver resolver;
   tflite::InterpreterBuilder(*mTfliteModel, resolver)(&mTfliteInterpreter);
   if (!mTfliteInterpreter) {
@@ -97,7 +302,7 @@ bool BenchmarkModel::init(const char* modelfile, bool use_nnapi,
     return false;
   }
 
-  if (enable_intermediate_tensors_dump) {
+  if (mEnableIntermediateTensorsDump) {
     // Make output of every op a model output. This way we will be able to
     // fetch each intermediate tensor when running with delegates.
     std::vector<int> outputs;
@@ -110,118 +315,490 @@ bool BenchmarkModel::init(const char* modelfile, bool use_nnapi,
     mTfliteInterpreter->SetOutputs(outputs);
   }
 
-  // Allow Fp16 precision for all models
-  mTfliteInterpreter->SetAllowFp16PrecisionForFp32(true);
+  if (mNumThreads != -1) {
+    // Worker threads inherit the affinity of the thread creating them.
+    ScopedCpuAffinity affinity(mCpuAffinityMask);
+    mTfliteInterpreter->SetNumThreads(mNumThreads);
+  }
+
+  mTfliteInterpreter->SetAllowFp16PrecisionForFp32(mDelegateOptions.allowFp16);
 
-  if (use_nnapi) {
+  long long delegateStartTime = currentTimeInNsec();
+  if (mUseNnapi) {
     if (nnapi_device_name != nullptr) {
       __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "Running NNAPI on device %s",
                           nnapi_device_name);
     }
+    tflite::StatefulNnApiDelegate::Options nnapi_options;
+    nnapi_options.accelerator_name = nnapi_device_name;
+    nnapi_options.execution_preference =
+        static_cast<tflite::StatefulNnApiDelegate::Options::ExecutionPreference>(
+            mDelegateOptions.executionPreference);
+    nnapi_options.allow_fp16 = mDelegateOptions.allowFp16;
+    nnapi_options.max_number_delegated_partitions =
+        mDelegateOptions.maxDelegatedPartitions;
+    nnapi_options.disallow_nnapi_cpu = mDelegateOptions.disallowNnapiCpu;
+    nnapi_options.use_burst_computation = mDelegateOptions.useBurst;
+    // Needs to stay valid as long as the delegate exists.
+    mModelToken = modelToken(mModelFileHash, mDelegateOptions);
+    if (!mDelegateOptions.cacheDir.empty()) {
+      nnapi_options.cache_dir = mDelegateOptions.cacheDir.c_str();
+      nnapi_options.model_token = mModelToken.c_str();
+    }
+    mTfliteNnapiDelegate.reset(new tflite::StatefulNnApiDelegate(nnapi_options));
     if (mTfliteInterpreter->ModifyGraphWithDelegate(
-            tflite::NnApiDelegate(nnapi_device_name)) != kTfLiteOk) {
+            mTfliteNnapiDelegate.get()) != kTfLiteOk) {
       __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
                           "Failed to initialize NNAPI Delegate");
       return false;
     }
   }
+  if (profile != nullptr) {
+    profile->interpreterBuildTimeSec =
+        nsecToSec(delegateStartTime - buildStartTime);
+    profile->delegateApplyTimeSec =
+        nsecToSec(currentTimeInNsec() - delegateStartTime);
+  }
+  mMemoryProfile.arenaBytes = tensorArenaBytes();
+  mHasVariableTensors = false;
+  for (size_t i = 0; i < mTfliteInterpreter->tensors_size(); ++i) {
+    mHasVariableTensors |= mTfliteInterpreter->tensor(i)->is_variable;
+  }
+  configureOutputArena();
   return true;
 }
 
+void BenchmarkModel::setMappedDataset(std::unique_ptr<MappedDataset> dataset) {
+  mMappedDataset = std::move(dataset);
+}
+
+void BenchmarkModel::setNativeEvaluator(
+    std::unique_ptr<NativeEvaluator> evaluator) {
+  mNativeEvaluator = std::move(evaluator);
+}
+
+bool BenchmarkModel::reinitInterpreter(const DelegateOptions& options) {
+  // The interpreter has to go first, it may still reference the delegate, and
+  // shared memory can only go with the delegate it is registered with.
+  releaseSharedMemoryInputs();
+  mTfliteInterpreter.reset();
+  mTfliteNnapiDelegate.reset();
+  freeSharedMemoryRegions();
+  mDelegateOptions = options;
+  if (!initInterpreter()) {
+    return false;
+  }
+  return mInputShapes.empty() || applyInputShapes(mInputShapes);
+}
+
 BenchmarkModel::BenchmarkModel() {}
-BenchmarkModel::~BenchmarkModel() {}
+BenchmarkModel::~BenchmarkModel() {
+  releaseSharedMemoryInputs();
+  mTfliteInterpreter.reset();
+  mTfliteNnapiDelegate.reset();
+  freeSharedMemoryRegions();
+}
 
-bool BenchmarkModel::setInput(const uint8_t* dataPtr, size_t length) {
-  int input = mTfliteInterpreter->inputs()[0];
+bool BenchmarkModel::setInput(int input_index, const uint8_t* dataPtr,
+                              size_t length) {
+  int input = mTfliteInterpreter->inputs()[input_index];
   auto* input_tensor = mTfliteInterpreter->tensor(input);
+  // Previous input may have been bound to shared memory.
+  input_tensor->buffer_handle = kTfLiteNullBufferHandle;
 
   switch (input_tensor->type) {
     case kTfLiteFloat32:
-    case kTfLiteUInt8: {
+    case kTfLiteFloat16:
+    case kTfLiteUInt8:
+    case kTfLiteInt8:
+    case kTfLiteInt16:
+    case kTfLiteInt32:
+    case kTfLiteInt64:
+    case kTfLiteBool: {
+      if (length != input_tensor->bytes) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "Input %d size mismatch, expected %zu, got %zu",
+                            input_index, input_tensor->bytes, length);
+        return false;
+      }
       void* raw = input_tensor->data.raw;
       memcpy(raw, dataPtr, length);
       break;
     }
     default:
       __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                          "Input tensor type not supported");
+                          "Input %d tensor type %d not supported", input_index,
+                          input_tensor->type);
       return false;
   }
   return true;
 }
-void BenchmarkModel::saveInferenceOutput(InferenceResult* result,
-                                         int output_index) {
-  int output = mTfliteInterpreter->outputs()[output_index];
-  auto* output_tensor = mTfliteInterpreter->tensor(output);
-  auto& sink = result->inferenceOutputs[output_index];
-  sink.insert(sink.end(), output_tensor->data.uint8,
-              output_tensor->data.uint8 + output_tensor->bytes);
+
+bool BenchmarkModel::setInputs(const InferenceInOut& data) {
+  if (data.inputs.size() != mTfliteInterpreter->inputs().size()) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Given/model inputs (%zu/%zu) count mismatch",
+                        data.inputs.size(), mTfliteInterpreter->inputs().size());
+    return false;
+  }
+  // With FLAG_PREFETCH_INPUTS the next slot holds the created inputs of
+  // exactly this inference.
+  const InputPrefetcher::Slot* prefetched = nullptr;
+  // Gives the slot back on every return, the producer waits for it.
+  auto releaseSlot = [this](const InputPrefetcher::Slot* slot) {
+    mInputPrefetcher->release(slot);
+  };
+  std::unique_ptr<const InputPrefetcher::Slot, decltype(releaseSlot)>
+      prefetchedGuard(nullptr, releaseSlot);
+  if (mInputPrefetcher != nullptr) {
+    prefetched = mInputPrefetcher->acquire();
+    prefetchedGuard.reset(prefetched);
+    if (prefetched == nullptr || prefetched->data != &data) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Prefetched inputs out of order");
+      return false;
+    }
+    if (!prefetched->success) {
+      return false;
+    }
+  }
+  for (int j = 0; j < data.inputs.size(); ++j) {
+    const InferenceInput& input = data.inputs[j];
+    if (input.ptr) {
+      if (!setSharedMemoryInput(j, input.ptr) &&
+          !setInput(j, input.ptr, input.size)) {
+        return false;
+      }
+    } else if (prefetched != nullptr) {
+      auto* input_tensor =
+          mTfliteInterpreter->tensor(mTfliteInterpreter->inputs()[j]);
+      input_tensor->buffer_handle = kTfLiteNullBufferHandle;
+      memcpy(input_tensor->data.raw, prefetched->inputs[j].data(),
+             input_tensor->bytes);
+    } else {
+      auto* input_tensor =
+          mTfliteInterpreter->tensor(mTfliteInterpreter->inputs()[j]);
+      input_tensor->buffer_handle = kTfLiteNullBufferHandle;
+      if (!input.createInput((uint8_t*)input_tensor->data.raw,
+                             input_tensor->bytes)) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "Input %d creation failed", j);
+        return false;
+      }
+    }
+  }
+  return true;
 }
 
-void BenchmarkModel::getOutputError(const uint8_t* expected_data, size_t length,
-                                    InferenceResult* result, int output_index) {
-  int output = mTfliteInterpreter->outputs()[output_index];
-  auto* output_tensor = mTfliteInterpreter->tensor(output);
-  if (output_tensor->bytes != length) {
-    FATAL("Wrong size of output tensor, expected %zu, is %zu",
-          output_tensor->bytes, length);
+bool BenchmarkModel::bindInputsToSharedMemory(
+    const std::vector<InferenceInOutSequence>& inOutData) {
+  if (!mTfliteNnapiDelegate) {
+    __android_log_print(ANDROID_LOG_WARN, LOG_TAG,
+                        "Zero-copy input requires NNAPI, copying inputs");
+    return true;
+  }
+  const NnApi* nnapi = NnApiImplementation();
+  if (!nnapi->nnapi_exists) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "NNAPI is not available");
+    return false;
   }
 
-  size_t elements_count = 0;
-  float err_sum = 0.0;
-  float max_error = 0.0;
-  switch (output_tensor->type) {
-    case kTfLiteUInt8: {
-      uint8_t* output_raw = mTfliteInterpreter->typed_tensor<uint8_t>(output);
-      elements_count = output_tensor->bytes;
-      for (size_t i = 0; i < output_tensor->bytes; ++i) {
-        float err = ((float)output_raw[i]) - ((float)expected_data[i]);
-        if (err > max_error) max_error = err;
-        err_sum += err * err;
+  // Lay out all inputs in one region. Offsets are page aligned, as
+  // required for creating NNAPI memory from the region file descriptor.
+  const size_t pageSize = getpagesize();
+  std::vector<std::pair<const uint8_t*, size_t>> inputs;
+  std::unordered_map<const uint8_t*, size_t> offsets;
+  size_t totalSize = 0;
+  for (const auto& seq : inOutData) {
+    for (const auto& data : seq) {
+      for (const auto& input : data.inputs) {
+        if (input.ptr == nullptr || offsets.count(input.ptr) != 0) {
+          continue;
+        }
+        offsets[input.ptr] = totalSize;
+        inputs.push_back({input.ptr, input.size});
+        totalSize += (input.size + pageSize - 1) / pageSize * pageSize;
       }
+    }
+  }
+  if (totalSize == 0) {
+    // Only lazily created inputs, nothing to bind.
+    return true;
+  }
+
+  // The delegate can't unregister memory, so regions are only added when no
+  // registered one has the same layout. Reused ones just get the new data.
+  SharedMemoryRegion* region = nullptr;
+  for (SharedMemoryRegion& candidate : mSharedMemoryRegions) {
+    if (candidate.inputs.size() != inputs.size()) {
+      continue;
+    }
+    bool sameLayout = true;
+    for (int i = 0; i < inputs.size() && sameLayout; ++i) {
+      sameLayout = candidate.inputs[i].size == inputs[i].second;
+    }
+    if (sameLayout) {
+      region = &candidate;
       break;
     }
-    case kTfLiteFloat32: {
-      const float* expected = reinterpret_cast<const float*>(expected_data);
-      float* output_raw = mTfliteInterpreter->typed_tensor<float>(output);
-      elements_count = output_tensor->bytes / sizeof(float);
-      for (size_t i = 0; i < output_tensor->bytes / sizeof(float); ++i) {
-        float err = output_raw[i] - expected[i];
-        if (err > max_error) max_error = err;
-        err_sum += err * err;
+  }
+  if (region == nullptr) {
+    SharedMemoryRegion created;
+    created.fd = ASharedMemory_create("nn_benchmark_inputs", totalSize);
+    if (created.fd < 0) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Failed to create shared memory of %zu bytes",
+                          totalSize);
+      return false;
+    }
+    void* ptr = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     created.fd, 0);
+    if (ptr == MAP_FAILED) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Failed to map shared memory");
+      close(created.fd);
+      return false;
+    }
+    created.ptr = reinterpret_cast<uint8_t*>(ptr);
+    created.size = totalSize;
+    // Registered memory has to stay alive with the delegate even if the
+    // region is incomplete, hence the region is kept from here on.
+    mSharedMemoryRegions.push_back(std::move(created));
+    region = &mSharedMemoryRegions.back();
+    for (const auto& input : inputs) {
+      const size_t offset = offsets[input.first];
+      ANeuralNetworksMemory* memory = nullptr;
+      if (nnapi->ANeuralNetworksMemory_createFromFd(
+              input.second, PROT_READ, region->fd, offset, &memory) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "Failed to create NNAPI memory from shared memory");
+        // The inputs registered so far stay with the region to be freed
+        // with the delegate.
+        return false;
       }
-      break;
+      uint8_t* hostPtr = region->ptr + offset;
+      TfLiteBufferHandle bufferHandle =
+          mTfliteNnapiDelegate->RegisterNnapiMemory(
+              memory, copySharedMemoryToHost, hostPtr);
+      region->inputs.push_back({memory, bufferHandle, hostPtr, input.second});
     }
-    default:
-      FATAL("Output sensor type %d not supported", output_tensor->type);
   }
-  result->meanSquareErrors[output_index] = err_sum / elements_count;
-  result->maxSingleErrors[output_index] = max_error;
+
+  for (int i = 0; i < inputs.size(); ++i) {
+    const SharedMemoryInput& sharedInput = region->inputs[i];
+    memcpy(sharedInput.hostPtr, inputs[i].first, inputs[i].second);
+    mSharedMemoryInputs[inputs[i].first] = sharedInput;
+  }
+  return true;
 }
 
-bool BenchmarkModel::resizeInputTensors(std::vector<int> shape) {
-  // The benchmark only expects single input tensor, hardcoded as 0.
-  int input = mTfliteInterpreter->inputs()[0];
-  mTfliteInterpreter->ResizeInputTensor(input, shape);
+void BenchmarkModel::releaseSharedMemoryInputs() {
+  if (mTfliteInterpreter) {
+    for (int input : mTfliteInterpreter->inputs()) {
+      mTfliteInterpreter->tensor(input)->buffer_handle =
+          kTfLiteNullBufferHandle;
+    }
+  }
+  mSharedMemoryInputs.clear();
+}
+
+void BenchmarkModel::freeSharedMemoryRegions() {
+  for (SharedMemoryRegion& region : mSharedMemoryRegions) {
+    for (const SharedMemoryInput& input : region.inputs) {
+      NnApiImplementation()->ANeuralNetworksMemory_free(input.memory);
+    }
+    munmap(region.ptr, region.size);
+    close(region.fd);
+  }
+  mSharedMemoryRegions.clear();
+}
+
+bool BenchmarkModel::setSharedMemoryInput(int input_index,
+                                          const uint8_t* dataPtr) {
+  auto sharedInput = mSharedMemoryInputs.find(dataPtr);
+  if (sharedInput == mSharedMemoryInputs.end()) {
+    return false;
+  }
+  int input = mTfliteInterpreter->inputs()[input_index];
+  auto* input_tensor = mTfliteInterpreter->tensor(input);
+  // The handles are owned by this model and only released together with the
+  // delegate, Interpreter::SetBufferHandle() would free the previously bound
+  // one in the delegate instead. Switch the handle directly, data.raw is
+  // filled by the delegate on CPU access.
+  input_tensor->delegate = mTfliteNnapiDelegate.get();
+  input_tensor->buffer_handle = sharedInput->second.bufferHandle;
+  input_tensor->data_is_stale = true;
+  return true;
+}
+
+void BenchmarkModel::saveInferenceOutputs(InferenceResult* result) {
+  result->inferenceOutputsSlot = mOutputArena.allocateSlot();
+  const std::vector<int>& outputs = mTfliteInterpreter->outputs();
+  for (int j = 0; j < outputs.size(); ++j) {
+    auto* output_tensor = mTfliteInterpreter->tensor(outputs[j]);
+    memcpy(mOutputArena.output(result->inferenceOutputsSlot, j),
+           output_tensor->data.raw, mOutputArena.outputSizes()[j]);
+  }
+}
+
+void BenchmarkModel::configureOutputArena() {
+  std::vector<size_t> outputSizes;
+  for (int output : mTfliteInterpreter->outputs()) {
+    outputSizes.push_back(mTfliteInterpreter->tensor(output)->bytes);
+  }
+  mOutputArena.configure(outputSizes);
+}
+
+void BenchmarkModel::getOutputError(const uint8_t* expected_data, size_t length,
+                                    InferenceResult* result, int output_index) {
+  int output = mTfliteInterpreter->outputs()[output_index];
+  auto* output_tensor = mTfliteInterpreter->tensor(output);
+  computeOutputError(output_tensor->type,
+                     reinterpret_cast<const uint8_t*>(output_tensor->data.raw),
+                     output_tensor->bytes, expected_data, length, result,
+                     output_index);
+}
+
+bool BenchmarkModel::setNumThreads(int numThreads) {
+  if (numThreads < 1 && numThreads != -1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Invalid threads count %d",
+                        numThreads);
+    return false;
+  }
+  // Worker threads inherit the affinity of the thread creating them.
+  ScopedCpuAffinity affinity(mCpuAffinityMask);
+  if (!affinity.ok()) {
+    return false;
+  }
+  mNumThreads = numThreads;
+  mTfliteInterpreter->SetNumThreads(numThreads);
+  return true;
+}
+
+bool BenchmarkModel::setCpuAffinity(int cores, uint64_t explicitMask) {
+  uint64_t mask = getCpuCoresMask(cores, explicitMask);
+  if (mask == 0) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Empty CPU affinity mask for cores set %d", cores);
+    return false;
+  }
+  const uint64_t previousMask = mCpuAffinityMask;
+  mCpuAffinityMask = mask;
+  // Setting the threads count recreates the TFLite thread pool from a pinned
+  // thread.
+  if (!setNumThreads(mNumThreads)) {
+    mCpuAffinityMask = previousMask;
+    return false;
+  }
+  return true;
+}
+
+bool BenchmarkModel::setConvergence(const ConvergenceOptions& options) {
+  if (!options.validate()) {
+    return false;
+  }
+  mConvergence = true;
+  mConvergenceOptions = options;
+  return true;
+}
+
+bool BenchmarkModel::resizeInputTensors(std::vector<std::vector<int>> shapes) {
+  long long startTime = currentTimeInNsec();
+  if (!applyInputShapes(std::move(shapes))) {
+    return false;
+  }
+  mStartupProfile.inputResizeTimeSec =
+      nsecToSec(currentTimeInNsec() - startTime);
+  // Outside of the timing above, taking the snapshot takes milliseconds.
+  mMemoryProfile.afterCreate = MemorySnapshot::take();
+  return true;
+}
+
+bool BenchmarkModel::applyInputShapes(std::vector<std::vector<int>> shapes) {
+  if (shapes.size() != mTfliteInterpreter->inputs().size()) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Given/model input shapes (%zu/%zu) count mismatch",
+                        shapes.size(), mTfliteInterpreter->inputs().size());
+    return false;
+  }
+  for (int i = 0; i < shapes.size(); ++i) {
+    int input = mTfliteInterpreter->inputs()[i];
+    if (mTfliteInterpreter->ResizeInputTensor(input, shapes[i]) != kTfLiteOk) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Failed to resize input %d", i);
+      return false;
+    }
+  }
   if (mTfliteInterpreter->AllocateTensors() != kTfLiteOk) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
                         "Failed to allocate tensors!");
     return false;
   }
+  mInputShapes = std::move(shapes);
+  configureOutputArena();
+  mMemoryProfile.arenaBytes = tensorArenaBytes();
   return true;
 }
 
+long long BenchmarkModel::tensorArenaBytes() const {
+  // Arena tensors are slices of one buffer per arena, allocated again by
+  // every AllocateTensors(). Their extent is the used size of the arena.
+  bool allocated = false;
+  long long totalBytes = 0;
+  for (TfLiteAllocationType type : {kTfLiteArenaRw, kTfLiteArenaRwPersistent}) {
+    uintptr_t begin = std::numeric_limits<uintptr_t>::max();
+    uintptr_t end = 0;
+    for (size_t i = 0; i < mTfliteInterpreter->tensors_size(); ++i) {
+      const TfLiteTensor* tensor = mTfliteInterpreter->tensor(i);
+      if (tensor->allocation_type != type || tensor->data.raw == nullptr) {
+        continue;
+      }
+      const uintptr_t data = reinterpret_cast<uintptr_t>(tensor->data.raw);
+      begin = std::min(begin, data);
+      end = std::max(end, data + tensor->bytes);
+    }
+    if (end > begin) {
+      allocated = true;
+      totalBytes += end - begin;
+    }
+  }
+  return allocated ? totalBytes : -1;
+}
+
 bool BenchmarkModel::runInference() {
+  const bool firstInference = mStartupProfile.firstInferenceTimeSec < 0.0f;
+  long long startTime = firstInference ? currentTimeInNsec() : 0;
   auto status = mTfliteInterpreter->Invoke();
   if (status != kTfLiteOk) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to invoke: %d!",
                         (int)status);
     return false;
   }
+  if (firstInference) {
+    mStartupProfile.firstInferenceTimeSec =
+        nsecToSec(currentTimeInNsec() - startTime);
+    mFirstInferenceSnapshotPending = true;
+  }
   return true;
 }
 
+void BenchmarkModel::resetRunResults(size_t expectedInferences) {
+  mOutputArena.reset(expectedInferences);
+  mOpProfiler.reset();
+  mConvergenceStatus = ConvergenceStatus();
+}
+
+void BenchmarkModel::takeFirstInferenceSnapshot() {
+  if (mFirstInferenceSnapshotPending) {
+    mMemoryProfile.afterFirstInference = MemorySnapshot::take();
+    mFirstInferenceSnapshotPending = false;
+  }
+}
+
 bool BenchmarkModel::resetStates() {
+  if (!mHasVariableTensors) {
+    return true;
+  }
   auto status = mTfliteInterpreter->ResetVariableTensors();
   if (status != kTfLiteOk) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
@@ -231,124 +808,1079 @@ bool BenchmarkModel::resetStates() {
   return true;
 }
 
-bool BenchmarkModel::benchmark(
+bool BenchmarkModel::startSequence(InferenceResult* result) {
+  if (!mHasVariableTensors) {
+    result->resetTimeSec = -1.0f;
+    return true;
+  }
+  const long long startTime = currentTimeInNsec();
+  const bool success = resetStates();
+  result->resetTimeSec = nsecToSec(currentTimeInNsec() - startTime);
+  return success;
+}
+
+bool BenchmarkModel::runSingleInference(const InferenceInOut& data, int flags,
+                                        InferenceResult* result) {
+  const int i = result->inputOutputIndex;
+  // For NNAPI systrace usage documentation, see
+  // frameworks/ml/nn/common/include/Tracing.h.
+  kTraceFunc.ATrace_beginSection("[NN_LA_PE]BenchmarkModel::benchmark");
+  kTraceFunc.ATrace_beginSection("[NN_LA_PIO]BenchmarkModel::input");
+  long long inputStartTime = currentTimeInNsec();
+  if (!setInputs(data)) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Input setup %d failed", i);
+    kTraceFunc.ATrace_endSection();
+    kTraceFunc.ATrace_endSection();
+    return false;
+  }
+  kTraceFunc.ATrace_endSection();
+  long long startTime = currentTimeInNsec();
+  const bool success = runInference();
+  kTraceFunc.ATrace_endSection();
+  long long endTime = currentTimeInNsec();
+  if (!success) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Inference %d failed", i);
+    return false;
+  }
+  takeFirstInferenceSnapshot();
+
+  size_t outputsCount = mTfliteInterpreter->outputs().size();
+  result->computeTimeSec = nsecToSec(endTime - startTime);
+  result->inputTimeSec = nsecToSec(startTime - inputStartTime);
+  result->meanSquareErrors.resize(outputsCount);
+  result->maxSingleErrors.resize(outputsCount);
+  result->inferenceOutputsSlot = OutputArena::kNoSlot;
+
+  if ((flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0) {
+    if (outputsCount != data.outputs.size()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Golden/actual outputs (%zu/%zu) count mismatch",
+                          data.outputs.size(), outputsCount);
+      return false;
+    }
+    for (int j = 0; j < outputsCount; ++j) {
+      getOutputError(data.outputs[j].ptr, data.outputs[j].size, result, j);
+    }
+  }
+
+  if ((flags & FLAG_DISCARD_INFERENCE_OUTPUT) == 0) {
+    saveInferenceOutputs(result);
+  }
+  result->outputTimeSec = nsecToSec(currentTimeInNsec() - endTime);
+  return true;
+}
+
+bool BenchmarkModel::runNextInference(
+    const std::vector<InferenceInOutSequence>& inOutData, int flags,
+    InferenceCursor* cursor, InferenceResult* result) {
+  const InferenceInOutSequence& seq = inOutData[cursor->seqIndex];
+  result->resetTimeSec = -1.0f;
+  if (cursor->inferenceIndex == 0 && !startSequence(result)) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Sequence %d state reset failed", cursor->seqIndex);
+    return false;
+  }
+  result->inputOutputSequenceIndex = cursor->seqIndex;
+  result->inputOutputIndex = cursor->inferenceIndex;
+  if (!runSingleInference(seq[cursor->inferenceIndex], flags, result)) {
+    return false;
+  }
+  if (++cursor->inferenceIndex == seq.size()) {
+    cursor->inferenceIndex = 0;
+    cursor->seqIndex = (cursor->seqIndex + 1) % inOutData.size();
+  }
+  return true;
+}
+
+bool BenchmarkModel::warmup(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    int warmupInferencesMaxCount, float warmupTimeout,
+    std::vector<float>* warmupTimesSec) {
+  if (inOutData.empty()) {
+    FATAL("Input/output vector is empty");
+  }
+  // Without a single inference the loop below would never end.
+  if (std::all_of(inOutData.begin(), inOutData.end(),
+                  [](const InferenceInOutSequence& seq) {
+                    return seq.empty();
+                  })) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "No inferences to warm up with");
+    return false;
+  }
+
+  ScopedCpuAffinity affinity(mCpuAffinityMask);
+  if (!affinity.ok()) {
+    return false;
+  }
+
+  // Warmup only cares about latency, skip all output processing.
+  const int flags = FLAG_IGNORE_GOLDEN_OUTPUT | FLAG_DISCARD_INFERENCE_OUTPUT;
+  const long long warmupStartTime = currentTimeInNsec();
+  int inferencesCount = 0;
+  for (int seqInferenceIndex = 0; inferencesCount < warmupInferencesMaxCount;
+       ++seqInferenceIndex) {
+    const int inputOutputSequenceIndex = seqInferenceIndex % inOutData.size();
+    if (!resetStates()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Sequence %d state reset failed",
+                          inputOutputSequenceIndex);
+      return false;
+    }
+    const InferenceInOutSequence& seq = inOutData[inputOutputSequenceIndex];
+    for (int i = 0; i < seq.size() && inferencesCount < warmupInferencesMaxCount;
+         ++i) {
+      InferenceResult result;
+      result.inputOutputSequenceIndex = inputOutputSequenceIndex;
+      result.inputOutputIndex = i;
+      if (!runSingleInference(seq[i], flags, &result)) {
+        return false;
+      }
+      warmupTimesSec->push_back(result.computeTimeSec);
+      inferencesCount++;
+
+      // Unlike the benchmark timeout, warmup is bounded by wall time so that
+      // slow input creation doesn't make it run for much longer than asked.
+      if (warmupTimeout > 0.001 &&
+          nsecToSec(currentTimeInNsec() - warmupStartTime) > warmupTimeout) {
+        return true;
+      }
+    }
+  }
+  return true;
+}
+
+void InferenceSummary::add(const InferenceResult& result) {
+  computeTime.add(result.computeTimeSec);
+  totalInputTimeSec += result.inputTimeSec;
+  totalOutputTimeSec += result.outputTimeSec;
+  for (float mse : result.meanSquareErrors) {
+    sumOfMSEs += mse;
+  }
+  for (float error : result.maxSingleErrors) {
+    maxSingleError = std::max(maxSingleError, error);
+  }
+  if (result.inputOutputIndex == 0) {
+    firstStepTime.add(result.computeTimeSec);
+  } else {
+    laterStepTime.add(result.computeTimeSec);
+  }
+  if (result.resetTimeSec >= 0.0f) {
+    resetTime.add(result.resetTimeSec);
+  }
+}
+
+void InferenceSummary::merge(const InferenceSummary& other) {
+  computeTime.merge(other.computeTime);
+  totalInputTimeSec += other.totalInputTimeSec;
+  totalOutputTimeSec += other.totalOutputTimeSec;
+  wallTimeSec += other.wallTimeSec;
+  sumOfMSEs += other.sumOfMSEs;
+  maxSingleError = std::max(maxSingleError, other.maxSingleError);
+  firstStepTime.merge(other.firstStepTime);
+  laterStepTime.merge(other.laterStepTime);
+  resetTime.merge(other.resetTime);
+}
+
+bool BenchmarkModel::benchmarkLoop(
     const std::vector<InferenceInOutSequence>& inOutData,
     int seqInferencesMaxCount, float timeout, int flags,
-    std::vector<InferenceResult>* results) {
+    const std::function<void(const InferenceResult&)>& resultSink) {
   if (inOutData.empty()) {
     FATAL("Input/output vector is empty");
   }
 
+  ScopedCpuAffinity affinity(mCpuAffinityMask);
+  if (!affinity.ok()) {
+    return false;
+  }
+  if ((flags & FLAG_ZERO_COPY_INPUT) != 0 &&
+      !bindInputsToSharedMemory(inOutData)) {
+    return false;
+  }
+  const bool profileOperators = (flags & FLAG_PROFILE_OPERATORS) != 0;
+  if (profileOperators) {
+    mTfliteInterpreter->SetProfiler(&mOpProfiler);
+  }
+  std::unique_ptr<InputPrefetcher> prefetcher;
+  if ((flags & FLAG_PREFETCH_INPUTS) != 0 &&
+      InputPrefetcher::needed(inOutData)) {
+    std::vector<size_t> inputSizes;
+    for (int input : mTfliteInterpreter->inputs()) {
+      inputSizes.push_back(mTfliteInterpreter->tensor(input)->bytes);
+    }
+    prefetcher.reset(new InputPrefetcher(inOutData, seqInferencesMaxCount,
+                                         inputSizes, kInputPrefetchDepth));
+    mInputPrefetcher = prefetcher.get();
+  }
+  if (mNativeEvaluator) {
+    mNativeEvaluator->reset();
+  }
+  // The tracker stops at maxTimeSec on its own, whichever of it and the
+  // timeout comes first ends the run.
+  std::unique_ptr<ConvergenceTracker> convergence;
+  if (mConvergence && (flags & FLAG_IGNORE_CONVERGENCE) == 0) {
+    convergence.reset(new ConvergenceTracker(mConvergenceOptions));
+    mConvergenceTracker = convergence.get();
+  }
+  MemoryWatermark watermark((flags & FLAG_SAMPLE_PEAK_HEAP) != 0);
+  const int outputFlags =
+      FLAG_IGNORE_GOLDEN_OUTPUT | FLAG_DISCARD_INFERENCE_OUTPUT;
+  bool success;
+  if ((flags & FLAG_ASYNC_VALIDATION) != 0 &&
+      ((flags & outputFlags) != outputFlags || mNativeEvaluator)) {
+    success = benchmarkSequencesAsync(inOutData, seqInferencesMaxCount,
+                                      timeout, flags, resultSink);
+  } else {
+    success = benchmarkSequences(inOutData, seqInferencesMaxCount, timeout,
+                                 flags, mNativeEvaluator.get(),
+                                 /*failed=*/nullptr, resultSink);
+  }
+  if (profileOperators) {
+    mTfliteInterpreter->SetProfiler(nullptr);
+  }
+  if (prefetcher) {
+    prefetcher->stop();
+    mInputPrefetcher = nullptr;
+  }
+  if (convergence) {
+    mConvergenceStatus = convergence->status();
+    mConvergenceTracker = nullptr;
+    __android_log_print(ANDROID_LOG_INFO, LOG_TAG,
+                        "%s after %llu inferences, relative width %f",
+                        mConvergenceStatus.converged ? "Converged"
+                                                     : "Not converged",
+                        static_cast<unsigned long long>(
+                            mConvergenceStatus.inferences),
+                        mConvergenceStatus.relativeWidth);
+  }
+  watermark.stop(&mMemoryProfile.peakHeapBytes, &mMemoryProfile.peakRssKb);
+  // Before the shared memory inputs go, they are part of the steady state.
+  mMemoryProfile.steadyState = MemorySnapshot::take();
+  // Input data pointers are only valid for this call.
+  releaseSharedMemoryInputs();
+  return success;
+}
+
+bool BenchmarkModel::benchmarkSequences(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    int seqInferencesMaxCount, float timeout, int flags,
+    NativeEvaluator* evaluator, const std::atomic<bool>* failed,
+    const std::function<void(const InferenceResult&)>& resultSink) {
+  InferenceResult result;
+  std::vector<EvaluatorOutput> evaluatorOutputs;
   float inferenceTotal = 0.0;
   for (int seqInferenceIndex = 0; seqInferenceIndex < seqInferencesMaxCount;
        ++seqInferenceIndex) {
-    resetStates();
-
     const int inputOutputSequenceIndex = seqInferenceIndex % inOutData.size();
+    if (!startSequence(&result)) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Sequence %d state reset failed",
+                          inputOutputSequenceIndex);
+      return false;
+    }
     const InferenceInOutSequence& seq = inOutData[inputOutputSequenceIndex];
     for (int i = 0; i < seq.size(); ++i) {
-      const InferenceInOut& data = seq[i];
+      if (i > 0) {
+        result.resetTimeSec = -1.0f;
+      }
+      result.inputOutputSequenceIndex = inputOutputSequenceIndex;
+      result.inputOutputIndex = i;
+      if (!runSingleInference(seq[i], flags, &result)) {
+        return false;
+      }
+      if (evaluator != nullptr) {
+        const long long evaluateStartTime = currentTimeInNsec();
+        evaluatorOutputs.clear();
+        for (int output : mTfliteInterpreter->outputs()) {
+          auto* output_tensor = mTfliteInterpreter->tensor(output);
+          evaluatorOutputs.push_back(
+              {output_tensor->type,
+               reinterpret_cast<const uint8_t*>(output_tensor->data.raw),
+               output_tensor->bytes});
+        }
+        if (!evaluator->add(seq[i], i, seq.size(), evaluatorOutputs)) {
+          return false;
+        }
+        result.outputTimeSec +=
+            nsecToSec(currentTimeInNsec() - evaluateStartTime);
+      }
+      resultSink(result);
+      if (failed != nullptr && *failed) {
+        return false;
+      }
+      inferenceTotal += result.computeTimeSec;
+      // Unlike the timeout, convergence can stop in the middle of a sequence.
+      if (mConvergenceTracker != nullptr &&
+          mConvergenceTracker->add(result.computeTimeSec)) {
+        return true;
+      }
+    }
+
+    // Timeout?
+    if (timeout > 0.001 && inferenceTotal > timeout) {
+      return true;
+    }
+  }
+  return true;
+}
+
+bool BenchmarkModel::benchmarkSequencesAsync(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    int seqInferencesMaxCount, float timeout, int flags,
+    const std::function<void(const InferenceResult&)>& resultSink) {
+  std::vector<size_t> outputSizes;
+  std::vector<TfLiteType> outputTypes;
+  for (int output : mTfliteInterpreter->outputs()) {
+    auto* output_tensor = mTfliteInterpreter->tensor(output);
+    outputSizes.push_back(output_tensor->bytes);
+    outputTypes.push_back(output_tensor->type);
+  }
+
+  NativeEvaluator* evaluator = mNativeEvaluator.get();
+  AsyncValidationPipeline pipeline(
+      outputSizes, kAsyncValidationDepth,
+      [this, flags, outputTypes, evaluator,
+       &inOutData](AsyncValidationPipeline::Job* job) {
+        InferenceResult& result = job->result;
+        const size_t outputsCount = job->outputs.size();
+        if ((flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0) {
+          if (outputsCount != job->data->outputs.size()) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                "Golden/actual outputs (%zu/%zu) count mismatch",
+                                job->data->outputs.size(), outputsCount);
+            return false;
+          }
+          for (int j = 0; j < outputsCount; ++j) {
+            computeOutputError(outputTypes[j], job->outputs[j].data(),
+                               job->outputs[j].size(),
+                               job->data->outputs[j].ptr,
+                               job->data->outputs[j].size, &result, j);
+          }
+        }
+        // The arena is only touched by the pipeline worker while it runs.
+        if ((flags & FLAG_DISCARD_INFERENCE_OUTPUT) == 0) {
+          result.inferenceOutputsSlot = mOutputArena.allocateSlot();
+          for (int j = 0; j < outputsCount; ++j) {
+            memcpy(mOutputArena.output(result.inferenceOutputsSlot, j),
+                   job->outputs[j].data(), job->outputs[j].size());
+          }
+        }
+        if (evaluator != nullptr) {
+          std::vector<EvaluatorOutput> evaluatorOutputs;
+          for (int j = 0; j < outputsCount; ++j) {
+            evaluatorOutputs.push_back({outputTypes[j], job->outputs[j].data(),
+                                        job->outputs[j].size()});
+          }
+          const int sequenceLength =
+              inOutData[result.inputOutputSequenceIndex].size();
+          if (!evaluator->add(*job->data, result.inputOutputIndex,
+                              sequenceLength, evaluatorOutputs)) {
+            return false;
+          }
+        }
+        return true;
+      },
+      resultSink);
+
+  // Output processing is left to the pipeline, the inference thread only
+  // snapshots the output tensors. A failed pipeline stops the inferences
+  // after the one in flight.
+  const bool success = benchmarkSequences(
+      inOutData, seqInferencesMaxCount, timeout,
+      flags | FLAG_IGNORE_GOLDEN_OUTPUT | FLAG_DISCARD_INFERENCE_OUTPUT,
+      /*evaluator=*/nullptr, &pipeline.failed(),
+      [this, &pipeline, &inOutData](const InferenceResult& result) {
+        long long snapshotStartTime = currentTimeInNsec();
+        AsyncValidationPipeline::Job* job = pipeline.acquire();
+        if (job == nullptr) {
+          return;
+        }
+        job->data = &inOutData[result.inputOutputSequenceIndex]
+                              [result.inputOutputIndex];
+        job->result = result;
+        for (int j = 0; j < job->outputs.size(); ++j) {
+          auto* output_tensor =
+              mTfliteInterpreter->tensor(mTfliteInterpreter->outputs()[j]);
+          memcpy(job->outputs[j].data(), output_tensor->data.raw,
+                 job->outputs[j].size());
+        }
+        // Includes waiting for a free snapshot buffer, if validation can't
+        // keep up it slows down the inference thread.
+        job->result.outputTimeSec =
+            nsecToSec(currentTimeInNsec() - snapshotStartTime);
+        pipeline.submit(job);
+      });
+  const bool validationSuccess = pipeline.finish();
+  if (!validationSuccess) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Asynchronous output validation failed");
+  }
+  return success && validationSuccess;
+}
+
+bool BenchmarkModel::benchmark(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    int seqInferencesMaxCount, float timeout, int flags,
+    std::vector<InferenceResult>* results) {
+  // Reserve output storage for the expected number of inferences up front,
+  // the timeout may stop the benchmark earlier.
+  size_t expectedInferences = 0;
+  if ((flags & FLAG_DISCARD_INFERENCE_OUTPUT) == 0 && !inOutData.empty()) {
+    size_t allSequencesSize = 0;
+    for (const auto& seq : inOutData) {
+      allSequencesSize += seq.size();
+    }
+    expectedInferences = (seqInferencesMaxCount / inOutData.size()) *
+                         allSequencesSize;
+    for (int k = 0; k < seqInferencesMaxCount % inOutData.size(); ++k) {
+      expectedInferences += inOutData[k].size();
+    }
+  }
+  resetRunResults(expectedInferences);
+  return benchmarkLoop(inOutData, seqInferencesMaxCount, timeout, flags,
+                       [results](const InferenceResult& result) {
+                         results->push_back(result);
+                       });
+}
 
-      // For NNAPI systrace usage documentation, see
-      // frameworks/ml/nn/common/include/Tracing.h.
-      kTraceFunc.ATrace_beginSection("[NN_LA_PE]BenchmarkModel::benchmark");
-      kTraceFunc.ATrace_beginSection("[NN_LA_PIO]BenchmarkModel::input");
-      if (data.input) {
-        setInput(data.input, data.input_size);
-      } else {
-        int input = mTfliteInterpreter->inputs()[0];
-        auto* input_tensor = mTfliteInterpreter->tensor(input);
-        if (!data.createInput((uint8_t*)input_tensor->data.raw,
-                              input_tensor->bytes)) {
+bool BenchmarkModel::benchmarkStreaming(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    int seqInferencesMaxCount, float timeout, int flags,
+    InferenceSummary* summary) {
+  resetRunResults();
+  const long long startTime = currentTimeInNsec();
+  const bool success =
+      benchmarkLoop(inOutData, seqInferencesMaxCount, timeout,
+                    flags | FLAG_DISCARD_INFERENCE_OUTPUT,
+                    [summary](const InferenceResult& result) {
+                      summary->add(result);
+                    });
+  summary->wallTimeSec = nsecToSec(currentTimeInNsec() - startTime);
+  return success;
+}
+
+bool BenchmarkModel::benchmarkSustained(
+    const std::vector<InferenceInOutSequence>& inOutData, float durationSec,
+    float windowSec, int flags, const SysfsSensors* sensors,
+    InferenceSummary* summary, std::vector<SustainedWindow>* windows) {
+  if (windowSec <= 0.f || durationSec <= 0.f) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Invalid sustained duration/window %f/%f", durationSec,
+                        windowSec);
+    return false;
+  }
+  resetRunResults();
+  const long long startTime = currentTimeInNsec();
+  long long windowStartTime = startTime;
+  // Reused for each window, its histogram is too large to keep per window.
+  LatencyStats windowStats;
+  auto closeWindow = [&](long long endTime) {
+    SustainedWindow window;
+    window.startTimeSec = nsecToSec(windowStartTime - startTime);
+    window.durationSec = nsecToSec(endTime - windowStartTime);
+    window.count = windowStats.count();
+    window.meanTimeSec = windowStats.meanSec();
+    window.p99TimeSec = windowStats.percentileSec(0.99);
+    window.maxTimeSec = windowStats.maxSec();
+    if (sensors != nullptr) {
+      window.sensorValues = sensors->read();
+    }
+    windows->push_back(std::move(window));
+    windowStats.clear();
+    windowStartTime = endTime;
+  };
+
+  const bool success = benchmarkLoop(
+      inOutData, std::numeric_limits<int>::max(), durationSec,
+      flags | FLAG_DISCARD_INFERENCE_OUTPUT | FLAG_IGNORE_CONVERGENCE,
+      [&](const InferenceResult& result) {
+        summary->add(result);
+        windowStats.add(result.computeTimeSec);
+        const long long now = currentTimeInNsec();
+        if (nsecToSec(now - windowStartTime) >= windowSec) {
+          closeWindow(now);
+        }
+      });
+  const long long endTime = currentTimeInNsec();
+  if (windowStats.count() > 0) {
+    closeWindow(endTime);
+  }
+  summary->wallTimeSec = nsecToSec(endTime - startTime);
+  return success;
+}
+
+bool BenchmarkModel::createThreadModels(
+    const std::vector<InferenceInOutSequence>& inOutData, int threadsCount,
+    std::vector<std::unique_ptr<BenchmarkModel>>* replicas,
+    std::vector<BenchmarkModel*>* models) {
+  // Input creators aren't safe to call concurrently from the benchmark
+  // threads, the creators of a dataset share one Java image processor.
+  for (const auto& seq : inOutData) {
+    for (const auto& data : seq) {
+      for (const auto& input : data.inputs) {
+        if (input.ptr == nullptr) {
           __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                              "Input creation %d failed", i);
+                              "Input creators are not supported by "
+                              "multi-threaded benchmarks");
           return false;
         }
       }
-      kTraceFunc.ATrace_endSection();
-      long long startTime = currentTimeInUsec();
-      const bool success = runInference();
-      kTraceFunc.ATrace_endSection();
-      long long endTime = currentTimeInUsec();
-      if (!success) {
-        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Inference %d failed",
-                            i);
+    }
+  }
+
+  // This model serves the first thread, all other threads get a replica with
+  // its own interpreter (and delegate). Replicas are created, compiled and
+  // run once before any thread starts, the caller is expected to have warmed
+  // up this model.
+  models->assign(1, this);
+  for (int k = 1; k < threadsCount; ++k) {
+    replicas->push_back(createReplica());
+    std::vector<float> warmupTimesSec;
+    if (!replicas->back() ||
+        !replicas->back()->warmup(inOutData, 1, 0.0f, &warmupTimesSec)) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Failed to create interpreter replica %d", k);
+      return false;
+    }
+    models->push_back(replicas->back().get());
+  }
+
+  return true;
+}
+
+bool BenchmarkModel::benchmarkConcurrent(
+    const std::vector<InferenceInOutSequence>& inOutData, int threadsCount,
+    int seqInferencesMaxCount, float timeout, int flags,
+    std::vector<InferenceSummary>* summaries) {
+  if (threadsCount < 1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Invalid concurrent threads count %d", threadsCount);
+    return false;
+  }
+  std::vector<std::unique_ptr<BenchmarkModel>> replicas;
+  std::vector<BenchmarkModel*> models;
+  if (!createThreadModels(inOutData, threadsCount, &replicas, &models)) {
+    return false;
+  }
+
+  summaries->assign(threadsCount, InferenceSummary());
+  std::promise<void> start;
+  std::shared_future<void> started = start.get_future().share();
+  std::atomic<bool> success(true);
+  std::vector<std::thread> threads;
+  for (int k = 0; k < threadsCount; ++k) {
+    threads.emplace_back([&, k]() {
+      started.wait();
+      if (!models[k]->benchmarkStreaming(inOutData, seqInferencesMaxCount,
+                                         timeout,
+                                         flags | FLAG_IGNORE_CONVERGENCE,
+                                         &(*summaries)[k])) {
+        success = false;
+      }
+    });
+  }
+  start.set_value();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return success;
+}
+
+bool BenchmarkModel::benchmarkOpenLoop(
+    const std::vector<InferenceInOutSequence>& inOutData, float arrivalRate,
+    int distribution, int threadsCount, float durationSec, int flags,
+    OpenLoopSummary* summary) {
+  if (inOutData.empty()) {
+    FATAL("Input/output vector is empty");
+  }
+  if (arrivalRate <= 0.f || durationSec <= 0.f || threadsCount < 1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Invalid open-loop rate/duration/threads %f/%f/%d",
+                        arrivalRate, durationSec, threadsCount);
+    return false;
+  }
+  std::vector<std::unique_ptr<BenchmarkModel>> replicas;
+  std::vector<BenchmarkModel*> models;
+  if (!createThreadModels(inOutData, threadsCount, &replicas, &models)) {
+    return false;
+  }
+
+  resetRunResults();
+  *summary = OpenLoopSummary();
+  summary->arrivalRate = arrivalRate;
+  // Arrivals are scheduled from shortly after the threads are started, so
+  // that the first ones don't queue behind the thread creation.
+  const long long kStartDelayNsec = 10 * 1000 * 1000;
+  const long long startTime = currentTimeInNsec() + kStartDelayNsec;
+  const long long durationNsec = static_cast<long long>(durationSec * 1e9);
+  const long long drainEndTime = startTime + 2 * durationNsec;
+  ArrivalProcess arrivals(arrivalRate, distribution, startTime,
+                          startTime + durationNsec, /*seed=*/1);
+
+  std::mutex summaryMutex;
+  int served = 0;
+  std::atomic<bool> success(true);
+  std::vector<std::thread> threads;
+  for (int k = 0; k < threadsCount; ++k) {
+    threads.emplace_back([&, k]() {
+      BenchmarkModel* model = models[k];
+      // Same as benchmarkConcurrent(), where benchmarkLoop() sets it.
+      ScopedCpuAffinity affinity(model->mCpuAffinityMask);
+      if (!affinity.ok()) {
+        success = false;
+        return;
+      }
+      // Every server walks the dataset on its own, so that sequences with
+      // state are fed in order to the same interpreter.
+      InferenceCursor cursor;
+      cursor.seqIndex = k % inOutData.size();
+      long long arrivalTime;
+      while (success && arrivals.next(&arrivalTime)) {
+        if (currentTimeInNsec() > drainEndTime) {
+          std::lock_guard<std::mutex> lock(summaryMutex);
+          summary->dropped += 1 + arrivals.drain();
+          break;
+        }
+        timespec wakeup;
+        wakeup.tv_sec = arrivalTime / 1000000000LL;
+        wakeup.tv_nsec = arrivalTime % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup,
+                               nullptr) == EINTR) {
+        }
+
+        InferenceResult result;
+        const long long serviceStartTime = currentTimeInNsec();
+        if (!model->runNextInference(inOutData,
+                                     flags | FLAG_DISCARD_INFERENCE_OUTPUT,
+                                     &cursor, &result)) {
+          success = false;
+          break;
+        }
+        const long long serviceEndTime = currentTimeInNsec();
+
+        std::lock_guard<std::mutex> lock(summaryMutex);
+        summary->service.add(result);
+        summary->queueTime.add(nsecToSec(serviceStartTime - arrivalTime));
+        summary->responseTime.add(nsecToSec(serviceEndTime - arrivalTime));
+        ++served;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const double wallTimeSec = nsecToSec(currentTimeInNsec() - startTime);
+  summary->service.wallTimeSec = wallTimeSec;
+  summary->throughput = wallTimeSec > 0 ? served / wallTimeSec : 0.0f;
+  return success;
+}
+
+bool BenchmarkModel::benchmarkOpenLoopSweep(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    const std::vector<float>& arrivalRates, int distribution, int threadsCount,
+    float durationSec, int flags, std::vector<OpenLoopSummary>* summaries) {
+  summaries->assign(arrivalRates.size(), OpenLoopSummary());
+  bool success = true;
+  for (int k = 0; k < arrivalRates.size() && success; ++k) {
+    success = benchmarkOpenLoop(inOutData, arrivalRates[k], distribution,
+                                threadsCount, durationSec, flags,
+                                &(*summaries)[k]);
+  }
+  return success;
+}
+
+bool BenchmarkModel::benchmarkThreadSweep(
+    const std::vector<InferenceInOutSequence>& inOutData, int maxThreads,
+    int seqInferencesMaxCount, float timeout, int flags,
+    std::vector<InferenceSummary>* summaries) {
+  if (maxThreads < 1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Invalid max threads count %d", maxThreads);
+    return false;
+  }
+  const int numThreads = mNumThreads;
+  summaries->assign(maxThreads, InferenceSummary());
+  bool success = true;
+  for (int n = 1; n <= maxThreads && success; ++n) {
+    // The thread pool is recreated for every thread count.
+    std::vector<float> warmupTimesSec;
+    success = setNumThreads(n) &&
+              warmup(inOutData, 1, 0.0f, &warmupTimesSec) &&
+              benchmarkStreaming(inOutData, seqInferencesMaxCount, timeout,
+                                 flags | FLAG_IGNORE_CONVERGENCE,
+                                 &(*summaries)[n - 1]);
+  }
+  setNumThreads(numThreads);
+  return success;
+}
+
+bool BenchmarkModel::benchmarkDelegateOptionsSweep(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    const std::vector<DelegateOptions>& options, int seqInferencesMaxCount,
+    float timeout, int flags, std::vector<InferenceSummary>* summaries) {
+  const DelegateOptions originalOptions = mDelegateOptions;
+  summaries->assign(options.size(), InferenceSummary());
+  bool success = true;
+  for (int k = 0; k < options.size() && success; ++k) {
+    DelegateOptions sweepOptions = options[k];
+    sweepOptions.deviceName = originalOptions.deviceName;
+    sweepOptions.cacheDir = originalOptions.cacheDir;
+    std::vector<float> warmupTimesSec;
+    success = reinitInterpreter(sweepOptions) &&
+              warmup(inOutData, 1, 0.0f, &warmupTimesSec) &&
+              benchmarkStreaming(inOutData, seqInferencesMaxCount, timeout,
+                                 flags | FLAG_IGNORE_CONVERGENCE,
+                                 &(*summaries)[k]);
+  }
+  if (!reinitInterpreter(originalOptions)) {
+    success = false;
+  }
+  return success;
+}
+
+bool BenchmarkModel::benchmarkExecutionModes(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    const std::vector<int>& modes, int seqInferencesMaxCount, float timeout,
+    int flags, std::vector<InferenceSummary>* summaries) {
+  if (!mUseNnapi) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Execution modes need the NNAPI delegate");
+    return false;
+  }
+  std::vector<DelegateOptions> options(modes.size(), mDelegateOptions);
+  for (int k = 0; k < modes.size(); ++k) {
+    if (modes[k] != EXECUTION_MODE_SYNC && modes[k] != EXECUTION_MODE_BURST) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Invalid execution mode %d", modes[k]);
+      return false;
+    }
+    if (std::find(modes.begin(), modes.begin() + k, modes[k]) !=
+        modes.begin() + k) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Execution mode %d given twice", modes[k]);
+      return false;
+    }
+    options[k].useBurst = modes[k] == EXECUTION_MODE_BURST;
+  }
+
+  // Compiling a mode once per round would dominate the run, every mode keeps
+  // its interpreter across all rounds instead.
+  const int modesCount = modes.size();
+  std::vector<std::unique_ptr<BenchmarkModel>> replicas;
+  std::vector<BenchmarkModel*> models;
+  for (int k = 0; k < modesCount; ++k) {
+    if (options[k].useBurst == mDelegateOptions.useBurst) {
+      models.push_back(this);
+      continue;
+    }
+    replicas.push_back(createReplica(options[k]));
+    std::vector<float> warmupTimesSec;
+    if (!replicas.back() ||
+        !replicas.back()->warmup(inOutData, 1, 0.0f, &warmupTimesSec)) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Failed to create interpreter for mode %d",
+                          modes[k]);
+      return false;
+    }
+    models.push_back(replicas.back().get());
+  }
+
+  summaries->assign((1 + EXECUTION_MODE_ROUNDS) * modesCount,
+                    InferenceSummary());
+  for (int r = 0; r < EXECUTION_MODE_ROUNDS; ++r) {
+    for (int i = 0; i < modesCount; ++i) {
+      const int k = r % 2 == 0 ? i : modesCount - 1 - i;
+      InferenceSummary roundSummary;
+      if (!models[k]->benchmarkStreaming(
+              inOutData,
+              std::max(1, seqInferencesMaxCount / EXECUTION_MODE_ROUNDS),
+              timeout / EXECUTION_MODE_ROUNDS, flags | FLAG_IGNORE_CONVERGENCE,
+              &roundSummary)) {
         return false;
       }
+      (*summaries)[k].merge(roundSummary);
+      (*summaries)[(1 + r) * modesCount + k] = roundSummary;
+    }
+  }
+  return true;
+}
 
-      float inferenceTime =
-          static_cast<float>(endTime - startTime) / 1000000.0f;
-      size_t outputsCount = mTfliteInterpreter->outputs().size();
-      InferenceResult result{
-          inferenceTime, {}, {}, {}, inputOutputSequenceIndex, i};
-      result.meanSquareErrors.resize(outputsCount);
-      result.maxSingleErrors.resize(outputsCount);
-      result.inferenceOutputs.resize(outputsCount);
-
-      if ((flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0) {
-        if (outputsCount != data.outputs.size()) {
+bool BenchmarkModel::benchmarkBatchSweep(
+    const std::vector<InferenceInOutSequence>& inOutData,
+    const std::vector<int>& batchSizes, int batchesMaxCount, float timeout,
+    int flags, std::vector<InferenceSummary>* summaries) {
+  if (inOutData.empty()) {
+    FATAL("Input/output vector is empty");
+  }
+
+  resetRunResults();
+  std::vector<const InferenceInOut*> samples;
+  for (const auto& seq : inOutData) {
+    for (const auto& data : seq) {
+      if (data.inputs.size() != mTfliteInterpreter->inputs().size()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "Given/model inputs (%zu/%zu) count mismatch",
+                            data.inputs.size(),
+                            mTfliteInterpreter->inputs().size());
+        return false;
+      }
+      samples.push_back(&data);
+    }
+  }
+  if (samples.empty()) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "No batch samples");
+    return false;
+  }
+
+  std::vector<std::vector<int>> baseShapes;
+  for (int input : mTfliteInterpreter->inputs()) {
+    const TfLiteIntArray* dims = mTfliteInterpreter->tensor(input)->dims;
+    if (dims == nullptr || dims->size == 0) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Input %d has no batch dimension", input);
+      return false;
+    }
+    baseShapes.emplace_back(dims->data, dims->data + dims->size);
+  }
+
+  summaries->assign(batchSizes.size(), InferenceSummary());
+  bool success = true;
+  for (int b = 0; b < batchSizes.size() && success; ++b) {
+    success = benchmarkBatch(samples, baseShapes, batchSizes[b],
+                             batchesMaxCount, timeout, flags,
+                             &(*summaries)[b]);
+  }
+  if (!applyInputShapes(baseShapes)) {
+    success = false;
+  }
+  return success;
+}
+
+bool BenchmarkModel::benchmarkBatch(
+    const std::vector<const InferenceInOut*>& samples,
+    const std::vector<std::vector<int>>& baseShapes, int batchSize,
+    int batchesMaxCount, float timeout, int flags, InferenceSummary* summary) {
+  if (batchSize < 1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Invalid batch size %d",
+                        batchSize);
+    return false;
+  }
+  std::vector<std::vector<int>> shapes = baseShapes;
+  for (auto& shape : shapes) {
+    shape[0] *= batchSize;
+  }
+  ScopedCpuAffinity affinity(mCpuAffinityMask);
+  if (!affinity.ok() || !applyInputShapes(shapes)) {
+    return false;
+  }
+
+  const std::vector<int>& inputs = mTfliteInterpreter->inputs();
+  const std::vector<int>& outputs = mTfliteInterpreter->outputs();
+  // Outputs are split into samples along dim 0, like the inputs.
+  for (int j = 0; j < outputs.size(); ++j) {
+    const TfLiteIntArray* dims = mTfliteInterpreter->tensor(outputs[j])->dims;
+    if (dims == nullptr || dims->size == 0 || dims->data[0] % batchSize != 0) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Output %d is not batched along dim 0", j);
+      return false;
+    }
+  }
+  // Per batch result, golden output errors averaged over the samples.
+  InferenceResult result;
+  result.meanSquareErrors.resize(outputs.size());
+  result.maxSingleErrors.resize(outputs.size());
+  result.inferenceOutputsSlot = OutputArena::kNoSlot;
+  InferenceResult sampleResult;
+  sampleResult.meanSquareErrors.resize(outputs.size());
+  sampleResult.maxSingleErrors.resize(outputs.size());
+
+  const long long startTime = currentTimeInNsec();
+  size_t nextSample = 0;
+  float inferenceTotal = 0.0;
+  // Batch -1 is the warmup batch, the first inference after a resize may
+  // have to recompile the model.
+  for (int batchIndex = -1; batchIndex < batchesMaxCount; ++batchIndex) {
+    if (!resetStates()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Batch %d state reset failed", batchIndex);
+      return false;
+    }
+
+    long long inputStartTime = currentTimeInNsec();
+    for (int j = 0; j < inputs.size(); ++j) {
+      auto* input_tensor = mTfliteInterpreter->tensor(inputs[j]);
+      input_tensor->buffer_handle = kTfLiteNullBufferHandle;
+      const size_t sampleBytes = input_tensor->bytes / batchSize;
+      for (int k = 0; k < batchSize; ++k) {
+        const InferenceInput& input =
+            samples[(nextSample + k) % samples.size()]->inputs[j];
+        uint8_t* sampleData =
+            reinterpret_cast<uint8_t*>(input_tensor->data.raw) +
+            k * sampleBytes;
+        if (input.ptr) {
+          if (input.size != sampleBytes) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                "Input %d size mismatch, expected %zu, got %zu",
+                                j, sampleBytes, input.size);
+            return false;
+          }
+          memcpy(sampleData, input.ptr, sampleBytes);
+        } else if (!input.createInput(sampleData, sampleBytes)) {
           __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
-                              "Golden/actual outputs (%zu/%zu) count mismatch",
-                              data.outputs.size(), outputsCount);
+                              "Input %d creation failed", j);
           return false;
         }
-        for (int j = 0; j < outputsCount; ++j) {
-          getOutputError(data.outputs[j].ptr, data.outputs[j].size, &result, j);
-        }
       }
+    }
+
+    long long inferenceStartTime = currentTimeInNsec();
+    if (!runInference()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Batch inference %d failed", batchIndex);
+      return false;
+    }
+    long long inferenceEndTime = currentTimeInNsec();
+    takeFirstInferenceSnapshot();
 
-      if ((flags & FLAG_DISCARD_INFERENCE_OUTPUT) == 0) {
-        for (int j = 0; j < outputsCount; ++j) {
-          saveInferenceOutput(&result, j);
+    if ((flags & FLAG_IGNORE_GOLDEN_OUTPUT) == 0) {
+      for (int j = 0; j < outputs.size(); ++j) {
+        auto* output_tensor = mTfliteInterpreter->tensor(outputs[j]);
+        const size_t sampleBytes = output_tensor->bytes / batchSize;
+        result.meanSquareErrors[j] = 0.0f;
+        result.maxSingleErrors[j] = 0.0f;
+        for (int k = 0; k < batchSize; ++k) {
+          const InferenceInOut* sample =
+              samples[(nextSample + k) % samples.size()];
+          if (sample->outputs.size() != outputs.size()) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                "Golden/actual outputs (%zu/%zu) count mismatch",
+                                sample->outputs.size(), outputs.size());
+            return false;
+          }
+          if (sample->outputs[j].size != sampleBytes) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                "Output %d size mismatch, expected %zu, got %zu",
+                                j, sampleBytes, sample->outputs[j].size);
+            return false;
+          }
+          computeOutputError(
+              output_tensor->type,
+              reinterpret_cast<const uint8_t*>(output_tensor->data.raw) +
+                  k * sampleBytes,
+              sampleBytes, sample->outputs[j].ptr, sample->outputs[j].size,
+              &sampleResult, j);
+          result.meanSquareErrors[j] += sampleResult.meanSquareErrors[j];
+          result.maxSingleErrors[j] = std::max(result.maxSingleErrors[j],
+                                               sampleResult.maxSingleErrors[j]);
         }
+        // All samples are the same size, so this is the MSE of the batch.
+        result.meanSquareErrors[j] /= batchSize;
       }
-      results->push_back(result);
-      inferenceTotal += inferenceTime;
+    }
+    nextSample = (nextSample + batchSize) % samples.size();
+    if (batchIndex < 0) {
+      continue;
     }
 
-    // Timeout?
+    result.computeTimeSec = nsecToSec(inferenceEndTime - inferenceStartTime);
+    result.inputTimeSec = nsecToSec(inferenceStartTime - inputStartTime);
+    result.outputTimeSec = nsecToSec(currentTimeInNsec() - inferenceEndTime);
+    summary->add(result);
+
+    inferenceTotal += result.computeTimeSec;
     if (timeout > 0.001 && inferenceTotal > timeout) {
-      return true;
+      break;
+    }
+  }
+  summary->wallTimeSec = nsecToSec(currentTimeInNsec() - startTime);
+  return true;
+}
+
+bool BenchmarkModel::benchmarkColdStart(
+    const InferenceInOut& input, int iterations,
+    std::vector<StartupProfile>* profiles) {
+  resetRunResults();
+  for (int i = 0; i < iterations; ++i) {
+    std::unique_ptr<BenchmarkModel> model(new BenchmarkModel());
+    model->mNumThreads = mNumThreads;
+    model->mCpuAffinityMask = mCpuAffinityMask;
+    ScopedCpuAffinity affinity(mCpuAffinityMask);
+    if (!affinity.ok() ||
+        !model->init(mModelFile.c_str(), mUseNnapi,
+                     mEnableIntermediateTensorsDump, mDelegateOptions)) {
+      return false;
+    }
+    if (!mInputShapes.empty() && !model->resizeInputTensors(mInputShapes)) {
+      return false;
+    }
+    if (!model->setInputs(input) || !model->runInference()) {
+      return false;
     }
+    model->takeFirstInferenceSnapshot();
+
+    StartupProfile profile = model->mStartupProfile;
+    long long destroyStartTime = currentTimeInNsec();
+    model.reset();
+    profile.destroyTimeSec = nsecToSec(currentTimeInNsec() - destroyStartTime);
+    profiles->push_back(profile);
   }
   return true;
 }
 
 bool BenchmarkModel::dumpAllLayers(
-    const char* path, const std::vector<InferenceInOutSequence>& inOutData) {
+    const char* path, const std::vector<InferenceInOutSequence>& inOutData,
+    const TensorDumpOptions& options) {
   if (inOutData.empty()) {
     FATAL("Input/output vector is empty");
   }
 
+  const std::string dumpPath = std::string(path) + "/tensors.dump";
+  std::unique_ptr<TensorDumpWriter> writer = TensorDumpWriter::create(
+      dumpPath.c_str(), options.compress, kTensorDumpDepth);
+  if (!writer) {
+    return false;
+  }
+
   for (int seqInferenceIndex = 0; seqInferenceIndex < inOutData.size();
        ++seqInferenceIndex) {
-    resetStates();
+    if (!resetStates()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Sequence %d state reset failed", seqInferenceIndex);
+      return false;
+    }
 
     const InferenceInOutSequence& seq = inOutData[seqInferenceIndex];
     for (int i = 0; i < seq.size(); ++i) {
       const InferenceInOut& data = seq[i];
-      setInput(data.input, data.input_size);
+      if (!setInputs(data)) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                            "Input setup %d failed", i);
+        return false;
+      }
       const bool success = runInference();
       if (!success) {
         __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Inference %d failed",
                             i);
         return false;
       }
+      takeFirstInferenceSnapshot();
 
       for (int tensor = 0; tensor < mTfliteInterpreter->tensors_size();
            ++tensor) {
         auto* output_tensor = mTfliteInterpreter->tensor(tensor);
-        if (output_tensor->data.raw == nullptr) {
+        if (output_tensor->data.raw == nullptr ||
+            !options.matches(tensor, output_tensor->name)) {
           continue;
         }
-        char fullpath[1024];
-        snprintf(fullpath, 1024, "%s/dump_%.3d_seq_%.3d_tensor_%.3d", path,
-                 seqInferenceIndex, i, tensor);
-        FILE* f = fopen(fullpath, "wb");
-        fwrite(output_tensor->data.raw, output_tensor->bytes, 1, f);
-        fclose(f);
+        if (!writer->add(seqInferenceIndex, i, tensor, output_tensor->type,
+                         output_tensor->name, output_tensor->data.raw,
+                         output_tensor->bytes)) {
+          return false;
+        }
       }
     }
   }
-  return true;
+  return writer->finish();
 }
@@ -17,10 +17,21 @@
 #ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_RUN_TFLITE_H
 #define COM_EXAMPLE_ANDROID_NN_BENCHMARK_RUN_TFLITE_H
 
+#include "tensorflow/lite/delegates/nnapi/nnapi_delegate.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/model.h"
 
+#include "convergence.h"
+#include "latency_stats.h"
+#include "memory_footprint.h"
+#include "op_profiler.h"
+#include "output_arena.h"
+
 #include <unistd.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 struct InferenceOutput {
@@ -28,16 +39,23 @@ struct InferenceOutput {
   size_t size;
 };
 
-// Inputs and expected outputs for inference
-struct InferenceInOut {
+// Data for a single model input tensor
+struct InferenceInput {
   // Input can either be directly specified as a pointer or indirectly with
   // the createInput callback. This is needed for large datasets where
   // allocating memory for all inputs at once is not feasible.
-  uint8_t* input;
-  size_t input_size;
+  uint8_t* ptr;
+  size_t size;
+  std::function<bool(uint8_t*, size_t)> createInput;
+};
 
+// Inputs and expected outputs for inference
+struct InferenceInOut {
+  // One entry per model input, in the model input order.
+  std::vector<InferenceInput> inputs;
   std::vector<InferenceOutput> outputs;
-  std::function<bool(uint8_t*, size_t)> createInput;
+  // Class index for classifier evaluators, -1 if not set.
+  int expectedClass = -1;
 };
 
 // Inputs and expected outputs for an inference sequence.
@@ -45,55 +63,572 @@ using InferenceInOutSequence = std::vector<InferenceInOut>;
 
 // Result of a single inference
 struct InferenceResult {
+  // Time spent in Interpreter::Invoke()
   float computeTimeSec;
+  // Time spent setting up the input tensor (setInput or createInput)
+  float inputTimeSec;
+  // Time spent comparing against golden output and saving the output
+  float outputTimeSec;
   // MSE for each output
   std::vector<float> meanSquareErrors;
   // Max single error for each output
   std::vector<float> maxSingleErrors;
-  // Outputs
-  std::vector<std::vector<uint8_t>> inferenceOutputs;
+  // Slot of the saved outputs in BenchmarkModel::savedOutputs(), or
+  // OutputArena::kNoSlot if outputs were discarded
+  size_t inferenceOutputsSlot;
   int inputOutputSequenceIndex;
   int inputOutputIndex;
+  // Time spent resetting the model states before this inference, -1 if they
+  // weren't reset (not the start of a sequence, or a stateless model)
+  float resetTimeSec = -1.0f;
+};
+
+// Position of a model driven one inference at a time in its inputs, see
+// BenchmarkModel::runNextInference().
+struct InferenceCursor {
+  int seqIndex = 0;
+  int inferenceIndex = 0;
+};
+
+// Aggregated results of a benchmark run, constant memory regardless of the
+// number of inferences.
+struct InferenceSummary {
+  // Invoke() latency statistics
+  LatencyStats computeTime;
+  double totalInputTimeSec = 0.0;
+  double totalOutputTimeSec = 0.0;
+  // Wall time of the whole benchmark run, including time spent outside of
+  // the inferences
+  double wallTimeSec = 0.0;
+  // Sum of MSEs of all outputs of all inferences
+  double sumOfMSEs = 0.0;
+  // Max single error across all outputs of all inferences
+  float maxSingleError = 0.0f;
+  // Invoke() latency of the first inference of every sequence and of the
+  // later ones, the first step vs steady state latency of streaming models
+  LatencyStats firstStepTime;
+  LatencyStats laterStepTime;
+  // State resets at the start of sequences, see InferenceResult::resetTimeSec
+  LatencyStats resetTime;
+
+  void add(const InferenceResult& result);
+  // Adds the statistics of another run, wall times add up.
+  void merge(const InferenceSummary& other);
+};
+
+// One fixed wall time window of BenchmarkModel::benchmarkSustained().
+struct SustainedWindow {
+  // Seconds of wall time since the start of the run.
+  float startTimeSec = 0.0f;
+  // At least the window length, the window closes with the first inference
+  // ending after it.
+  float durationSec = 0.0f;
+  // Invoke() latency statistics of the inferences ending in this window
+  int count = 0;
+  float meanTimeSec = 0.0f;
+  float p99TimeSec = 0.0f;
+  float maxTimeSec = 0.0f;
+  // SysfsSensors::read() at the end of the window, empty without sensors.
+  std::vector<float> sensorValues;
+};
+
+// Result of BenchmarkModel::benchmarkOpenLoop() at one arrival rate.
+struct OpenLoopSummary {
+  // Offered load, requests per second
+  float arrivalRate = 0.0f;
+  // Service time of the requests, from input setup to output processing.
+  // computeTime is the Invoke() time as in every other summary.
+  InferenceSummary service;
+  // Scheduled arrival until the start of service, includes the wake up
+  // latency of the serving thread
+  LatencyStats queueTime;
+  // Scheduled arrival until the end of service
+  LatencyStats responseTime;
+  // Requests served per second of wall time
+  float throughput = 0.0f;
+  // Requests of the schedule that were never served, see
+  // benchmarkOpenLoop()
+  int dropped = 0;
+};
+
+// Time spent in each stage of BenchmarkModel::create() and in the first
+// inference.
+struct StartupProfile {
+  // FlatBufferModel::BuildFromFile(), 0 for models sharing a FlatBuffer
+  float modelLoadTimeSec = 0.0f;
+  // InterpreterBuilder, until the delegate is applied
+  float interpreterBuildTimeSec = 0.0f;
+  // ModifyGraphWithDelegate(), this is where NNAPI compiles the model
+  float delegateApplyTimeSec = 0.0f;
+  // Last resizeInputTensors() call, which may recompile the model, 0 if the
+  // inputs were never resized
+  float inputResizeTimeSec = 0.0f;
+  // First Invoke(), -1 until the first inference has run
+  float firstInferenceTimeSec = -1.0f;
+  // Destruction of the model, only measured by benchmarkColdStart()
+  float destroyTimeSec = 0.0f;
+};
+
+// Memory footprint of a model, see BenchmarkModel::memoryProfile().
+struct MemoryProfile {
+  // Extent of the TFLite tensor arenas after the last AllocateTensors(), the
+  // scratch and persistent arenas together. -1 before tensors are allocated
+  long long arenaBytes = -1;
+  // Process memory at the start and the end of create() (including the last
+  // resizeInputTensors()), after the first inference and at the end of the
+  // last benchmark run
+  MemorySnapshot beforeCreate;
+  MemorySnapshot afterCreate;
+  MemorySnapshot afterFirstInference;
+  MemorySnapshot steadyState;
+  // High-water marks during the last benchmark run, see MemoryWatermark.
+  // Without FLAG_SAMPLE_PEAK_HEAP the heap peak is the larger of the heap
+  // at its start and end
+  long long peakHeapBytes = -1;
+  long long peakRssKb = -1;
+};
+
+// Values of DelegateOptions::executionPreference, same as
+// StatefulNnApiDelegate::Options::ExecutionPreference.
+const int EXECUTION_PREFERENCE_UNDEFINED = -1;
+const int EXECUTION_PREFERENCE_LOW_POWER = 0;
+const int EXECUTION_PREFERENCE_FAST_SINGLE_ANSWER = 1;
+const int EXECUTION_PREFERENCE_SUSTAINED_SPEED = 2;
+
+// NNAPI execution paths of BenchmarkModel::benchmarkExecutionModes().
+// Synchronous execution per inference.
+const int EXECUTION_MODE_SYNC = 0;
+// Reusable burst execution, keeps the driver resources of the previous
+// inference. Needs NNAPI 1.2, the delegate falls back to synchronous
+// executions on older devices.
+const int EXECUTION_MODE_BURST = 1;
+// benchmarkExecutionModes() runs every mode this many times, interleaved.
+const int EXECUTION_MODE_ROUNDS = 4;
+
+// Request arrival distributions of BenchmarkModel::benchmarkOpenLoop().
+const int ARRIVAL_FIXED_INTERVAL = 0;
+const int ARRIVAL_POISSON = 1;
+
+// Interpreter and NNAPI delegate options of BenchmarkModel::create().
+struct DelegateOptions {
+  // NNAPI device to run on, empty for the NNAPI default
+  std::string deviceName;
+  // NNAPI compilation cache directory, empty to disable caching. The model
+  // token is derived from the model file contents and the other options.
+  std::string cacheDir;
+  int executionPreference = EXECUTION_PREFERENCE_UNDEFINED;
+  // Allow fp32 to be computed with fp16 precision, also for TFLite CPU
+  bool allowFp16 = true;
+  // Max number of model partitions delegated to NNAPI, <= 0 for no limit
+  int maxDelegatedPartitions = 3;
+  // Don't let NNAPI use its CPU reference implementation
+  bool disallowNnapiCpu = false;
+  // Run NNAPI executions as a burst, see EXECUTION_MODE_BURST
+  bool useBurst = false;
 };
 
 /** Discard inference output in inference results. */
 const int FLAG_DISCARD_INFERENCE_OUTPUT = 1 << 0;
 /** Do not expect golden output for inference inputs. */
 const int FLAG_IGNORE_GOLDEN_OUTPUT = 1 << 1;
+/**
+ * Copy inputs into NNAPI shared memory once before the benchmark, and only
+ * switch input tensor buffer handles between inferences. NNAPI only.
+ */
+const int FLAG_ZERO_COPY_INPUT = 1 << 2;
+/**
+ * Check golden outputs and save inference outputs on a background thread,
+ * while the next inference runs. Only the output tensor copy stays on the
+ * inference thread.
+ */
+const int FLAG_ASYNC_VALIDATION = 1 << 3;
+/**
+ * Collect per-operator execution times with a TFLite profiler, see
+ * BenchmarkModel::operatorProfiles().
+ */
+const int FLAG_PROFILE_OPERATORS = 1 << 4;
+/**
+ * Run input creators on a producer thread, ahead of the inferences, see
+ * InputPrefetcher. Only the copy into the input tensors stays on the
+ * inference thread. Input creators need to be callable from any thread.
+ */
+const int FLAG_PREFETCH_INPUTS = 1 << 5;
+/**
+ * Run until seqInferencesMaxCount or the timeout even if the model has
+ * convergence options, see BenchmarkModel::setConvergence().
+ */
+const int FLAG_IGNORE_CONVERGENCE = 1 << 6;
+/**
+ * Sample the heap on a background thread during the run for
+ * MemoryProfile::peakHeapBytes, instead of only reading it before and after.
+ * The sampling disturbs the latency measurement.
+ */
+const int FLAG_SAMPLE_PEAK_HEAP = 1 << 7;
+
+// Monotonic clock time of all benchmark timings.
+long long currentTimeInNsec();
+
+class InputPrefetcher;
+class MappedDataset;
+class NativeEvaluator;
+class SysfsSensors;
+struct TensorDumpOptions;
 
 class BenchmarkModel {
  public:
   ~BenchmarkModel();
 
-  static BenchmarkModel* create(const char* modelfile, bool use_nnapi,
-                                bool enable_intermediate_tensors_dump,
-                                const char* nnapi_device_name = nullptr);
+  static BenchmarkModel* create(
+      const char* modelfile, bool use_nnapi,
+      bool enable_intermediate_tensors_dump,
+      const DelegateOptions& delegate_options = DelegateOptions());
 
-  bool resizeInputTensors(std::vector<int> shape);
-  bool setInput(const uint8_t* dataPtr, size_t length);
+  // One shape per model input, in the model input order. Part of the model
+  // setup, it is timed and ends MemoryProfile::afterCreate.
+  bool resizeInputTensors(std::vector<std::vector<int>> shapes);
+  bool setInput(int input_index, const uint8_t* dataPtr, size_t length);
+  // Callers take MemoryProfile::afterFirstInference with
+  // takeFirstInferenceSnapshot(), outside of their timed region.
   bool runInference();
-  // Resets TFLite states (RNN/LSTM states etc).
+  // Attaches a dataset to be used instead of the inputs passed from Java, see
+  // MappedDataset. Owned by the model so it lives as long as the results
+  // pointing into it.
+  void setMappedDataset(std::unique_ptr<MappedDataset> dataset);
+  const MappedDataset* mappedDataset() const { return mMappedDataset.get(); }
+  // Evaluates the outputs of every benchmark inference, see NativeEvaluator.
+  // Reset at the start of every benchmark run, so it holds the results of
+  // the last one.
+  void setNativeEvaluator(std::unique_ptr<NativeEvaluator> evaluator);
+  const NativeEvaluator* nativeEvaluator() const {
+    return mNativeEvaluator.get();
+  }
+  // Resets TFLite states (RNN/LSTM states etc). A no-op for models without
+  // variable tensors.
   bool resetStates();
+  bool hasVariableTensors() const { return mHasVariableTensors; }
+  // Number of threads used by TFLite CPU kernels (including CPU fallback ops
+  // with NNAPI), -1 for the TFLite default.
+  bool setNumThreads(int numThreads);
+  // Pins the benchmark thread to one of the CPU_CORES_* sets. TFLite worker
+  // threads are recreated here so that they inherit the affinity. The
+  // calling thread is only pinned for the duration of every benchmark run,
+  // which may be on another thread, and gets its affinity back afterwards.
+  bool setCpuAffinity(int cores, uint64_t explicitMask);
+  // Makes benchmark() and benchmarkStreaming() runs stop as soon as the
+  // latency estimate has converged, checked after every inference. A set
+  // options.maxTimeSec bounds those runs together with their timeout. Runs
+  // with FLAG_IGNORE_CONVERGENCE are unaffected, as are all other modes, so
+  // that their runs keep the asked for lengths.
+  bool setConvergence(const ConvergenceOptions& options);
+  // Where the last benchmark() or benchmarkStreaming() run stopped, only
+  // meaningful with setConvergence(). Empty after any other mode.
+  const ConvergenceStatus& convergenceStatus() const {
+    return mConvergenceStatus;
+  }
+
+  // Runs the inference of inOutData at cursor and advances it, wrapping
+  // around at the end of the inputs. States are reset at the start of every
+  // sequence. For schedulers that interleave inferences with other work or
+  // other models, result can be passed to InferenceSummary::add().
+  bool runNextInference(const std::vector<InferenceInOutSequence>& inOutData,
+                        int flags, InferenceCursor* cursor,
+                        InferenceResult* result);
+
+  // Runs warmup inferences through the same input path as benchmark(), but
+  // without golden output checks and without producing InferenceResults.
+  // Stops after warmupInferencesMaxCount inferences, or once warmupTimeout
+  // seconds of wall time have passed (if warmupTimeout > 0). The latency of
+  // every warmup inference is appended to warmupTimesSec.
+  bool warmup(const std::vector<InferenceInOutSequence>& inOutData,
+              int warmupInferencesMaxCount, float warmupTimeout,
+              std::vector<float>* warmupTimesSec);
 
   bool benchmark(const std::vector<InferenceInOutSequence>& inOutData,
                  int seqInferencesMaxCount, float timeout, int flags,
                  std::vector<InferenceResult>* result);
+  // Inference outputs saved by the last benchmark() call, valid until the
+  // next benchmark run of any kind.
+  const OutputArena& savedOutputs() const { return mOutputArena; }
+  // Per-operator statistics of the last benchmark run, empty unless it had
+  // FLAG_PROFILE_OPERATORS.
+  std::vector<OpProfile> operatorProfiles() const {
+    return mOpProfiler.profiles();
+  }
+  // Drops the results kept from the previous run (saved outputs, operator
+  // profiles, convergence status), called at the start of every benchmark
+  // run, including the ones driven from outside the model. Reserves room for
+  // the outputs of expectedInferences inferences.
+  void resetRunResults(size_t expectedInferences = 0);
+
+  // Same as benchmark(), but only keeps running statistics of the results
+  // instead of one InferenceResult per inference. Inference outputs are
+  // always discarded. Meant for long running benchmarks.
+  bool benchmarkStreaming(const std::vector<InferenceInOutSequence>& inOutData,
+                          int seqInferencesMaxCount, float timeout, int flags,
+                          InferenceSummary* summary);
 
+  // Runs benchmarkStreaming() on threadsCount threads at once, each with its
+  // own interpreter built from the same model, all over the same inOutData.
+  // The timeout applies to each thread separately. Produces one summary per
+  // thread. Inputs need to be given as data, input creators are not
+  // supported.
+  bool benchmarkConcurrent(const std::vector<InferenceInOutSequence>& inOutData,
+                           int threadsCount, int seqInferencesMaxCount,
+                           float timeout, int flags,
+                           std::vector<InferenceSummary>* summaries);
+
+  // Open-loop benchmark: requests arrive at arrivalRate per second for
+  // durationSec of wall time, at fixed intervals or as a Poisson process
+  // (ARRIVAL_*). threadsCount interpreters, set up like benchmarkConcurrent(),
+  // serve them in arrival order. Requests arriving while all of them are
+  // busy wait in the queue. Queueing and response times are measured from
+  // the scheduled arrival times. Requests still queued after twice the
+  // duration are dropped, so that a hopeless overload terminates. Inference
+  // outputs are always discarded.
+  bool benchmarkOpenLoop(const std::vector<InferenceInOutSequence>& inOutData,
+                         float arrivalRate, int distribution,
+                         int threadsCount, float durationSec, int flags,
+                         OpenLoopSummary* summary);
+
+  // Runs benchmarkOpenLoop() once per entry of arrivalRates, for a latency
+  // vs throughput curve. summaries[k] is the result at arrivalRates[k].
+  bool benchmarkOpenLoopSweep(
+      const std::vector<InferenceInOutSequence>& inOutData,
+      const std::vector<float>& arrivalRates, int distribution,
+      int threadsCount, float durationSec, int flags,
+      std::vector<OpenLoopSummary>* summaries);
+
+  // Runs benchmarkStreaming() with every interpreter thread count from 1 to
+  // maxThreads, summaries[n - 1] is the result with n threads. Each thread
+  // count gets one warmup inference first. The thread count is restored
+  // afterwards.
+  bool benchmarkThreadSweep(const std::vector<InferenceInOutSequence>& inOutData,
+                            int maxThreads, int seqInferencesMaxCount,
+                            float timeout, int flags,
+                            std::vector<InferenceSummary>* summaries);
+
+  // Runs benchmarkStreaming() once per entry of options, rebuilding the
+  // interpreter and delegate for each. The device name and cache directory
+  // of options are ignored, those of this model are used. summaries[k] is
+  // the result with options[k]. Each entry gets one warmup inference first.
+  // The original options are restored afterwards.
+  bool benchmarkDelegateOptionsSweep(
+      const std::vector<InferenceInOutSequence>& inOutData,
+      const std::vector<DelegateOptions>& options, int seqInferencesMaxCount,
+      float timeout, int flags, std::vector<InferenceSummary>* summaries);
+
+  // Benchmarks the EXECUTION_MODE_* entries of modes, with otherwise
+  // unchanged delegate options, so that the per inference overhead of every
+  // NNAPI execution path can be compared on the same inputs. NNAPI only,
+  // every mode may only be given once. Every mode other than the one of this
+  // model gets a replica, built and warmed up once before the first round.
+  // The timeout is split into EXECUTION_MODE_ROUNDS rounds running all modes,
+  // in reverse order every other round, so that drift during the run (e.g.
+  // thermal throttling) affects all modes alike. summaries[k] pools all
+  // rounds of modes[k], summaries[(1 + r) * modes.size() + k] is round r
+  // alone.
+  bool benchmarkExecutionModes(
+      const std::vector<InferenceInOutSequence>& inOutData,
+      const std::vector<int>& modes, int seqInferencesMaxCount, float timeout,
+      int flags, std::vector<InferenceSummary>* summaries);
+
+  // Batched throughput benchmark. For every batch size B in batchSizes, the
+  // leading dimension of all inputs is scaled by B and B consecutive inputs
+  // are packed into each inference (sequences are flattened into independent
+  // samples, so stateful models don't make sense here). Golden outputs are
+  // checked per sample. summaries[b] holds per-batch latencies for
+  // batchSizes[b], its MSEs are averaged over the samples of each batch so
+  // that they compare across batch sizes. Every output has to be batched
+  // along dim 0 too. Every batch size gets one warmup batch first. The
+  // original input shapes are restored afterwards.
+  bool benchmarkBatchSweep(const std::vector<InferenceInOutSequence>& inOutData,
+                           const std::vector<int>& batchSizes,
+                           int batchesMaxCount, float timeout, int flags,
+                           std::vector<InferenceSummary>* summaries);
+
+  // Sustained performance benchmark. Same as benchmarkStreaming(), but also
+  // splits the run into windows of windowSec seconds of wall time, to follow
+  // thermal throttling over long runs. If sensors is set, it is read at the
+  // end of every window. The duration counts inference time, like every
+  // other benchmark timeout.
+  bool benchmarkSustained(const std::vector<InferenceInOutSequence>& inOutData,
+                          float durationSec, float windowSec, int flags,
+                          const SysfsSensors* sensors,
+                          InferenceSummary* summary,
+                          std::vector<SustainedWindow>* windows);
+
+  // Startup cost of this model, firstInferenceTimeSec is set by the first
+  // runInference() call.
+  const StartupProfile& startupProfile() const { return mStartupProfile; }
+  // Memory footprint of this model, updated by create(), the first inference
+  // and every benchmark run. Process wide values, so other models alive at
+  // the same time are included.
+  const MemoryProfile& memoryProfile() const { return mMemoryProfile; }
+
+  // Cold start benchmark. Repeats iterations times: creates a new model from
+  // the model file with this model's configuration (input shapes, threads
+  // and affinity included), runs a single inference on input and destroys
+  // it. The profile of every created model is appended to profiles. The model
+  // file itself will usually be in the page cache after the first load.
+  bool benchmarkColdStart(const InferenceInOut& input, int iterations,
+                          std::vector<StartupProfile>* profiles);
+
+  // Runs every inference of inOutData and writes the tensors selected by
+  // options after each one into a single TensorDumpWriter container,
+  // path/tensors.dump.
   bool dumpAllLayers(const char* path,
-                     const std::vector<InferenceInOutSequence>& inOutData);
+                     const std::vector<InferenceInOutSequence>& inOutData,
+                     const TensorDumpOptions& options);
 
  private:
   BenchmarkModel();
   bool init(const char* modelfile, bool use_nnapi,
             bool enable_intermediate_tensors_dump,
-            const char* nnapi_device_name);
+            const DelegateOptions& delegate_options);
+  // Builds the interpreter (and delegate) for mTfliteModel. Only the first
+  // build, from init(), passes profile to record its times in, so that sweep
+  // rebuilds don't replace the startup profile.
+  bool initInterpreter(StartupProfile* profile = nullptr);
+  // Replaces the interpreter and delegate with ones built with options,
+  // keeping the input shapes.
+  bool reinitInterpreter(const DelegateOptions& options);
+  // resizeInputTensors() without the setup profiling, for the resizes of
+  // benchmark runs and interpreter rebuilds.
+  bool applyInputShapes(std::vector<std::vector<int>> shapes);
+  // New model sharing this model's FlatBuffer, with its own interpreter set
+  // up the same way, optionally with other delegate options.
+  std::unique_ptr<BenchmarkModel> createReplica() const;
+  std::unique_ptr<BenchmarkModel> createReplica(
+      const DelegateOptions& options) const;
+  // This model followed by threadsCount - 1 warmed up replicas, one per
+  // thread of a multi-threaded benchmark. Fails for input creators, which
+  // aren't safe to call concurrently.
+  bool createThreadModels(const std::vector<InferenceInOutSequence>& inOutData,
+                          int threadsCount,
+                          std::vector<std::unique_ptr<BenchmarkModel>>* replicas,
+                          std::vector<BenchmarkModel*>* models);
+  // Single batch size run of benchmarkBatchSweep().
+  bool benchmarkBatch(const std::vector<const InferenceInOut*>& samples,
+                      const std::vector<std::vector<int>>& baseShapes,
+                      int batchSize, int batchesMaxCount, float timeout,
+                      int flags, InferenceSummary* summary);
+  // Resets the states at the start of a sequence, result->resetTimeSec is
+  // the time it took.
+  bool startSequence(InferenceResult* result);
+
+  // Benchmark loop shared by benchmark() and benchmarkStreaming(), passes
+  // every result to resultSink. The result object is reused across calls.
+  bool benchmarkLoop(
+      const std::vector<InferenceInOutSequence>& inOutData,
+      int seqInferencesMaxCount, float timeout, int flags,
+      const std::function<void(const InferenceResult&)>& resultSink);
+  // Passes the outputs of every inference to evaluator, if set. Fails as
+  // soon as *failed, if given, is set by the result sink side.
+  bool benchmarkSequences(
+      const std::vector<InferenceInOutSequence>& inOutData,
+      int seqInferencesMaxCount, float timeout, int flags,
+      NativeEvaluator* evaluator, const std::atomic<bool>* failed,
+      const std::function<void(const InferenceResult&)>& resultSink);
+  // FLAG_ASYNC_VALIDATION version of benchmarkSequences(), output processing
+  // is done by an AsyncValidationPipeline. resultSink is called from the
+  // pipeline worker thread.
+  bool benchmarkSequencesAsync(
+      const std::vector<InferenceInOutSequence>& inOutData,
+      int seqInferencesMaxCount, float timeout, int flags,
+      const std::function<void(const InferenceResult&)>& resultSink);
+  // Sets up all model inputs from data, either by copying, by switching to
+  // shared memory, by calling the input creator or from the next
+  // FLAG_PREFETCH_INPUTS slot.
+  bool setInputs(const InferenceInOut& data);
+  // Sets up the input, runs the inference and processes its outputs
+  // according to flags. result's sequence/inference indices must be set.
+  bool runSingleInference(const InferenceInOut& data, int flags,
+                          InferenceResult* result);
+  // FLAG_ZERO_COPY_INPUT support. Every input buffer of inOutData gets
+  // copied into a page aligned slice of an ASharedMemory region, and each
+  // slice is registered with the NNAPI delegate as its own buffer handle.
+  // Regions are registered once per delegate and reused by later runs with
+  // the same input sizes.
+  bool bindInputsToSharedMemory(
+      const std::vector<InferenceInOutSequence>& inOutData);
+  // Unbinds the inputs of the last bindInputsToSharedMemory() call, the
+  // regions stay registered.
+  void releaseSharedMemoryInputs();
+  // Frees all regions. The delegate they were registered with has to be
+  // destroyed already, it can't unregister memory.
+  void freeSharedMemoryRegions();
+  // Points the input tensor at a registered shared memory input, returns
+  // false if input data was not bound to shared memory.
+  bool setSharedMemoryInput(int input_index, const uint8_t* dataPtr);
 
   void getOutputError(const uint8_t* dataPtr, size_t length,
                       InferenceResult* result, int output_index);
-  void saveInferenceOutput(InferenceResult* result, int output_index);
+  void saveInferenceOutputs(InferenceResult* result);
+  // Extent of the tensor arenas, see MemoryProfile::arenaBytes.
+  long long tensorArenaBytes() const;
+  // Sizes the output arena from the output tensors, needs to be called after
+  // every tensor allocation.
+  void configureOutputArena();
 
-  std::unique_ptr<tflite::FlatBufferModel> mTfliteModel;
+  // Shared with replicas, see createReplica().
+  std::shared_ptr<tflite::FlatBufferModel> mTfliteModel;
+  // Attached to the interpreter during FLAG_PROFILE_OPERATORS runs.
+  OpProfiler mOpProfiler;
+  // Needs to outlive the interpreter.
+  std::unique_ptr<tflite::StatefulNnApiDelegate> mTfliteNnapiDelegate;
   std::unique_ptr<tflite::Interpreter> mTfliteInterpreter;
+
+  OutputArena mOutputArena;
+  // Set during FLAG_PREFETCH_INPUTS benchmark runs, owned by benchmarkLoop().
+  InputPrefetcher* mInputPrefetcher = nullptr;
+  // Set during setConvergence() benchmark runs, owned by benchmarkLoop().
+  ConvergenceTracker* mConvergenceTracker = nullptr;
+  std::unique_ptr<MappedDataset> mMappedDataset;
+  std::unique_ptr<NativeEvaluator> mNativeEvaluator;
+
+  StartupProfile mStartupProfile;
+  MemoryProfile mMemoryProfile;
+  // Set by the first runInference() until takeFirstInferenceSnapshot().
+  bool mFirstInferenceSnapshotPending = false;
+  void takeFirstInferenceSnapshot();
+  // Set by initInterpreter(), stateless models skip state resets.
+  bool mHasVariableTensors = false;
+
+  // Interpreter configuration, needed to create replicas.
+  std::string mModelFile;
+  bool mUseNnapi = false;
+  bool mEnableIntermediateTensorsDump = false;
+  DelegateOptions mDelegateOptions;
+  // Only computed if compilation caching is enabled.
+  uint64_t mModelFileHash = 0;
+  std::string mModelToken;
+  std::vector<std::vector<int>> mInputShapes;
+  int mNumThreads = -1;
+  // 0 if the affinity was never set.
+  uint64_t mCpuAffinityMask = 0;
+  bool mConvergence = false;
+  ConvergenceOptions mConvergenceOptions;
+  ConvergenceStatus mConvergenceStatus;
+
+  struct SharedMemoryInput {
+    ANeuralNetworksMemory* memory;
+    TfLiteBufferHandle bufferHandle;
+    uint8_t* hostPtr;
+    size_t size;
+  };
+  struct SharedMemoryRegion {
+    int fd = -1;
+    uint8_t* ptr = nullptr;
+    size_t size = 0;
+    // In the order of the inputs they were laid out for.
+    std::vector<SharedMemoryInput> inputs;
+  };
+  // Registered with mTfliteNnapiDelegate, owned by this model until the
+  // delegate is destroyed.
+  std::vector<SharedMemoryRegion> mSharedMemoryRegions;
+  // Inputs of the current run, keyed by the original (JNI pinned) input data
+  // pointer.
+  std::unordered_map<const uint8_t*, SharedMemoryInput> mSharedMemoryInputs;
 };
 
 #endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_RUN_TFLITE_H
@@ -0,0 +1,221 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scenario_runner.h"
+
+#include <android/log.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <thread>
+
+#define LOG_TAG "NN_BENCHMARK"
+
+namespace {
+
+void sleepUntil(long long timeNsec) {
+  timespec wakeup;
+  wakeup.tv_sec = timeNsec / 1000000000LL;
+  wakeup.tv_nsec = timeNsec % 1000000000LL;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, nullptr) ==
+         EINTR) {
+  }
+}
+
+long long intervalNsec(const ScenarioModel& model) {
+  return model.ratePerSec > 0.f
+             ? static_cast<long long>(1e9 / model.ratePerSec)
+             : 0;
+}
+
+// Runs one model at its rate until endTime, on the calling thread.
+bool runAlone(const ScenarioModel& model, long long endTime,
+              InferenceSummary* summary) {
+  const long long startTime = currentTimeInNsec();
+  const long long interval = intervalNsec(model);
+  long long dueTime = startTime;
+  InferenceCursor cursor;
+  InferenceResult result;
+  while (currentTimeInNsec() < endTime) {
+    if (interval > 0) {
+      sleepUntil(dueTime);
+      dueTime += interval;
+    }
+    if (!model.model->runNextInference(*model.inOutData, model.flags, &cursor,
+                                       &result)) {
+      return false;
+    }
+    summary->add(result);
+  }
+  summary->wallTimeSec = (currentTimeInNsec() - startTime) / 1e9;
+  return true;
+}
+
+bool runInterleaved(const std::vector<ScenarioModel>& models,
+                    long long endTime,
+                    std::vector<ScenarioModelResult>* results) {
+  const long long startTime = currentTimeInNsec();
+  std::vector<long long> dueTimes(models.size(), startTime);
+  std::vector<InferenceCursor> cursors(models.size());
+  InferenceResult result;
+  long long now = startTime;
+  while (now < endTime) {
+    int next = -1;
+    long long earliestDueTime = endTime;
+    for (int k = 0; k < models.size(); ++k) {
+      earliestDueTime = std::min(earliestDueTime, dueTimes[k]);
+      if (dueTimes[k] > now) {
+        continue;
+      }
+      if (next < 0 || models[k].priority < models[next].priority ||
+          (models[k].priority == models[next].priority &&
+           dueTimes[k] < dueTimes[next])) {
+        next = k;
+      }
+    }
+    if (next < 0) {
+      sleepUntil(earliestDueTime);
+      now = currentTimeInNsec();
+      continue;
+    }
+
+    const ScenarioModel& model = models[next];
+    if (!model.model->runNextInference(*model.inOutData, model.flags,
+                                       &cursors[next], &result)) {
+      return false;
+    }
+    (*results)[next].shared.add(result);
+    now = currentTimeInNsec();
+    // Back to back models are due again right away, but queue behind the
+    // models that waited while this one ran.
+    const long long interval = intervalNsec(model);
+    dueTimes[next] = interval > 0 ? dueTimes[next] + interval : now;
+  }
+  for (auto& result : *results) {
+    result.shared.wallTimeSec = (now - startTime) / 1e9;
+  }
+  return true;
+}
+
+// Applies the priority of model k to the calling thread. Threads can't
+// reliably get back their previous nice value, so it's only used on
+// threads created for the model.
+void setThreadPriority(const ScenarioModel& model, int k) {
+  if (model.priority != 0 &&
+      setpriority(PRIO_PROCESS, gettid(), model.priority) != 0) {
+    __android_log_print(ANDROID_LOG_WARN, LOG_TAG,
+                        "Failed to set model %d priority %d: %s", k,
+                        model.priority, strerror(errno));
+  }
+}
+
+bool runConcurrent(const std::vector<ScenarioModel>& models,
+                   long long endTime,
+                   std::vector<ScenarioModelResult>* results) {
+  std::promise<void> start;
+  std::shared_future<void> started = start.get_future().share();
+  std::atomic<bool> success(true);
+  std::vector<std::thread> threads;
+  for (int k = 0; k < models.size(); ++k) {
+    threads.emplace_back([&, k]() {
+      setThreadPriority(models[k], k);
+      started.wait();
+      if (!runAlone(models[k], endTime, &(*results)[k].shared)) {
+        success = false;
+      }
+    });
+  }
+  start.set_value();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return success;
+}
+
+}  // namespace
+
+bool runScenario(const std::vector<ScenarioModel>& models, int schedule,
+                 float durationSec, std::vector<ScenarioModelResult>* results) {
+  if (models.empty() || durationSec <= 0.f) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Invalid scenario of %zu models for %f s",
+                        models.size(), durationSec);
+    return false;
+  }
+  for (const auto& model : models) {
+    if (model.inOutData->empty()) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Model without inputs");
+      return false;
+    }
+  }
+  if (schedule == SCENARIO_CONCURRENT) {
+    // Input creators aren't safe to call concurrently, the creators of a
+    // dataset share one Java image processor.
+    for (const auto& model : models) {
+      for (const auto& seq : *model.inOutData) {
+        for (const auto& data : seq) {
+          for (const auto& input : data.inputs) {
+            if (input.ptr == nullptr) {
+              __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                                  "Input creators are not supported by "
+                                  "concurrent scenarios");
+              return false;
+            }
+          }
+        }
+      }
+    }
+  } else if (schedule != SCENARIO_INTERLEAVED) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Invalid scenario schedule %d", schedule);
+    return false;
+  }
+
+  for (const auto& model : models) {
+    model.model->resetRunResults();
+  }
+  const long long durationNsec = static_cast<long long>(durationSec * 1e9);
+  results->assign(models.size(), ScenarioModelResult());
+  for (int k = 0; k < models.size(); ++k) {
+    const long long aloneEndTime = currentTimeInNsec() + durationNsec;
+    ScenarioModelResult* result = &(*results)[k];
+    bool success;
+    if (schedule == SCENARIO_CONCURRENT) {
+      // Same thread priority as in the concurrent run, on a thread of its
+      // own like there.
+      std::thread thread([&]() {
+        setThreadPriority(models[k], k);
+        success = runAlone(models[k], aloneEndTime, &result->alone);
+      });
+      thread.join();
+    } else {
+      success = runAlone(models[k], aloneEndTime, &result->alone);
+    }
+    if (!success) {
+      return false;
+    }
+  }
+  const long long endTime = currentTimeInNsec() + durationNsec;
+  return schedule == SCENARIO_CONCURRENT
+             ? runConcurrent(models, endTime, results)
+             : runInterleaved(models, endTime, results);
+}
@@ -0,0 +1,63 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_SCENARIO_RUNNER_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_SCENARIO_RUNNER_H
+
+#include "run_tflite.h"
+
+#include <vector>
+
+// Schedules of runScenario().
+// All models share the calling thread. The next inference is the one of the
+// model that is due with the lowest priority value, ties go to the model
+// that has waited longest.
+const int SCENARIO_INTERLEAVED = 0;
+// Every model runs on its own thread, with its priority as the thread nice
+// value, in the alone runs too.
+const int SCENARIO_CONCURRENT = 1;
+
+// One model of a multi-model scenario.
+struct ScenarioModel {
+  BenchmarkModel* model = nullptr;
+  const std::vector<InferenceInOutSequence>* inOutData = nullptr;
+  int flags = 0;
+  // Inferences per second, at fixed intervals. 0 to run back to back.
+  float ratePerSec = 0.0f;
+  // Lower runs first, like nice values. Negative values, i.e. a priority
+  // above the default, need CAP_SYS_NICE, which the app usually doesn't
+  // have; the thread then keeps its default priority.
+  int priority = 0;
+};
+
+// Results of a model in runScenario().
+struct ScenarioModelResult {
+  // The model running on its own at the same rate, on the calling thread, or
+  // for concurrent schedules on a thread of its own
+  InferenceSummary alone;
+  // The model running together with the other models of the scenario
+  InferenceSummary shared;
+};
+
+// Runs every model on its own for durationSec, then all models together for
+// durationSec with the given SCENARIO_* schedule. The difference between
+// results[k].alone and results[k].shared is the cost of sharing the
+// accelerator (and, when interleaved, the CPU) with the other models.
+// Models must be warmed up. Concurrent models can't use input creators.
+bool runScenario(const std::vector<ScenarioModel>& models, int schedule,
+                 float durationSec, std::vector<ScenarioModelResult>* results);
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_SCENARIO_RUNNER_H
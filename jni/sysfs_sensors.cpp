@@ -0,0 +1,112 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sysfs_sensors.h"
+
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Thermal zones and CPUs are numbered densely, probing stops at the first
+// missing one past this many.
+constexpr int kMaxSysfsIndex = 64;
+
+bool readLong(const std::string& path, long* value) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return false;
+  }
+  bool success = fscanf(file, "%ld", value) == 1;
+  fclose(file);
+  return success;
+}
+
+std::string readLine(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return "";
+  }
+  char line[128] = {};
+  if (fgets(line, sizeof(line), file) == nullptr) {
+    line[0] = '\0';
+  }
+  fclose(file);
+  line[strcspn(line, "\n")] = '\0';
+  return line;
+}
+
+}  // namespace
+
+SysfsSensors SysfsSensors::discover() {
+  SysfsSensors sensors;
+  for (int zone = 0; zone < kMaxSysfsIndex; ++zone) {
+    const std::string dir =
+        "/sys/class/thermal/thermal_zone" + std::to_string(zone);
+    if (access(dir.c_str(), F_OK) != 0) {
+      break;
+    }
+    std::string type = readLine(dir + "/type");
+    sensors.add(type.empty() ? "thermal_zone" + std::to_string(zone)
+                             : "thermal_" + type,
+                dir + "/temp", true);
+  }
+  const long cpusCount = sysconf(_SC_NPROCESSORS_CONF);
+  for (int cpu = 0; cpu < cpusCount && cpu < kMaxSysfsIndex; ++cpu) {
+    sensors.add("cpu" + std::to_string(cpu) + "_freq",
+                "/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                    "/cpufreq/scaling_cur_freq",
+                false);
+  }
+  return sensors;
+}
+
+void SysfsSensors::add(const std::string& name, const std::string& path,
+                       bool thermal) {
+  long value;
+  if (!readLong(path, &value)) {
+    return;
+  }
+  // Names end up in CSV files.
+  std::string csvName = name;
+  for (char& c : csvName) {
+    if (c == ',' || c == ' ') {
+      c = '_';
+    }
+  }
+  mNames.push_back(csvName);
+  mPaths.push_back(path);
+  mThermal.push_back(thermal);
+}
+
+std::vector<float> SysfsSensors::read() const {
+  std::vector<float> values(mPaths.size(), NAN);
+  for (int i = 0; i < mPaths.size(); ++i) {
+    long value;
+    if (!readLong(mPaths[i], &value)) {
+      continue;
+    }
+    if (mThermal[i]) {
+      // Most drivers report millidegrees, a few whole degrees.
+      values[i] = std::abs(value) >= 1000 ? value / 1000.0f : value;
+    } else {
+      values[i] = value / 1000.0f;
+    }
+  }
+  return values;
+}
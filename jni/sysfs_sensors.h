@@ -0,0 +1,47 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_SYSFS_SENSORS_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_SYSFS_SENSORS_H
+
+#include <string>
+#include <vector>
+
+// Thermal zone temperatures and current CPU frequencies read from sysfs, for
+// following throttling during long benchmarks. Nodes that can't be read
+// (SELinux denies most thermal zones on user builds) are left out.
+class SysfsSensors {
+ public:
+  // Finds the readable /sys/class/thermal/thermal_zone*/temp and
+  // /sys/devices/system/cpu/cpu*/cpufreq/scaling_cur_freq nodes.
+  static SysfsSensors discover();
+
+  // "thermal_<zone type>" (or "thermal_zone<N>" without a type) and
+  // "cpu<N>_freq", in the order of read() values.
+  const std::vector<std::string>& names() const { return mNames; }
+  // Temperatures in degrees Celsius, frequencies in MHz, NaN for failed
+  // reads.
+  std::vector<float> read() const;
+
+ private:
+  void add(const std::string& name, const std::string& path, bool thermal);
+
+  std::vector<std::string> mNames;
+  std::vector<std::string> mPaths;
+  std::vector<bool> mThermal;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_SYSFS_SENSORS_H
@@ -0,0 +1,233 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensor_dump_writer.h"
+
+#include <android/log.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#define LOG_TAG "NN_BENCHMARK"
+
+namespace {
+
+const char kFileMagic[8] = {'N', 'N', 'T', 'D', 'U', 'M', 'P', '1'};
+const char kIndexMagic[8] = {'N', 'N', 'T', 'I', 'N', 'D', 'E', 'X'};
+
+template <typename T>
+void append(std::vector<uint8_t>* out, T value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(T));
+}
+
+}  // namespace
+
+bool TensorDumpOptions::matches(int tensorIndex, const char* name) const {
+  if (names.empty() && indices.empty()) {
+    return true;
+  }
+  if (std::find(indices.begin(), indices.end(), tensorIndex) !=
+      indices.end()) {
+    return true;
+  }
+  return name != nullptr &&
+         std::find(names.begin(), names.end(), name) != names.end();
+}
+
+std::unique_ptr<TensorDumpWriter> TensorDumpWriter::create(const char* path,
+                                                           bool compress,
+                                                           int depth) {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to create %s: %s",
+                        path, strerror(errno));
+    return nullptr;
+  }
+  if (fwrite(kFileMagic, sizeof(kFileMagic), 1, file) != 1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "Failed to write %s",
+                        path);
+    fclose(file);
+    return nullptr;
+  }
+  return std::unique_ptr<TensorDumpWriter>(
+      new TensorDumpWriter(file, compress, depth));
+}
+
+TensorDumpWriter::TensorDumpWriter(FILE* file, bool compress, int depth)
+    : mFile(file), mCompress(compress), mOffset(sizeof(kFileMagic)) {
+  for (int i = 0; i < depth; ++i) {
+    mBuffers.emplace_back(new Buffer());
+    mFreeBuffers.push_back(mBuffers.back().get());
+  }
+  mIoThread = std::thread(&TensorDumpWriter::ioLoop, this);
+}
+
+TensorDumpWriter::~TensorDumpWriter() { finish(); }
+
+bool TensorDumpWriter::add(int seqIndex, int inferenceIndex, int tensorIndex,
+                           int tfliteType, const char* name, const void* data,
+                           size_t bytes) {
+  Buffer* buffer;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mBufferFreed.wait(lock,
+                      [this] { return mFailed || !mFreeBuffers.empty(); });
+    if (mFailed) {
+      return false;
+    }
+    buffer = mFreeBuffers.front();
+    mFreeBuffers.pop_front();
+  }
+
+  buffer->entry.seqIndex = seqIndex;
+  buffer->entry.inferenceIndex = inferenceIndex;
+  buffer->entry.tensorIndex = tensorIndex;
+  buffer->entry.tfliteType = tfliteType;
+  buffer->entry.bytes = bytes;
+  buffer->entry.name = name != nullptr ? name : "";
+  // The pooled buffers keep their capacity, so the copy only allocates while
+  // the first tensors of the largest sizes go through.
+  const uint8_t* begin = static_cast<const uint8_t*>(data);
+  buffer->data.assign(begin, begin + bytes);
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQueuedBuffers.push_back(buffer);
+  }
+  mBufferQueued.notify_one();
+  return true;
+}
+
+bool TensorDumpWriter::finish() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mBufferQueued.notify_one();
+  if (mIoThread.joinable()) {
+    mIoThread.join();
+  }
+  if (mFile != nullptr) {
+    if (!mFailed && !writeIndex()) {
+      mFailed = true;
+    }
+    if (fclose(mFile) != 0) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Failed to close the tensor dump: %s",
+                          strerror(errno));
+      mFailed = true;
+    }
+    mFile = nullptr;
+  }
+  return !mFailed;
+}
+
+void TensorDumpWriter::ioLoop() {
+  while (true) {
+    Buffer* buffer;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mBufferQueued.wait(
+          lock, [this] { return mStopping || !mQueuedBuffers.empty(); });
+      if (mQueuedBuffers.empty()) {
+        return;
+      }
+      buffer = mQueuedBuffers.front();
+      mQueuedBuffers.pop_front();
+    }
+
+    // Buffers after a failure are only drained, not written.
+    bool failed;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      failed = mFailed;
+    }
+    if (!failed && !write(buffer)) {
+      failed = true;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mFailed = mFailed || failed;
+      mFreeBuffers.push_back(buffer);
+    }
+    mBufferFreed.notify_one();
+  }
+}
+
+bool TensorDumpWriter::write(Buffer* buffer) {
+  Entry& entry = buffer->entry;
+  const uint8_t* stored = buffer->data.data();
+  entry.storedBytes = buffer->data.size();
+  entry.compressed = 0;
+  if (mCompress && !buffer->data.empty()) {
+    uLongf compressedBytes = compressBound(buffer->data.size());
+    mCompressed.resize(compressedBytes);
+    if (compress2(mCompressed.data(), &compressedBytes, buffer->data.data(),
+                  buffer->data.size(), Z_BEST_SPEED) != Z_OK) {
+      __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                          "Failed to compress tensor %d", entry.tensorIndex);
+      return false;
+    }
+    if (compressedBytes < buffer->data.size()) {
+      stored = mCompressed.data();
+      entry.storedBytes = compressedBytes;
+      entry.compressed = 1;
+    }
+  }
+
+  if (entry.storedBytes > 0 &&
+      fwrite(stored, entry.storedBytes, 1, mFile) != 1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Failed to write tensor %d: %s", entry.tensorIndex,
+                        strerror(errno));
+    return false;
+  }
+  entry.offset = mOffset;
+  mOffset += entry.storedBytes;
+  mIndex.push_back(entry);
+  return true;
+}
+
+bool TensorDumpWriter::writeIndex() {
+  std::vector<uint8_t> index;
+  for (const Entry& entry : mIndex) {
+    append<uint32_t>(&index, entry.seqIndex);
+    append<uint32_t>(&index, entry.inferenceIndex);
+    append<uint32_t>(&index, entry.tensorIndex);
+    append<uint32_t>(&index, entry.tfliteType);
+    append<uint64_t>(&index, entry.offset);
+    append<uint64_t>(&index, entry.storedBytes);
+    append<uint64_t>(&index, entry.bytes);
+    append<uint32_t>(&index, entry.compressed);
+    append<uint32_t>(&index, entry.name.size());
+    index.insert(index.end(), entry.name.begin(), entry.name.end());
+  }
+  append<uint64_t>(&index, mOffset);
+  append<uint32_t>(&index, mIndex.size());
+  index.insert(index.end(), kIndexMagic, kIndexMagic + sizeof(kIndexMagic));
+
+  if (fwrite(index.data(), index.size(), 1, mFile) != 1) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG,
+                        "Failed to write the tensor dump index: %s",
+                        strerror(errno));
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COM_EXAMPLE_ANDROID_NN_BENCHMARK_TENSOR_DUMP_WRITER_H
+#define COM_EXAMPLE_ANDROID_NN_BENCHMARK_TENSOR_DUMP_WRITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Which tensors BenchmarkModel::dumpAllLayers() writes, and how.
+struct TensorDumpOptions {
+  // Deflate the tensor contents (zlib, fastest level).
+  bool compress = false;
+  // Dump only the tensors with one of these names or indices, every tensor if
+  // both are empty.
+  std::vector<std::string> names;
+  std::vector<int> indices;
+
+  bool matches(int tensorIndex, const char* name) const;
+};
+
+// Writes tensor snapshots into a single indexed container file. The caller
+// copies each tensor into one of a fixed pool of buffers, a single I/O thread
+// compresses and writes them in submission order.
+//
+// File layout, integers are little endian:
+//   "NNTDUMP1"
+//   tensor contents, back to back
+//   index, for every tensor:
+//     u32 seqIndex, u32 inferenceIndex, u32 tensorIndex, u32 tfliteType,
+//     u64 offset, u64 storedBytes, u64 bytes, u32 compressed,
+//     u32 nameLength, name (not terminated)
+//   u64 indexOffset, u32 entriesCount, "NNTINDEX"
+class TensorDumpWriter {
+ public:
+  // Returns nullptr if the file can't be created.
+  static std::unique_ptr<TensorDumpWriter> create(const char* path,
+                                                  bool compress, int depth);
+  ~TensorDumpWriter();
+
+  // Copies the tensor and queues it, blocks while all buffers are queued.
+  // Returns false once an earlier write failed.
+  bool add(int seqIndex, int inferenceIndex, int tensorIndex, int tfliteType,
+           const char* name, const void* data, size_t bytes);
+  // Writes the queued tensors and the index, and closes the file. Returns
+  // false if any write failed.
+  bool finish();
+
+ private:
+  struct Entry {
+    uint32_t seqIndex;
+    uint32_t inferenceIndex;
+    uint32_t tensorIndex;
+    uint32_t tfliteType;
+    uint64_t offset;
+    uint64_t storedBytes;
+    uint64_t bytes;
+    // Tensors that don't deflate smaller are stored as is.
+    uint32_t compressed;
+    std::string name;
+  };
+  struct Buffer {
+    Entry entry;
+    std::vector<uint8_t> data;
+  };
+
+  TensorDumpWriter(FILE* file, bool compress, int depth);
+  void ioLoop();
+  bool write(Buffer* buffer);
+  bool writeIndex();
+
+  FILE* mFile;
+  const bool mCompress;
+  uint64_t mOffset = 0;
+  std::vector<Entry> mIndex;
+  // Deflate output, only used by the I/O thread.
+  std::vector<uint8_t> mCompressed;
+  std::vector<std::unique_ptr<Buffer>> mBuffers;
+
+  std::mutex mMutex;
+  std::condition_variable mBufferFreed;
+  std::condition_variable mBufferQueued;
+  std::deque<Buffer*> mFreeBuffers;
+  std::deque<Buffer*> mQueuedBuffers;
+  bool mStopping = false;
+  bool mFailed = false;
+  std::thread mIoThread;
+};
+
+#endif  // COM_EXAMPLE_ANDROID_NN_BENCHMARK_TENSOR_DUMP_WRITER_H
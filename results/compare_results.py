@@ -0,0 +1,487 @@
+#!/usr/bin/python3
+#
+# Copyright 2019, The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""MLTS benchmark result comparison.
+
+Compares one or more candidate runs (new build, driver or device) against a
+baseline run, per model and backend, and flags the latency regressions that are
+both statistically significant and above a threshold.
+
+A result set is either a result CSV, written by CSVWriter or the nnbenchmark
+executable, or a directory pulled from the device with mlts_benchmark.csv and,
+optionally, mlts_operator_profile.csv in it. Results of the same model and
+backend appended to the same file are pooled.
+
+Latency distributions are compared with a two-sided Mann-Whitney U test on the
+native log-linear latency histograms of the results (bucket mid-points), the
+size of the change by the mean latency or a percentile. Unlike the timeFreq
+histograms, which span the min to max latency of every run, their bucket bounds
+are the same for all runs, so an outlier doesn't move the bulk of a run to other
+buckets. Results without them (older CSVs) aren't tested, the threshold alone
+decides. Operators are matched by name and occurrence, as losing delegation
+renumbers the nodes, and compared by their mean time and whether they are still
+delegated.
+
+Usage:
+  compare_results [options] baseline candidate [candidate...]
+
+The exit status is 1 if any candidate regressed or lost a model.
+"""
+
+import argparse
+import collections
+import csv
+import json
+import math
+import os
+import sys
+
+import generate_result
+
+
+RESULT_FILENAME = 'mlts_benchmark.csv'
+OPERATOR_PROFILE_FILENAME = 'mlts_operator_profile.csv'
+
+# Verdicts of models and operators. Regressions and missing models fail the
+# candidate.
+REGRESSION = 'regression'
+MISSING = 'missing'
+IMPROVEMENT = 'improvement'
+NO_CHANGE = 'no_change'
+NEW = 'new'
+FAILING_VERDICTS = (REGRESSION, MISSING)
+
+ResultSet = collections.namedtuple(
+    'ResultSet',
+    ['path', 'build', 'results', 'operators'])
+
+OperatorProfile = collections.namedtuple(
+    'OperatorProfile',
+    ['delegated', 'count', 'total_time_sec'])
+
+
+def load_result_set(path):
+  """Load a result CSV or result directory, returns a ResultSet.
+
+  results maps (name, backend) to the list of its BenchmarkResult, operators
+  maps (name, backend) to {(node index, op name): OperatorProfile}.
+  """
+  results_path = path
+  operators_path = None
+  if os.path.isdir(path):
+    results_path = os.path.join(path, RESULT_FILENAME)
+    operators_path = os.path.join(path, OPERATOR_PROFILE_FILENAME)
+  benchmark_info, data = generate_result.parse_csv_input(results_path)
+
+  results = collections.defaultdict(list)
+  for result in data:
+    results[(result.name, result.backend_type)].append(result)
+  operators = {}
+  if operators_path and os.path.exists(operators_path):
+    operators = parse_operator_profiles(operators_path)
+  return ResultSet(
+      path=path,
+      build=benchmark_info[1] if len(benchmark_info) > 1 else '',
+      results=results,
+      operators=operators)
+
+
+def parse_operator_profiles(input_filename):
+  """Parse an operator profile CSV, see CSVWriter.
+
+  One line per operator, in OPERATOR_PROFILE_FORMAT_COMMENT order. Profiles
+  of the same operator in repeated runs are pooled.
+  """
+  operators = collections.defaultdict(dict)
+  with open(input_filename, 'r') as csvfile:
+    csv_reader = csv.reader(filter(lambda row: row[0] != '#', csvfile))
+    for row in csv_reader:
+      # Skips the device info lines.
+      if len(row) < 10:
+        continue
+      model = (row[0], row[1])
+      op = (int(row[2]), row[3])
+      count = int(row[5])
+      total_time_sec = float(row[6])
+      previous = operators[model].get(op)
+      if previous:
+        count += previous.count
+        total_time_sec += previous.total_time_sec
+      operators[model][op] = OperatorProfile(
+          delegated=row[4] == '1',
+          count=count,
+          total_time_sec=total_time_sec)
+  return operators
+
+
+# Same as LatencyHistogram in jni/latency_stats.h.
+SUB_BUCKET_BITS = 7
+SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS
+
+
+def bucket_bounds_nsec(value_nsec):
+  """[lower, upper) nsec bounds of the native histogram bucket of value_nsec."""
+  if value_nsec < SUB_BUCKET_COUNT:
+    return value_nsec, value_nsec + 1
+  shift = value_nsec.bit_length() - SUB_BUCKET_BITS
+  lower = (value_nsec >> shift) << shift
+  return lower, lower + (1 << shift)
+
+
+def latency_histogram(results):
+  """Pooled native latency histogram of results, None if any lacks one.
+
+  Returns (bucket mid-point sec, count) pairs. Bucket lower bounds are written
+  as 32-bit floats, which can come back just below the bound, so every bucket
+  is looked up from a point a little inside of it. Buckets are at least 1/128
+  of their lower bound wide, far more than the float error.
+  """
+  buckets = collections.Counter()
+  for result in results:
+    if result.latency_histogram is None:
+      return None
+    for lower_bound_sec, count in result.latency_histogram:
+      lower, upper = bucket_bounds_nsec(
+          int(round(lower_bound_sec * 1e9 * (1 + 2**-10))))
+      # Same mid-point as LatencyHistogram::percentile().
+      buckets[(lower + upper - 1) // 2] += count
+  return [(mid_point / 1e9, count)
+          for mid_point, count in sorted(buckets.items())]
+
+
+def histogram_percentile(histogram, q):
+  """Nearest rank percentile q (0.0 - 1.0) of a latency histogram."""
+  histogram = sorted(histogram)
+  rank = q * sum(count for _, count in histogram)
+  seen = 0.0
+  for value, count in histogram:
+    seen += count
+    if seen >= rank:
+      return value
+  return histogram[-1][0] if histogram else 0.0
+
+
+def latency_sec(results, metric, exact=True):
+  """Mean or percentile latency of the pooled results, None if unknown.
+
+  Percentiles of a single result come from its exact percentile columns if
+  exact is set, otherwise from the native histograms like those of pooled
+  results. Both sides of a comparison need the same estimator.
+  """
+  iterations = sum(result.iterations for result in results)
+  if iterations <= 0:
+    return None
+  if metric == 'mean':
+    return sum(result.total_time_sec for result in results) / iterations
+  index = generate_result.LATENCY_PERCENTILES.index(metric)
+  if exact and len(results) == 1 and results[0].latency_percentiles_sec:
+    value = results[0].latency_percentiles_sec[index]
+    if value > 0:
+      return value
+  if metric == 'max':
+    if all(result.latency_percentiles_sec for result in results):
+      return max(result.latency_percentiles_sec[index] for result in results)
+    return None
+  histogram = latency_histogram(results)
+  if histogram is None:
+    return None
+  return histogram_percentile(histogram, float(metric[1:]) / 100.0)
+
+
+def mann_whitney_u(baseline, candidate):
+  """Two-sided Mann-Whitney U test of two latency histograms.
+
+  Uses the normal approximation with tie and continuity corrections. Returns
+  (p-value, probability that a candidate latency is above a baseline one, ties
+  counting half), or (None, None) if a histogram is empty.
+  """
+  n1 = sum(count for _, count in baseline)
+  n2 = sum(count for _, count in candidate)
+  if n1 <= 0 or n2 <= 0:
+    return None, None
+  merged = sorted([(value, count, False) for value, count in baseline] +
+                  [(value, count, True) for value, count in candidate])
+
+  # Equal values share their average rank.
+  rank = 0.0
+  candidate_rank_sum = 0.0
+  tie_term = 0.0
+  i = 0
+  while i < len(merged):
+    j = i
+    tied = 0.0
+    tied_candidate = 0.0
+    while j < len(merged) and merged[j][0] == merged[i][0]:
+      tied += merged[j][1]
+      if merged[j][2]:
+        tied_candidate += merged[j][1]
+      j += 1
+    candidate_rank_sum += (rank + (tied + 1.0) / 2.0) * tied_candidate
+    tie_term += tied ** 3 - tied
+    rank += tied
+    i = j
+
+  u = candidate_rank_sum - n2 * (n2 + 1.0) / 2.0
+  n = n1 + n2
+  variance = n1 * n2 / 12.0 * ((n + 1.0) - tie_term / (n * (n - 1.0)))
+  superiority = u / (n1 * n2)
+  if variance <= 0:
+    return 1.0, superiority
+  z = max(0.0, abs(u - n1 * n2 / 2.0) - 0.5) / math.sqrt(variance)
+  return math.erfc(z / math.sqrt(2.0)), superiority
+
+
+def classify(change, threshold, significant=True):
+  if significant and change > threshold:
+    return REGRESSION
+  if significant and change < -threshold:
+    return IMPROVEMENT
+  return NO_CHANGE
+
+
+def operators_by_occurrence(ops):
+  """Re-keys {(node index, op name): profile} by (op name, occurrence).
+
+  The occurrence counts the operators of the same name in node order, so that
+  operators still match when a different delegate partitioning renumbers the
+  nodes. Values are (node index, profile) pairs.
+  """
+  by_occurrence = {}
+  occurrences = collections.Counter()
+  for node_index, op_name in sorted(ops):
+    by_occurrence[(op_name, occurrences[op_name])] = (
+        node_index, ops[(node_index, op_name)])
+    occurrences[op_name] += 1
+  return by_occurrence
+
+
+def delegated_count(ops):
+  return sum(1 for op in ops.values() if op.delegated)
+
+
+def compare_operators(baseline_ops, candidate_ops, args):
+  """Per operator deltas, worst first."""
+  deltas = []
+  baseline_ops = operators_by_occurrence(baseline_ops)
+  candidate_ops = operators_by_occurrence(candidate_ops)
+  for op in sorted(set(baseline_ops) | set(candidate_ops)):
+    delta = {'op_name': op[0], 'occurrence': op[1]}
+    base_index, base = baseline_ops.get(op, (None, None))
+    cand_index, cand = candidate_ops.get(op, (None, None))
+    delta['node_index'] = cand_index if cand else base_index
+    # Operators only on one side are reported but don't fail the comparison,
+    # lost delegation is caught by the delegated operator count.
+    if not base or not cand:
+      delta['verdict'] = NEW if cand else MISSING
+      deltas.append(delta)
+      continue
+    base_mean = base.total_time_sec / base.count if base.count else 0.0
+    cand_mean = cand.total_time_sec / cand.count if cand.count else 0.0
+    delta['baseline_mean_sec'] = base_mean
+    delta['candidate_mean_sec'] = cand_mean
+    delta['baseline_delegated'] = base.delegated
+    delta['candidate_delegated'] = cand.delegated
+    change = cand_mean / base_mean - 1.0 if base_mean > 0 else 0.0
+    delta['change'] = change
+    if base.delegated and not cand.delegated:
+      delta['verdict'] = REGRESSION
+      delta['reason'] = 'no longer delegated'
+    elif abs(cand_mean - base_mean) * 1000.0 < args.op_min_delta_ms:
+      delta['verdict'] = NO_CHANGE
+    else:
+      delta['verdict'] = classify(change, args.op_threshold / 100.0)
+    deltas.append(delta)
+  deltas.sort(key=lambda x: ([REGRESSION, IMPROVEMENT, NO_CHANGE, NEW,
+                              MISSING].index(x['verdict']),
+                             -abs(x.get('change', 0.0))))
+  return deltas
+
+
+def compare_model(name, backend, baseline, candidate, args):
+  """Compare the pooled results of a model, returns its verdict entry."""
+  entry = {'name': name, 'backend': backend, 'metric': args.metric}
+  base_results = baseline.results.get((name, backend))
+  cand_results = candidate.results.get((name, backend))
+  if not base_results or not cand_results:
+    entry['verdict'] = NEW if cand_results else MISSING
+    return entry
+
+  # Exact percentiles only exist for single results, pooled ones on either
+  # side switch both to the histograms.
+  exact = len(base_results) == 1 and len(cand_results) == 1
+  base_latency = latency_sec(base_results, args.metric, exact)
+  cand_latency = latency_sec(cand_results, args.metric, exact)
+  base_histogram = latency_histogram(base_results)
+  cand_histogram = latency_histogram(cand_results)
+  tested = base_histogram is not None and cand_histogram is not None
+  p_value, superiority = None, None
+  if tested:
+    p_value, superiority = mann_whitney_u(base_histogram, cand_histogram)
+  entry['baseline_iterations'] = sum(r.iterations for r in base_results)
+  entry['candidate_iterations'] = sum(r.iterations for r in cand_results)
+  entry['baseline_sec'] = base_latency
+  entry['candidate_sec'] = cand_latency
+  entry['p_value'] = p_value
+  entry['prob_slower'] = superiority
+  reasons = []
+  if base_latency and cand_latency is not None:
+    entry['change'] = cand_latency / base_latency - 1.0
+    entry['verdict'] = classify(
+        entry['change'], args.threshold / 100.0,
+        not tested or (p_value is not None and p_value < args.alpha))
+  else:
+    entry['verdict'] = NO_CHANGE
+  if entry['verdict'] == REGRESSION:
+    reasons.append('latency')
+
+  if (not any(r.validation_errors for r in base_results) and
+      any(r.validation_errors for r in cand_results)):
+    entry['verdict'] = REGRESSION
+    reasons.append('validation errors')
+
+  if (name, backend) in baseline.operators and (
+      (name, backend) in candidate.operators):
+    entry['operators'] = compare_operators(
+        baseline.operators[(name, backend)],
+        candidate.operators[(name, backend)], args)
+    if any(op['verdict'] == REGRESSION for op in entry['operators']):
+      entry['verdict'] = REGRESSION
+      reasons.append('operators')
+    base_delegated = delegated_count(baseline.operators[(name, backend)])
+    cand_delegated = delegated_count(candidate.operators[(name, backend)])
+    entry['baseline_delegated_ops'] = base_delegated
+    entry['candidate_delegated_ops'] = cand_delegated
+    if cand_delegated < base_delegated:
+      entry['verdict'] = REGRESSION
+      reasons.append('fewer delegated operators')
+  if reasons:
+    entry['reasons'] = reasons
+  return entry
+
+
+def compare_result_sets(baseline, candidate, args):
+  """Compare every model/backend of two result sets."""
+  models = [compare_model(name, backend, baseline, candidate, args)
+            for name, backend in sorted(set(baseline.results) |
+                                        set(candidate.results))]
+  failed = any(model['verdict'] in FAILING_VERDICTS for model in models)
+  return {
+      'path': candidate.path,
+      'build': candidate.build,
+      'verdict': 'fail' if failed else 'pass',
+      'models': models,
+  }
+
+
+def format_latency_change(entry):
+  if 'change' not in entry:
+    return ''
+  text = '{} {:.3f}ms -> {:.3f}ms ({:+.1f}%)'.format(
+      entry['metric'], entry['baseline_sec'] * 1000.0,
+      entry['candidate_sec'] * 1000.0, entry['change'] * 100.0)
+  if entry['p_value'] is not None:
+    text += ', p={:.2g}'.format(entry['p_value'])
+  return text
+
+
+def format_report(baseline, comparisons, verbose):
+  """Human readable report, only the changes unless verbose."""
+  lines = ['Baseline: {} ({})'.format(baseline.path, baseline.build)]
+  for comparison in comparisons:
+    lines.append('Candidate: {} ({}): {}'.format(
+        comparison['path'], comparison['build'],
+        comparison['verdict'].upper()))
+    for model in comparison['models']:
+      if model['verdict'] == NO_CHANGE and not verbose:
+        continue
+      line = '  {:<12} {} {} {}'.format(
+          model['verdict'].upper(), model['name'], model['backend'],
+          format_latency_change(model))
+      if 'reasons' in model:
+        line += ' [{}]'.format(', '.join(model['reasons']))
+      lines.append(line.rstrip())
+      for op in model.get('operators', []):
+        if op['verdict'] in (NO_CHANGE, NEW, MISSING) and not verbose:
+          continue
+        line = '    {:<12} op {} {}'.format(op['verdict'].upper(),
+                                            op['node_index'], op['op_name'])
+        if 'change' in op:
+          line += ' {:.3f}ms -> {:.3f}ms ({:+.1f}%)'.format(
+              op['baseline_mean_sec'] * 1000.0,
+              op['candidate_mean_sec'] * 1000.0, op['change'] * 100.0)
+        if 'reason' in op:
+          line += ' [{}]'.format(op['reason'])
+        lines.append(line)
+  return '\n'.join(lines) + '\n'
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description='Compare MLTS benchmark results against a baseline.')
+  parser.add_argument('baseline', help='baseline result csv or directory')
+  parser.add_argument('candidates', nargs='+',
+                      help='candidate result csvs or directories')
+  parser.add_argument('--metric', default='mean',
+                      choices=['mean'] + generate_result.LATENCY_PERCENTILES,
+                      help='latency compared against the threshold')
+  parser.add_argument('--threshold', type=float, default=5.0,
+                      help='latency change in percent flagged as a '
+                      'regression, default 5')
+  parser.add_argument('--alpha', type=float, default=0.01,
+                      help='significance level of the latency test, '
+                      'default 0.01')
+  parser.add_argument('--op-threshold', type=float, default=10.0,
+                      help='operator mean time change in percent flagged as '
+                      'a regression, default 10')
+  parser.add_argument('--op-min-delta-ms', type=float, default=0.05,
+                      help='operator mean time changes below this are '
+                      'ignored, default 0.05')
+  parser.add_argument('--json', help='write the verdict as json to this '
+                      'file, - for stdout')
+  parser.add_argument('--verbose', action='store_true',
+                      help='also report unchanged models and operators')
+  args = parser.parse_args()
+
+  baseline = load_result_set(args.baseline)
+  comparisons = [compare_result_sets(baseline, load_result_set(path), args)
+                 for path in args.candidates]
+  failed = any(c['verdict'] == 'fail' for c in comparisons)
+
+  verdict = {
+      'verdict': 'fail' if failed else 'pass',
+      'baseline': {'path': baseline.path, 'build': baseline.build},
+      'settings': {
+          'metric': args.metric,
+          'threshold': args.threshold,
+          'alpha': args.alpha,
+          'op_threshold': args.op_threshold,
+          'op_min_delta_ms': args.op_min_delta_ms,
+      },
+      'candidates': comparisons,
+  }
+  if args.json == '-':
+    json.dump(verdict, sys.stdout, indent=2, sort_keys=True)
+    sys.stdout.write('\n')
+  else:
+    sys.stdout.write(format_report(baseline, comparisons, args.verbose))
+    if args.json:
+      with open(args.json, 'w') as jsonfile:
+        json.dump(verdict, jsonfile, indent=2, sort_keys=True)
+  return 1 if failed else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,264 @@
+#!/usr/bin/python3
+#
+# Copyright 2019, The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Unit tests of compare_results.
+
+Usage:
+  python3 compare_results_test.py
+"""
+
+import argparse
+import collections
+import struct
+import unittest
+
+import compare_results
+import generate_result
+
+
+TIME_FREQ_BUCKETS = 32
+
+
+def float32_text(value):
+  """Shortest text of value as a 32-bit float, like formatFloat() writes it."""
+  value32 = struct.unpack('f', struct.pack('f', value))[0]
+  for precision in range(1, 10):
+    text = '%.*g' % (precision, value32)
+    if struct.unpack('f', struct.pack('f', float(text)))[0] == value32:
+      return text
+  return text
+
+
+def make_result(latencies_sec, name='model', backend='TFLite_NNAPI',
+                validation_errors=(), percentiles=None):
+  """BenchmarkResult of the given latencies, binned like BenchmarkResult.java.
+
+  The timeFreq histogram spans the min to max latency, the native histogram
+  has the fixed log-linear buckets of LatencyHistogram, with their lower bounds
+  read back from 32-bit float text like in the CSV.
+  """
+  start_sec = min(latencies_sec)
+  step_sec = (max(latencies_sec) - start_sec) / (TIME_FREQ_BUCKETS - 1)
+  time_freq_sec = [0.0] * TIME_FREQ_BUCKETS
+  native_buckets = collections.Counter()
+  for latency in latencies_sec:
+    index = int((latency - start_sec) / step_sec) if step_sec > 0 else 0
+    time_freq_sec[min(index, TIME_FREQ_BUCKETS - 1)] += 1
+    lower, _ = compare_results.bucket_bounds_nsec(int(latency * 1e9))
+    native_buckets[float32_text(lower / 1e9)] += 1
+  return generate_result.BenchmarkResult(
+      name=name,
+      backend_type=backend,
+      iterations=len(latencies_sec),
+      total_time_sec=sum(latencies_sec),
+      max_single_error=0.0,
+      testset_size=1,
+      evaluator_keys=[],
+      evaluator_values=[],
+      time_freq_start_sec=start_sec,
+      time_freq_step_sec=step_sec,
+      time_freq_sec=time_freq_sec,
+      validation_errors=list(validation_errors),
+      latency_percentiles_sec=percentiles or [],
+      memory=None,
+      step_latencies=None,
+      convergence=None,
+      latency_histogram=sorted((float(lower_sec), count)
+                               for lower_sec, count in native_buckets.items()))
+
+
+def make_result_set(results, operators=None):
+  return compare_results.ResultSet(
+      path='path',
+      build='build',
+      results={(r.name, r.backend_type): [r] for r in results},
+      operators=operators or {})
+
+
+def make_args(metric='mean'):
+  return argparse.Namespace(metric=metric, threshold=5.0, alpha=0.01,
+                            op_threshold=10.0, op_min_delta_ms=0.05)
+
+
+class MannWhitneyUTest(unittest.TestCase):
+
+  def test_identical_distributions(self):
+    histogram = [(0.001, 10), (0.002, 20), (0.003, 10)]
+    p_value, superiority = compare_results.mann_whitney_u(histogram,
+                                                          histogram)
+    self.assertAlmostEqual(p_value, 1.0)
+    self.assertAlmostEqual(superiority, 0.5)
+
+  def test_shifted_distributions(self):
+    baseline = [(0.001, 50), (0.002, 50)]
+    candidate = [(0.003, 50), (0.004, 50)]
+    p_value, superiority = compare_results.mann_whitney_u(baseline, candidate)
+    self.assertLess(p_value, 1e-10)
+    self.assertAlmostEqual(superiority, 1.0)
+    p_value, superiority = compare_results.mann_whitney_u(candidate, baseline)
+    self.assertLess(p_value, 1e-10)
+    self.assertAlmostEqual(superiority, 0.0)
+
+  def test_known_value(self):
+    # Only the candidate 7 beats the baseline, so U = 3 of 9 pairs. Without
+    # ties the corrected normal approximation gives z = 1 / sqrt(5.25).
+    baseline = [(4.0, 1), (5.0, 1), (6.0, 1)]
+    candidate = [(1.0, 1), (2.0, 1), (7.0, 1)]
+    p_value, superiority = compare_results.mann_whitney_u(baseline, candidate)
+    self.assertAlmostEqual(superiority, 3.0 / 9.0)
+    self.assertAlmostEqual(p_value, 0.6625, places=3)
+
+  def test_empty_histogram(self):
+    self.assertEqual(compare_results.mann_whitney_u([], [(0.001, 1)]),
+                     (None, None))
+
+
+class CompareModelTest(unittest.TestCase):
+
+  def test_regression(self):
+    baseline = make_result_set([make_result([0.010, 0.011] * 50)])
+    candidate = make_result_set([make_result([0.020, 0.021] * 50)])
+    entry = compare_results.compare_model('model', 'TFLite_NNAPI', baseline,
+                                          candidate, make_args())
+    self.assertEqual(entry['verdict'], compare_results.REGRESSION)
+    self.assertEqual(entry['reasons'], ['latency'])
+    self.assertGreater(entry['change'], 0.5)
+
+  def test_improvement(self):
+    baseline = make_result_set([make_result([0.020, 0.021] * 50)])
+    candidate = make_result_set([make_result([0.010, 0.011] * 50)])
+    entry = compare_results.compare_model('model', 'TFLite_NNAPI', baseline,
+                                          candidate, make_args())
+    self.assertEqual(entry['verdict'], compare_results.IMPROVEMENT)
+
+  def test_insignificant_change(self):
+    baseline = make_result_set([make_result([0.010, 0.030])])
+    candidate = make_result_set([make_result([0.012, 0.031])])
+    entry = compare_results.compare_model('model', 'TFLite_NNAPI', baseline,
+                                          candidate, make_args())
+    self.assertEqual(entry['verdict'], compare_results.NO_CHANGE)
+
+  def test_outlier_does_not_move_bulk(self):
+    # Same bulk, only the outlier differs. It stretches the timeFreq range,
+    # which shifted the bulk into other buckets.
+    bulk = [0.0100 + 0.00002 * (i % 10) for i in range(200)]
+    baseline = make_result_set([make_result(bulk + [0.100])])
+    candidate = make_result_set([make_result(bulk + [0.050])])
+    entry = compare_results.compare_model('model', 'TFLite_NNAPI', baseline,
+                                          candidate, make_args('p50'))
+    self.assertEqual(entry['verdict'], compare_results.NO_CHANGE)
+    self.assertGreater(entry['p_value'], 0.5)
+    self.assertAlmostEqual(entry['change'], 0.0)
+
+  def test_untested_without_native_histogram(self):
+    # Results of older versions only have the timeFreq histogram, the
+    # threshold alone decides.
+    baseline = make_result([0.010, 0.030])._replace(latency_histogram=None)
+    candidate = make_result([0.020, 0.060])
+    entry = compare_results.compare_model(
+        'model', 'TFLite_NNAPI', make_result_set([baseline]),
+        make_result_set([candidate]), make_args())
+    self.assertIsNone(entry['p_value'])
+    self.assertEqual(entry['verdict'], compare_results.REGRESSION)
+
+  def test_bucket_bounds(self):
+    self.assertEqual(compare_results.bucket_bounds_nsec(100), (100, 101))
+    # 10 ms is in a 2^17 nsec wide bucket.
+    lower, upper = compare_results.bucket_bounds_nsec(10000000)
+    self.assertEqual(upper - lower, 1 << 17)
+    self.assertLessEqual(lower, 10000000)
+    self.assertLess(10000000, upper)
+    self.assertEqual(compare_results.bucket_bounds_nsec(lower), (lower, upper))
+
+  def test_histogram_from_float32_bounds(self):
+    # Bounds of buckets above ~8 ms written as 32-bit floats can read back
+    # 1 nsec low, they must still land in their own bucket.
+    latencies_sec = []
+    expected = []
+    lower, _ = compare_results.bucket_bounds_nsec(16 * 1000 * 1000)
+    while lower < 67 * 1000 * 1000:
+      _, upper = compare_results.bucket_bounds_nsec(lower)
+      latencies_sec.append((lower + upper) / 2e9)
+      expected.append(((lower + upper - 1) // 2 / 1e9, 1))
+      lower = upper
+    histogram = compare_results.latency_histogram([make_result(latencies_sec)])
+    self.assertEqual(histogram, expected)
+
+  def test_missing_and_new(self):
+    results = make_result_set([make_result([0.010])])
+    empty = make_result_set([])
+    self.assertEqual(
+        compare_results.compare_model('model', 'TFLite_NNAPI', results,
+                                      empty, make_args())['verdict'],
+        compare_results.MISSING)
+    self.assertEqual(
+        compare_results.compare_model('model', 'TFLite_NNAPI', empty,
+                                      results, make_args())['verdict'],
+        compare_results.NEW)
+
+  def test_validation_errors(self):
+    baseline = make_result_set([make_result([0.010] * 10)])
+    candidate = make_result_set(
+        [make_result([0.010] * 10, validation_errors=['error'])])
+    entry = compare_results.compare_model('model', 'TFLite_NNAPI', baseline,
+                                          candidate, make_args())
+    self.assertEqual(entry['verdict'], compare_results.REGRESSION)
+    self.assertEqual(entry['reasons'], ['validation errors'])
+
+  def test_percentile_estimator_matches_pooled_side(self):
+    # The exact p50 column of the single baseline result is well below its
+    # histogram bucket mid-point, which the pooled candidate has to use.
+    baseline_result = make_result([0.0101] * 100,
+                                  percentiles=[0.0101] * 5)
+    candidate_result = make_result([0.0101] * 50)
+    baseline = make_result_set([baseline_result])
+    candidate = make_result_set([])
+    candidate.results[('model', 'TFLite_NNAPI')] = [candidate_result,
+                                                    candidate_result]
+    entry = compare_results.compare_model('model', 'TFLite_NNAPI', baseline,
+                                          candidate, make_args('p50'))
+    self.assertAlmostEqual(entry['baseline_sec'], entry['candidate_sec'])
+    self.assertEqual(entry['verdict'], compare_results.NO_CHANGE)
+
+  def test_lost_delegation(self):
+    profile = compare_results.OperatorProfile
+    baseline_ops = {
+        (0, 'TfLiteNnapiDelegate'): profile(False, 10, 0.010),
+        (1, 'CONV_2D'): profile(True, 10, 0.005),
+        (2, 'CONV_2D'): profile(True, 10, 0.005),
+    }
+    # The second convolution falls back to the CPU, which renumbers it.
+    candidate_ops = {
+        (0, 'TfLiteNnapiDelegate'): profile(False, 10, 0.005),
+        (1, 'CONV_2D'): profile(True, 10, 0.005),
+        (3, 'CONV_2D'): profile(False, 10, 0.005),
+    }
+    baseline = make_result_set([make_result([0.010] * 10)],
+                               {('model', 'TFLite_NNAPI'): baseline_ops})
+    candidate = make_result_set([make_result([0.010] * 10)],
+                                {('model', 'TFLite_NNAPI'): candidate_ops})
+    entry = compare_results.compare_model('model', 'TFLite_NNAPI', baseline,
+                                          candidate, make_args())
+    self.assertEqual(entry['verdict'], compare_results.REGRESSION)
+    self.assertIn('operators', entry['reasons'])
+    self.assertIn('fewer delegated operators', entry['reasons'])
+    lost = entry['operators'][0]
+    self.assertEqual((lost['op_name'], lost['occurrence']), ('CONV_2D', 1))
+    self.assertEqual(lost['reason'], 'no longer delegated')
+
+
+if __name__ == '__main__':
+  unittest.main()
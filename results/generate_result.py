@@ -40,7 +40,44 @@ BenchmarkResult = collections.namedtuple(
     ['name', 'backend_type', 'iterations', 'total_time_sec', 'max_single_error',
      'testset_size', 'evaluator_keys', 'evaluator_values',
      'time_freq_start_sec', 'time_freq_step_sec', 'time_freq_sec',
-     'validation_errors'])
+     'validation_errors', 'latency_percentiles_sec', 'memory',
+     'step_latencies', 'convergence', 'latency_histogram'])
+
+# Latency percentiles at the end of every result line, in CSV order.
+LATENCY_PERCENTILES = ['p50', 'p90', 'p95', 'p99', 'max']
+
+# Memory footprint after the latency percentiles, in CSV order, see
+# MemoryProfile.toCsvValues(). -1 when not measured.
+MEMORY_FIELDS = [
+    'arena_bytes',
+    'before_create_rss_kb', 'before_create_pss_kb', 'before_create_heap_bytes',
+    'after_create_rss_kb', 'after_create_pss_kb', 'after_create_heap_bytes',
+    'first_inference_rss_kb', 'first_inference_pss_kb',
+    'first_inference_heap_bytes',
+    'steady_rss_kb', 'steady_pss_kb', 'steady_heap_bytes',
+    'peak_heap_bytes', 'peak_rss_kb']
+
+# Latency by sequence position after the memory footprint, in CSV order, see
+# StepLatencies.toCsvValues(). -1 when not measured.
+STEP_LATENCY_FIELDS = [
+    'first_step_count', 'first_step_mean_sec', 'first_step_p99_sec',
+    'later_step_count', 'later_step_mean_sec', 'later_step_p99_sec',
+    'reset_count', 'reset_mean_sec']
+
+# Convergence status after the step latencies, in CSV order, see
+# ConvergenceStatus.toCsvValues(). -1 for fixed time or size runs.
+CONVERGENCE_FIELDS = ['converged', 'estimate_sec', 'relative_width']
+
+# The convergence status is followed by the non-empty buckets of the native
+# log-linear latency histogram, see LatencyHistogram.java: their count, then
+# (bucket lower bound sec, count) pairs.
+
+# Memory columns of the result table: (field, divisor to the displayed unit).
+MEMORY_COLUMNS = [
+    ('arena_bytes', 1024.0),
+    ('steady_pss_kb', 1024.0),
+    ('peak_rss_kb', 1024.0),
+    ('peak_heap_bytes', 1024.0 * 1024.0)]
 
 
 ResultsWithBaseline = collections.namedtuple(
@@ -69,6 +106,9 @@ def parse_csv_input(input_filename):
 
     results = []
     for row in csv_reader:
+      # CSVWriter appends, later runs in the same file repeat the device info.
+      if len(row) < 11:
+        continue
       evaluator_keys_count = int(row[8])
       time_freq_sec_count = int(row[9])
       validation_error_count = int(row[10])
@@ -78,6 +118,36 @@ def parse_csv_input(input_filename):
                        row[tf_start:tf_start + time_freq_sec_count]]
       ve_start = 11 + evaluator_keys_count*2 + time_freq_sec_count
       validation_errors = row[ve_start: ve_start + validation_error_count]
+      # Not present in results of older versions.
+      lp_start = ve_start + validation_error_count
+      latency_percentiles_sec = None
+      if len(row) >= lp_start + len(LATENCY_PERCENTILES):
+        latency_percentiles_sec = [
+            float(x) for x in
+            row[lp_start:lp_start + len(LATENCY_PERCENTILES)]]
+      mem_start = lp_start + len(LATENCY_PERCENTILES)
+      memory = None
+      if len(row) >= mem_start + len(MEMORY_FIELDS):
+        memory = dict(zip(MEMORY_FIELDS, [
+            int(x) for x in row[mem_start:mem_start + len(MEMORY_FIELDS)]]))
+      sl_start = mem_start + len(MEMORY_FIELDS)
+      step_latencies = None
+      if len(row) >= sl_start + len(STEP_LATENCY_FIELDS):
+        step_latencies = dict(zip(STEP_LATENCY_FIELDS, [
+            float(x) for x in
+            row[sl_start:sl_start + len(STEP_LATENCY_FIELDS)]]))
+      cv_start = sl_start + len(STEP_LATENCY_FIELDS)
+      convergence = None
+      if len(row) >= cv_start + len(CONVERGENCE_FIELDS):
+        convergence = dict(zip(CONVERGENCE_FIELDS, [
+            float(x) for x in
+            row[cv_start:cv_start + len(CONVERGENCE_FIELDS)]]))
+      lh_start = cv_start + len(CONVERGENCE_FIELDS)
+      latency_histogram = None
+      if len(row) > lh_start:
+        buckets = row[lh_start + 1:lh_start + 1 + 2 * int(row[lh_start])]
+        latency_histogram = [(float(buckets[i]), int(buckets[i + 1]))
+                             for i in range(0, len(buckets), 2)]
 
       results.append(BenchmarkResult(
           name=row[0],
@@ -93,6 +163,11 @@ def parse_csv_input(input_filename):
               11 + evaluator_keys_count: 11 + evaluator_keys_count*2],
           time_freq_sec=time_freq_sec,
           validation_errors=validation_errors,
+          latency_percentiles_sec=latency_percentiles_sec,
+          memory=memory,
+          step_latencies=step_latencies,
+          convergence=convergence,
+          latency_histogram=latency_histogram,
       ))
     return (benchmark_info, results)
 
@@ -311,6 +386,57 @@ def generate_avg_ms(baseline, result):
       span=get_diff_span(diff, same_delta=1.0, positive_is_better=False))
 
 
+def generate_latency_percentiles(result):
+  """Generate latency percentile cells, empty if the result has none."""
+  percentiles = result.latency_percentiles_sec
+  if not percentiles or percentiles[-1] <= 0.0:
+    return ''.join(LATENCY_PERCENTILE_MISSING_TEMPLATE
+                   for _ in LATENCY_PERCENTILES)
+  return ''.join(LATENCY_PERCENTILE_TEMPLATE.format(val=x * 1000.0)
+                 for x in percentiles)
+
+
+def generate_memory_values(baseline, result):
+  """Generate memory footprint cells, diffed against the baseline."""
+  cells = []
+  for field, divisor in MEMORY_COLUMNS:
+    if not result.memory or result.memory[field] < 0:
+      cells.append(MEMORY_MISSING_TEMPLATE)
+      continue
+    val = result.memory[field] / divisor
+    if (result is baseline or not baseline.memory or
+        baseline.memory[field] <= 0):
+      cells.append(MEMORY_BASELINE_TEMPLATE.format(val=val))
+      continue
+    diff = (float(result.memory[field]) / baseline.memory[field] - 1.0) * 100.0
+    cells.append(MEMORY_DIFF_TEMPLATE.format(
+        val=val,
+        diff=diff,
+        span=get_diff_span(diff, same_delta=2.0, positive_is_better=False)))
+  return ''.join(cells)
+
+
+def generate_step_latencies(result):
+  """Generate first and later step cells, empty for single step sequences."""
+  steps = result.step_latencies
+  if not steps or steps['later_step_count'] <= 0:
+    return STEP_LATENCY_MISSING_TEMPLATE * 2
+  return ''.join(STEP_LATENCY_TEMPLATE.format(val=x * 1000.0) for x in
+                 [steps['first_step_mean_sec'], steps['later_step_mean_sec']])
+
+
+def generate_convergence(result):
+  """Generate the confidence interval cell of convergence driven runs."""
+  convergence = result.convergence
+  if not convergence or convergence['converged'] < 0:
+    return CONVERGENCE_MISSING_TEMPLATE
+  if convergence['relative_width'] < 0:
+    return CONVERGENCE_UNBOUNDED_TEMPLATE
+  return CONVERGENCE_TEMPLATE.format(
+      val=convergence['relative_width'] * 100.0,
+      span='same' if convergence['converged'] > 0 else 'worse')
+
+
 def generate_result_entry(baseline, result):
   if result is None:
     result = baseline
@@ -322,7 +448,11 @@ def generate_result_entry(baseline, result):
       iterations=result.iterations,
       testset_size=result.testset_size,
       accuracy_values=generate_accuracy_values(baseline, result),
-      avg_ms=generate_avg_ms(baseline, result))
+      avg_ms=generate_avg_ms(baseline, result),
+      latency_percentiles=generate_latency_percentiles(result),
+      memory_values=generate_memory_values(baseline, result),
+      step_latencies=generate_step_latencies(result),
+      convergence=generate_convergence(result))
 
 
 def generate_latency_graph_entry(result, results_with_bl):
@@ -487,6 +617,18 @@ RESULT_GROUP_TEMPLATE = """<div class="group">
    <th>Iterations</th>
    <th>Test set size</th>
    <th>Average latency ms</th>
+   <th>p50 ms</th>
+   <th>p90 ms</th>
+   <th>p95 ms</th>
+   <th>p99 ms</th>
+   <th>Max ms</th>
+   <th>Arena KiB</th>
+   <th>Steady PSS MiB</th>
+   <th>Peak RSS MiB</th>
+   <th>Peak heap MiB</th>
+   <th>First step ms</th>
+   <th>Later steps ms</th>
+   <th>CI &plusmn;%</th>
    {accuracy_headers}
  </tr>
  {results}
@@ -590,9 +732,24 @@ RESULT_ENTRY_TEMPLATE = """
    <td>{iterations:d}</td>
    <td>{testset_size:d}</td>
    <td>{avg_ms}</td>
+   {latency_percentiles}
+   {memory_values}
+   {step_latencies}
+   {convergence}
    {accuracy_values}
   </tr>"""
 
+LATENCY_PERCENTILE_TEMPLATE = """<td>{val:.2f}</td>"""
+LATENCY_PERCENTILE_MISSING_TEMPLATE = """<td>-</td>"""
+STEP_LATENCY_TEMPLATE = """<td>{val:.2f}</td>"""
+STEP_LATENCY_MISSING_TEMPLATE = """<td>-</td>"""
+CONVERGENCE_TEMPLATE = """<td><span class='{span}'>{val:.1f}</span></td>"""
+CONVERGENCE_UNBOUNDED_TEMPLATE = """<td><span class='worse'>&infin;</span></td>"""
+CONVERGENCE_MISSING_TEMPLATE = """<td>-</td>"""
+MEMORY_BASELINE_TEMPLATE = """<td>{val:.1f}</td>"""
+MEMORY_DIFF_TEMPLATE = """<td>{val:.1f} <span class='{span}'>
+({diff:.1f}%)</span></td>"""
+MEMORY_MISSING_TEMPLATE = """<td>-</td>"""
 LATENCY_BASELINE_TEMPLATE = """{val:.2f}ms"""
 LATENCY_DIFF_TEMPLATE = """{val:.2f}ms <span class='{span}'>
 ({diff_val:.2f}ms, {diff:.1f}%)</span>"""
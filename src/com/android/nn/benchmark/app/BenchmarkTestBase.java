@@ -27,6 +27,9 @@ import androidx.test.InstrumentationRegistry;
 
 import com.android.nn.benchmark.core.BenchmarkException;
 import com.android.nn.benchmark.core.BenchmarkResult;
+import com.android.nn.benchmark.core.ConvergenceOptions;
+import com.android.nn.benchmark.core.ScenarioResult;
+import com.android.nn.benchmark.core.ScenarioRunner;
 import com.android.nn.benchmark.core.TestModels;
 import com.android.nn.benchmark.core.TestModels.TestModelEntry;
 
@@ -79,6 +82,102 @@ public class BenchmarkTestBase extends ActivityInstrumentationTestCase2<NNBenchm
         mActivity.setCompleteInputSet(completeInputSet);
     }
 
+    protected void setWarmupInferences(int warmupInferences) {
+        mActivity.setWarmupInferences(warmupInferences);
+    }
+
+    protected void setStreamingStats(boolean streamingStats) {
+        mActivity.setStreamingStats(streamingStats);
+    }
+
+    protected void setZeroCopyInput(boolean zeroCopyInput) {
+        mActivity.setZeroCopyInput(zeroCopyInput);
+    }
+
+    protected void setAsyncValidation(boolean asyncValidation) {
+        mActivity.setAsyncValidation(asyncValidation);
+    }
+
+    protected void setMappedDataset(boolean mappedDataset) {
+        mActivity.setMappedDataset(mappedDataset);
+    }
+
+    protected void setOperatorProfiling(boolean operatorProfiling) {
+        mActivity.setOperatorProfiling(operatorProfiling);
+    }
+
+    protected void setPrefetchInputs(boolean prefetchInputs) {
+        mActivity.setPrefetchInputs(prefetchInputs);
+    }
+
+    protected void setSamplePeakHeap(boolean samplePeakHeap) {
+        mActivity.setSamplePeakHeap(samplePeakHeap);
+    }
+
+    protected void setNativeEvaluation(boolean nativeEvaluation) {
+        mActivity.setNativeEvaluation(nativeEvaluation);
+    }
+
+    protected void setSustained(float durationSec, float windowSec, boolean readSensors) {
+        mActivity.setSustained(durationSec, windowSec, readSensors);
+    }
+
+    protected void setConcurrentInferences(int concurrentInferences) {
+        mActivity.setConcurrentInferences(concurrentInferences);
+    }
+
+    protected void setOpenLoop(float[] arrivalRates, boolean poisson) {
+        mActivity.setOpenLoop(arrivalRates, poisson);
+    }
+
+    protected void setNumThreads(int numThreads) {
+        mActivity.setNumThreads(numThreads);
+    }
+
+    protected void setThreadSweepMax(int threadSweepMax) {
+        mActivity.setThreadSweepMax(threadSweepMax);
+    }
+
+    protected void setBatchSweep(int[] batchSizes) {
+        mActivity.setBatchSweep(batchSizes);
+    }
+
+    protected void setColdStartIterations(int coldStartIterations) {
+        mActivity.setColdStartIterations(coldStartIterations);
+    }
+
+    protected void setDelegateOptions(int executionPreference, boolean allowFp16,
+            int maxDelegatedPartitions, boolean disallowNNApiCpu) {
+        mActivity.setDelegateOptions(executionPreference, allowFp16, maxDelegatedPartitions,
+                disallowNNApiCpu);
+    }
+
+    protected void setDelegateOptionsSweep(int[] executionPreferences, boolean[] allowFp16,
+            int[] maxDelegatedPartitions, boolean[] disallowNNApiCpu) {
+        mActivity.setDelegateOptionsSweep(executionPreferences, allowFp16,
+                maxDelegatedPartitions, disallowNNApiCpu);
+    }
+
+    protected void setExecutionModes(int[] executionModes) {
+        mActivity.setExecutionModes(executionModes);
+    }
+
+    protected void setCompilationCaching(boolean compilationCaching) {
+        mActivity.setCompilationCaching(compilationCaching);
+    }
+
+    protected void setCompilationCacheIterations(int compilationCacheIterations) {
+        mActivity.setCompilationCacheIterations(compilationCacheIterations);
+    }
+
+    protected void setCpuAffinity(int cores, long explicitMask) {
+        mActivity.setCpuAffinity(cores, explicitMask);
+    }
+
+    protected void setConvergence(ConvergenceOptions convergenceOptions) {
+        mActivity.setConvergence(convergenceOptions);
+    }
+
     // Initialize the parameter for ImageProcessingActivityJB.
     protected void prepareTest() {
         injectInstrumentation(InstrumentationRegistry.getInstrumentation());
@@ -171,6 +270,33 @@ public class BenchmarkTestBase extends ActivityInstrumentationTestCase2<NNBenchm
         getInstrumentation().sendStatus(Activity.RESULT_OK, bmValue.toBundle(testName));
     }
 
+    /**
+     * Runs the models together on the instrumentation thread, see {@link ScenarioRunner}, and
+     * posts one result per model, named testName + "_" + its model name.
+     */
+    public void runScenario(List<ScenarioRunner.ModelConfig> models, boolean useNNApi,
+            int schedule, float durationSec, String testName)
+            throws IOException, BenchmarkException {
+        final String traceName = "[NN_LA_PO]" + testName;
+        ScenarioResult scenario;
+        try {
+            Trace.beginSection(traceName);
+            scenario = new ScenarioRunner(models, useNNApi).run(mActivity, schedule,
+                    durationSec);
+        } finally {
+            Trace.endSection();
+        }
+        String backendType = useNNApi ? BenchmarkResult.BACKEND_TFLITE_NNAPI
+                : BenchmarkResult.BACKEND_TFLITE_CPU;
+        for (int k = 0; k < scenario.mModelNames.length; ++k) {
+            BenchmarkResult result = BenchmarkResult.fromScenarioResult(backendType, scenario, k);
+            Log.v(NNBenchmark.TAG, "Scenario \"" + testName + "\" model "
+                    + scenario.mModelNames[k] + ": " + result);
+            getInstrumentation().sendStatus(Activity.RESULT_OK,
+                    result.toBundle(testName + "_" + scenario.mModelNames[k]));
+        }
+    }
+
     @Parameters(name = "{0}")
     public static List<TestModelEntry> modelsList() {
         return TestModels.modelsList();
@@ -27,9 +27,15 @@ import android.widget.TextView;
 
 import com.android.nn.benchmark.core.BenchmarkException;
 import com.android.nn.benchmark.core.BenchmarkResult;
+import com.android.nn.benchmark.core.ConvergenceOptions;
+import com.android.nn.benchmark.core.ConvergenceStatus;
 import com.android.nn.benchmark.core.InferenceInOutSequence;
 import com.android.nn.benchmark.core.InferenceResult;
+import com.android.nn.benchmark.core.InferenceSummary;
 import com.android.nn.benchmark.core.NNTestBase;
+import com.android.nn.benchmark.core.OpenLoopSummary;
+import com.android.nn.benchmark.core.StartupProfile;
+import com.android.nn.benchmark.core.SustainedProfile;
 import com.android.nn.benchmark.core.TestModels;
 import com.android.nn.benchmark.core.UnsupportedSdkException;
 
@@ -57,6 +63,64 @@ public class NNBenchmark extends Activity {
 
     private boolean mUseNNApi;
     private boolean mCompleteInputSet;
+    // If positive, caps the number of warmup inferences, otherwise warmup is time-bound only.
+    private int mWarmupInferences = 0;
+    // Aggregate results in native code instead of collecting every inference result.
+    private boolean mStreamingStats;
+    private boolean mZeroCopyInput;
+    // Validate inference outputs on a background thread.
+    private boolean mAsyncValidation;
+    // Run on a memory mapped copy of the inputs, see NNTestBase.setUseMappedDataset.
+    private boolean mMappedDataset;
+    // Attach per-operator execution times to the results.
+    private boolean mOperatorProfiling;
+    // Create inputs on a native producer thread ahead of the inferences.
+    private boolean mPrefetchInputs;
+    // Sample the heap during the runs for the peak heap, at some cost in latency accuracy.
+    private boolean mSamplePeakHeap;
+    // Evaluate accuracy in native code, without keeping the inference outputs.
+    private boolean mNativeEvaluation;
+    // If positive, runs inferences back to back for that many seconds and reports the latency
+    // in windows of mSustainedWindowSec, optionally with the thermal and clock readings.
+    private float mSustainedDurationSec = 0.f;
+    private float mSustainedWindowSec = 1.f;
+    private boolean mSustainedReadSensors;
+    // If greater than 1, runs that many inferences at once, each on its own interpreter.
+    private int mConcurrentInferences = 1;
+    // If set, runs an open-loop benchmark at each of these arrival rates (requests per
+    // second) for minTime each, served by mConcurrentInferences interpreters.
+    private float[] mOpenLoopArrivalRates;
+    private boolean mOpenLoopPoisson;
+    // TFLite CPU kernel threads, -1 for the TFLite default.
+    private int mNumThreads = -1;
+    // If positive, benchmarks every thread count from 1 to mThreadSweepMax.
+    private int mThreadSweepMax = 0;
+    // If set, benchmarks throughput with every batch size in mBatchSizes.
+    private int[] mBatchSizes;
+    // If positive, benchmarks the model startup instead of the inference, creating and
+    // destroying the model that many times.
+    private int mColdStartIterations = 0;
+    private int mExecutionPreference = NNTestBase.EXECUTION_PREFERENCE_UNDEFINED;
+    private boolean mAllowFp16 = true;
+    private int mMaxDelegatedPartitions = 3;
+    private boolean mDisallowNNApiCpu;
+    // If set, compares these NNTestBase.EXECUTION_MODE_* NNAPI execution paths, the first one
+    // is the baseline.
+    private int[] mExecutionModes;
+    // If set, benchmarks every combination of these delegate options instead.
+    private int[] mSweepExecutionPreferences;
+    private boolean[] mSweepAllowFp16;
+    private int[] mSweepMaxDelegatedPartitions;
+    private boolean[] mSweepDisallowNNApiCpu;
+    private boolean mCompilationCaching;
+    // If positive, benchmarks the model startup with an empty vs a warm compilation cache,
+    // that many times each.
+    private int mCompilationCacheIterations = 0;
+    private boolean mCpuAffinity;
+    private int mCpuCores;
+    private long mCpuAffinityMask;
+    // If set, benchmark runs stop once the latency estimate has converged.
+    private ConvergenceOptions mConvergenceOptions;
 
     protected void setUseNNApi(boolean useNNApi) {
         mUseNNApi = useNNApi;
@@ -66,6 +130,111 @@ public class NNBenchmark extends Activity {
         mCompleteInputSet = completeInputSet;
     }
 
+    protected void setWarmupInferences(int warmupInferences) {
+        mWarmupInferences = warmupInferences;
+    }
+
+    protected void setStreamingStats(boolean streamingStats) {
+        mStreamingStats = streamingStats;
+    }
+
+    protected void setZeroCopyInput(boolean zeroCopyInput) {
+        mZeroCopyInput = zeroCopyInput;
+    }
+
+    protected void setAsyncValidation(boolean asyncValidation) {
+        mAsyncValidation = asyncValidation;
+    }
+
+    protected void setMappedDataset(boolean mappedDataset) {
+        mMappedDataset = mappedDataset;
+    }
+
+    protected void setOperatorProfiling(boolean operatorProfiling) {
+        mOperatorProfiling = operatorProfiling;
+    }
+
+    protected void setPrefetchInputs(boolean prefetchInputs) {
+        mPrefetchInputs = prefetchInputs;
+    }
+
+    protected void setSamplePeakHeap(boolean samplePeakHeap) {
+        mSamplePeakHeap = samplePeakHeap;
+    }
+
+    protected void setNativeEvaluation(boolean nativeEvaluation) {
+        mNativeEvaluation = nativeEvaluation;
+    }
+
+    protected void setSustained(float durationSec, float windowSec, boolean readSensors) {
+        mSustainedDurationSec = durationSec;
+        mSustainedWindowSec = windowSec;
+        mSustainedReadSensors = readSensors;
+    }
+
+    protected void setConcurrentInferences(int concurrentInferences) {
+        mConcurrentInferences = concurrentInferences;
+    }
+
+    protected void setOpenLoop(float[] arrivalRates, boolean poisson) {
+        mOpenLoopArrivalRates = arrivalRates;
+        mOpenLoopPoisson = poisson;
+    }
+
+    protected void setNumThreads(int numThreads) {
+        mNumThreads = numThreads;
+    }
+
+    protected void setThreadSweepMax(int threadSweepMax) {
+        mThreadSweepMax = threadSweepMax;
+    }
+
+    protected void setBatchSweep(int[] batchSizes) {
+        mBatchSizes = batchSizes;
+    }
+
+    protected void setColdStartIterations(int coldStartIterations) {
+        mColdStartIterations = coldStartIterations;
+    }
+
+    protected void setDelegateOptions(int executionPreference, boolean allowFp16,
+            int maxDelegatedPartitions, boolean disallowNNApiCpu) {
+        mExecutionPreference = executionPreference;
+        mAllowFp16 = allowFp16;
+        mMaxDelegatedPartitions = maxDelegatedPartitions;
+        mDisallowNNApiCpu = disallowNNApiCpu;
+    }
+
+    protected void setDelegateOptionsSweep(int[] executionPreferences, boolean[] allowFp16,
+            int[] maxDelegatedPartitions, boolean[] disallowNNApiCpu) {
+        mSweepExecutionPreferences = executionPreferences;
+        mSweepAllowFp16 = allowFp16;
+        mSweepMaxDelegatedPartitions = maxDelegatedPartitions;
+        mSweepDisallowNNApiCpu = disallowNNApiCpu;
+    }
+
+    protected void setExecutionModes(int[] executionModes) {
+        mExecutionModes = executionModes;
+    }
+
+    protected void setCompilationCaching(boolean compilationCaching) {
+        mCompilationCaching = compilationCaching;
+    }
+
+    protected void setCompilationCacheIterations(int compilationCacheIterations) {
+        mCompilationCacheIterations = compilationCacheIterations;
+    }
+
+    protected void setCpuAffinity(int cores, long explicitMask) {
+        mCpuAffinity = true;
+        mCpuCores = cores;
+        mCpuAffinityMask = explicitMask;
+    }
+
+    protected void setConvergence(ConvergenceOptions convergenceOptions) {
+        mConvergenceOptions = convergenceOptions;
+    }
+
     // Initialize the parameters for Instrumentation tests.
     protected void prepareInstrumentationTest() {
         mTestList = new int[1];
@@ -94,7 +263,80 @@ public class NNBenchmark extends Activity {
         // The function returns the average time in ms for the test run
         private BenchmarkResult runBenchmarkLoop(float minTime, boolean completeInputSet)
                 throws IOException {
+            String backendType = mUseNNApi ? BenchmarkResult.BACKEND_TFLITE_NNAPI
+                    : BenchmarkResult.BACKEND_TFLITE_CPU;
             try {
+                if (mCompilationCacheIterations > 0 && minTime > 0.f) {
+                    Pair<List<InferenceInOutSequence>, StartupProfile[][]> profiles =
+                            mTest.runCompilationCacheBenchmark(mCompilationCacheIterations);
+                    return BenchmarkResult.fromCompilationCacheProfiles(mTest.getTestInfo(),
+                            backendType, profiles.first, profiles.second[0],
+                            profiles.second[1]);
+                }
+                if (mColdStartIterations > 0 && minTime > 0.f) {
+                    Pair<List<InferenceInOutSequence>, StartupProfile[]> profiles =
+                            mTest.runColdStartBenchmark(mColdStartIterations);
+                    return BenchmarkResult.fromStartupProfiles(mTest.getTestInfo(),
+                            backendType, profiles.first, profiles.second);
+                }
+                // Concurrent and streaming modes keep no per-inference results, so they
+                // can't be used with evaluators or when the whole input set needs to be
+                // verified.
+                if (hasAggregatedMode() && minTime > 0.f && !completeInputSet
+                        && mTest.getEvaluator() != null) {
+                    return new BenchmarkResult("Concurrent, streaming and sweep benchmarks "
+                            + "can't be used with an evaluator");
+                }
+                if (mOpenLoopArrivalRates != null && minTime > 0.f && !completeInputSet) {
+                    Pair<List<InferenceInOutSequence>, OpenLoopSummary[]> summaries =
+                            mTest.runBenchmarkOpenLoop(mOpenLoopArrivalRates,
+                                    mOpenLoopPoisson ? NNTestBase.ARRIVAL_POISSON
+                                            : NNTestBase.ARRIVAL_FIXED_INTERVAL,
+                                    mConcurrentInferences, minTime);
+                    return BenchmarkResult.fromOpenLoopSummaries(mTest.getTestInfo(),
+                            backendType, summaries.first, summaries.second);
+                }
+                if (mConcurrentInferences > 1 && minTime > 0.f && !completeInputSet) {
+                    Pair<List<InferenceInOutSequence>, InferenceSummary[]> summaries =
+                            mTest.runBenchmarkConcurrent(mConcurrentInferences, minTime);
+                    return BenchmarkResult.fromConcurrentInferenceSummaries(mTest.getTestInfo(),
+                            backendType, summaries.first, summaries.second);
+                }
+                if (mThreadSweepMax > 0 && minTime > 0.f && !completeInputSet) {
+                    Pair<List<InferenceInOutSequence>, InferenceSummary[]> summaries =
+                            mTest.runBenchmarkThreadSweep(mThreadSweepMax, minTime);
+                    return BenchmarkResult.fromThreadSweepSummaries(mTest.getTestInfo(),
+                            backendType, summaries.first, summaries.second);
+                }
+                if (mSweepExecutionPreferences != null && minTime > 0.f && !completeInputSet) {
+                    return runDelegateOptionsSweep(minTime, backendType);
+                }
+                if (mExecutionModes != null && minTime > 0.f && !completeInputSet) {
+                    Pair<List<InferenceInOutSequence>, InferenceSummary[]> summaries =
+                            mTest.runBenchmarkExecutionModes(mExecutionModes, minTime);
+                    return BenchmarkResult.fromExecutionModeSummaries(mTest.getTestInfo(),
+                            backendType, summaries.first, mExecutionModes, summaries.second);
+                }
+                if (mBatchSizes != null && minTime > 0.f && !completeInputSet) {
+                    Pair<List<InferenceInOutSequence>, InferenceSummary[]> summaries =
+                            mTest.runBenchmarkBatchSweep(mBatchSizes, minTime);
+                    return BenchmarkResult.fromBatchSweepSummaries(mTest.getTestInfo(),
+                            backendType, summaries.first, mBatchSizes, summaries.second);
+                }
+                if (mSustainedDurationSec > 0.f && minTime > 0.f && !completeInputSet) {
+                    Pair<List<InferenceInOutSequence>, SustainedProfile> profile =
+                            mTest.runBenchmarkSustained(mSustainedDurationSec,
+                                    mSustainedWindowSec, mSustainedReadSensors);
+                    return BenchmarkResult.fromSustainedProfile(mTest.getTestInfo(), backendType,
+                            profile.first, profile.second);
+                }
+                if (mStreamingStats && minTime > 0.f && !completeInputSet) {
+                    Pair<List<InferenceInOutSequence>, InferenceSummary> summary =
+                            mTest.runBenchmarkStreaming(minTime);
+                    return BenchmarkResult.fromInferenceSummary(mTest.getTestInfo(), backendType,
+                            summary.first, summary.second);
+                }
+
                 // Run the kernel
                 Pair<List<InferenceInOutSequence>, List<InferenceResult>> results;
                 if (minTime > 0.f) {
@@ -107,9 +349,7 @@ public class NNBenchmark extends Activity {
                     results = mTest.runInferenceOnce();
                 }
                 return BenchmarkResult.fromInferenceResults(
-                        mTest.getTestInfo(),
-                        mUseNNApi ? BenchmarkResult.BACKEND_TFLITE_NNAPI
-                                : BenchmarkResult.BACKEND_TFLITE_CPU,
+                        mTest.getTestInfo(), backendType,
                         results.first, results.second, mTest.getEvaluator());
             } catch (BenchmarkException e) {
                 return new BenchmarkResult(e.getMessage());
@@ -117,6 +357,48 @@ public class NNBenchmark extends Activity {
         }
 
 
+        // Whether a benchmark mode reporting aggregated results only is set.
+        private boolean hasAggregatedMode() {
+            return mOpenLoopArrivalRates != null || mConcurrentInferences > 1
+                    || mThreadSweepMax > 0 || mSweepExecutionPreferences != null
+                    || mExecutionModes != null || mBatchSizes != null
+                    || mSustainedDurationSec > 0.f || mStreamingStats;
+        }
+
+        // Benchmarks every combination of the delegate options sweep values.
+        private BenchmarkResult runDelegateOptionsSweep(float minTime, String backendType)
+                throws IOException, BenchmarkException {
+            int count = mSweepExecutionPreferences.length * mSweepAllowFp16.length
+                    * mSweepMaxDelegatedPartitions.length * mSweepDisallowNNApiCpu.length;
+            int[] executionPreferences = new int[count];
+            boolean[] allowFp16 = new boolean[count];
+            int[] maxDelegatedPartitions = new int[count];
+            boolean[] disallowNNApiCpu = new boolean[count];
+            String[] configNames = new String[count];
+            int k = 0;
+            for (int preference : mSweepExecutionPreferences) {
+                for (boolean fp16 : mSweepAllowFp16) {
+                    for (int partitions : mSweepMaxDelegatedPartitions) {
+                        for (boolean disallowCpu : mSweepDisallowNNApiCpu) {
+                            executionPreferences[k] = preference;
+                            allowFp16[k] = fp16;
+                            maxDelegatedPartitions[k] = partitions;
+                            disallowNNApiCpu[k] = disallowCpu;
+                            configNames[k] = "pref_" + preference + "_fp16_" + (fp16 ? 1 : 0)
+                                    + "_partitions_" + partitions + "_nnapi_cpu_"
+                                    + (disallowCpu ? 0 : 1);
+                            ++k;
+                        }
+                    }
+                }
+            }
+            Pair<List<InferenceInOutSequence>, InferenceSummary[]> summaries =
+                    mTest.runBenchmarkDelegateOptionsSweep(executionPreferences, allowFp16,
+                            maxDelegatedPartitions, disallowNNApiCpu, minTime);
+            return BenchmarkResult.fromConfigSweepSummaries(mTest.getTestInfo(), backendType,
+                    summaries.first, configNames, summaries.second);
+        }
+
         // Get a benchmark result for a specific test
         private BenchmarkResult getBenchmark(float warmupTimeSeconds, float runTimeSeconds)
             throws IOException {
@@ -127,35 +409,68 @@ public class NNBenchmark extends Activity {
             }
 
             mDoingBenchmark = true;
+            try {
+                long result = 0;
+
+                // We run a short bit of work before starting the actual test
+                // this is to let any power management do its job and respond.
+                // Warmup inferences don't count towards the benchmark results,
+                // they are only reported separately as cold start cost.
+                // For NNAPI systrace usage documentation, see
+                // frameworks/ml/nn/common/include/Tracing.h.
+                int warmupInferences = mWarmupInferences;
+                if (warmupInferences <= 0) {
+                    warmupInferences = warmupTimeSeconds > 0.f ? Integer.MAX_VALUE : 1;
+                }
+                float[] warmupTimesSec;
+                try {
+                    final String traceName = "[NN_LA_PWU]runWarmup";
+                    Trace.beginSection(traceName);
+                    warmupTimesSec = mTest.runWarmup(warmupInferences, warmupTimeSeconds);
+                } catch (BenchmarkException e) {
+                    return new BenchmarkResult(e.getMessage());
+                } finally {
+                    Trace.endSection();
+                }
+                try {
+                    Log.v(TAG, "Startup: " + mTest.getStartupProfile());
+                } catch (BenchmarkException e) {
+                    return new BenchmarkResult(e.getMessage());
+                }
 
-            long result = 0;
+                // Run the actual benchmark
+                BenchmarkResult r;
+                try {
+                    final String traceName = "[NN_LA_PBM]runBenchmarkLoop";
+                    Trace.beginSection(traceName);
+                    r = runBenchmarkLoop(runTimeSeconds, mCompleteInputSet);
+                    if (mOperatorProfiling) {
+                        r.setOperatorProfiles(mTest.getOperatorProfiles());
+                    }
+                    r.setMemoryProfile(mTest.getMemoryProfile());
+                    Log.v(TAG, "Memory: " + r.getMemoryProfile());
+                    if (mConvergenceOptions != null && !mCompleteInputSet) {
+                        // Only plain and streaming runs stop at convergence, all other modes
+                        // leave it empty.
+                        ConvergenceStatus convergence = mTest.getConvergenceStatus();
+                        if (convergence.mInferences > 0) {
+                            r.setConvergenceStatus(convergence);
+                            Log.v(TAG, "Convergence: " + convergence);
+                        }
+                    }
+                } catch (BenchmarkException e) {
+                    return new BenchmarkResult(e.getMessage());
+                } finally {
+                    Trace.endSection();
+                }
+                r.setWarmupTimes(warmupTimesSec);
 
-            // We run a short bit of work before starting the actual test
-            // this is to let any power management do its job and respond.
-            // For NNAPI systrace usage documentation, see
-            // frameworks/ml/nn/common/include/Tracing.h.
-            try {
-                final String traceName = "[NN_LA_PWU]runBenchmarkLoop";
-                Trace.beginSection(traceName);
-                runBenchmarkLoop(warmupTimeSeconds, false);
-            } finally {
-                Trace.endSection();
-            }
+                Log.v(TAG, "Test: " + r.toString());
 
-            // Run the actual benchmark
-            BenchmarkResult r;
-            try {
-                final String traceName = "[NN_LA_PBM]runBenchmarkLoop";
-                Trace.beginSection(traceName);
-                r = runBenchmarkLoop(runTimeSeconds, mCompleteInputSet);
+                return r;
             } finally {
-                Trace.endSection();
+                mDoingBenchmark = false;
             }
-
-            Log.v(TAG, "Test: " + r.toString());
-
-            mDoingBenchmark = false;
-            return r;
         }
 
         @Override
@@ -254,6 +569,24 @@ public class NNBenchmark extends Activity {
     NNTestBase changeTest(TestModels.TestModelEntry t) {
         NNTestBase tb = t.createNNTestBase(mUseNNApi,
                 false /* enableIntermediateTensorsDump */);
+        tb.setZeroCopyInput(mZeroCopyInput && mUseNNApi);
+        tb.setAsyncValidation(mAsyncValidation);
+        tb.setOperatorProfiling(mOperatorProfiling);
+        tb.setPrefetchInputs(mPrefetchInputs);
+        tb.setSamplePeakHeap(mSamplePeakHeap);
+        tb.setNativeEvaluation(mNativeEvaluation);
+        tb.setUseMappedDataset(mMappedDataset);
+        tb.setNumThreads(mNumThreads);
+        if (mCpuAffinity) {
+            tb.setCpuAffinity(mCpuCores, mCpuAffinityMask);
+        }
+        tb.setConvergence(mConvergenceOptions);
+        tb.setExecutionPreference(mExecutionPreference);
+        tb.setAllowFp16(mAllowFp16);
+        tb.setMaxDelegatedPartitions(mMaxDelegatedPartitions);
+        tb.setDisallowNNApiCpu(mDisallowNNApiCpu);
+        tb.setCompilationCaching(
+                mUseNNApi && (mCompilationCaching || mCompilationCacheIterations > 0));
         tb.setupModel(this);
         return tb;
     }
@@ -19,6 +19,7 @@ package com.android.nn.benchmark.app;
 import android.os.Environment;
 import android.test.suitebuilder.annotation.LargeTest;
 
+import com.android.nn.benchmark.core.BenchmarkResult;
 import com.android.nn.benchmark.core.TestModels;
 import com.android.nn.benchmark.util.CSVWriter;
 import com.android.nn.benchmark.util.TestExternalStorageActivity;
@@ -47,6 +48,8 @@ import java.util.List;
 @RunWith(Parameterized.class)
 public class NNScoringTest extends BenchmarkTestBase {
     private static final String RESULT_FILENAME = "mlts_benchmark.csv";
+    private static final String OPERATOR_PROFILE_FILENAME = "mlts_operator_profile.csv";
+    private static final String SUSTAINED_FILENAME = "mlts_sustained.csv";
     private static final String TAG = NNScoringTest.class.getSimpleName();
 
     private static File csvPath;
@@ -101,9 +104,7 @@ public class NNScoringTest extends BenchmarkTestBase {
                 RUNTIME_REPEATABLE_SECONDS);
         runTest(ta, mModel.getTestName());
 
-        try (CSVWriter writer = new CSVWriter(getLocalCSVFile())) {
-            writer.write(ta.getBenchmark());
-        }
+        writeResult(ta.getBenchmark());
     }
 
     @Test
@@ -119,9 +120,18 @@ public class NNScoringTest extends BenchmarkTestBase {
                 RUNTIME_REPEATABLE_SECONDS);
         runTest(ta, mModel.getTestName());
 
+        writeResult(ta.getBenchmark());
+    }
 
+    private static void writeResult(BenchmarkResult result) throws IOException {
         try (CSVWriter writer = new CSVWriter(getLocalCSVFile())) {
-            writer.write(ta.getBenchmark());
+            writer.write(result);
+        }
+        try (CSVWriter writer = new CSVWriter(getLocalOperatorProfileCSVFile())) {
+            writer.writeOperatorProfiles(result);
+        }
+        try (CSVWriter writer = new CSVWriter(getLocalSustainedCSVFile())) {
+            writer.writeSustainedWindows(result);
         }
     }
 
@@ -129,6 +139,14 @@ public class NNScoringTest extends BenchmarkTestBase {
         return new File("/data/data/com.android.nn.benchmark.app", RESULT_FILENAME);
     }
 
+    public static File getLocalOperatorProfileCSVFile() {
+        return new File("/data/data/com.android.nn.benchmark.app", OPERATOR_PROFILE_FILENAME);
+    }
+
+    public static File getLocalSustainedCSVFile() {
+        return new File("/data/data/com.android.nn.benchmark.app", SUSTAINED_FILENAME);
+    }
+
     @BeforeClass
     public static void beforeClass() throws IOException {
         // Clear up CSV file in data directory for result storage
@@ -138,6 +156,18 @@ public class NNScoringTest extends BenchmarkTestBase {
         try (CSVWriter writer = new CSVWriter(localResults)) {
             writer.writeHeader();
         }
+        File localOperatorProfiles = getLocalOperatorProfileCSVFile();
+        localOperatorProfiles.delete();
+        localOperatorProfiles.createNewFile();
+        try (CSVWriter writer = new CSVWriter(localOperatorProfiles)) {
+            writer.writeOperatorProfileHeader();
+        }
+        File localSustained = getLocalSustainedCSVFile();
+        localSustained.delete();
+        localSustained.createNewFile();
+        try (CSVWriter writer = new CSVWriter(localSustained)) {
+            writer.writeSustainedHeader();
+        }
     }
 
     @AfterClass
@@ -150,6 +180,15 @@ public class NNScoringTest extends BenchmarkTestBase {
                 RESULT_FILENAME);
         externalStorageCSVFile.delete();
         Files.copy(getLocalCSVFile().toPath(), externalStorageCSVFile.toPath());
+        File externalStorageOperatorProfileFile = new File(
+                Environment.getExternalStorageDirectory(), OPERATOR_PROFILE_FILENAME);
+        externalStorageOperatorProfileFile.delete();
+        Files.copy(getLocalOperatorProfileCSVFile().toPath(),
+                externalStorageOperatorProfileFile.toPath());
+        File externalStorageSustainedFile = new File(Environment.getExternalStorageDirectory(),
+                SUSTAINED_FILENAME);
+        externalStorageSustainedFile.delete();
+        Files.copy(getLocalSustainedCSVFile().toPath(), externalStorageSustainedFile.toPath());
     }
 
 }
@@ -19,10 +19,20 @@ package com.android.nn.benchmark.app;
 import android.test.suitebuilder.annotation.LargeTest;
 import android.test.suitebuilder.annotation.MediumTest;
 
+import com.android.nn.benchmark.core.BenchmarkException;
+import com.android.nn.benchmark.core.InferenceInOut;
+import com.android.nn.benchmark.core.InferenceInOutSequence;
+import com.android.nn.benchmark.core.NNTestBase;
+import com.android.nn.benchmark.core.ScenarioRunner;
 import com.android.nn.benchmark.core.TestModels;
 
+import org.junit.Assume;
 import org.junit.Test;
 
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+import java.util.Collections;
+
 /**
  * NNAPI benchmark test.
  * To run the test, please use command
@@ -65,4 +75,93 @@ public class NNTest extends BenchmarkTestBase {
                 COMPLETE_SET_TIMEOUT_SECOND);
         runTest(ta, mModel.getTestName());
     }
+
+    @Test
+    @LargeTest
+    public void testNNAPINativeEvaluation() {
+        setNativeEvaluation(true);
+        TestAction ta = new TestAction(mModel, WARMUP_SHORT_SECONDS, RUNTIME_SHORT_SECONDS);
+        runTest(ta, mModel.getTestName() + "_native_evaluation");
+    }
+
+    @Test
+    @LargeTest
+    public void testNNAPIOpenLoop() {
+        // Open-loop runs don't support datasets.
+        Assume.assumeTrue(mModel.mInOutDatasets == null);
+        setOpenLoop(new float[] {10.f, 50.f}, /*poisson=*/true);
+        TestAction ta = new TestAction(mModel, WARMUP_SHORT_SECONDS, RUNTIME_SHORT_SECONDS);
+        runTest(ta, mModel.getTestName() + "_open_loop");
+    }
+
+    @Test
+    @LargeTest
+    public void testNNAPIExecutionModes() {
+        setExecutionModes(new int[] {NNTestBase.EXECUTION_MODE_SYNC,
+                NNTestBase.EXECUTION_MODE_BURST});
+        TestAction ta = new TestAction(mModel, WARMUP_SHORT_SECONDS, RUNTIME_SHORT_SECONDS);
+        runTest(ta, mModel.getTestName() + "_execution_modes");
+    }
+
+    @Test
+    @LargeTest
+    public void testNNAPIPrefetchInputsCreatorThrows() throws Exception {
+        Assume.assumeTrue(mModel.mInOutAssets != null);
+        InferenceInOutSequence sequence =
+                mModel.mInOutAssets[0].readAssets(getActivity().getAssets());
+        // The first creator calls attach the producer thread, a later one throws.
+        final int[] calls = {0};
+        for (int i = 0; i < sequence.size(); ++i) {
+            InferenceInOut inOut = sequence.get(i);
+            InferenceInOut.InputCreatorInterface[] creators =
+                    new InferenceInOut.InputCreatorInterface[inOut.mInputs.length];
+            for (int j = 0; j < creators.length; ++j) {
+                final byte[] input = inOut.mInputs[j];
+                creators[j] = new InferenceInOut.InputCreatorInterface() {
+                    @Override
+                    public void createInput(ByteBuffer buffer) {
+                        if (++calls[0] == 3) {
+                            throw new IllegalStateException("Input creator failure");
+                        }
+                        buffer.put(input);
+                    }
+                };
+            }
+            inOut.mInputs = null;
+            inOut.mInputCreators = creators;
+        }
+
+        NNTestBase test = mModel.createNNTestBase(/*useNNApi=*/true,
+                /*enableIntermediateTensorsDump=*/false);
+        test.setPrefetchInputs(true);
+        assertTrue(test.setupModel(getActivity()));
+        try {
+            test.runBenchmark(Collections.singletonList(sequence), 0xFFFFFFF,
+                    RUNTIME_SHORT_SECONDS, test.getDefaultFlags());
+            fail("The benchmark didn't fail on the throwing input creator");
+        } catch (BenchmarkException expected) {
+        } finally {
+            test.destroy();
+        }
+    }
+
+    @Test
+    @LargeTest
+    public void testNNAPIScenarioInterleaved() throws Exception {
+        runScenario(Arrays.asList(new ScenarioRunner.ModelConfig(mModel, 0.f, 0),
+                new ScenarioRunner.ModelConfig(mModel, 10.f, 1)), /*useNNApi=*/true,
+                NNTestBase.SCENARIO_INTERLEAVED, RUNTIME_SHORT_SECONDS,
+                mModel.getTestName() + "_scenario_interleaved");
+    }
+
+    @Test
+    @LargeTest
+    public void testNNAPIScenarioConcurrent() throws Exception {
+        // Concurrent scenarios don't support datasets.
+        Assume.assumeTrue(mModel.mInOutDatasets == null);
+        runScenario(Arrays.asList(new ScenarioRunner.ModelConfig(mModel, 0.f, 0),
+                new ScenarioRunner.ModelConfig(mModel, 10.f, 1)), /*useNNApi=*/true,
+                NNTestBase.SCENARIO_CONCURRENT, RUNTIME_SHORT_SECONDS,
+                mModel.getTestName() + "_scenario_concurrent");
+    }
 }
@@ -33,6 +33,10 @@ public class BenchmarkResult implements Parcelable {
     private final static int TIME_FREQ_ARRAY_SIZE = 32;
 
     private float mTotalTimeSec;
+    /** Total time spent preparing inference inputs */
+    private float mTotalInputTimeSec;
+    /** Total time spent validating and saving inference outputs */
+    private float mTotalOutputTimeSec;
     private float mSumOfMSEs;
     private float mMaxSingleError;
     private int mIterations;
@@ -42,6 +46,15 @@ public class BenchmarkResult implements Parcelable {
     private String[] mEvaluatorKeys = {};
     private float[] mEvaluatorResults = {};
 
+    /** Number of warmup inferences, not included in the results above */
+    private int mWarmupIterations;
+
+    /** Latency of the first warmup inference (cold start) */
+    private float mWarmupFirstTimeSec;
+
+    /** Total latency of all warmup inferences */
+    private float mWarmupTotalTimeSec;
+
     /** Type of backend used for inference */
     private String mBackendType;
 
@@ -67,12 +80,43 @@ public class BenchmarkResult implements Parcelable {
     /** Error that prevents the benchmark from running, e.g. SDK version not supported. */
     private String mBenchmarkError;
 
+    /** Per-operator execution times, empty unless operator profiling was enabled */
+    private OperatorProfile[] mOperatorProfiles = {};
+
+    /**
+     * Latency percentiles, computed in native code, see {@link LatencyPercentiles}.
+     * All 0 if the result has no per-inference latencies (e.g. concurrent runs).
+     */
+    private float mP50TimeSec;
+    private float mP90TimeSec;
+    private float mP95TimeSec;
+    private float mP99TimeSec;
+    private float mMaxTimeSec;
+
+    /** Windowed latency time series of sustained benchmarks, null for other results */
+    private SustainedProfile mSustainedProfile;
+
+    /** Memory footprint of the model, null if not measured */
+    private MemoryProfile mMemoryProfile;
+
+    /** Latency by sequence position, null for results that don't keep it */
+    private StepLatencies mStepLatencies;
+
+    /** Where a convergence driven run stopped, null for fixed time or size runs */
+    private ConvergenceStatus mConvergenceStatus;
+
+    /** Fixed bucket latency histogram, null for results without per-inference latencies */
+    private LatencyHistogram mLatencyHistogram;
+
     public BenchmarkResult(float totalTimeSec, int iterations, float timeVarianceSec,
-            float sumOfMSEs, float maxSingleError, String testInfo,
+            float totalInputTimeSec, float totalOutputTimeSec, float sumOfMSEs,
+            float maxSingleError, String testInfo,
             String[] evaluatorKeys, float[] evaluatorResults,
             float timeFreqStartSec, float timeFreqStepSec, float[] timeFreqSec,
             String backendType, int testSetSize, String[] validationErrors) {
         mTotalTimeSec = totalTimeSec;
+        mTotalInputTimeSec = totalInputTimeSec;
+        mTotalOutputTimeSec = totalOutputTimeSec;
         mSumOfMSEs = sumOfMSEs;
         mMaxSingleError = maxSingleError;
         mIterations = iterations;
@@ -109,6 +153,84 @@ public class BenchmarkResult implements Parcelable {
         mBenchmarkError = benchmarkError;
     }
 
+    /** Attach latencies of the warmup inferences that preceded this benchmark. */
+    public void setWarmupTimes(float[] warmupTimesSec) {
+        mWarmupIterations = warmupTimesSec.length;
+        mWarmupFirstTimeSec = warmupTimesSec.length > 0 ? warmupTimesSec[0] : 0.0f;
+        mWarmupTotalTimeSec = 0.0f;
+        for (float warmupTimeSec : warmupTimesSec) {
+            mWarmupTotalTimeSec += warmupTimeSec;
+        }
+    }
+
+    /** Attach the per-operator profile of this benchmark run. */
+    public void setOperatorProfiles(OperatorProfile[] operatorProfiles) {
+        mOperatorProfiles = operatorProfiles;
+    }
+
+    public OperatorProfile[] getOperatorProfiles() {
+        return mOperatorProfiles;
+    }
+
+    /** percentilesSec holds the latencies at LatencyPercentiles.REPORTED_QUANTILES. */
+    private void setLatencyPercentiles(float[] percentilesSec, float maxTimeSec) {
+        mP50TimeSec = percentilesSec[0];
+        mP90TimeSec = percentilesSec[1];
+        mP95TimeSec = percentilesSec[2];
+        mP99TimeSec = percentilesSec[3];
+        mMaxTimeSec = maxTimeSec;
+    }
+
+    public float getP50TimeSec() {
+        return mP50TimeSec;
+    }
+
+    public float getP90TimeSec() {
+        return mP90TimeSec;
+    }
+
+    public float getP95TimeSec() {
+        return mP95TimeSec;
+    }
+
+    public float getP99TimeSec() {
+        return mP99TimeSec;
+    }
+
+    public float getMaxTimeSec() {
+        return mMaxTimeSec;
+    }
+
+    public SustainedProfile getSustainedProfile() {
+        return mSustainedProfile;
+    }
+
+    /** Attach the memory footprint of the model after this benchmark. */
+    public void setMemoryProfile(MemoryProfile memoryProfile) {
+        mMemoryProfile = memoryProfile;
+    }
+
+    public MemoryProfile getMemoryProfile() {
+        return mMemoryProfile;
+    }
+
+    public StepLatencies getStepLatencies() {
+        return mStepLatencies;
+    }
+
+    /** Attach the convergence status of this benchmark, see NNTestBase.setConvergence(). */
+    public void setConvergenceStatus(ConvergenceStatus convergenceStatus) {
+        mConvergenceStatus = convergenceStatus;
+    }
+
+    public ConvergenceStatus getConvergenceStatus() {
+        return mConvergenceStatus;
+    }
+
+    public LatencyHistogram getLatencyHistogram() {
+        return mLatencyHistogram;
+    }
+
     public boolean hasValidationErrors() {
         return mValidationErrors.length > 0;
     }
@@ -119,6 +241,8 @@ public class BenchmarkResult implements Parcelable {
         mMaxSingleError = in.readFloat();
         mIterations = in.readInt();
         mTimeStdDeviation = in.readFloat();
+        mTotalInputTimeSec = in.readFloat();
+        mTotalOutputTimeSec = in.readFloat();
         mTestInfo = in.readString();
         mNumberOfEvaluatorResults = in.readInt();
         mEvaluatorKeys = new String[mNumberOfEvaluatorResults];
@@ -139,6 +263,33 @@ public class BenchmarkResult implements Parcelable {
         mValidationErrors = new String[validationsErrorsSize];
         in.readStringArray(mValidationErrors);
         mBenchmarkError = in.readString();
+        mWarmupIterations = in.readInt();
+        mWarmupFirstTimeSec = in.readFloat();
+        mWarmupTotalTimeSec = in.readFloat();
+        mOperatorProfiles = new OperatorProfile[in.readInt()];
+        for (int i = 0; i < mOperatorProfiles.length; ++i) {
+            mOperatorProfiles[i] = new OperatorProfile(in);
+        }
+        mP50TimeSec = in.readFloat();
+        mP90TimeSec = in.readFloat();
+        mP95TimeSec = in.readFloat();
+        mP99TimeSec = in.readFloat();
+        mMaxTimeSec = in.readFloat();
+        if (in.readInt() != 0) {
+            mSustainedProfile = new SustainedProfile(in);
+        }
+        if (in.readInt() != 0) {
+            mMemoryProfile = new MemoryProfile(in);
+        }
+        if (in.readInt() != 0) {
+            mStepLatencies = new StepLatencies(in);
+        }
+        if (in.readInt() != 0) {
+            mConvergenceStatus = new ConvergenceStatus(in);
+        }
+        if (in.readInt() != 0) {
+            mLatencyHistogram = new LatencyHistogram(in);
+        }
     }
 
     @Override
@@ -153,6 +304,8 @@ public class BenchmarkResult implements Parcelable {
         dest.writeFloat(mMaxSingleError);
         dest.writeInt(mIterations);
         dest.writeFloat(mTimeStdDeviation);
+        dest.writeFloat(mTotalInputTimeSec);
+        dest.writeFloat(mTotalOutputTimeSec);
         dest.writeString(mTestInfo);
         dest.writeInt(mNumberOfEvaluatorResults);
         dest.writeStringArray(mEvaluatorKeys);
@@ -166,6 +319,38 @@ public class BenchmarkResult implements Parcelable {
         dest.writeInt(mValidationErrors.length);
         dest.writeStringArray(mValidationErrors);
         dest.writeString(mBenchmarkError);
+        dest.writeInt(mWarmupIterations);
+        dest.writeFloat(mWarmupFirstTimeSec);
+        dest.writeFloat(mWarmupTotalTimeSec);
+        dest.writeInt(mOperatorProfiles.length);
+        for (OperatorProfile profile : mOperatorProfiles) {
+            profile.writeToParcel(dest);
+        }
+        dest.writeFloat(mP50TimeSec);
+        dest.writeFloat(mP90TimeSec);
+        dest.writeFloat(mP95TimeSec);
+        dest.writeFloat(mP99TimeSec);
+        dest.writeFloat(mMaxTimeSec);
+        dest.writeInt(mSustainedProfile != null ? 1 : 0);
+        if (mSustainedProfile != null) {
+            mSustainedProfile.writeToParcel(dest);
+        }
+        dest.writeInt(mMemoryProfile != null ? 1 : 0);
+        if (mMemoryProfile != null) {
+            mMemoryProfile.writeToParcel(dest);
+        }
+        dest.writeInt(mStepLatencies != null ? 1 : 0);
+        if (mStepLatencies != null) {
+            mStepLatencies.writeToParcel(dest);
+        }
+        dest.writeInt(mConvergenceStatus != null ? 1 : 0);
+        if (mConvergenceStatus != null) {
+            mConvergenceStatus.writeToParcel(dest);
+        }
+        dest.writeInt(mLatencyHistogram != null ? 1 : 0);
+        if (mLatencyHistogram != null) {
+            mLatencyHistogram.writeToParcel(dest);
+        }
     }
 
     @SuppressWarnings("unused")
@@ -190,6 +375,18 @@ public class BenchmarkResult implements Parcelable {
         return mTotalTimeSec / mIterations;
     }
 
+    public float getMeanInputTimeSec() {
+        return mTotalInputTimeSec / mIterations;
+    }
+
+    public float getMeanOutputTimeSec() {
+        return mTotalOutputTimeSec / mIterations;
+    }
+
+    public float getMeanWarmupTimeSec() {
+        return mWarmupIterations > 0 ? mWarmupTotalTimeSec / mWarmupIterations : 0.0f;
+    }
+
     public List<Pair<String, Float>> getEvaluatorResults() {
         List<Pair<String, Float>> results = new ArrayList<>();
         for (int i = 0; i < mEvaluatorKeys.length; ++i) {
@@ -208,12 +405,22 @@ public class BenchmarkResult implements Parcelable {
                 "mTestInfo='" + mTestInfo + '\'' +
                 ", getMeanTimeSec()=" + getMeanTimeSec() +
                 ", mTotalTimeSec=" + mTotalTimeSec +
+                ", mTotalInputTimeSec=" + mTotalInputTimeSec +
+                ", mTotalOutputTimeSec=" + mTotalOutputTimeSec +
                 ", mSumOfMSEs=" + mSumOfMSEs +
                 ", mMaxSingleErrors=" + mMaxSingleError +
                 ", mIterations=" + mIterations +
                 ", mTimeStdDeviation=" + mTimeStdDeviation +
+                ", mP50TimeSec=" + mP50TimeSec +
+                ", mP90TimeSec=" + mP90TimeSec +
+                ", mP95TimeSec=" + mP95TimeSec +
+                ", mP99TimeSec=" + mP99TimeSec +
+                ", mMaxTimeSec=" + mMaxTimeSec +
                 ", mTimeFreqStartSec=" + mTimeFreqStartSec +
                 ", mTimeFreqStepSec=" + mTimeFreqStepSec +
+                ", mWarmupIterations=" + mWarmupIterations +
+                ", mWarmupFirstTimeSec=" + mWarmupFirstTimeSec +
+                ", getMeanWarmupTimeSec()=" + getMeanWarmupTimeSec() +
                 ", mBackendType=" + mBackendType +
                 ", mTestSetSize=" + mTestSetSize);
         for (int i = 0; i < mEvaluatorKeys.length; i++) {
@@ -254,10 +461,48 @@ public class BenchmarkResult implements Parcelable {
         // Reported in ms
         results.putFloat(testName + "_avg", getMeanTimeSec() * 1000.0f);
         results.putFloat(testName + "_std_dev", mTimeStdDeviation * 1000.0f);
+        results.putFloat(testName + "_p50", mP50TimeSec * 1000.0f);
+        results.putFloat(testName + "_p90", mP90TimeSec * 1000.0f);
+        results.putFloat(testName + "_p95", mP95TimeSec * 1000.0f);
+        results.putFloat(testName + "_p99", mP99TimeSec * 1000.0f);
+        results.putFloat(testName + "_max", mMaxTimeSec * 1000.0f);
         results.putFloat(testName + "_total_time", mTotalTimeSec * 1000.0f);
+        results.putFloat(testName + "_avg_input", getMeanInputTimeSec() * 1000.0f);
+        results.putFloat(testName + "_avg_output", getMeanOutputTimeSec() * 1000.0f);
         results.putFloat(testName + "_mean_square_error", mSumOfMSEs / mIterations);
         results.putFloat(testName + "_max_single_error", mMaxSingleError);
         results.putInt(testName + "_iterations", mIterations);
+        results.putInt(testName + "_warmup_iterations", mWarmupIterations);
+        results.putFloat(testName + "_warmup_first", mWarmupFirstTimeSec * 1000.0f);
+        results.putFloat(testName + "_warmup_avg", getMeanWarmupTimeSec() * 1000.0f);
+        if (mMemoryProfile != null) {
+            // Keep the -1 of unmeasured values, rather than rounding them to 0 KiB.
+            results.putLong(testName + "_arena_kb", mMemoryProfile.mArenaBytes < 0
+                    ? -1 : mMemoryProfile.mArenaBytes / 1024);
+            results.putLong(testName + "_peak_rss_kb", mMemoryProfile.mPeakRssKb);
+            results.putLong(testName + "_peak_heap_kb", mMemoryProfile.mPeakHeapBytes < 0
+                    ? -1 : mMemoryProfile.mPeakHeapBytes / 1024);
+            results.putLong(testName + "_steady_pss_kb", mMemoryProfile.mSteadyState.mPssKb);
+            results.putLong(testName + "_rss_growth_kb", mMemoryProfile.getRssGrowthKb());
+        }
+        // Only interesting for sequences of more than one inference.
+        if (mStepLatencies != null && mStepLatencies.mLaterStepCount > 0) {
+            results.putFloat(testName + "_first_step_avg",
+                    mStepLatencies.mFirstStepMeanTimeSec * 1000.0f);
+            results.putFloat(testName + "_later_step_avg",
+                    mStepLatencies.mLaterStepMeanTimeSec * 1000.0f);
+            results.putFloat(testName + "_later_step_p99",
+                    mStepLatencies.mLaterStepP99TimeSec * 1000.0f);
+            results.putFloat(testName + "_steady_state_ratio",
+                    mStepLatencies.getSteadyStateRatio());
+        }
+        if (mStepLatencies != null && mStepLatencies.mResetCount > 0) {
+            results.putFloat(testName + "_reset_avg", mStepLatencies.mResetMeanTimeSec * 1000.0f);
+        }
+        if (mConvergenceStatus != null) {
+            results.putInt(testName + "_converged", mConvergenceStatus.mConverged ? 1 : 0);
+            results.putFloat(testName + "_ci_relative_width", mConvergenceStatus.mRelativeWidth);
+        }
         for (int i = 0; i < mEvaluatorKeys.length; i++) {
             results.putFloat(testName + "_" + mEvaluatorKeys[i],
                 mEvaluatorResults[i]);
@@ -301,10 +546,94 @@ public class BenchmarkResult implements Parcelable {
             sb.append(',').append(validationError.replace(',', ' '));
         }
 
+        for (float value : new float[] {mP50TimeSec, mP90TimeSec, mP95TimeSec, mP99TimeSec,
+                mMaxTimeSec}) {
+            sb.append(',').append(value);
+        }
+
+        long[] memoryValues = mMemoryProfile != null ? mMemoryProfile.toCsvValues() : null;
+        for (int i = 0; i < MemoryProfile.CSV_VALUES_COUNT; ++i) {
+            sb.append(',').append(memoryValues != null ? memoryValues[i] : -1);
+        }
+
+        float[] stepValues = mStepLatencies != null ? mStepLatencies.toCsvValues() : null;
+        for (int i = 0; i < StepLatencies.CSV_VALUES_COUNT; ++i) {
+            sb.append(',').append(stepValues != null ? stepValues[i] : -1);
+        }
+
+        float[] convergenceValues =
+                mConvergenceStatus != null ? mConvergenceStatus.toCsvValues() : null;
+        for (int i = 0; i < ConvergenceStatus.CSV_VALUES_COUNT; ++i) {
+            sb.append(',').append(convergenceValues != null ? convergenceValues[i] : -1);
+        }
+
+        int histogramBuckets = mLatencyHistogram != null ? mLatencyHistogram.mBucketsSec.length : 0;
+        sb.append(',').append(histogramBuckets);
+        for (int i = 0; i < histogramBuckets; ++i) {
+            sb.append(',').append(mLatencyHistogram.mBucketsSec[i]);
+            sb.append(',').append(mLatencyHistogram.mCounts[i]);
+        }
+
         sb.append('\n');
         return sb.toString();
     }
 
+    /** One CSV line per operator profile, see CSVWriter.OPERATOR_PROFILE_FORMAT_COMMENT. */
+    @SuppressWarnings("AndroidJdkLibsChecker")
+    public String toOperatorProfileCsvLines() {
+        StringBuilder sb = new StringBuilder();
+        for (OperatorProfile profile : mOperatorProfiles) {
+            sb.append(String.join(",",
+                mTestInfo,
+                mBackendType,
+                String.valueOf(profile.mNodeIndex),
+                profile.mOpName.replace(',', ' '),
+                String.valueOf(profile.mDelegated ? 1 : 0),
+                String.valueOf(profile.mCount),
+                String.valueOf(profile.mTotalTimeSec),
+                String.valueOf(profile.getMeanTimeSec()),
+                String.valueOf(profile.mMinTimeSec),
+                String.valueOf(profile.mMaxTimeSec)));
+            sb.append('\n');
+        }
+        return sb.toString();
+    }
+
+    /**
+     * One CSV line per sustained benchmark window, see
+     * CSVWriter.SUSTAINED_FORMAT_COMMENT. Empty for other results.
+     */
+    @SuppressWarnings("AndroidJdkLibsChecker")
+    public String toSustainedCsvLines() {
+        if (mSustainedProfile == null) {
+            return "";
+        }
+        StringBuilder sb = new StringBuilder();
+        SustainedProfile.Window[] windows = mSustainedProfile.mWindows;
+        for (int i = 0; i < windows.length; ++i) {
+            SustainedProfile.Window window = windows[i];
+            sb.append(String.join(",",
+                mTestInfo,
+                mBackendType,
+                String.valueOf(i),
+                String.valueOf(window.mStartTimeSec),
+                String.valueOf(window.mDurationSec),
+                String.valueOf(window.mCount),
+                String.valueOf(window.mMeanTimeSec),
+                String.valueOf(window.mP99TimeSec),
+                String.valueOf(window.mMaxTimeSec),
+                String.valueOf(window.mSensorValues.length)));
+            for (int k = 0; k < window.mSensorValues.length; ++k) {
+                sb.append(',').append(mSustainedProfile.mSensorNames[k]);
+            }
+            for (float value : window.mSensorValues) {
+                sb.append(',').append(value);
+            }
+            sb.append('\n');
+        }
+        return sb.toString();
+    }
+
     float rebase(float v, float baselineSec) {
         if (v > 0.001) {
             v = baselineSec / v;
@@ -312,6 +641,494 @@ public class BenchmarkResult implements Parcelable {
         return v;
     }
 
+    /** Create result from natively aggregated statistics, evaluators are not supported. */
+    public static BenchmarkResult fromInferenceSummary(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            InferenceSummary summary) {
+        return fromInferenceSummary(testInfo, backendType, inferenceInOuts, summary, null, null);
+    }
+
+    private static BenchmarkResult fromInferenceSummary(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            InferenceSummary summary,
+            String[] evaluatorKeys,
+            float[] evaluatorResults) {
+        float[] timeFreqSec = new float[TIME_FREQ_ARRAY_SIZE];
+        float stepSize = (summary.mMaxTimeSec - summary.mMinTimeSec) / (TIME_FREQ_ARRAY_SIZE - 1);
+        addToTimeFreq(summary, summary.mMinTimeSec, stepSize, timeFreqSec);
+
+        BenchmarkResult result = new BenchmarkResult(summary.mTotalTimeSec,
+                summary.mIterations, summary.mTimeStdDeviationSec, summary.mTotalInputTimeSec,
+                summary.mTotalOutputTimeSec, summary.mSumOfMSEs, summary.mMaxSingleError,
+                testInfo, evaluatorKeys, evaluatorResults, summary.mMinTimeSec, stepSize,
+                timeFreqSec, backendType, getTestSetSize(inferenceInOuts), null);
+        result.setLatencyPercentiles(new float[] {summary.mP50TimeSec, summary.mP90TimeSec,
+                summary.mP95TimeSec, summary.mP99TimeSec}, summary.mMaxTimeSec);
+        result.mStepLatencies = summary.mStepLatencies;
+        result.mLatencyHistogram = LatencyHistogram.fromSummaries(summary);
+        return result;
+    }
+
+    /**
+     * Result of a thread count sweep, summaries[n - 1] ran with n interpreter threads.
+     *
+     * Latency statistics are those of the thread count with the lowest mean latency. The
+     * latency and speedup (over a single thread) of every thread count are reported as
+     * evaluator results.
+     */
+    public static BenchmarkResult fromThreadSweepSummaries(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            InferenceSummary[] summaries) {
+        int best = 0;
+        for (int n = 1; n < summaries.length; ++n) {
+            if (summaries[n].mMeanTimeSec < summaries[best].mMeanTimeSec) {
+                best = n;
+            }
+        }
+
+        String[] keys = new String[1 + 3 * summaries.length];
+        float[] values = new float[keys.length];
+        keys[0] = "best_threads";
+        values[0] = best + 1;
+        for (int n = 0; n < summaries.length; ++n) {
+            int index = 1 + 3 * n;
+            String prefix = "threads_" + (n + 1);
+            keys[index] = prefix + "_mean";
+            values[index] = summaries[n].mMeanTimeSec;
+            keys[index + 1] = prefix + "_p90";
+            values[index + 1] = summaries[n].mP90TimeSec;
+            keys[index + 2] = prefix + "_speedup";
+            values[index + 2] = summaries[n].mMeanTimeSec > 0.0f
+                    ? summaries[0].mMeanTimeSec / summaries[n].mMeanTimeSec
+                    : 0.0f;
+        }
+        return fromInferenceSummary(testInfo, backendType, inferenceInOuts, summaries[best],
+                keys, values);
+    }
+
+    /**
+     * Result of a sweep over named configurations, summaries[k] ran with configuration
+     * configNames[k].
+     *
+     * Latency statistics are those of the configuration with the lowest mean latency. The
+     * mean and 90th percentile latency of every configuration are reported as evaluator
+     * results.
+     */
+    public static BenchmarkResult fromConfigSweepSummaries(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            String[] configNames,
+            InferenceSummary[] summaries) {
+        int best = 0;
+        for (int k = 1; k < summaries.length; ++k) {
+            if (summaries[k].mMeanTimeSec < summaries[best].mMeanTimeSec) {
+                best = k;
+            }
+        }
+
+        String[] keys = new String[2 * summaries.length];
+        float[] values = new float[keys.length];
+        for (int k = 0; k < summaries.length; ++k) {
+            keys[2 * k] = configNames[k] + "_mean";
+            values[2 * k] = summaries[k].mMeanTimeSec;
+            keys[2 * k + 1] = configNames[k] + "_p90";
+            values[2 * k + 1] = summaries[k].mP90TimeSec;
+        }
+        return fromInferenceSummary(testInfo, backendType, inferenceInOuts, summaries[best],
+                keys, values);
+    }
+
+    /**
+     * Result of an NNAPI execution mode comparison, summaries[k] pooled all rounds of modes[k]
+     * and summaries[(1 + r) * modes.length + k] is round r alone, see
+     * {@link NNTestBase#runBenchmarkExecutionModes}.
+     *
+     * Latency statistics are those of the first mode, the baseline. The mean, median and 90th
+     * percentile latency of every mode are reported as evaluator results, together with its
+     * mean latency difference to the baseline (negative when faster). On the same inputs and
+     * compiled model, that difference is the change of per inference execution overhead. It is
+     * averaged over the differences within each round, their min and max show its spread.
+     */
+    public static BenchmarkResult fromExecutionModeSummaries(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            int[] modes,
+            InferenceSummary[] summaries) {
+        int rounds = summaries.length / modes.length - 1;
+        String[] keys = new String[6 * modes.length];
+        float[] values = new float[keys.length];
+        for (int k = 0; k < modes.length; ++k) {
+            String prefix = modes[k] == NNTestBase.EXECUTION_MODE_BURST ? "burst" : "sync";
+            // Differences within a round, the drift between rounds cancels out.
+            float sumDelta = 0.0f;
+            float minDelta = Float.MAX_VALUE;
+            float maxDelta = -Float.MAX_VALUE;
+            for (int r = 0; r < rounds; ++r) {
+                int round = (1 + r) * modes.length;
+                float delta = summaries[round + k].mMeanTimeSec - summaries[round].mMeanTimeSec;
+                sumDelta += delta;
+                minDelta = Math.min(minDelta, delta);
+                maxDelta = Math.max(maxDelta, delta);
+            }
+            keys[6 * k] = prefix + "_mean";
+            values[6 * k] = summaries[k].mMeanTimeSec;
+            keys[6 * k + 1] = prefix + "_p50";
+            values[6 * k + 1] = summaries[k].mP50TimeSec;
+            keys[6 * k + 2] = prefix + "_p90";
+            values[6 * k + 2] = summaries[k].mP90TimeSec;
+            keys[6 * k + 3] = prefix + "_overhead_delta";
+            values[6 * k + 3] = rounds > 0 ? sumDelta / rounds : 0.0f;
+            keys[6 * k + 4] = prefix + "_overhead_delta_min";
+            values[6 * k + 4] = rounds > 0 ? minDelta : 0.0f;
+            keys[6 * k + 5] = prefix + "_overhead_delta_max";
+            values[6 * k + 5] = rounds > 0 ? maxDelta : 0.0f;
+        }
+        return fromInferenceSummary(testInfo, backendType, inferenceInOuts, summaries[0],
+                keys, values);
+    }
+
+    /**
+     * Result of a batch size sweep, summaries[b] ran batchSizes[b] inputs per inference.
+     *
+     * Latency statistics are those of the batch size with the highest throughput and are
+     * per batch, not per input. The per-input latency and throughput of every batch size are
+     * reported as evaluator results.
+     */
+    public static BenchmarkResult fromBatchSweepSummaries(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            int[] batchSizes,
+            InferenceSummary[] summaries) {
+        float[] samplesPerSec = new float[summaries.length];
+        int best = 0;
+        for (int b = 0; b < summaries.length; ++b) {
+            samplesPerSec[b] = summaries[b].mTotalTimeSec > 0.0f
+                    ? batchSizes[b] * summaries[b].mIterations / summaries[b].mTotalTimeSec
+                    : 0.0f;
+            if (samplesPerSec[b] > samplesPerSec[best]) {
+                best = b;
+            }
+        }
+
+        String[] keys = new String[1 + 2 * summaries.length];
+        float[] values = new float[keys.length];
+        keys[0] = "best_batch";
+        values[0] = batchSizes[best];
+        for (int b = 0; b < summaries.length; ++b) {
+            int index = 1 + 2 * b;
+            String prefix = "batch_" + batchSizes[b];
+            keys[index] = prefix + "_sample_latency";
+            values[index] = summaries[b].mMeanTimeSec / batchSizes[b];
+            keys[index + 1] = prefix + "_samples_per_sec";
+            values[index + 1] = samplesPerSec[b];
+        }
+        return fromInferenceSummary(testInfo, backendType, inferenceInOuts, summaries[best],
+                keys, values);
+    }
+
+    /**
+     * Merges the per-thread summaries of a concurrent benchmark run.
+     *
+     * Latency statistics cover the inferences of all threads. The aggregate throughput and
+     * per-thread latencies are reported as evaluator results.
+     */
+    public static BenchmarkResult fromConcurrentInferenceSummaries(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            InferenceSummary[] summaries) {
+        int iterations = 0;
+        float totalTime = 0;
+        float totalInputTime = 0;
+        float totalOutputTime = 0;
+        float sumOfMSEs = 0;
+        float maxSingleError = 0;
+        float minTime = Float.MAX_VALUE;
+        float maxTime = 0;
+        float wallTime = 0;
+        // Sum of squared inference times, to pool the per-thread deviations.
+        double sumOfSquares = 0;
+        for (InferenceSummary summary : summaries) {
+            iterations += summary.mIterations;
+            totalTime += summary.mTotalTimeSec;
+            totalInputTime += summary.mTotalInputTimeSec;
+            totalOutputTime += summary.mTotalOutputTimeSec;
+            sumOfMSEs += summary.mSumOfMSEs;
+            maxSingleError = Math.max(maxSingleError, summary.mMaxSingleError);
+            minTime = Math.min(minTime, summary.mMinTimeSec);
+            maxTime = Math.max(maxTime, summary.mMaxTimeSec);
+            wallTime = Math.max(wallTime, summary.mWallTimeSec);
+            sumOfSquares += summary.mIterations * ((double) summary.mTimeStdDeviationSec *
+                    summary.mTimeStdDeviationSec +
+                    (double) summary.mMeanTimeSec * summary.mMeanTimeSec);
+        }
+        float mean = iterations > 0 ? totalTime / iterations : 0.0f;
+        float stdDeviation = iterations > 0
+                ? (float) Math.sqrt(Math.max(0.0, sumOfSquares / iterations - mean * mean))
+                : 0.0f;
+
+        float[] timeFreqSec = new float[TIME_FREQ_ARRAY_SIZE];
+        float stepSize = (maxTime - minTime) / (TIME_FREQ_ARRAY_SIZE - 1);
+        for (InferenceSummary summary : summaries) {
+            addToTimeFreq(summary, minTime, stepSize, timeFreqSec);
+        }
+
+        String[] keys = new String[2 + 4 * summaries.length];
+        float[] values = new float[keys.length];
+        keys[0] = "concurrent_threads";
+        values[0] = summaries.length;
+        keys[1] = "throughput_per_sec";
+        values[1] = wallTime > 0.0f ? iterations / wallTime : 0.0f;
+        for (int k = 0; k < summaries.length; ++k) {
+            int index = 2 + 4 * k;
+            keys[index] = "thread_" + k + "_mean";
+            values[index] = summaries[k].mMeanTimeSec;
+            keys[index + 1] = "thread_" + k + "_p90";
+            values[index + 1] = summaries[k].mP90TimeSec;
+            keys[index + 2] = "thread_" + k + "_p99";
+            values[index + 2] = summaries[k].mP99TimeSec;
+            keys[index + 3] = "thread_" + k + "_max";
+            values[index + 3] = summaries[k].mMaxTimeSec;
+        }
+
+        BenchmarkResult result = new BenchmarkResult(totalTime, iterations, stdDeviation,
+                totalInputTime, totalOutputTime, sumOfMSEs, maxSingleError, testInfo, keys,
+                values, minTime, stepSize, timeFreqSec, backendType,
+                getTestSetSize(inferenceInOuts), null);
+        result.mLatencyHistogram = LatencyHistogram.fromSummaries(summaries);
+        return result;
+    }
+
+    /**
+     * Result of an open-loop sweep, summaries[k] ran at arrival rate summaries[k].mArrivalRate.
+     *
+     * Latency statistics are the service times at the highest rate the device sustained (the
+     * first rate if none). The throughput, queueing and response times and dropped requests
+     * of every rate are reported as evaluator results, with the highest sustained rate (0 if
+     * none) as "max_sustained_rate".
+     */
+    public static BenchmarkResult fromOpenLoopSummaries(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            OpenLoopSummary[] summaries) {
+        int best = -1;
+        for (int k = 0; k < summaries.length; ++k) {
+            if (summaries[k].isSustained() && (best < 0
+                    || summaries[k].mArrivalRate > summaries[best].mArrivalRate)) {
+                best = k;
+            }
+        }
+
+        String[] keys = new String[1 + 7 * summaries.length];
+        float[] values = new float[keys.length];
+        keys[0] = "max_sustained_rate";
+        values[0] = best >= 0 ? summaries[best].mArrivalRate : 0.0f;
+        for (int k = 0; k < summaries.length; ++k) {
+            int index = 1 + 7 * k;
+            String prefix = "rate_" + summaries[k].mArrivalRate;
+            keys[index] = prefix + "_throughput";
+            values[index] = summaries[k].mThroughput;
+            keys[index + 1] = prefix + "_queue_mean";
+            values[index + 1] = summaries[k].mQueueMeanTimeSec;
+            keys[index + 2] = prefix + "_queue_p99";
+            values[index + 2] = summaries[k].mQueueP99TimeSec;
+            keys[index + 3] = prefix + "_response_p50";
+            values[index + 3] = summaries[k].mResponseP50TimeSec;
+            keys[index + 4] = prefix + "_response_p90";
+            values[index + 4] = summaries[k].mResponseP90TimeSec;
+            keys[index + 5] = prefix + "_response_p99";
+            values[index + 5] = summaries[k].mResponseP99TimeSec;
+            keys[index + 6] = prefix + "_dropped";
+            values[index + 6] = summaries[k].mDropped;
+        }
+        return fromInferenceSummary(testInfo, backendType, inferenceInOuts,
+                summaries[Math.max(best, 0)].mService, keys, values);
+    }
+
+    /**
+     * Result of model k of a multi-model scenario.
+     *
+     * Latency statistics are those of the model sharing the device with the other models. Its
+     * latency running alone and the shared over alone slowdown are reported as evaluator
+     * results.
+     */
+    public static BenchmarkResult fromScenarioResult(
+            String backendType,
+            ScenarioResult scenario,
+            int k) {
+        InferenceSummary alone = scenario.mAlone[k];
+        InferenceSummary shared = scenario.mShared[k];
+        String[] keys = {"scenario_models", "scenario_concurrent", "alone_mean", "alone_p99",
+                "shared_throughput", "slowdown", "p99_slowdown"};
+        float[] values = {scenario.mModelNames.length,
+                scenario.mSchedule == NNTestBase.SCENARIO_CONCURRENT ? 1.0f : 0.0f,
+                alone.mMeanTimeSec, alone.mP99TimeSec,
+                shared.mWallTimeSec > 0.0f ? shared.mIterations / shared.mWallTimeSec : 0.0f,
+                scenario.getSlowdown(k), scenario.getTailSlowdown(k)};
+        return fromInferenceSummary(scenario.mModelNames[k], backendType,
+                scenario.mInferenceInOuts.get(k), shared, keys, values);
+    }
+
+    /**
+     * Result of a sustained performance benchmark.
+     *
+     * Latency statistics are those of the whole run. Initial and final window mean latency,
+     * their ratio and the time to throttle (-1 if not throttled) are reported as evaluator
+     * results, the windows themselves are attached for {@link #toSustainedCsvLines}.
+     */
+    public static BenchmarkResult fromSustainedProfile(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            SustainedProfile profile) {
+        float initialMean = profile.getInitialMeanTimeSec();
+        float finalMean = profile.getFinalMeanTimeSec();
+        String[] keys = {"sustained_windows", "sustained_initial_mean", "sustained_final_mean",
+                "sustained_slowdown", "time_to_throttle_sec"};
+        float[] values = {profile.mWindows.length, initialMean, finalMean,
+                initialMean > 0.0f ? finalMean / initialMean : 0.0f,
+                profile.getTimeToThrottleSec()};
+        BenchmarkResult result = fromInferenceSummary(testInfo, backendType, inferenceInOuts,
+                profile.mSummary, keys, values);
+        result.mSustainedProfile = profile;
+        return result;
+    }
+
+    /**
+     * Result of a cold start benchmark, one profile per created model.
+     *
+     * Latency statistics are those of the whole startup (model creation and first
+     * inference). The mean time of every startup stage is reported as evaluator results.
+     */
+    public static BenchmarkResult fromStartupProfiles(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            StartupProfile[] profiles) {
+        return fromStartupProfiles(testInfo, backendType, inferenceInOuts, profiles,
+                new String[0], new float[0]);
+    }
+
+    /**
+     * Result of a compilation cache benchmark, see
+     * {@link NNTestBase#runCompilationCacheBenchmark}.
+     *
+     * Latency statistics are those of the startup with a warm cache. The mean startup and
+     * delegate application times with an empty cache, and the startup speedup from the
+     * cache are reported as additional evaluator results.
+     */
+    public static BenchmarkResult fromCompilationCacheProfiles(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            StartupProfile[] cacheMissProfiles,
+            StartupProfile[] cacheHitProfiles) {
+        float missStartup = 0;
+        float missDelegateApply = 0;
+        for (StartupProfile profile : cacheMissProfiles) {
+            missStartup += profile.getStartupTimeSec() / cacheMissProfiles.length;
+            missDelegateApply += profile.mDelegateApplyTimeSec / cacheMissProfiles.length;
+        }
+        float hitStartup = 0;
+        for (StartupProfile profile : cacheHitProfiles) {
+            hitStartup += profile.getStartupTimeSec() / cacheHitProfiles.length;
+        }
+        String[] keys = {"cache_miss_startup_mean", "cache_miss_delegate_apply_mean",
+                "cache_speedup"};
+        float[] values = {missStartup, missDelegateApply,
+                hitStartup > 0.0f ? missStartup / hitStartup : 0.0f};
+        return fromStartupProfiles(testInfo, backendType, inferenceInOuts, cacheHitProfiles,
+                keys, values);
+    }
+
+    private static BenchmarkResult fromStartupProfiles(
+            String testInfo,
+            String backendType,
+            List<InferenceInOutSequence> inferenceInOuts,
+            StartupProfile[] profiles,
+            String[] extraKeys,
+            float[] extraValues) {
+        String[] stageKeys = {"model_load_mean", "interpreter_build_mean",
+                "delegate_apply_mean", "input_resize_mean", "first_inference_mean",
+                "destroy_mean", "startup_max"};
+        String[] keys = Arrays.copyOf(stageKeys, stageKeys.length + extraKeys.length);
+        System.arraycopy(extraKeys, 0, keys, stageKeys.length, extraKeys.length);
+        float[] values = new float[keys.length];
+        System.arraycopy(extraValues, 0, values, stageKeys.length, extraValues.length);
+        float[] startupTimesSec = new float[profiles.length];
+        float totalTime = 0;
+        float minTime = Float.MAX_VALUE;
+        float maxTime = 0;
+        for (int i = 0; i < profiles.length; ++i) {
+            StartupProfile profile = profiles[i];
+            values[0] += profile.mModelLoadTimeSec;
+            values[1] += profile.mInterpreterBuildTimeSec;
+            values[2] += profile.mDelegateApplyTimeSec;
+            values[3] += profile.mInputResizeTimeSec;
+            values[4] += profile.mFirstInferenceTimeSec;
+            values[5] += profile.mDestroyTimeSec;
+            startupTimesSec[i] = profile.getStartupTimeSec();
+            totalTime += startupTimesSec[i];
+            minTime = Math.min(minTime, startupTimesSec[i]);
+            maxTime = Math.max(maxTime, startupTimesSec[i]);
+        }
+        for (int k = 0; k < 6; ++k) {
+            values[k] /= profiles.length;
+        }
+        values[6] = maxTime;
+
+        float mean = totalTime / profiles.length;
+        float variance = 0;
+        float[] timeFreqSec = new float[TIME_FREQ_ARRAY_SIZE];
+        float stepSize = (maxTime - minTime) / (TIME_FREQ_ARRAY_SIZE - 1);
+        for (float startupTimeSec : startupTimesSec) {
+            variance += (startupTimeSec - mean) * (startupTimeSec - mean);
+            int index = stepSize > 0.0f ? (int) ((startupTimeSec - minTime) / stepSize) : 0;
+            timeFreqSec[Math.min(index, TIME_FREQ_ARRAY_SIZE - 1)] += 1;
+        }
+        variance /= profiles.length;
+
+        BenchmarkResult result = new BenchmarkResult(totalTime, profiles.length,
+                (float) Math.sqrt(variance), 0.0f, 0.0f, 0.0f, 0.0f, testInfo, keys, values,
+                minTime, stepSize, timeFreqSec, backendType, getTestSetSize(inferenceInOuts),
+                null);
+        result.setLatencyPercentiles(LatencyPercentiles.compute(startupTimesSec,
+                LatencyPercentiles.REPORTED_QUANTILES), maxTime);
+        result.mLatencyHistogram = LatencyHistogram.compute(startupTimesSec);
+        return result;
+    }
+
+    /** Re-bins the native histogram of summary into the timeFreqSec buckets. */
+    private static void addToTimeFreq(InferenceSummary summary, float startSec, float stepSec,
+            float[] timeFreqSec) {
+        for (int i = 0; i < summary.mHistogramBucketsSec.length; ++i) {
+            int index = 0;
+            if (stepSec > 0.0f) {
+                index = (int) ((summary.mHistogramBucketsSec[i] - startSec) / stepSec);
+                index = Math.max(0, Math.min(timeFreqSec.length - 1, index));
+            }
+            timeFreqSec[index] += summary.mHistogramCounts[i];
+        }
+    }
+
+    private static int getTestSetSize(List<InferenceInOutSequence> inferenceInOuts) {
+        int testSetSize = 0;
+        for (InferenceInOutSequence iios : inferenceInOuts) {
+            testSetSize += iios.size();
+        }
+        return testSetSize;
+    }
+
     public static BenchmarkResult fromInferenceResults(
             String testInfo,
             String backendType,
@@ -319,16 +1136,22 @@ public class BenchmarkResult implements Parcelable {
             List<InferenceResult> inferenceResults,
             EvaluatorInterface evaluator) {
         float totalTime = 0;
+        float totalInputTime = 0;
+        float totalOutputTime = 0;
         int iterations = 0;
         float sumOfMSEs = 0;
         float maxSingleError = 0;
 
         float maxComputeTimeSec = 0.0f;
         float minComputeTimeSec = Float.MAX_VALUE;
+        float[] computeTimesSec = new float[inferenceResults.size()];
 
         for (InferenceResult iresult : inferenceResults) {
+            computeTimesSec[iterations] = iresult.mComputeTimeSec;
             iterations++;
             totalTime += iresult.mComputeTimeSec;
+            totalInputTime += iresult.mInputTimeSec;
+            totalOutputTime += iresult.mOutputTimeSec;
             if (iresult.mMeanSquaredErrors != null) {
                 for (float mse : iresult.mMeanSquaredErrors) {
                     sumOfMSEs += mse;
@@ -378,10 +1201,13 @@ public class BenchmarkResult implements Parcelable {
         }
 
         // Calculate inference frequency/histogram across TIME_FREQ_ARRAY_SIZE buckets.
+        // Only used for plotting, percentiles are computed from the exact latencies.
         float[] timeFreqSec = new float[TIME_FREQ_ARRAY_SIZE];
         float stepSize = (maxComputeTimeSec - minComputeTimeSec) / (TIME_FREQ_ARRAY_SIZE - 1);
-        for (InferenceResult iresult : inferenceResults) {
-            timeFreqSec[(int) ((iresult.mComputeTimeSec - minComputeTimeSec) / stepSize)] += 1;
+        for (float computeTimeSec : computeTimesSec) {
+            int index = stepSize > 0.0f
+                    ? (int) ((computeTimeSec - minComputeTimeSec) / stepSize) : 0;
+            timeFreqSec[Math.max(0, Math.min(TIME_FREQ_ARRAY_SIZE - 1, index))] += 1;
         }
 
         // Calc test set size
@@ -390,9 +1216,15 @@ public class BenchmarkResult implements Parcelable {
             testSetSize += iios.size();
         }
 
-        return new BenchmarkResult(totalTime, iterations, (float) Math.sqrt(variance),
-                sumOfMSEs, maxSingleError, testInfo, evaluatorKeys, evaluatorResults,
+        BenchmarkResult result = new BenchmarkResult(totalTime, iterations,
+                (float) Math.sqrt(variance), totalInputTime, totalOutputTime, sumOfMSEs,
+                maxSingleError, testInfo, evaluatorKeys, evaluatorResults,
                 minComputeTimeSec, stepSize, timeFreqSec, backendType, testSetSize,
                 validationErrors);
+        result.setLatencyPercentiles(LatencyPercentiles.compute(computeTimesSec,
+                LatencyPercentiles.REPORTED_QUANTILES), maxComputeTimeSec);
+        result.mStepLatencies = StepLatencies.fromInferenceResults(inferenceResults);
+        result.mLatencyHistogram = LatencyHistogram.compute(computeTimesSec);
+        return result;
     }
 }
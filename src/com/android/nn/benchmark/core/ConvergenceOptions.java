@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+/**
+ * Stopping rule of convergence driven benchmark runs, see jni/convergence.h.
+ *
+ * The run stops once the confidence interval of the mean (or of a latency quantile) is
+ * within targetRelativeWidth of the estimate, as long as the min bounds are reached. The max
+ * bounds stop runs that don't converge; the benchmark run time still applies next to maxTimeSec.
+ */
+public class ConvergenceOptions {
+    /** Value of {@link #mQuantile} to estimate the mean latency. */
+    public static final float MEAN = -1.0f;
+
+    /** Half-width of the confidence interval, relative to the estimate. */
+    public final float mTargetRelativeWidth;
+    public final float mConfidence;
+    /** Latency quantile (0.0 - 1.0, exclusive) or MEAN. */
+    public final float mQuantile;
+    /** Bounds on the inferences and their total compute time, 0 for none. */
+    public final int mMinInferences;
+    public final int mMaxInferences;
+    public final float mMinTimeSec;
+    public final float mMaxTimeSec;
+
+    public ConvergenceOptions(float targetRelativeWidth, float confidence, float quantile,
+            int minInferences, int maxInferences, float minTimeSec, float maxTimeSec) {
+        mTargetRelativeWidth = targetRelativeWidth;
+        mConfidence = confidence;
+        mQuantile = quantile;
+        mMinInferences = minInferences;
+        mMaxInferences = maxInferences;
+        mMinTimeSec = minTimeSec;
+        mMaxTimeSec = maxTimeSec;
+    }
+
+    /** Mean latency within targetRelativeWidth at 95% confidence, at most maxTimeSec. */
+    public static ConvergenceOptions mean(float targetRelativeWidth, float maxTimeSec) {
+        return new ConvergenceOptions(targetRelativeWidth, 0.95f, MEAN, 10, 0, 0.f, maxTimeSec);
+    }
+
+    @Override
+    public String toString() {
+        return "ConvergenceOptions{width=" + mTargetRelativeWidth
+                + ", confidence=" + mConfidence
+                + ", quantile=" + (mQuantile < 0.f ? "mean" : mQuantile)
+                + ", inferences=" + mMinInferences + "-" + mMaxInferences
+                + ", time=" + mMinTimeSec + "-" + mMaxTimeSec + "}";
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import android.os.Parcel;
+
+/**
+ * Where a convergence driven benchmark run stopped, see {@link ConvergenceOptions}.
+ */
+public class ConvergenceStatus {
+    /** Number of values of {@link #toCsvValues}, see CSVWriter.RESULT_FORMAT_COMMENT. */
+    public static final int CSV_VALUES_COUNT = 3;
+
+    /** False if a max bound (or the end of the inputs) stopped the run first. */
+    public final boolean mConverged;
+    public final int mInferences;
+    public final float mTotalTimeSec;
+    /** Mean or quantile latency. */
+    public final float mEstimateSec;
+    /**
+     * Half-width of the confidence interval relative to the estimate, -1 if there were too
+     * few inferences to bound it.
+     */
+    public final float mRelativeWidth;
+
+    public ConvergenceStatus(boolean converged, int inferences, float totalTimeSec,
+            float estimateSec, float relativeWidth) {
+        mConverged = converged;
+        mInferences = inferences;
+        mTotalTimeSec = totalTimeSec;
+        mEstimateSec = estimateSec;
+        mRelativeWidth = relativeWidth;
+    }
+
+    ConvergenceStatus(Parcel in) {
+        this(in.readInt() != 0, in.readInt(), in.readFloat(), in.readFloat(), in.readFloat());
+    }
+
+    void writeToParcel(Parcel dest) {
+        dest.writeInt(mConverged ? 1 : 0);
+        dest.writeInt(mInferences);
+        dest.writeFloat(mTotalTimeSec);
+        dest.writeFloat(mEstimateSec);
+        dest.writeFloat(mRelativeWidth);
+    }
+
+    /** The CSV columns, in the order of CSVWriter.RESULT_FORMAT_COMMENT. */
+    public float[] toCsvValues() {
+        return new float[] {mConverged ? 1 : 0, mEstimateSec, mRelativeWidth};
+    }
+
+    @Override
+    public String toString() {
+        return "ConvergenceStatus{converged=" + mConverged
+                + ", inferences=" + mInferences
+                + ", estimate=" + mEstimateSec
+                + ", relativeWidth=" + mRelativeWidth + "}";
+    }
+}
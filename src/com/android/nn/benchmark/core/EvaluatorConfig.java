@@ -22,6 +22,8 @@ import com.android.nn.benchmark.evaluators.MelCepLogF0;
 import com.android.nn.benchmark.evaluators.TopK;
 import com.android.nn.benchmark.util.IOUtils;
 
+import java.io.IOException;
+
 /**
  * Config options for inference accuracy evaluators.
  */
@@ -61,4 +63,20 @@ public class EvaluatorConfig {
                     "Can not create evaluator named '" + className + "'", e);
         }
     }
+
+    /**
+     * Native version of the evaluator, attached to the model, or null if the evaluator has no
+     * native implementation.
+     */
+    public NativeEvaluator createNativeEvaluator(AssetManager assetManager, long modelHandle)
+            throws IOException {
+        // Same options as createEvaluator() sets on the Java evaluators.
+        OutputMeanStdDev meanStdDev = null;
+        if (className.equals("MelCepLogF0") && outputMeanStdDev != null) {
+            meanStdDev = new OutputMeanStdDev(IOUtils.readAsset(
+                    assetManager, outputMeanStdDev, MeanStdDev.ELEMENT_SIZE_BYTES));
+        }
+        return NativeEvaluator.create(modelHandle, className,
+                expectedTop1 != null ? expectedTop1.floatValue() : 0.0f, meanStdDev);
+    }
 }
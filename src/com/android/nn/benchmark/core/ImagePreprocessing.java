@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import android.content.res.AssetManager;
+import android.graphics.Bitmap;
+import android.graphics.BitmapFactory;
+
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.ByteBuffer;
+
+/**
+ * Native image preprocessing, from a decoded image to a [1, D, D, 3] input tensor.
+ *
+ * The image is decoded by {@link BitmapFactory}, then cropped to a centered square, bilinearly
+ * resized and normalized (and quantized for uint8 models) in native code, straight into the
+ * input tensor buffer. The defaults match the Inception preprocessor. Set from the optional
+ * "preprocessing" object of a dataset in the test models list.
+ */
+public class ImagePreprocessing {
+    static {
+        System.loadLibrary("nnbenchmark_jni");
+    }
+
+    /** Side of the centered square crop, as a fraction of the smaller image dimension. */
+    public float mCropFraction = 0.875f;
+    /** Pixel values v in [0, 255] become (v - mean) / std. */
+    public float mMean = 127.5f;
+    public float mStd = 127.5f;
+    /**
+     * Let the decoder downsample the image by a power of two, as long as the crop stays
+     * larger than the output. Much faster for large images, but changes the output slightly.
+     */
+    public boolean mSubsampleDecode = false;
+
+    /**
+     * Preprocesses an image asset into outputBuffer, which needs to be a direct buffer (as
+     * passed to input creators).
+     */
+    public void preprocess(int datasize, float quantScale, float quantZeroPoint,
+            int imageDimension, AssetManager assetManager, String imageFileName,
+            ByteBuffer outputBuffer) throws IOException {
+        BitmapFactory.Options options = new BitmapFactory.Options();
+        options.inPreferredConfig = Bitmap.Config.ARGB_8888;
+        if (mSubsampleDecode) {
+            options.inSampleSize = sampleSize(assetManager, imageFileName, imageDimension);
+        }
+        Bitmap bitmap;
+        try (InputStream stream = assetManager.open(imageFileName)) {
+            bitmap = BitmapFactory.decodeStream(stream, null, options);
+        }
+        if (bitmap == null) {
+            throw new IOException("Failed to decode " + imageFileName);
+        }
+        try {
+            if (!preprocessBitmap(bitmap, mCropFraction, mMean, mStd, datasize, quantScale,
+                    quantZeroPoint, imageDimension, outputBuffer)) {
+                throw new IOException("Failed to preprocess " + imageFileName);
+            }
+        } finally {
+            bitmap.recycle();
+        }
+    }
+
+    private int sampleSize(AssetManager assetManager, String imageFileName, int imageDimension)
+            throws IOException {
+        BitmapFactory.Options bounds = new BitmapFactory.Options();
+        bounds.inJustDecodeBounds = true;
+        try (InputStream stream = assetManager.open(imageFileName)) {
+            BitmapFactory.decodeStream(stream, null, bounds);
+        }
+        int cropSize = (int) (mCropFraction * Math.min(bounds.outWidth, bounds.outHeight));
+        int sampleSize = 1;
+        while (cropSize / (sampleSize * 2) >= imageDimension) {
+            sampleSize *= 2;
+        }
+        return sampleSize;
+    }
+
+    private static native boolean preprocessBitmap(Bitmap bitmap, float cropFraction, float mean,
+            float std, int dataSize, float quantScale, float quantZeroPoint, int outputSize,
+            ByteBuffer outputBuffer);
+}
@@ -20,31 +20,32 @@ import java.nio.ByteBuffer;
 
 /** Input and expected output pair for inference benchmark */
 public class InferenceInOut {
-    // TODO: Support multiple inputs/outputs
-
-    // Input can be passed either directly as a byte array or indirectly through
-    // the input creator. This is needed to pass datasets that can not fit into
-    // memory at once.
-    public byte[] mInput;
+    // One entry per model input. Each input can be passed either directly as a
+    // byte array or indirectly through its input creator. This is needed to
+    // pass datasets that can not fit into memory at once.
+    public byte[][] mInputs;
     public byte[][] mExpectedOutputs;
     public int  mExpectedClass;
-    public InputCreatorInterface mInputCreator;
+    public InputCreatorInterface[] mInputCreators;
 
     public interface InputCreatorInterface {
         public abstract void createInput(ByteBuffer buffer);
     }
 
     public InferenceInOut(byte[] input, byte[][] expectedOutputs, int expectedClass) {
-        mInput = input;
+        this(new byte[][]{input}, expectedOutputs, expectedClass);
+    }
+    public InferenceInOut(byte[][] inputs, byte[][] expectedOutputs, int expectedClass) {
+        mInputs = inputs;
         mExpectedOutputs = expectedOutputs;
         mExpectedClass = expectedClass;
-        mInputCreator = null;
+        mInputCreators = null;
     }
     public InferenceInOut(InputCreatorInterface inputCreator, byte[][] expectedOutputs,
                           int expectedClass) {
-        mInput = null;
+        mInputs = null;
         mExpectedOutputs = expectedOutputs;
         mExpectedClass = expectedClass;
-        mInputCreator = inputCreator;
+        mInputCreators = new InputCreatorInterface[]{inputCreator};
     }
 }
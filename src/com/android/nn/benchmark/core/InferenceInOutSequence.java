@@ -65,25 +65,55 @@ public class InferenceInOutSequence {
         return mHasGoldenOutput;
     }
 
-    /** Helper class, generates {@link InferenceInOut} from a pair of android asset files */
+    /**
+     * Helper class, generates {@link InferenceInOut} from android asset files, one file
+     * per model input and output.
+     */
     public static class FromAssets {
-        private String mInputAssetName;
+        private String[] mInputAssetsNames;
         private String[] mOutputAssetsNames;
         private int mDataBytesSize;
-        private int mInputSizeBytes;
+        private int[] mInputsSizeBytes;
 
         public FromAssets(String inputAssetName, String[] outputAssetsNames, int dataBytesSize,
                 int inputSizeBytes) {
-            this.mInputAssetName = inputAssetName;
+            this(new String[]{inputAssetName}, outputAssetsNames, dataBytesSize,
+                    new int[]{inputSizeBytes});
+        }
+
+        public FromAssets(String[] inputAssetsNames, String[] outputAssetsNames,
+                int dataBytesSize, int[] inputsSizeBytes) {
+            if (inputAssetsNames.length != inputsSizeBytes.length) {
+                throw new IllegalArgumentException("Got " + inputAssetsNames.length +
+                        " input assets for " + inputsSizeBytes.length + " input sizes");
+            }
+            this.mInputAssetsNames = inputAssetsNames;
             this.mOutputAssetsNames = outputAssetsNames;
             this.mDataBytesSize = dataBytesSize;
-            this.mInputSizeBytes = inputSizeBytes;
+            this.mInputsSizeBytes = inputsSizeBytes;
         }
 
         public InferenceInOutSequence readAssets(AssetManager assetManager) throws IOException {
-            byte[] inputs = IOUtils.readAsset(assetManager, mInputAssetName, mDataBytesSize);
+            byte[][] inputs = new byte[mInputAssetsNames.length][];
             byte[][] outputs = new byte[mOutputAssetsNames.length][];
-            int sequenceLength = inputs.length / mInputSizeBytes;
+            int sequenceLength = -1;
+
+            for (int i = 0; i < mInputAssetsNames.length; ++i) {
+                inputs[i] = IOUtils.readAsset(assetManager, mInputAssetsNames[i], mDataBytesSize);
+                if (inputs[i].length % mInputsSizeBytes[i] != 0) {
+                    throw new IllegalArgumentException("Input data " + mInputAssetsNames[i] +
+                            " size (in bytes): " + inputs[i].length +
+                            " is not a multiple of input size (in bytes): " +
+                            mInputsSizeBytes[i]);
+                }
+                int inputSequenceLength = inputs[i].length / mInputsSizeBytes[i];
+                if (sequenceLength >= 0 && inputSequenceLength != sequenceLength) {
+                    throw new IllegalArgumentException("Input data " + mInputAssetsNames[i] +
+                            " sequence length: " + inputSequenceLength +
+                            " doesn't match other inputs sequence length: " + sequenceLength);
+                }
+                sequenceLength = inputSequenceLength;
+            }
 
             for (int i = 0; i < mOutputAssetsNames.length; ++i) {
                 outputs[i] = IOUtils.readAsset(assetManager, mOutputAssetsNames[i], mDataBytesSize);
@@ -94,10 +124,6 @@ public class InferenceInOutSequence {
                                     sequenceLength);
                 }
             }
-            if (inputs.length % mInputSizeBytes != 0) {
-                throw new IllegalArgumentException("Input data size (in bytes): " + inputs.length +
-                        " is not a multiple of input size (in bytes): " + mInputSizeBytes);
-            }
             InferenceInOutSequence sequence = new InferenceInOutSequence(
                     sequenceLength, true, mDataBytesSize);
 
@@ -109,10 +135,13 @@ public class InferenceInOutSequence {
                             outputSizeBytes * (i + 1));
                 }
 
-                sequence.mInputOutputs.add(new InferenceInOut(
-                        Arrays.copyOfRange(inputs, mInputSizeBytes * i, mInputSizeBytes * (i + 1)),
-                        outz,
-                        -1));
+                byte[][] inz = new byte[mInputAssetsNames.length][];
+                for (int j = 0; j < mInputAssetsNames.length; ++j) {
+                    inz[j] = Arrays.copyOfRange(inputs[j], mInputsSizeBytes[j] * i,
+                            mInputsSizeBytes[j] * (i + 1));
+                }
+
+                sequence.mInputOutputs.add(new InferenceInOut(inz, outz, -1));
             }
             return sequence;
         }
@@ -135,11 +164,21 @@ public class InferenceInOutSequence {
         private float mQuantScale;
         private float mQuantZeroPoint;
         private int mImageDimension;
+        // If set, replaces the preprocessor named by mPreprocessorName.
+        private ImagePreprocessing mPreprocessing;
 
         public FromDataset(String inputPath, String labelAssetName, String groundTruthAssetName,
                 String preprocessorName, int datasize,
                 float quantScale, float quantZeroPoint,
                 int imageDimension) {
+            this(inputPath, labelAssetName, groundTruthAssetName, preprocessorName, datasize,
+                    quantScale, quantZeroPoint, imageDimension, null);
+        }
+
+        public FromDataset(String inputPath, String labelAssetName, String groundTruthAssetName,
+                String preprocessorName, int datasize,
+                float quantScale, float quantZeroPoint,
+                int imageDimension, ImagePreprocessing preprocessing) {
             mInputPath = inputPath;
             if (mInputPath.endsWith("/")) {
                 mInputPath = mInputPath.substring(0, mInputPath.length() - 1);
@@ -151,6 +190,7 @@ public class InferenceInOutSequence {
             mQuantScale = quantScale;
             mQuantZeroPoint = quantZeroPoint;
             mImageDimension = imageDimension;
+            mPreprocessing = preprocessing;
         }
 
         private boolean isImageFile(String fileName) {
@@ -159,6 +199,18 @@ public class InferenceInOutSequence {
         }
 
         private ImageProcessorInterface createImageProcessor() {
+            if (mPreprocessing != null) {
+                return new ImageProcessorInterface() {
+                    @Override
+                    public void preprocess(int datasize, float quantScale, float quantZeroPoint,
+                            int imageDimension, AssetManager assetManager,
+                            String imageFileName, File cacheDir, ByteBuffer outputBuffer)
+                            throws IOException {
+                        mPreprocessing.preprocess(datasize, quantScale, quantZeroPoint,
+                                imageDimension, assetManager, imageFileName, outputBuffer);
+                    }
+                };
+            }
             try {
                 Class<?> clazz = Class.forName(
                         "com.android.nn.benchmark.imageprocessors." + mPreprocessorName);
@@ -16,22 +16,53 @@
 
 package com.android.nn.benchmark.core;
 
+import java.nio.ByteBuffer;
+
 public class InferenceResult {
+    /** Time spent in the inference call itself. */
     public float mComputeTimeSec;
+    /** Time spent copying or creating the inference input. */
+    public float mInputTimeSec;
+    /** Time spent comparing against golden output and saving the inference output. */
+    public float mOutputTimeSec;
     public float[] mMeanSquaredErrors;
     public float[] mMaxSingleErrors;
-    public byte[][] mInferenceOutput;
+    /**
+     * Inference outputs, or null if they were discarded. Read-only slices of a single
+     * direct buffer shared by all results of a benchmark run.
+     */
+    public ByteBuffer[] mInferenceOutput;
     public int mInputOutputSequenceIndex;
     public int mInputOutputIndex;
+    /**
+     * Time spent resetting the model states before this inference, -1 if they weren't reset
+     * (not the start of a sequence, or a stateless model).
+     */
+    public float mResetTimeSec;
 
-    public InferenceResult(float computeTimeSec, float[] meanSquaredErrors,
-            float[] maxSingleErrors, byte[][] inferenceOutput, int inputOutputSequenceIndex,
-            int inputOutputIndex) {
+    public InferenceResult(float computeTimeSec, float inputTimeSec, float outputTimeSec,
+            float[] meanSquaredErrors, float[] maxSingleErrors, ByteBuffer inferenceOutputs,
+            int inferenceOutputsOffset, int[] inferenceOutputSizes,
+            int inputOutputSequenceIndex, int inputOutputIndex, float resetTimeSec) {
         mComputeTimeSec = computeTimeSec;
+        mInputTimeSec = inputTimeSec;
+        mOutputTimeSec = outputTimeSec;
         mMeanSquaredErrors = meanSquaredErrors;
         mMaxSingleErrors = maxSingleErrors;
-        mInferenceOutput = inferenceOutput;
+        mInferenceOutput = null;
+        if (inferenceOutputs != null) {
+            mInferenceOutput = new ByteBuffer[inferenceOutputSizes.length];
+            int offset = inferenceOutputsOffset;
+            for (int i = 0; i < inferenceOutputSizes.length; ++i) {
+                ByteBuffer output = inferenceOutputs.asReadOnlyBuffer();
+                output.position(offset);
+                output.limit(offset + inferenceOutputSizes[i]);
+                mInferenceOutput[i] = output.slice();
+                offset += inferenceOutputSizes[i];
+            }
+        }
         mInputOutputSequenceIndex = inputOutputSequenceIndex;
         mInputOutputIndex = inputOutputIndex;
+        mResetTimeSec = resetTimeSec;
     }
 }
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+/**
+ * Aggregated statistics of a benchmark run, computed in native code.
+ *
+ * Used instead of a list of {@link InferenceResult} for long running benchmarks,
+ * its size doesn't depend on the number of inferences.
+ */
+public class InferenceSummary {
+    public final int mIterations;
+    public final float mTotalTimeSec;
+    public final float mTotalInputTimeSec;
+    public final float mTotalOutputTimeSec;
+    public final float mMeanTimeSec;
+    public final float mTimeStdDeviationSec;
+    public final float mMinTimeSec;
+    public final float mMaxTimeSec;
+    public final float mP50TimeSec;
+    public final float mP90TimeSec;
+    public final float mP95TimeSec;
+    public final float mP99TimeSec;
+    public final float mP999TimeSec;
+    public final float mSumOfMSEs;
+    public final float mMaxSingleError;
+
+    /**
+     * Non-empty buckets of the native log-linear latency histogram.
+     * mHistogramCounts[i] inferences took at least mHistogramBucketsSec[i] seconds
+     * (and less than the next bucket lower bound).
+     */
+    public final float[] mHistogramBucketsSec;
+    public final int[] mHistogramCounts;
+
+    /** Wall time of the whole run, including time spent between inferences. */
+    public final float mWallTimeSec;
+
+    /** Latency of the first and the later inferences of the sequences, and of state resets. */
+    public final StepLatencies mStepLatencies;
+
+    public InferenceSummary(int iterations, float totalTimeSec, float totalInputTimeSec,
+            float totalOutputTimeSec, float meanTimeSec, float timeStdDeviationSec,
+            float minTimeSec, float maxTimeSec, float p50TimeSec, float p90TimeSec,
+            float p95TimeSec, float p99TimeSec, float p999TimeSec, float sumOfMSEs,
+            float maxSingleError,
+            float[] histogramBucketsSec, int[] histogramCounts, float wallTimeSec,
+            int firstStepCount, float firstStepMeanTimeSec, float firstStepP99TimeSec,
+            int laterStepCount, float laterStepMeanTimeSec, float laterStepP99TimeSec,
+            int resetCount, float resetMeanTimeSec) {
+        mIterations = iterations;
+        mTotalTimeSec = totalTimeSec;
+        mTotalInputTimeSec = totalInputTimeSec;
+        mTotalOutputTimeSec = totalOutputTimeSec;
+        mMeanTimeSec = meanTimeSec;
+        mTimeStdDeviationSec = timeStdDeviationSec;
+        mMinTimeSec = minTimeSec;
+        mMaxTimeSec = maxTimeSec;
+        mP50TimeSec = p50TimeSec;
+        mP90TimeSec = p90TimeSec;
+        mP95TimeSec = p95TimeSec;
+        mP99TimeSec = p99TimeSec;
+        mP999TimeSec = p999TimeSec;
+        mSumOfMSEs = sumOfMSEs;
+        mMaxSingleError = maxSingleError;
+        mHistogramBucketsSec = histogramBucketsSec;
+        mHistogramCounts = histogramCounts;
+        mWallTimeSec = wallTimeSec;
+        mStepLatencies = new StepLatencies(firstStepCount, firstStepMeanTimeSec,
+                firstStepP99TimeSec, laterStepCount, laterStepMeanTimeSec, laterStepP99TimeSec,
+                resetCount, resetMeanTimeSec);
+    }
+}
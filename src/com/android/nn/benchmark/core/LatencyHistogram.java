@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import android.os.Parcel;
+
+import java.util.Map;
+import java.util.TreeMap;
+
+/**
+ * Non-empty buckets of the native log-linear latency histogram (jni/latency_stats.h).
+ *
+ * Unlike the timeFreq histogram of a result, its bucket bounds don't depend on the latency
+ * range of the run, so histograms of different runs can be compared bucket by bucket, see
+ * results/compare_results.py.
+ */
+public class LatencyHistogram {
+    static {
+        System.loadLibrary("nnbenchmark_jni");
+    }
+
+    /**
+     * mCounts[i] inferences took at least mBucketsSec[i] seconds (and less than the next
+     * bucket lower bound). Ascending.
+     */
+    public final float[] mBucketsSec;
+    public final int[] mCounts;
+
+    public LatencyHistogram(float[] bucketsSec, int[] counts) {
+        mBucketsSec = bucketsSec;
+        mCounts = counts;
+    }
+
+    LatencyHistogram(Parcel in) {
+        mBucketsSec = new float[in.readInt()];
+        in.readFloatArray(mBucketsSec);
+        mCounts = new int[mBucketsSec.length];
+        in.readIntArray(mCounts);
+    }
+
+    void writeToParcel(Parcel dest) {
+        dest.writeInt(mBucketsSec.length);
+        dest.writeFloatArray(mBucketsSec);
+        dest.writeIntArray(mCounts);
+    }
+
+    /** Histogram of latenciesSec. */
+    public static native LatencyHistogram compute(float[] latenciesSec);
+
+    /** Histogram of the inferences of all summaries together. */
+    public static LatencyHistogram fromSummaries(InferenceSummary... summaries) {
+        TreeMap<Float, Integer> buckets = new TreeMap<>();
+        for (InferenceSummary summary : summaries) {
+            for (int i = 0; i < summary.mHistogramBucketsSec.length; ++i) {
+                buckets.merge(summary.mHistogramBucketsSec[i], summary.mHistogramCounts[i],
+                        Integer::sum);
+            }
+        }
+        float[] bucketsSec = new float[buckets.size()];
+        int[] counts = new int[buckets.size()];
+        int i = 0;
+        for (Map.Entry<Float, Integer> bucket : buckets.entrySet()) {
+            bucketsSec[i] = bucket.getKey();
+            counts[i] = bucket.getValue();
+            ++i;
+        }
+        return new LatencyHistogram(bucketsSec, counts);
+    }
+}
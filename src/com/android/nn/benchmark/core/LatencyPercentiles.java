@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+/**
+ * Latency percentiles of a list of inference results, computed in native code.
+ *
+ * Percentiles are nearest rank, exact for short runs and from the native log-linear
+ * histogram (~1.6% relative error) for long ones.
+ */
+public class LatencyPercentiles {
+    static {
+        System.loadLibrary("nnbenchmark_jni");
+    }
+
+    /** Quantiles reported with every benchmark result. */
+    static final float[] REPORTED_QUANTILES = {0.5f, 0.9f, 0.95f, 0.99f};
+
+    /** Returns the latency at each of quantiles (0.0 - 1.0), 0 for an empty input. */
+    public static native float[] compute(float[] latenciesSec, float[] quantiles);
+}
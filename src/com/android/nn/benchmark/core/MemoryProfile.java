@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import android.os.Parcel;
+
+/**
+ * Memory footprint of a model, computed in native code, see jni/memory_footprint.h.
+ *
+ * Snapshots are of the whole process. All values are -1 when they couldn't be measured.
+ */
+public class MemoryProfile {
+    /** Number of values of {@link #toCsvValues}, see CSVWriter.RESULT_FORMAT_COMMENT. */
+    public static final int CSV_VALUES_COUNT = 15;
+
+    /** Process memory at one point in time. */
+    public static class Snapshot {
+        public final long mRssKb;
+        public final long mPssKb;
+        /** Bytes allocated through malloc and still in use. */
+        public final long mHeapBytes;
+
+        public Snapshot(long rssKb, long pssKb, long heapBytes) {
+            mRssKb = rssKb;
+            mPssKb = pssKb;
+            mHeapBytes = heapBytes;
+        }
+    }
+
+    /** Extent of the TFLite tensor arenas after the last tensor allocation. */
+    public final long mArenaBytes;
+    public final Snapshot mBeforeCreate;
+    /** After the model creation and input resizing. */
+    public final Snapshot mAfterCreate;
+    public final Snapshot mAfterFirstInference;
+    /** At the end of the last benchmark run. */
+    public final Snapshot mSteadyState;
+    /**
+     * Malloc high-water mark during the last benchmark run. Only sampled during the run with
+     * NNTestBase.setSamplePeakHeap(), the larger of the heap at its start and end otherwise.
+     */
+    public final long mPeakHeapBytes;
+    /** Exact peak RSS during the last benchmark run. */
+    public final long mPeakRssKb;
+
+    public MemoryProfile(long arenaBytes, Snapshot beforeCreate, Snapshot afterCreate,
+            Snapshot afterFirstInference, Snapshot steadyState, long peakHeapBytes,
+            long peakRssKb) {
+        mArenaBytes = arenaBytes;
+        mBeforeCreate = beforeCreate;
+        mAfterCreate = afterCreate;
+        mAfterFirstInference = afterFirstInference;
+        mSteadyState = steadyState;
+        mPeakHeapBytes = peakHeapBytes;
+        mPeakRssKb = peakRssKb;
+    }
+
+    MemoryProfile(Parcel in) {
+        this(in.readLong(), readSnapshot(in), readSnapshot(in), readSnapshot(in),
+                readSnapshot(in), in.readLong(), in.readLong());
+    }
+
+    void writeToParcel(Parcel dest) {
+        for (long value : toCsvValues()) {
+            dest.writeLong(value);
+        }
+    }
+
+    private static Snapshot readSnapshot(Parcel in) {
+        return new Snapshot(in.readLong(), in.readLong(), in.readLong());
+    }
+
+    /** RSS growth from before the model creation to the steady state, -1 if unknown. */
+    public long getRssGrowthKb() {
+        if (mBeforeCreate.mRssKb < 0 || mSteadyState.mRssKb < 0) {
+            return -1;
+        }
+        return mSteadyState.mRssKb - mBeforeCreate.mRssKb;
+    }
+
+    /**
+     * Arena bytes, rss/pss/heap of every snapshot in creation order, peak heap bytes and peak
+     * RSS, also the parcel order.
+     */
+    public long[] toCsvValues() {
+        return new long[] {mArenaBytes,
+                mBeforeCreate.mRssKb, mBeforeCreate.mPssKb, mBeforeCreate.mHeapBytes,
+                mAfterCreate.mRssKb, mAfterCreate.mPssKb, mAfterCreate.mHeapBytes,
+                mAfterFirstInference.mRssKb, mAfterFirstInference.mPssKb,
+                mAfterFirstInference.mHeapBytes,
+                mSteadyState.mRssKb, mSteadyState.mPssKb, mSteadyState.mHeapBytes,
+                mPeakHeapBytes, mPeakRssKb};
+    }
+
+    @Override
+    public String toString() {
+        return "MemoryProfile{arena=" + mArenaBytes
+                + ", rssGrowthKb=" + getRssGrowthKb()
+                + ", steadyPssKb=" + mSteadyState.mPssKb
+                + ", peakRssKb=" + mPeakRssKb
+                + ", peakHeap=" + mPeakHeapBytes + "}";
+    }
+}
@@ -23,6 +23,8 @@ import android.util.Log;
 import android.util.Pair;
 import android.widget.TextView;
 
+import com.android.nn.benchmark.util.MappedDatasetWriter;
+
 import java.io.File;
 import java.io.FileOutputStream;
 import java.io.IOException;
@@ -44,11 +46,60 @@ public class NNTestBase {
             String modelFileName,
             boolean useNNApi,
             boolean enableIntermediateTensorsDump,
-            String nnApiDeviceName);
+            String nnApiDeviceName,
+            String nnApiCacheDir,
+            int executionPreference,
+            boolean allowFp16,
+            int maxDelegatedPartitions,
+            boolean disallowNNApiCpu);
 
     private synchronized native void destroyModel(long modelHandle);
 
-    private synchronized native boolean resizeInputTensors(long modelHandle, int[] inputShape);
+    private synchronized native boolean resizeInputTensors(long modelHandle,
+            int[][] inputShapes);
+
+    private synchronized native boolean loadMappedDataset(long modelHandle, String datasetPath);
+
+    private synchronized native boolean mappedDatasetHasGoldenOutputs(long modelHandle);
+
+    private synchronized native boolean setNumThreads(long modelHandle, int numThreads);
+
+    private synchronized native boolean setCpuAffinity(long modelHandle, int cores,
+            long explicitMask);
+
+    private synchronized native boolean setConvergence(long modelHandle,
+            float targetRelativeWidth, float confidence, float quantile, int minInferences,
+            int maxInferences, float minTimeSec, float maxTimeSec);
+
+    /** NNAPI execution preferences for {@link #setExecutionPreference}. */
+    public static final int EXECUTION_PREFERENCE_UNDEFINED = -1;
+    public static final int EXECUTION_PREFERENCE_LOW_POWER = 0;
+    public static final int EXECUTION_PREFERENCE_FAST_SINGLE_ANSWER = 1;
+    public static final int EXECUTION_PREFERENCE_SUSTAINED_SPEED = 2;
+
+    /** NNAPI execution paths for {@link #runBenchmarkExecutionModes}. */
+    public static final int EXECUTION_MODE_SYNC = 0;
+    /** Burst executions, needs NNAPI 1.2 (Android Q), falls back to sync before. */
+    public static final int EXECUTION_MODE_BURST = 1;
+    /** Interleaved rounds of {@link #runBenchmarkExecutionModes}, same as in native code. */
+    public static final int EXECUTION_MODE_ROUNDS = 4;
+
+    /** Multi-model schedules for {@link #runScenario}, see jni/scenario_runner.h. */
+    public static final int SCENARIO_INTERLEAVED = 0;
+    public static final int SCENARIO_CONCURRENT = 1;
+
+    /** Request arrival distributions for {@link #runBenchmarkOpenLoop}. */
+    public static final int ARRIVAL_FIXED_INTERVAL = 0;
+    public static final int ARRIVAL_POISSON = 1;
+
+    /** CPU core sets for {@link #setCpuAffinity}. */
+    public static final int CPU_CORES_ALL = 0;
+    /** Cores with the highest max frequency (big cores on big.LITTLE). */
+    public static final int CPU_CORES_BIG = 1;
+    /** Cores with the lowest max frequency (little cores on big.LITTLE). */
+    public static final int CPU_CORES_LITTLE = 2;
+    /** Explicit CPU mask, bit N is CPU N. */
+    public static final int CPU_CORES_EXPLICIT = 3;
 
     /** Discard inference output in inference results. */
     public static final int FLAG_DISCARD_INFERENCE_OUTPUT = 1 << 0;
@@ -60,6 +111,40 @@ public class NNTestBase {
      * output based) error metrics.
      */
     public static final int FLAG_IGNORE_GOLDEN_OUTPUT = 1 << 1;
+    /**
+     * Bind inputs as NNAPI shared memory instead of copying them for every inference.
+     *
+     * Inputs are copied into shared memory once, before the benchmark starts. Has no
+     * effect with the TFLite CPU backend or for inputs created with an input creator.
+     */
+    public static final int FLAG_ZERO_COPY_INPUT = 1 << 2;
+    /**
+     * Check golden outputs and save inference outputs on a background thread.
+     *
+     * The inference thread only copies the output tensors, so output processing
+     * overlaps with the next inference. Inference results keep their order.
+     */
+    public static final int FLAG_ASYNC_VALIDATION = 1 << 3;
+    /**
+     * Collect per-operator execution times with a TFLite profiler, see
+     * {@link #getOperatorProfiles}. Adds some overhead to every operator.
+     */
+    public static final int FLAG_PROFILE_OPERATORS = 1 << 4;
+    /**
+     * Run input creators on a native producer thread, ahead of the inferences.
+     *
+     * Input creation no longer runs between inferences, only the copy of the created input
+     * does. Input creators are called from that thread, one at a time, in benchmark order.
+     */
+    public static final int FLAG_PREFETCH_INPUTS = 1 << 5;
+    /** Run to the end even if the model has convergence options, see {@link #setConvergence}. */
+    public static final int FLAG_IGNORE_CONVERGENCE = 1 << 6;
+    /**
+     * Sample the heap on a native background thread for the peak heap of the memory profile.
+     *
+     * The sampling competes with the benchmark, latencies of such runs are less accurate.
+     */
+    public static final int FLAG_SAMPLE_PEAK_HEAP = 1 << 7;
 
     private synchronized native boolean runBenchmark(long modelHandle,
             List<InferenceInOutSequence> inOutList,
@@ -68,17 +153,105 @@ public class NNTestBase {
             float timeoutSec,
             int flags);
 
-    private synchronized native void dumpAllLayers(
+    private synchronized native InferenceSummary runBenchmarkStreaming(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            int inferencesSeqMaxCount,
+            float timeoutSec,
+            int flags);
+
+    private synchronized native SustainedProfile runBenchmarkSustained(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            float durationSec,
+            float windowSec,
+            boolean readSensors,
+            int flags);
+
+    private synchronized native InferenceSummary[] runBenchmarkConcurrent(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            int threadsCount,
+            int inferencesSeqMaxCount,
+            float timeoutSec,
+            int flags);
+
+    private synchronized native OpenLoopSummary[] runBenchmarkOpenLoop(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            float[] arrivalRates,
+            int distribution,
+            int threadsCount,
+            float durationSec,
+            int flags);
+
+    private static native InferenceSummary[] runScenario(long[] modelHandles,
+            Object[] inOutLists,
+            int[] flags,
+            float[] ratesPerSec,
+            int[] priorities,
+            int schedule,
+            float durationSec);
+
+    private synchronized native InferenceSummary[] runBenchmarkThreadSweep(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            int maxThreads,
+            int inferencesSeqMaxCount,
+            float timeoutSec,
+            int flags);
+
+    private synchronized native InferenceSummary[] runBenchmarkExecutionModes(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            int[] modes,
+            int inferencesSeqMaxCount,
+            float timeoutSec,
+            int flags);
+
+    private synchronized native InferenceSummary[] runBenchmarkDelegateOptionsSweep(
+            long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            int[] executionPreferences,
+            boolean[] allowFp16,
+            int[] maxDelegatedPartitions,
+            boolean[] disallowNNApiCpu,
+            int inferencesSeqMaxCount,
+            float timeoutSec,
+            int flags);
+
+    private synchronized native InferenceSummary[] runBenchmarkBatchSweep(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            int[] batchSizes,
+            int batchesMaxCount,
+            float timeoutSec,
+            int flags);
+
+    private synchronized native StartupProfile getStartupProfile(long modelHandle);
+
+    private synchronized native OperatorProfile[] getOperatorProfiles(long modelHandle);
+
+    private synchronized native MemoryProfile getMemoryProfile(long modelHandle);
+
+    private synchronized native ConvergenceStatus getConvergenceStatus(long modelHandle);
+
+    private synchronized native StartupProfile[] runColdStartBenchmark(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            int iterations);
+
+    private synchronized native float[] runWarmup(long modelHandle,
+            List<InferenceInOutSequence> inOutList,
+            int warmupInferencesMaxCount,
+            float warmupTimeoutSec);
+
+    private synchronized native boolean dumpAllLayers(
             long modelHandle,
             String dumpPath,
-            List<InferenceInOutSequence> inOutList);
+            List<InferenceInOutSequence> inOutList,
+            boolean compress,
+            String[] tensorNames,
+            int[] tensorIndices);
 
     protected Activity mActivity;
     protected TextView mText;
     private String mModelName;
     private String mModelFile;
     private long mModelHandle;
-    private int[] mInputShape;
+    private int[][] mInputShapes;
     private InferenceInOutSequence.FromAssets[] mInputOutputAssets;
     private InferenceInOutSequence.FromDataset[] mInputOutputDatasets;
     private EvaluatorConfig mEvaluatorConfig;
@@ -86,10 +259,29 @@ public class NNTestBase {
     private boolean mHasGoldenOutputs;
     private boolean mUseNNApi = false;
     private boolean mEnableIntermediateTensorsDump = false;
+    private boolean mZeroCopyInput = false;
+    private boolean mAsyncValidation = false;
+    private boolean mOperatorProfiling = false;
+    private boolean mPrefetchInputs = false;
+    private boolean mSamplePeakHeap = false;
+    private boolean mNativeEvaluation = false;
+    private boolean mUseMappedDataset = false;
+    private boolean mMappedDatasetLoaded = false;
+    private int mNumThreads = -1;
+    private boolean mCpuAffinity = false;
+    private int mCpuCores = CPU_CORES_ALL;
+    private long mCpuAffinityMask = 0;
+    private ConvergenceOptions mConvergenceOptions = null;
+    private int mExecutionPreference = EXECUTION_PREFERENCE_UNDEFINED;
+    private boolean mAllowFp16 = true;
+    private int mMaxDelegatedPartitions = 3;
+    private boolean mDisallowNNApiCpu = false;
+    private boolean mCompilationCaching = false;
+    private File mCompilationCacheDir;
     private int mMinSdkVersion;
     private Optional<String> mNNApiDeviceName = Optional.empty();
 
-    public NNTestBase(String modelName, String modelFile, int[] inputShape,
+    public NNTestBase(String modelName, String modelFile, int[][] inputShapes,
             InferenceInOutSequence.FromAssets[] inputOutputAssets,
             InferenceInOutSequence.FromDataset[] inputOutputDatasets,
             EvaluatorConfig evaluator, int minSdkVersion) {
@@ -104,7 +296,7 @@ public class NNTestBase {
         }
         mModelName = modelName;
         mModelFile = modelFile;
-        mInputShape = inputShape;
+        mInputShapes = inputShapes;
         mInputOutputAssets = inputOutputAssets;
         mInputOutputDatasets = inputOutputDatasets;
         mModelHandle = 0;
@@ -128,6 +320,103 @@ public class NNTestBase {
         mEnableIntermediateTensorsDump = value;
     }
 
+    public void setZeroCopyInput(boolean value) {
+        if (value && !mUseNNApi) {
+            Log.e(TAG, "Zero-copy input has no effect when not using NNAPI");
+        }
+        mZeroCopyInput = value;
+    }
+
+    public void setAsyncValidation(boolean value) {
+        mAsyncValidation = value;
+    }
+
+    /**
+     * Runs on a memory mapped copy of the inputs and golden outputs instead of passing them
+     * from Java. The copy is written into the app cache on first use, after that the inputs
+     * are never loaded into the Java heap. Evaluators are not supported.
+     */
+    public void setUseMappedDataset(boolean value) {
+        mUseMappedDataset = value;
+    }
+
+    public void setOperatorProfiling(boolean value) {
+        mOperatorProfiling = value;
+    }
+
+    public void setPrefetchInputs(boolean value) {
+        mPrefetchInputs = value;
+    }
+
+    public void setSamplePeakHeap(boolean value) {
+        mSamplePeakHeap = value;
+    }
+
+    /**
+     * Use the native version of the model's evaluator, if it has one, see
+     * {@link NativeEvaluator}. Inference outputs are then discarded instead of being copied
+     * into the Java heap. Needs to be set before setupModel().
+     */
+    public void setNativeEvaluation(boolean value) {
+        mNativeEvaluation = value;
+    }
+
+    /** Threads used by TFLite CPU kernels, -1 for the TFLite default. */
+    public void setNumThreads(int numThreads) {
+        mNumThreads = numThreads;
+    }
+
+    /**
+     * Pins the benchmark (and TFLite worker) threads to one of the CPU_CORES_* sets.
+     * explicitMask is only used with CPU_CORES_EXPLICIT. The calling thread is only pinned
+     * while a benchmark runs, its affinity is restored afterwards.
+     */
+    public void setCpuAffinity(int cores, long explicitMask) {
+        mCpuAffinity = true;
+        mCpuCores = cores;
+        mCpuAffinityMask = explicitMask;
+    }
+
+    /**
+     * Stops the benchmark runs as soon as the latency estimate has converged, checked after
+     * every inference. Needs to be set before setupModel(). Only plain and streaming benchmark
+     * runs stop early; complete input set runs still go through the whole set.
+     */
+    public void setConvergence(ConvergenceOptions options) {
+        mConvergenceOptions = options;
+    }
+
+    /** One of the EXECUTION_PREFERENCE_* values. */
+    public void setExecutionPreference(int executionPreference) {
+        mExecutionPreference = executionPreference;
+    }
+
+    /** Allows fp32 models to run with fp16 precision, on NNAPI and on the TFLite CPU. */
+    public void setAllowFp16(boolean value) {
+        mAllowFp16 = value;
+    }
+
+    /** Max number of model partitions delegated to NNAPI, non-positive for no limit. */
+    public void setMaxDelegatedPartitions(int maxDelegatedPartitions) {
+        mMaxDelegatedPartitions = maxDelegatedPartitions;
+    }
+
+    /** Don't let NNAPI fall back to its CPU implementation. */
+    public void setDisallowNNApiCpu(boolean value) {
+        mDisallowNNApiCpu = value;
+    }
+
+    /**
+     * Enables NNAPI compilation caching, in a per-model directory of the app code cache.
+     * The cache is kept across runs.
+     */
+    public void setCompilationCaching(boolean value) {
+        if (value && !mUseNNApi) {
+            Log.e(TAG, "Compilation caching has no effect when not using NNAPI");
+        }
+        mCompilationCaching = value;
+    }
+
     public void setNNApiDeviceName(String value) {
         if (!mUseNNApi) {
             Log.e(TAG, "Setting device name has no effect when not using NNAPI");
@@ -139,17 +428,62 @@ public class NNTestBase {
         mActivity = ipact;
         String modelFileName = copyAssetToFile();
         if (modelFileName != null) {
+            String cacheDir = null;
+            if (mCompilationCaching) {
+                mCompilationCacheDir = new File(mActivity.getCodeCacheDir(),
+                        "nnapi_cache/" + mModelName);
+                if (!mCompilationCacheDir.isDirectory() && !mCompilationCacheDir.mkdirs()) {
+                    Log.e(TAG, "Failed to create " + mCompilationCacheDir);
+                    return false;
+                }
+                cacheDir = mCompilationCacheDir.getAbsolutePath();
+            }
             mModelHandle = initModel(
                     modelFileName, mUseNNApi, mEnableIntermediateTensorsDump,
-                    mNNApiDeviceName.orElse(null));
+                    mNNApiDeviceName.orElse(null), cacheDir, mExecutionPreference, mAllowFp16,
+                    mMaxDelegatedPartitions, mDisallowNNApiCpu);
             if (mModelHandle == 0) {
                 Log.e(TAG, "Failed to init the model");
                 return false;
             }
-            resizeInputTensors(mModelHandle, mInputShape);
+            if (!resizeInputTensors(mModelHandle, mInputShapes)) {
+                Log.e(TAG, "Failed to resize the model inputs");
+                return false;
+            }
+            if (mNumThreads != -1 && !setNumThreads(mModelHandle, mNumThreads)) {
+                Log.e(TAG, "Failed to set the number of threads");
+                return false;
+            }
+            if (mCpuAffinity && !setCpuAffinity(mModelHandle, mCpuCores, mCpuAffinityMask)) {
+                Log.e(TAG, "Failed to set the CPU affinity");
+                return false;
+            }
+            if (mConvergenceOptions != null && !setConvergence(mModelHandle,
+                    mConvergenceOptions.mTargetRelativeWidth, mConvergenceOptions.mConfidence,
+                    mConvergenceOptions.mQuantile, mConvergenceOptions.mMinInferences,
+                    mConvergenceOptions.mMaxInferences, mConvergenceOptions.mMinTimeSec,
+                    mConvergenceOptions.mMaxTimeSec)) {
+                Log.e(TAG, "Failed to set the convergence options");
+                return false;
+            }
+            if (mUseMappedDataset && !setupMappedDataset()) {
+                return false;
+            }
         }
+        mEvaluator = null;
         if (mEvaluatorConfig != null) {
-            mEvaluator = mEvaluatorConfig.createEvaluator(mActivity.getAssets());
+            if (mNativeEvaluation && mModelHandle != 0) {
+                try {
+                    mEvaluator = mEvaluatorConfig.createNativeEvaluator(
+                            mActivity.getAssets(), mModelHandle);
+                } catch (IOException e) {
+                    Log.e(TAG, "Failed to set up the native evaluator", e);
+                    return false;
+                }
+            }
+            if (mEvaluator == null) {
+                mEvaluator = mEvaluatorConfig.createEvaluator(mActivity.getAssets());
+            }
         }
         return true;
     }
@@ -169,7 +503,44 @@ public class NNTestBase {
         }
     }
 
+    private boolean setupMappedDataset() {
+        if (mEvaluatorConfig != null) {
+            Log.e(TAG, "Evaluators can't be used with a mapped dataset");
+            return false;
+        }
+        File datasetFile = new File(mActivity.getCacheDir(), mModelName + ".nnbd");
+        // Datasets written by a previous version of the app may be stale.
+        long apkTime = new File(mActivity.getPackageCodePath()).lastModified();
+        if (!datasetFile.exists() || datasetFile.lastModified() < apkTime) {
+            try {
+                MappedDatasetWriter.write(datasetFile, readInputOutputs());
+            } catch (IOException | IllegalArgumentException e) {
+                Log.e(TAG, "Failed to write the mapped dataset", e);
+                return false;
+            }
+        }
+        if (!loadMappedDataset(mModelHandle, datasetFile.getAbsolutePath())) {
+            Log.e(TAG, "Failed to load the mapped dataset");
+            return false;
+        }
+        mMappedDatasetLoaded = true;
+        mHasGoldenOutputs = mappedDatasetHasGoldenOutputs(mModelHandle);
+        return true;
+    }
+
+    /**
+     * Inputs and outputs to pass to the native benchmark, empty when a mapped dataset is used,
+     * the native code reads its data instead. Modes that size their work from the list don't
+     * support mapped datasets.
+     */
     private List<InferenceInOutSequence> getInputOutputAssets() throws IOException {
+        if (mMappedDatasetLoaded) {
+            return new ArrayList<>();
+        }
+        return readInputOutputs();
+    }
+
+    private List<InferenceInOutSequence> readInputOutputs() throws IOException {
         // TODO: Caching, don't read inputs for every inference
         List<InferenceInOutSequence> inOutList = new ArrayList<>();
         if (mInputOutputAssets != null) {
@@ -204,14 +575,39 @@ public class NNTestBase {
         if (!mHasGoldenOutputs) {
             flags = flags | FLAG_IGNORE_GOLDEN_OUTPUT;
         }
-        if (mEvaluator == null) {
+        if (mEvaluator == null || mEvaluator instanceof NativeEvaluator) {
             flags = flags | FLAG_DISCARD_INFERENCE_OUTPUT;
         }
+        if (mZeroCopyInput && mUseNNApi) {
+            flags = flags | FLAG_ZERO_COPY_INPUT;
+        }
+        if (mAsyncValidation) {
+            flags = flags | FLAG_ASYNC_VALIDATION;
+        }
+        if (mOperatorProfiling) {
+            flags = flags | FLAG_PROFILE_OPERATORS;
+        }
+        if (mPrefetchInputs) {
+            flags = flags | FLAG_PREFETCH_INPUTS;
+        }
+        if (mSamplePeakHeap) {
+            flags = flags | FLAG_SAMPLE_PEAK_HEAP;
+        }
         return flags;
     }
 
     public void dumpAllLayers(File dumpDir, int inputAssetIndex, int inputAssetSize)
             throws IOException {
+        dumpAllLayers(dumpDir, inputAssetIndex, inputAssetSize, false, null, null);
+    }
+
+    /**
+     * Dumps the tensors after every inference into dumpDir/tensors.dump, see
+     * jni/tensor_dump_writer.h for the format and tools/extract_tensor_dump.py to unpack it.
+     * If tensorNames or tensorIndices are set, only the tensors matching either are dumped.
+     */
+    public void dumpAllLayers(File dumpDir, int inputAssetIndex, int inputAssetSize,
+            boolean compress, String[] tensorNames, int[] tensorIndices) throws IOException {
         if (!dumpDir.exists() || !dumpDir.isDirectory()) {
             throw new IllegalArgumentException("dumpDir doesn't exist or is not a directory");
         }
@@ -219,10 +615,149 @@ public class NNTestBase {
             throw new IllegalStateException("mEnableIntermediateTensorsDump is " +
                     "set to false, impossible to proceed");
         }
+        if (mMappedDatasetLoaded) {
+            throw new IllegalStateException("Tensors can't be dumped from a mapped dataset");
+        }
+
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        if (!dumpAllLayers(mModelHandle, dumpDir.toString(),
+                ios.subList(inputAssetIndex, inputAssetSize), compress, tensorNames,
+                tensorIndices)) {
+            throw new IOException("Failed to dump the tensors into " + dumpDir);
+        }
+    }
+
+    /**
+     * Per-operator execution times of the last benchmark run, empty unless operator
+     * profiling is enabled.
+     */
+    public OperatorProfile[] getOperatorProfiles() throws BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        if (!mOperatorProfiling) {
+            return new OperatorProfile[0];
+        }
+        OperatorProfile[] profiles = getOperatorProfiles(mModelHandle);
+        if (profiles == null) {
+            throw new BenchmarkException("Failed to get operator profiles");
+        }
+        return profiles;
+    }
+
+    /** Startup cost of the model, including the first inference once it has run. */
+    public StartupProfile getStartupProfile() throws BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        return getStartupProfile(mModelHandle);
+    }
+
+    /**
+     * Memory footprint of the model: tensor arena size, process memory at each stage of its
+     * life and the peaks of the last benchmark run.
+     */
+    public MemoryProfile getMemoryProfile() throws BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        return getMemoryProfile(mModelHandle);
+    }
+
+    /** Where the last benchmark run stopped, only meaningful with setConvergence(). */
+    public ConvergenceStatus getConvergenceStatus() throws BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        return getConvergenceStatus(mModelHandle);
+    }
+
+    /**
+     * Creates, runs a single inference with and destroys a new native model iterations
+     * times, with the same configuration as this test's model.
+     *
+     * Returns the startup profile of every created model.
+     */
+    public Pair<List<InferenceInOutSequence>, StartupProfile[]> runColdStartBenchmark(
+            int iterations) throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        if (mMappedDatasetLoaded) {
+            throw new BenchmarkException("Cold start benchmark doesn't support mapped datasets");
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        StartupProfile[] profiles = runColdStartBenchmark(mModelHandle, ios, iterations);
+        if (profiles == null) {
+            throw new BenchmarkException("Failed to run cold start benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, StartupProfile[]>(ios, profiles);
+    }
 
+    /**
+     * Measures the model startup with an empty and with a warm compilation cache.
+     *
+     * Every iteration clears the compilation cache, then creates a model twice (see
+     * {@link #runColdStartBenchmark}): the first one misses the cache and fills it, the second
+     * one hits it. Returns the cache miss profiles in [0] and the cache hit profiles in [1].
+     */
+    public Pair<List<InferenceInOutSequence>, StartupProfile[][]> runCompilationCacheBenchmark(
+            int iterations) throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        if (mCompilationCacheDir == null) {
+            throw new BenchmarkException("Compilation caching is not enabled");
+        }
+        if (mMappedDatasetLoaded) {
+            throw new BenchmarkException(
+                    "Compilation cache benchmark doesn't support mapped datasets");
+        }
         List<InferenceInOutSequence> ios = getInputOutputAssets();
-        dumpAllLayers(mModelHandle, dumpDir.toString(),
-                ios.subList(inputAssetIndex, inputAssetSize));
+        StartupProfile[][] profiles = new StartupProfile[2][iterations];
+        for (int i = 0; i < iterations; ++i) {
+            clearCompilationCache();
+            for (int k = 0; k < 2; ++k) {
+                StartupProfile[] run = runColdStartBenchmark(mModelHandle, ios, 1);
+                if (run == null) {
+                    throw new BenchmarkException("Failed to run compilation cache benchmark");
+                }
+                profiles[k][i] = run[0];
+            }
+        }
+        return new Pair<List<InferenceInOutSequence>, StartupProfile[][]>(ios, profiles);
+    }
+
+    private void clearCompilationCache() throws IOException {
+        File[] files = mCompilationCacheDir.listFiles();
+        if (files == null) {
+            throw new IOException("Failed to list " + mCompilationCacheDir);
+        }
+        for (File file : files) {
+            if (!file.delete()) {
+                throw new IOException("Failed to delete " + file);
+            }
+        }
+    }
+
+    /**
+     * Run warmup inferences that are not part of the benchmark results.
+     *
+     * Stops after warmupInferencesMaxCount inferences, or after warmupTimeoutSec seconds if
+     * it's positive. Returns the latency of every warmup inference, so the cold start cost
+     * can still be reported.
+     */
+    public float[] runWarmup(int warmupInferencesMaxCount, float warmupTimeoutSec)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        float[] warmupTimesSec = runWarmup(mModelHandle, getInputOutputAssets(),
+                warmupInferencesMaxCount, warmupTimeoutSec);
+        if (warmupTimesSec == null) {
+            throw new BenchmarkException("Failed to run warmup");
+        }
+        return warmupTimesSec;
     }
 
     public Pair<List<InferenceInOutSequence>, List<InferenceResult>> runInferenceOnce()
@@ -246,7 +781,12 @@ public class NNTestBase {
             int setRepeat,
             float timeoutSec)
             throws IOException, BenchmarkException {
-        int flags = getDefaultFlags();
+        // The input set size is only known from the inputs passed to the native code.
+        if (mMappedDatasetLoaded) {
+            throw new BenchmarkException(
+                    "Complete input set benchmark doesn't support mapped datasets");
+        }
+        int flags = getDefaultFlags() | FLAG_IGNORE_CONVERGENCE;
         List<InferenceInOutSequence> ios = getInputOutputAssets();
         int totalSequenceInferencesCount = ios.size() * setRepeat;
         int extpectedResults = 0;
@@ -286,10 +826,258 @@ public class NNTestBase {
                 inOutList, resultList);
     }
 
+    /**
+     * Run as many inferences as possible before timeout, aggregating the results in native code.
+     *
+     * Memory usage doesn't grow with the number of inferences, which makes it suitable for
+     * long runs. Inference outputs are not kept, so evaluators can't be used with it.
+     */
+    public Pair<List<InferenceInOutSequence>, InferenceSummary> runBenchmarkStreaming(
+            float timeoutSec)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        int flags = getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+        InferenceSummary summary = runBenchmarkStreaming(mModelHandle, ios, 0xFFFFFFF,
+                timeoutSec, flags);
+        if (summary == null) {
+            throw new BenchmarkException("Failed to run benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, InferenceSummary>(ios, summary);
+    }
+
+    /**
+     * Run continuously for durationSec, recording latency in windows of windowSec seconds of
+     * wall time.
+     *
+     * Meant for runs of several minutes, to see how performance decays with thermal
+     * throttling. If readSensors is set, thermal zone temperatures and CPU frequencies are
+     * read from sysfs at the end of every window (nodes not readable by the app are skipped).
+     */
+    public Pair<List<InferenceInOutSequence>, SustainedProfile> runBenchmarkSustained(
+            float durationSec, float windowSec, boolean readSensors)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        int flags = getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+        SustainedProfile profile = runBenchmarkSustained(mModelHandle, ios, durationSec,
+                windowSec, readSensors, flags);
+        if (profile == null) {
+            throw new BenchmarkException("Failed to run sustained benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, SustainedProfile>(ios, profile);
+    }
+
+    /**
+     * Run the benchmark on threadsCount native threads at once, each with its own interpreter.
+     *
+     * Every thread runs as many inferences as possible before timeout, results are aggregated
+     * per thread like {@link #runBenchmarkStreaming}. Doesn't support dataset inputs.
+     */
+    public Pair<List<InferenceInOutSequence>, InferenceSummary[]> runBenchmarkConcurrent(
+            int threadsCount, float timeoutSec)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        if (mInputOutputDatasets != null) {
+            throw new BenchmarkException("Concurrent benchmark doesn't support datasets");
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        int flags = getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+        InferenceSummary[] summaries = runBenchmarkConcurrent(mModelHandle, ios, threadsCount,
+                0xFFFFFFF, timeoutSec, flags);
+        if (summaries == null) {
+            throw new BenchmarkException("Failed to run concurrent benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, InferenceSummary[]>(ios, summaries);
+    }
+
+    /**
+     * Run an open-loop benchmark once for every arrival rate, in requests per second.
+     *
+     * Requests arrive at the given rate for durationSec, at fixed intervals or as a Poisson
+     * process, whether or not the model keeps up. threadsCount interpreters, set up like
+     * {@link #runBenchmarkConcurrent}, serve them in arrival order. summaries[k] holds the
+     * queueing, service and response times at arrivalRates[k]. Doesn't support dataset inputs.
+     */
+    public Pair<List<InferenceInOutSequence>, OpenLoopSummary[]> runBenchmarkOpenLoop(
+            float[] arrivalRates, int distribution, int threadsCount, float durationSec)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        if (mInputOutputDatasets != null) {
+            throw new BenchmarkException("Open-loop benchmark doesn't support datasets");
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        int flags = getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+        OpenLoopSummary[] summaries = runBenchmarkOpenLoop(mModelHandle, ios, arrivalRates,
+                distribution, threadsCount, durationSec, flags);
+        if (summaries == null) {
+            throw new BenchmarkException("Failed to run open-loop benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, OpenLoopSummary[]>(ios, summaries);
+    }
+
+    /**
+     * Run the benchmark once for every delegate configuration, rebuilding the interpreter and
+     * the NNAPI delegate each time.
+     *
+     * Configuration k is given by the k-th entry of every array. Each run lasts timeoutSec,
+     * summaries[k] holds the results of configuration k. The model configuration is
+     * restored afterwards.
+     */
+    public Pair<List<InferenceInOutSequence>, InferenceSummary[]> runBenchmarkDelegateOptionsSweep(
+            int[] executionPreferences, boolean[] allowFp16, int[] maxDelegatedPartitions,
+            boolean[] disallowNNApiCpu, float timeoutSec)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        int flags = getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+        InferenceSummary[] summaries = runBenchmarkDelegateOptionsSweep(mModelHandle, ios,
+                executionPreferences, allowFp16, maxDelegatedPartitions, disallowNNApiCpu,
+                0xFFFFFFF, timeoutSec, flags);
+        if (summaries == null) {
+            throw new BenchmarkException("Failed to run delegate options sweep benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, InferenceSummary[]>(ios, summaries);
+    }
+
+    /**
+     * Run the benchmark for every EXECUTION_MODE_* entry of modes, each on an NNAPI delegate
+     * built once with otherwise unchanged options. Every mode may only be given once.
+     *
+     * timeoutSec is split into EXECUTION_MODE_ROUNDS rounds running all modes, in reverse order
+     * every other round, so that drift during the run affects all modes alike. summaries[k]
+     * pools all rounds of modes[k], summaries[(1 + r) * modes.length + k] is round r alone.
+     * Compares the per inference overhead of the NNAPI execution paths on the same inputs.
+     * NNAPI only.
+     */
+    public Pair<List<InferenceInOutSequence>, InferenceSummary[]> runBenchmarkExecutionModes(
+            int[] modes, float timeoutSec)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        if (!mUseNNApi) {
+            throw new BenchmarkException("Execution modes need NNAPI");
+        }
+        for (int k = 0; k < modes.length; ++k) {
+            for (int j = 0; j < k; ++j) {
+                if (modes[j] == modes[k]) {
+                    throw new BenchmarkException("Execution mode " + modes[k] + " given twice");
+                }
+            }
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        int flags = getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+        InferenceSummary[] summaries = runBenchmarkExecutionModes(mModelHandle, ios, modes,
+                0xFFFFFFF, timeoutSec, flags);
+        if (summaries == null) {
+            throw new BenchmarkException("Failed to run execution modes benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, InferenceSummary[]>(ios, summaries);
+    }
+
+    /**
+     * Run the benchmark once for every batch size, packing batchSizes[b] inputs into each
+     * inference by scaling the leading dimension of the model inputs.
+     *
+     * Each run lasts timeoutSec, summaries[b] holds the per-batch results of batchSizes[b].
+     * Sequences are run as independent inputs, so the model must be stateless.
+     */
+    public Pair<List<InferenceInOutSequence>, InferenceSummary[]> runBenchmarkBatchSweep(
+            int[] batchSizes, float timeoutSec)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        int flags = getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+        InferenceSummary[] summaries = runBenchmarkBatchSweep(mModelHandle, ios, batchSizes,
+                0xFFFFFFF, timeoutSec, flags);
+        if (summaries == null) {
+            throw new BenchmarkException("Failed to run batch sweep benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, InferenceSummary[]>(ios, summaries);
+    }
+
+    /**
+     * Run the benchmark once for every interpreter thread count from 1 to maxThreads.
+     *
+     * Each run lasts timeoutSec, summaries[n - 1] holds the results with n threads.
+     */
+    public Pair<List<InferenceInOutSequence>, InferenceSummary[]> runBenchmarkThreadSweep(
+            int maxThreads, float timeoutSec)
+            throws IOException, BenchmarkException {
+        if (mModelHandle == 0) {
+            throw new BenchmarkException("Unsupported model");
+        }
+        List<InferenceInOutSequence> ios = getInputOutputAssets();
+        int flags = getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+        InferenceSummary[] summaries = runBenchmarkThreadSweep(mModelHandle, ios, maxThreads,
+                0xFFFFFFF, timeoutSec, flags);
+        if (summaries == null) {
+            throw new BenchmarkException("Failed to run thread sweep benchmark");
+        }
+        return new Pair<List<InferenceInOutSequence>, InferenceSummary[]>(ios, summaries);
+    }
+
+    /**
+     * Run the models of several set up tests together, see {@link ScenarioRunner}.
+     *
+     * Every model first runs alone for durationSec, then all of them run together for
+     * durationSec on one thread (SCENARIO_INTERLEAVED) or on a thread each
+     * (SCENARIO_CONCURRENT). Model k runs ratesPerSec[k] inferences per second (0 for back to
+     * back) with thread nice value priorities[k]. Concurrent scenarios don't support datasets.
+     */
+    static ScenarioResult runScenario(NNTestBase[] tests, float[] ratesPerSec, int[] priorities,
+            int schedule, float durationSec) throws IOException, BenchmarkException {
+        long[] modelHandles = new long[tests.length];
+        Object[] inOutLists = new Object[tests.length];
+        int[] flags = new int[tests.length];
+        String[] modelNames = new String[tests.length];
+        List<List<InferenceInOutSequence>> ios = new ArrayList<>();
+        for (int k = 0; k < tests.length; ++k) {
+            NNTestBase test = tests[k];
+            if (test.mModelHandle == 0) {
+                throw new BenchmarkException("Unsupported model " + test.mModelName);
+            }
+            if (schedule == SCENARIO_CONCURRENT && test.mInputOutputDatasets != null) {
+                throw new BenchmarkException("Concurrent scenario doesn't support datasets");
+            }
+            modelHandles[k] = test.mModelHandle;
+            ios.add(test.getInputOutputAssets());
+            inOutLists[k] = ios.get(k);
+            flags[k] = test.getDefaultFlags() | FLAG_DISCARD_INFERENCE_OUTPUT;
+            modelNames[k] = test.getTestInfo();
+        }
+        InferenceSummary[] summaries = runScenario(modelHandles, inOutLists, flags, ratesPerSec,
+                priorities, schedule, durationSec);
+        if (summaries == null) {
+            throw new BenchmarkException("Failed to run scenario");
+        }
+        InferenceSummary[] alone = new InferenceSummary[tests.length];
+        InferenceSummary[] shared = new InferenceSummary[tests.length];
+        for (int k = 0; k < tests.length; ++k) {
+            alone[k] = summaries[2 * k];
+            shared[k] = summaries[2 * k + 1];
+        }
+        return new ScenarioResult(modelNames, ios, schedule, alone, shared);
+    }
+
     public void destroy() {
         if (mModelHandle != 0) {
             destroyModel(mModelHandle);
             mModelHandle = 0;
+            mMappedDatasetLoaded = false;
         }
     }
 
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import java.util.Collections;
+import java.util.List;
+
+/**
+ * Accuracy evaluator running in native code, on the output tensors of every inference of the
+ * benchmark, see jni/native_evaluators.h.
+ *
+ * Computes the same metrics as the Java evaluator of the same name, but the inference outputs
+ * don't need to be copied into the inference results, so benchmarks with a native evaluator
+ * discard them. EvaluateAccuracy() only reports the results of the last benchmark run of the
+ * model.
+ */
+public class NativeEvaluator implements EvaluatorInterface {
+    static {
+        System.loadLibrary("nnbenchmark_jni");
+    }
+
+    /** Evaluator results as computed by the native code. */
+    static class Results {
+        final String[] mKeys;
+        final float[] mValues;
+        final String[] mValidationErrors;
+
+        Results(String[] keys, float[] values, String[] validationErrors) {
+            mKeys = keys;
+            mValues = values;
+            mValidationErrors = validationErrors;
+        }
+    }
+
+    private final long mModelHandle;
+
+    private NativeEvaluator(long modelHandle) {
+        mModelHandle = modelHandle;
+    }
+
+    /**
+     * Attaches the native version of the evaluator className to the model, returns null if
+     * there is none. outputMeanStdDev is optional.
+     */
+    static NativeEvaluator create(long modelHandle, String className, float expectedTop1,
+            OutputMeanStdDev outputMeanStdDev) {
+        if (!isSupported(className)) {
+            return null;
+        }
+        float[] outputMean = null;
+        float[] outputStdDev = null;
+        if (outputMeanStdDev != null) {
+            outputMean = outputMeanStdDev.getMeans();
+            outputStdDev = outputMeanStdDev.getStdDevs();
+        }
+        if (!setup(modelHandle, className, /*targetOutputIndex=*/0, expectedTop1, outputMean,
+                outputStdDev)) {
+            return null;
+        }
+        return new NativeEvaluator(modelHandle);
+    }
+
+    @Override
+    public void EvaluateAccuracy(
+            List<InferenceInOutSequence> inferenceInOuts,
+            List<InferenceResult> inferenceResults,
+            List<String> outKeys,
+            List<Float> outValues,
+            List<String> outValidationErrors) {
+        Results results = getResults(mModelHandle);
+        if (results == null) {
+            throw new IllegalStateException("No native evaluator results");
+        }
+        Collections.addAll(outKeys, results.mKeys);
+        for (float value : results.mValues) {
+            outValues.add(value);
+        }
+        Collections.addAll(outValidationErrors, results.mValidationErrors);
+    }
+
+    public static native boolean isSupported(String className);
+
+    private static native boolean setup(long modelHandle, String className,
+            int targetOutputIndex, float expectedTop1, float[] outputMean, float[] outputStdDev);
+
+    private static native Results getResults(long modelHandle);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+/**
+ * Result of an open-loop benchmark at one arrival rate, see
+ * {@link NNTestBase#runBenchmarkOpenLoop}.
+ *
+ * Queueing and response times are measured from the scheduled arrival of each request, so a
+ * slow inference delays the requests behind it instead of hiding them.
+ */
+public class OpenLoopSummary {
+    /** Offered load, requests per second. */
+    public final float mArrivalRate;
+    /** Service time statistics, the Invoke() time as in every other benchmark. */
+    public final InferenceSummary mService;
+    /** Scheduled arrival until the start of service. */
+    public final float mQueueMeanTimeSec;
+    public final float mQueueP50TimeSec;
+    public final float mQueueP90TimeSec;
+    public final float mQueueP99TimeSec;
+    /** Scheduled arrival until the end of service. */
+    public final float mResponseMeanTimeSec;
+    public final float mResponseP50TimeSec;
+    public final float mResponseP90TimeSec;
+    public final float mResponseP99TimeSec;
+    public final float mResponseMaxTimeSec;
+    /** Served requests per second of wall time. */
+    public final float mThroughput;
+    public final int mCompleted;
+    /** Requests never served because the queue didn't drain in time. */
+    public final int mDropped;
+
+    public OpenLoopSummary(float arrivalRate, InferenceSummary service, float queueMeanTimeSec,
+            float queueP50TimeSec, float queueP90TimeSec, float queueP99TimeSec,
+            float responseMeanTimeSec, float responseP50TimeSec, float responseP90TimeSec,
+            float responseP99TimeSec, float responseMaxTimeSec, float throughput, int completed,
+            int dropped) {
+        mArrivalRate = arrivalRate;
+        mService = service;
+        mQueueMeanTimeSec = queueMeanTimeSec;
+        mQueueP50TimeSec = queueP50TimeSec;
+        mQueueP90TimeSec = queueP90TimeSec;
+        mQueueP99TimeSec = queueP99TimeSec;
+        mResponseMeanTimeSec = responseMeanTimeSec;
+        mResponseP50TimeSec = responseP50TimeSec;
+        mResponseP90TimeSec = responseP90TimeSec;
+        mResponseP99TimeSec = responseP99TimeSec;
+        mResponseMaxTimeSec = responseMaxTimeSec;
+        mThroughput = throughput;
+        mCompleted = completed;
+        mDropped = dropped;
+    }
+
+    /**
+     * Whether the device kept up with the arrival rate: nothing was dropped and the
+     * throughput is within 5% of the offered load.
+     */
+    public boolean isSustained() {
+        return mDropped == 0 && mThroughput >= 0.95f * mArrivalRate;
+    }
+}
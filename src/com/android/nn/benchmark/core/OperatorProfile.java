@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import android.os.Parcel;
+
+/** Execution time of a single model operator, aggregated over a benchmark run. */
+public class OperatorProfile {
+    /** Operator name, the delegate name for delegate kernels. */
+    public final String mOpName;
+    public final int mNodeIndex;
+    /** True for operators executed inside a delegate kernel. */
+    public final boolean mDelegated;
+    public final int mCount;
+    public final float mTotalTimeSec;
+    public final float mMinTimeSec;
+    public final float mMaxTimeSec;
+
+    public OperatorProfile(String opName, int nodeIndex, boolean delegated, int count,
+            float totalTimeSec, float minTimeSec, float maxTimeSec) {
+        mOpName = opName;
+        mNodeIndex = nodeIndex;
+        mDelegated = delegated;
+        mCount = count;
+        mTotalTimeSec = totalTimeSec;
+        mMinTimeSec = minTimeSec;
+        mMaxTimeSec = maxTimeSec;
+    }
+
+    OperatorProfile(Parcel in) {
+        mOpName = in.readString();
+        mNodeIndex = in.readInt();
+        mDelegated = in.readInt() != 0;
+        mCount = in.readInt();
+        mTotalTimeSec = in.readFloat();
+        mMinTimeSec = in.readFloat();
+        mMaxTimeSec = in.readFloat();
+    }
+
+    void writeToParcel(Parcel dest) {
+        dest.writeString(mOpName);
+        dest.writeInt(mNodeIndex);
+        dest.writeInt(mDelegated ? 1 : 0);
+        dest.writeInt(mCount);
+        dest.writeFloat(mTotalTimeSec);
+        dest.writeFloat(mMinTimeSec);
+        dest.writeFloat(mMaxTimeSec);
+    }
+
+    public float getMeanTimeSec() {
+        return mCount > 0 ? mTotalTimeSec / mCount : 0.0f;
+    }
+}
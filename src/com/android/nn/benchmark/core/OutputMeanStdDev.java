@@ -46,4 +46,20 @@ public class OutputMeanStdDev {
         }
         return results;
     }
+
+    float[] getMeans() {
+        float[] means = new float[mNumOutputs];
+        for (int i = 0; i < mNumOutputs; ++i) {
+            means[i] = mMeanStdDevs[i].mean;
+        }
+        return means;
+    }
+
+    float[] getStdDevs() {
+        float[] stdDevs = new float[mNumOutputs];
+        for (int i = 0; i < mNumOutputs; ++i) {
+            stdDevs[i] = mMeanStdDevs[i].stdDev;
+        }
+        return stdDevs;
+    }
 }
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import java.util.List;
+
+/**
+ * Result of a multi-model scenario, see {@link ScenarioRunner}.
+ *
+ * Latency statistics of every model running alone and sharing the device with the other
+ * models of the scenario, in scenario model order.
+ */
+public class ScenarioResult {
+    public final String[] mModelNames;
+    /** Inputs each model ran on. */
+    public final List<List<InferenceInOutSequence>> mInferenceInOuts;
+    /** NNTestBase.SCENARIO_* schedule of the shared run. */
+    public final int mSchedule;
+    public final InferenceSummary[] mAlone;
+    public final InferenceSummary[] mShared;
+
+    public ScenarioResult(String[] modelNames,
+            List<List<InferenceInOutSequence>> inferenceInOuts, int schedule,
+            InferenceSummary[] alone, InferenceSummary[] shared) {
+        mModelNames = modelNames;
+        mInferenceInOuts = inferenceInOuts;
+        mSchedule = schedule;
+        mAlone = alone;
+        mShared = shared;
+    }
+
+    /** Shared over alone mean latency of model k, 0 if it didn't run alone. */
+    public float getSlowdown(int k) {
+        return mAlone[k].mMeanTimeSec > 0.0f
+                ? mShared[k].mMeanTimeSec / mAlone[k].mMeanTimeSec
+                : 0.0f;
+    }
+
+    /** Shared over alone 99th percentile latency of model k, 0 if it didn't run alone. */
+    public float getTailSlowdown(int k) {
+        return mAlone[k].mP99TimeSec > 0.0f
+                ? mShared[k].mP99TimeSec / mAlone[k].mP99TimeSec
+                : 0.0f;
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import android.app.Activity;
+
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Runs several models of {@link TestModels} at the same time, to measure how much they slow
+ * each other down when sharing the accelerator.
+ *
+ * Every model gets its own interpreter. Models run either interleaved on one thread or
+ * concurrently on a thread each, at their own rate and priority, see
+ * {@link NNTestBase#runScenario}.
+ */
+public class ScenarioRunner {
+    /** One model of the scenario. */
+    public static class ModelConfig {
+        public final TestModels.TestModelEntry mModel;
+        /** Inferences per second, 0 to run back to back. */
+        public final float mRatePerSec;
+        /**
+         * Thread nice value of the model in concurrent scenarios, lower runs first. Negative
+         * values need CAP_SYS_NICE, which apps usually don't have.
+         */
+        public final int mPriority;
+
+        public ModelConfig(TestModels.TestModelEntry model, float ratePerSec, int priority) {
+            mModel = model;
+            mRatePerSec = ratePerSec;
+            mPriority = priority;
+        }
+    }
+
+    private final List<ModelConfig> mModels;
+    private final boolean mUseNNApi;
+
+    public ScenarioRunner(List<ModelConfig> models, boolean useNNApi) {
+        mModels = models;
+        mUseNNApi = useNNApi;
+    }
+
+    /**
+     * Sets up and warms up every model, runs the scenario with the given
+     * NNTestBase.SCENARIO_* schedule and releases the models.
+     */
+    public ScenarioResult run(Activity activity, int schedule, float durationSec)
+            throws IOException, BenchmarkException {
+        List<NNTestBase> tests = new ArrayList<>();
+        try {
+            float[] ratesPerSec = new float[mModels.size()];
+            int[] priorities = new int[mModels.size()];
+            for (int k = 0; k < mModels.size(); ++k) {
+                ModelConfig config = mModels.get(k);
+                NNTestBase test = config.mModel.createNNTestBase(mUseNNApi,
+                        /*enableIntermediateTensorsDump=*/false);
+                tests.add(test);
+                if (!test.setupModel(activity)) {
+                    throw new BenchmarkException("Failed to set up " + config.mModel);
+                }
+                test.runWarmup(1, 0.0f);
+                ratesPerSec[k] = config.mRatePerSec;
+                priorities[k] = config.mPriority;
+            }
+            return NNTestBase.runScenario(tests.toArray(new NNTestBase[0]), ratesPerSec,
+                    priorities, schedule, durationSec);
+        } finally {
+            for (NNTestBase test : tests) {
+                test.destroy();
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+/** Time spent in each stage of the native model creation and in the first inference. */
+public class StartupProfile {
+    /** Model file loading. */
+    public final float mModelLoadTimeSec;
+    /** TFLite interpreter construction. */
+    public final float mInterpreterBuildTimeSec;
+    /** Applying the NNAPI delegate, this includes the NNAPI model compilation. */
+    public final float mDelegateApplyTimeSec;
+    /** Input tensors resizing (may recompile the model), 0 if not resized. */
+    public final float mInputResizeTimeSec;
+    /** First inference, -1 if no inference has run yet. */
+    public final float mFirstInferenceTimeSec;
+    /** Model destruction, only measured by cold start benchmarks. */
+    public final float mDestroyTimeSec;
+
+    public StartupProfile(float modelLoadTimeSec, float interpreterBuildTimeSec,
+            float delegateApplyTimeSec, float inputResizeTimeSec, float firstInferenceTimeSec,
+            float destroyTimeSec) {
+        mModelLoadTimeSec = modelLoadTimeSec;
+        mInterpreterBuildTimeSec = interpreterBuildTimeSec;
+        mDelegateApplyTimeSec = delegateApplyTimeSec;
+        mInputResizeTimeSec = inputResizeTimeSec;
+        mFirstInferenceTimeSec = firstInferenceTimeSec;
+        mDestroyTimeSec = destroyTimeSec;
+    }
+
+    /** Time from the start of model creation until the first inference output. */
+    public float getStartupTimeSec() {
+        return mModelLoadTimeSec + mInterpreterBuildTimeSec + mDelegateApplyTimeSec
+                + mInputResizeTimeSec + Math.max(mFirstInferenceTimeSec, 0.0f);
+    }
+
+    @Override
+    public String toString() {
+        return "StartupProfile{load=" + mModelLoadTimeSec
+                + ", build=" + mInterpreterBuildTimeSec
+                + ", delegate=" + mDelegateApplyTimeSec
+                + ", resize=" + mInputResizeTimeSec
+                + ", firstInference=" + mFirstInferenceTimeSec
+                + ", destroy=" + mDestroyTimeSec + "}";
+    }
+}
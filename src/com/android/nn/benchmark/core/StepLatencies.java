@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import android.os.Parcel;
+
+import java.util.List;
+
+/**
+ * Latency by position in the input sequences: the first inference of every sequence vs the
+ * later ones, and the state resets at the start of sequences.
+ *
+ * For streaming models (ASR, TTS) one inference is one step, so the later step latency is the
+ * per-frame latency and, divided by the frame duration, the real-time factor. Resets are only
+ * done (and counted) for models with variable tensors.
+ */
+public class StepLatencies {
+    /** Number of values of {@link #toCsvValues}, see CSVWriter.RESULT_FORMAT_COMMENT. */
+    public static final int CSV_VALUES_COUNT = 8;
+
+    public final int mFirstStepCount;
+    public final float mFirstStepMeanTimeSec;
+    public final float mFirstStepP99TimeSec;
+    public final int mLaterStepCount;
+    public final float mLaterStepMeanTimeSec;
+    public final float mLaterStepP99TimeSec;
+    public final int mResetCount;
+    public final float mResetMeanTimeSec;
+
+    public StepLatencies(int firstStepCount, float firstStepMeanTimeSec,
+            float firstStepP99TimeSec, int laterStepCount, float laterStepMeanTimeSec,
+            float laterStepP99TimeSec, int resetCount, float resetMeanTimeSec) {
+        mFirstStepCount = firstStepCount;
+        mFirstStepMeanTimeSec = firstStepMeanTimeSec;
+        mFirstStepP99TimeSec = firstStepP99TimeSec;
+        mLaterStepCount = laterStepCount;
+        mLaterStepMeanTimeSec = laterStepMeanTimeSec;
+        mLaterStepP99TimeSec = laterStepP99TimeSec;
+        mResetCount = resetCount;
+        mResetMeanTimeSec = resetMeanTimeSec;
+    }
+
+    StepLatencies(Parcel in) {
+        this(in.readInt(), in.readFloat(), in.readFloat(), in.readInt(), in.readFloat(),
+                in.readFloat(), in.readInt(), in.readFloat());
+    }
+
+    void writeToParcel(Parcel dest) {
+        dest.writeInt(mFirstStepCount);
+        dest.writeFloat(mFirstStepMeanTimeSec);
+        dest.writeFloat(mFirstStepP99TimeSec);
+        dest.writeInt(mLaterStepCount);
+        dest.writeFloat(mLaterStepMeanTimeSec);
+        dest.writeFloat(mLaterStepP99TimeSec);
+        dest.writeInt(mResetCount);
+        dest.writeFloat(mResetMeanTimeSec);
+    }
+
+    /** Same statistics as the native InferenceSummary, from per-inference results. */
+    static StepLatencies fromInferenceResults(List<InferenceResult> results) {
+        int firstStepCount = 0;
+        int resetCount = 0;
+        for (InferenceResult result : results) {
+            if (result.mInputOutputIndex == 0) {
+                ++firstStepCount;
+            }
+            if (result.mResetTimeSec >= 0.0f) {
+                ++resetCount;
+            }
+        }
+        float[] firstStepTimesSec = new float[firstStepCount];
+        float[] laterStepTimesSec = new float[results.size() - firstStepCount];
+        float resetTotalTimeSec = 0.0f;
+        int first = 0;
+        int later = 0;
+        for (InferenceResult result : results) {
+            if (result.mInputOutputIndex == 0) {
+                firstStepTimesSec[first++] = result.mComputeTimeSec;
+            } else {
+                laterStepTimesSec[later++] = result.mComputeTimeSec;
+            }
+            if (result.mResetTimeSec >= 0.0f) {
+                resetTotalTimeSec += result.mResetTimeSec;
+            }
+        }
+        return new StepLatencies(firstStepCount, mean(firstStepTimesSec),
+                p99(firstStepTimesSec), laterStepTimesSec.length, mean(laterStepTimesSec),
+                p99(laterStepTimesSec), resetCount,
+                resetCount > 0 ? resetTotalTimeSec / resetCount : 0.0f);
+    }
+
+    private static float mean(float[] timesSec) {
+        float total = 0.0f;
+        for (float timeSec : timesSec) {
+            total += timeSec;
+        }
+        return timesSec.length > 0 ? total / timesSec.length : 0.0f;
+    }
+
+    private static float p99(float[] timesSec) {
+        return LatencyPercentiles.compute(timesSec, new float[] {0.99f})[0];
+    }
+
+    /** Later step over first step mean latency, 0 without later steps. */
+    public float getSteadyStateRatio() {
+        return mLaterStepCount > 0 && mFirstStepMeanTimeSec > 0.0f
+                ? mLaterStepMeanTimeSec / mFirstStepMeanTimeSec
+                : 0.0f;
+    }
+
+    /** The CSV columns, in the order of CSVWriter.RESULT_FORMAT_COMMENT. */
+    public float[] toCsvValues() {
+        return new float[] {mFirstStepCount, mFirstStepMeanTimeSec, mFirstStepP99TimeSec,
+                mLaterStepCount, mLaterStepMeanTimeSec, mLaterStepP99TimeSec, mResetCount,
+                mResetMeanTimeSec};
+    }
+
+    @Override
+    public String toString() {
+        return "StepLatencies{firstStep=" + mFirstStepMeanTimeSec
+                + ", laterSteps=" + mLaterStepMeanTimeSec
+                + " (" + mLaterStepCount + ")"
+                + ", resets=" + mResetCount
+                + ", resetMean=" + mResetMeanTimeSec + "}";
+    }
+}
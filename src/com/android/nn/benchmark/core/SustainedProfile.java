@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.core;
+
+import android.os.Parcel;
+
+/**
+ * Result of a sustained performance benchmark, see {@link NNTestBase#runBenchmarkSustained}.
+ *
+ * Latency of a long run as a time series of fixed wall time windows, optionally with thermal
+ * zone temperatures and CPU frequencies read at the end of every window.
+ */
+public class SustainedProfile {
+    /** Any window this much slower than the initial performance counts as throttled. */
+    public static final float THROTTLE_THRESHOLD = 0.2f;
+    /** The initial performance is the fastest of the first few windows. */
+    private static final int BASELINE_WINDOWS = 3;
+
+    /** One window of the run. */
+    public static class Window {
+        /** Seconds of wall time since the start of the run. */
+        public final float mStartTimeSec;
+        public final float mDurationSec;
+        /** Number of inferences that ended in this window. */
+        public final int mCount;
+        public final float mMeanTimeSec;
+        public final float mP99TimeSec;
+        public final float mMaxTimeSec;
+        /** Sensor readings at the end of the window, in SustainedProfile.mSensorNames order. */
+        public final float[] mSensorValues;
+
+        public Window(float startTimeSec, float durationSec, int count, float meanTimeSec,
+                float p99TimeSec, float maxTimeSec, float[] sensorValues) {
+            mStartTimeSec = startTimeSec;
+            mDurationSec = durationSec;
+            mCount = count;
+            mMeanTimeSec = meanTimeSec;
+            mP99TimeSec = p99TimeSec;
+            mMaxTimeSec = maxTimeSec;
+            mSensorValues = sensorValues;
+        }
+
+        Window(Parcel in) {
+            mStartTimeSec = in.readFloat();
+            mDurationSec = in.readFloat();
+            mCount = in.readInt();
+            mMeanTimeSec = in.readFloat();
+            mP99TimeSec = in.readFloat();
+            mMaxTimeSec = in.readFloat();
+            mSensorValues = new float[in.readInt()];
+            in.readFloatArray(mSensorValues);
+        }
+
+        void writeToParcel(Parcel dest) {
+            dest.writeFloat(mStartTimeSec);
+            dest.writeFloat(mDurationSec);
+            dest.writeInt(mCount);
+            dest.writeFloat(mMeanTimeSec);
+            dest.writeFloat(mP99TimeSec);
+            dest.writeFloat(mMaxTimeSec);
+            dest.writeInt(mSensorValues.length);
+            dest.writeFloatArray(mSensorValues);
+        }
+    }
+
+    /** Statistics of the whole run. */
+    public final InferenceSummary mSummary;
+    /** Thermal zone ("thermal_<type>", degrees Celsius) and "cpu<N>_freq" (MHz) sensors. */
+    public final String[] mSensorNames;
+    public final Window[] mWindows;
+
+    public SustainedProfile(InferenceSummary summary, String[] sensorNames, Window[] windows) {
+        mSummary = summary;
+        mSensorNames = sensorNames;
+        mWindows = windows;
+    }
+
+    /** Parcels the windows only, the summary is already part of the BenchmarkResult. */
+    SustainedProfile(Parcel in) {
+        mSummary = null;
+        mSensorNames = new String[in.readInt()];
+        in.readStringArray(mSensorNames);
+        mWindows = new Window[in.readInt()];
+        for (int i = 0; i < mWindows.length; ++i) {
+            mWindows[i] = new Window(in);
+        }
+    }
+
+    void writeToParcel(Parcel dest) {
+        dest.writeInt(mSensorNames.length);
+        dest.writeStringArray(mSensorNames);
+        dest.writeInt(mWindows.length);
+        for (Window window : mWindows) {
+            window.writeToParcel(dest);
+        }
+    }
+
+    /** Mean latency of the fastest of the first windows, 0 without windows. */
+    public float getInitialMeanTimeSec() {
+        float initial = 0.0f;
+        for (int i = 0; i < Math.min(BASELINE_WINDOWS, mWindows.length); ++i) {
+            if (initial == 0.0f || mWindows[i].mMeanTimeSec < initial) {
+                initial = mWindows[i].mMeanTimeSec;
+            }
+        }
+        return initial;
+    }
+
+    public float getFinalMeanTimeSec() {
+        return mWindows.length > 0 ? mWindows[mWindows.length - 1].mMeanTimeSec : 0.0f;
+    }
+
+    /**
+     * Start of the first window that is THROTTLE_THRESHOLD slower than the initial
+     * performance, -1 if there is none.
+     */
+    public float getTimeToThrottleSec() {
+        float limit = getInitialMeanTimeSec() * (1.0f + THROTTLE_THRESHOLD);
+        for (Window window : mWindows) {
+            if (window.mMeanTimeSec > limit) {
+                return window.mStartTimeSec;
+            }
+        }
+        return -1.0f;
+    }
+}
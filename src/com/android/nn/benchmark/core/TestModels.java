@@ -30,8 +30,8 @@ public class TestModels {
         /** Expected inference performance in seconds */
         public final float mBaselineSec;
 
-        /** Shape of input data */
-        public final int[] mInputShape;
+        /** Shape of input data, one entry per model input */
+        public final int[][] mInputShapes;
 
         /** File pair asset input/output pairs */
         public final InferenceInOutSequence.FromAssets[] mInOutAssets;
@@ -51,14 +51,14 @@ public class TestModels {
         /** Min SDK version that the model can run on. */
         public final int mMinSdkVersion;
 
-        public TestModelEntry(String modelName, float baselineSec, int[] inputShape,
+        public TestModelEntry(String modelName, float baselineSec, int[][] inputShapes,
                               InferenceInOutSequence.FromAssets[] inOutAssets,
                               InferenceInOutSequence.FromDataset[] inOutDatasets,
                               String testName, String modelFile, EvaluatorConfig evaluator,
                               int minSdkVersion) {
             mModelName = modelName;
             mBaselineSec = baselineSec;
-            mInputShape = inputShape;
+            mInputShapes = inputShapes;
             mInOutAssets = inOutAssets;
             mInOutDatasets  = inOutDatasets;
             mTestName = testName;
@@ -68,7 +68,7 @@ public class TestModels {
         }
 
         public NNTestBase createNNTestBase() {
-            return new NNTestBase(mModelName, mModelFile, mInputShape, mInOutAssets, mInOutDatasets,
+            return new NNTestBase(mModelName, mModelFile, mInputShapes, mInOutAssets, mInOutDatasets,
                 mEvaluator, mMinSdkVersion);
         }
 
@@ -44,6 +44,10 @@ public class TestModelsListLoader {
      * "inputOutputs" : [ {"input": "input1", "output": "output2"} ]
      * }
      * ]}
+     *
+     * Models with multiple inputs use "inputSizes" : [[1,2,3,4], [1,5]] instead of
+     * "inputSize", and list one asset per input in order with
+     * "inputOutputs" : [ {"inputs": ["input1a", "input1b"], "outputs": ["output1"]} ].
      */
     static public void parseJSONModelsList(String jsonStringInput) throws JSONException {
         JSONObject jsonRootObject = new JSONObject(jsonStringInput);
@@ -79,12 +83,23 @@ public class TestModelsListLoader {
             }
 
             int dataSize = jsonTestModelEntry.getInt("dataSize");
-            JSONArray jsonInputSize = jsonTestModelEntry.getJSONArray("inputSize");
-            int[] inputSize = new int[jsonInputSize.length()];
-            int inputSizeBytes = dataSize;
-            for (int k = 0; k < jsonInputSize.length(); ++k) {
-                inputSize[k] = jsonInputSize.getInt(k);
-                inputSizeBytes *= inputSize[k];
+            JSONArray jsonInputSizes;
+            if (jsonTestModelEntry.has("inputSizes")) {
+                jsonInputSizes = jsonTestModelEntry.getJSONArray("inputSizes");
+            } else {
+                jsonInputSizes = new JSONArray();
+                jsonInputSizes.put(jsonTestModelEntry.getJSONArray("inputSize"));
+            }
+            int[][] inputSizes = new int[jsonInputSizes.length()][];
+            int[] inputSizesBytes = new int[jsonInputSizes.length()];
+            for (int n = 0; n < jsonInputSizes.length(); ++n) {
+                JSONArray jsonInputSize = jsonInputSizes.getJSONArray(n);
+                inputSizes[n] = new int[jsonInputSize.length()];
+                inputSizesBytes[n] = dataSize;
+                for (int k = 0; k < jsonInputSize.length(); ++k) {
+                    inputSizes[n][k] = jsonInputSize.getInt(k);
+                    inputSizesBytes[n] *= inputSizes[n][k];
+                }
             }
 
             InferenceInOutSequence.FromAssets[] inputOutputs = null;
@@ -95,7 +110,22 @@ public class TestModelsListLoader {
 
                 for (int j = 0; j < jsonInputOutputs.length(); j++) {
                     JSONObject jsonInputOutput = jsonInputOutputs.getJSONObject(j);
-                    String input = jsonInputOutput.getString("input");
+                    String[] inputs = null;
+                    String input = jsonInputOutput.optString("input", null);
+                    if (input != null) {
+                        inputs = new String[]{input};
+                    } else {
+                        JSONArray inputArray = jsonInputOutput.getJSONArray("inputs");
+                        inputs = new String[inputArray.length()];
+                        for (int k = 0; k < inputArray.length(); ++k) {
+                            inputs[k] = inputArray.getString(k);
+                        }
+                    }
+                    if (inputs.length != inputSizes.length) {
+                        throw new IllegalArgumentException("Model " + name + " has " +
+                                inputSizes.length + " inputs, given " + inputs.length +
+                                " input assets");
+                    }
                     String[] outputs = null;
                     String output = jsonInputOutput.optString("output", null);
                     if (output != null) {
@@ -110,9 +140,9 @@ public class TestModelsListLoader {
                         }
                     }
 
-                    inputOutputs[j] = new InferenceInOutSequence.FromAssets(input, outputs,
+                    inputOutputs[j] = new InferenceInOutSequence.FromAssets(inputs, outputs,
                             dataSize,
-                            inputSizeBytes);
+                            inputSizesBytes);
                 }
             }
             InferenceInOutSequence.FromDataset[] datasets = null;
@@ -122,6 +152,11 @@ public class TestModelsListLoader {
                 String groundTruth = jsonDataset.getString("groundTruth");
                 String labels = jsonDataset.getString("labels");
                 String preprocessor = jsonDataset.getString("preprocessor");
+                if (inputSizes.length != 1) {
+                    throw new IllegalArgumentException("Datasets only support single input " +
+                            "models, given " + inputSizes.length + " inputs");
+                }
+                int[] inputSize = inputSizes[0];
                 if (inputSize.length != 4 || inputSize[0] != 1 || inputSize[1] != inputSize[2] ||
                         inputSize[3] != 3) {
                     throw new IllegalArgumentException("Datasets only support square images," +
@@ -139,14 +174,34 @@ public class TestModelsListLoader {
                     quantScale = (float) jsonTestModelEntry.getDouble("inputScale");
                     quantZeroPoint = (float) jsonTestModelEntry.getDouble("inputZeroPoint");
                 }
+                // Optional native preprocessing descriptor, replaces the named preprocessor.
+                ImagePreprocessing preprocessing = null;
+                JSONObject jsonPreprocessing = jsonDataset.optJSONObject("preprocessing");
+                if (jsonPreprocessing != null) {
+                    preprocessing = new ImagePreprocessing();
+                    preprocessing.mCropFraction = (float) jsonPreprocessing.optDouble(
+                            "cropFraction", preprocessing.mCropFraction);
+                    preprocessing.mMean = (float) jsonPreprocessing.optDouble(
+                            "mean", preprocessing.mMean);
+                    preprocessing.mStd = (float) jsonPreprocessing.optDouble(
+                            "std", preprocessing.mStd);
+                    preprocessing.mSubsampleDecode = jsonPreprocessing.optBoolean(
+                            "subsampleDecode", preprocessing.mSubsampleDecode);
+                    if (preprocessing.mCropFraction <= 0.f || preprocessing.mCropFraction > 1.f
+                            || preprocessing.mStd == 0.f) {
+                        throw new IllegalArgumentException("Invalid preprocessing for " + name +
+                                ": cropFraction must be in (0, 1] and std non-zero");
+                    }
+                }
                 datasets = new InferenceInOutSequence.FromDataset[]{
                         new InferenceInOutSequence.FromDataset(inputPath, labels, groundTruth,
-                                preprocessor, dataSize, quantScale, quantZeroPoint, inputSize[1])
+                                preprocessor, dataSize, quantScale, quantZeroPoint, inputSize[1],
+                                preprocessing)
                 };
             }
 
             TestModels.registerModel(
-                    new TestModels.TestModelEntry(name, (float) baseline, inputSize,
+                    new TestModels.TestModelEntry(name, (float) baseline, inputSizes,
                             inputOutputs, datasets, testName, modelFile, evaluator, minSdkVersion));
         }
     }
@@ -41,7 +41,22 @@ public class CSVWriter implements AutoCloseable {
     static final String RESULT_FORMAT_COMMENT = "#testInfo,backendType" +
             ",iterations,totalTimeSec,maxSingleError,testSetSize,evaluatorsCount" +
             ",timeFreqStartSec,timeFreqStepSec,evaluatorKey1,evaluatorKey1,..." +
-            ",timeFreqBucket1,...";
+            ",timeFreqBucket1,...,validationError1,...,p50TimeSec,p90TimeSec,p95TimeSec" +
+            ",p99TimeSec,maxTimeSec,arenaBytes,beforeCreateRssKb,beforeCreatePssKb" +
+            ",beforeCreateHeapBytes,afterCreateRssKb,afterCreatePssKb,afterCreateHeapBytes" +
+            ",firstInferenceRssKb,firstInferencePssKb,firstInferenceHeapBytes,steadyRssKb" +
+            ",steadyPssKb,steadyHeapBytes,peakHeapBytes,peakRssKb,firstStepCount" +
+            ",firstStepMeanTimeSec,firstStepP99TimeSec,laterStepCount,laterStepMeanTimeSec" +
+            ",laterStepP99TimeSec,resetCount,resetMeanTimeSec,converged,convergenceEstimateSec" +
+            ",convergenceRelativeWidth,histogramBucketsCount,histogramBucket1Sec" +
+            ",histogramCount1,...";
+
+    static final String OPERATOR_PROFILE_FORMAT_COMMENT = "#testInfo,backendType" +
+            ",nodeIndex,opName,delegated,count,totalTimeSec,meanTimeSec,minTimeSec,maxTimeSec";
+
+    static final String SUSTAINED_FORMAT_COMMENT = "#testInfo,backendType" +
+            ",windowIndex,startTimeSec,durationSec,count,meanTimeSec,p99TimeSec,maxTimeSec" +
+            ",sensorsCount,sensorName1,...,sensorValue1,...";
 
     String deviceInfoCsvLine() {
         SimpleDateFormat sdf = new SimpleDateFormat("yyyyMMdd_HHmmss");
@@ -61,6 +76,28 @@ public class CSVWriter implements AutoCloseable {
         writer.write('\n');
     }
 
+    /** Per-operator profiles go to their own file, their lines have a different format. */
+    public void writeOperatorProfiles(BenchmarkResult benchmarkResult) throws IOException {
+        writer.write(benchmarkResult.toOperatorProfileCsvLines());
+    }
+
+    public void writeOperatorProfileHeader() throws IOException {
+        writer.write(deviceInfoCsvLine());
+        writer.write(OPERATOR_PROFILE_FORMAT_COMMENT);
+        writer.write('\n');
+    }
+
+    /** Sustained run windows go to their own file as well, one line per window. */
+    public void writeSustainedWindows(BenchmarkResult benchmarkResult) throws IOException {
+        writer.write(benchmarkResult.toSustainedCsvLines());
+    }
+
+    public void writeSustainedHeader() throws IOException {
+        writer.write(deviceInfoCsvLine());
+        writer.write(SUSTAINED_FORMAT_COMMENT);
+        writer.write('\n');
+    }
+
     @Override
     public void close() {
         try {
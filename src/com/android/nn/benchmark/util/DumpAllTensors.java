@@ -23,6 +23,8 @@ import com.android.nn.benchmark.core.TestModels.TestModelEntry;
 import com.android.nn.benchmark.core.TestModels;
 import java.io.IOException;
 import java.io.File;
+import java.util.ArrayList;
+import java.util.List;
 
 /** Helper activity for dumping state of interference intermediate tensors.
  *
@@ -30,9 +32,13 @@ import java.io.File;
  * adb shell am start -n  com.android.nn.benchmark.app/com.android.nn.benchmark.\
  *  util.DumpAllTensors --es modelName mobilenet_quantized inputAssetIndex 0 useNNAPI true
  *
- * Assets will be then dumped into /data/data/com.android.nn.benchmark.app/files/dump
- * To fetch:
+ * Optional extras: --ez compress true deflates the tensors, --es tensorFilter
+ * "name1,name2,12" dumps only the tensors with these names or indices.
+ *
+ * Assets will be then dumped into /data/data/com.android.nn.benchmark.app/files/dump/tensors.dump
+ * To fetch and unpack into one file per tensor:
  * adb pull /data/data/com.android.benchmark.app/files/dump
+ * tools/extract_tensor_dump.py dump/tensors.dump dump
  *
  */
 public class DumpAllTensors extends Activity {
@@ -40,6 +46,8 @@ public class DumpAllTensors extends Activity {
     public static final String EXTRA_USE_NNAPI = "useNNAPI";
     public static final String EXTRA_INPUT_ASSET_INDEX= "inputAssetIndex";
     public static final String EXTRA_INPUT_ASSET_SIZE= "inputAssetSize";
+    public static final String EXTRA_COMPRESS = "compress";
+    public static final String EXTRA_TENSOR_FILTER = "tensorFilter";
 
     @Override
     protected void onCreate(Bundle savedInstanceState) {
@@ -53,6 +61,23 @@ public class DumpAllTensors extends Activity {
         boolean useNNAPI = extras.getBoolean(EXTRA_USE_NNAPI, false);
         int inputAssetIndex = extras.getInt(EXTRA_INPUT_ASSET_INDEX, 0);
         int inputAssetSize = extras.getInt(EXTRA_INPUT_ASSET_SIZE, 1);
+        boolean compress = extras.getBoolean(EXTRA_COMPRESS, false);
+        List<String> tensorNames = new ArrayList<>();
+        List<Integer> tensorIndices = new ArrayList<>();
+        String tensorFilter = extras.getString(EXTRA_TENSOR_FILTER);
+        if (tensorFilter != null) {
+            for (String tensor : tensorFilter.split(",")) {
+                tensor = tensor.trim();
+                if (tensor.isEmpty()) {
+                    continue;
+                }
+                try {
+                    tensorIndices.add(Integer.parseInt(tensor));
+                } catch (NumberFormatException e) {
+                    tensorNames.add(tensor);
+                }
+            }
+        }
 
         try {
             File dumpDir = new File(getFilesDir(), "dump");
@@ -62,7 +87,12 @@ public class DumpAllTensors extends Activity {
             TestModelEntry modelEntry = TestModels.getModelByName(modelName);
             NNTestBase testBase = modelEntry.createNNTestBase(useNNAPI, true);
             testBase.setupModel(this);
-            testBase.dumpAllLayers(dumpDir, inputAssetIndex, inputAssetSize);
+            int[] indices = new int[tensorIndices.size()];
+            for (int i = 0; i < indices.length; ++i) {
+                indices[i] = tensorIndices.get(i);
+            }
+            testBase.dumpAllLayers(dumpDir, inputAssetIndex, inputAssetSize, compress,
+                    tensorNames.toArray(new String[0]), indices);
         } catch (IOException e) {
             throw new IllegalStateException("Failed to dump tensors", e);
         }
@@ -32,9 +32,14 @@ public final class IOUtils {
 
     /** Reads float values from a byte array. */
     public static float[] readFloats(byte[] bytes, int dataSize) {
-        ByteBuffer buffer = ByteBuffer.wrap(bytes);
+        return readFloats(ByteBuffer.wrap(bytes), dataSize);
+    }
+
+    /** Reads the remaining bytes of the buffer, doesn't change its position. */
+    public static float[] readFloats(ByteBuffer bytes, int dataSize) {
+        ByteBuffer buffer = bytes.duplicate();
         buffer.order(ByteOrder.LITTLE_ENDIAN);
-        int size = bytes.length / dataSize;
+        int size = buffer.remaining() / dataSize;
         float[] result = new float[size];
         for (int i = 0; i < size; ++i) {
             if (dataSize == 4) {
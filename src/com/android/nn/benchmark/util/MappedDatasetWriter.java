@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.nn.benchmark.util;
+
+import com.android.nn.benchmark.core.InferenceInOut;
+import com.android.nn.benchmark.core.InferenceInOutSequence;
+
+import java.io.BufferedOutputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.List;
+
+/**
+ * Writes inputs and golden outputs into the binary dataset container that the native code
+ * memory maps, see jni/mapped_dataset.h for the layout.
+ */
+public final class MappedDatasetWriter {
+    private MappedDatasetWriter() {}
+
+    private static final byte[] MAGIC = {'N', 'N', 'B', 'D'};
+    private static final int VERSION = 1;
+    private static final int HEADER_SIZE = 24;
+    private static final int BLOB_ENTRY_SIZE = 16;
+    /** Blobs start at cache line boundaries. */
+    private static final int BLOB_ALIGNMENT = 64;
+
+    /**
+     * Writes sequences into file, through a temporary file so that a partially written
+     * dataset is never picked up. Every input must be given as data, input creators are not
+     * supported.
+     */
+    public static void write(File file, List<InferenceInOutSequence> sequences)
+            throws IOException {
+        int inputsCount = -1;
+        int outputsCount = -1;
+        int inferencesCount = 0;
+        for (InferenceInOutSequence sequence : sequences) {
+            for (int i = 0; i < sequence.size(); ++i) {
+                InferenceInOut inOut = sequence.get(i);
+                if (inOut.mInputs == null) {
+                    throw new IllegalArgumentException(
+                            "Input creators can't be written into a mapped dataset");
+                }
+                int outputs = inOut.mExpectedOutputs != null ? inOut.mExpectedOutputs.length : 0;
+                if (inputsCount == -1) {
+                    inputsCount = inOut.mInputs.length;
+                    outputsCount = outputs;
+                } else if (inputsCount != inOut.mInputs.length || outputsCount != outputs) {
+                    throw new IllegalArgumentException(
+                            "All inferences need the same number of inputs and outputs");
+                }
+                ++inferencesCount;
+            }
+        }
+        if (inferencesCount == 0) {
+            throw new IllegalArgumentException("No inferences to write");
+        }
+
+        int blobsPerInference = inputsCount + outputsCount;
+        long indexSize = HEADER_SIZE + 4L * sequences.size()
+                + (long) BLOB_ENTRY_SIZE * blobsPerInference * inferencesCount;
+        ByteBuffer index = ByteBuffer.allocate((int) indexSize).order(ByteOrder.LITTLE_ENDIAN);
+        index.put(MAGIC);
+        index.putInt(VERSION);
+        index.putInt(sequences.size());
+        index.putInt(inputsCount);
+        index.putInt(outputsCount);
+        index.putInt(inferencesCount);
+        for (InferenceInOutSequence sequence : sequences) {
+            index.putInt(sequence.size());
+        }
+        long offset = align(indexSize);
+        for (InferenceInOutSequence sequence : sequences) {
+            for (int i = 0; i < sequence.size(); ++i) {
+                for (byte[] blob : blobs(sequence.get(i), outputsCount)) {
+                    index.putLong(offset);
+                    index.putLong(blob.length);
+                    offset = align(offset + blob.length);
+                }
+            }
+        }
+
+        File tmpFile = new File(file.getPath() + ".tmp");
+        try (OutputStream out = new BufferedOutputStream(new FileOutputStream(tmpFile))) {
+            out.write(index.array());
+            long written = indexSize;
+            for (InferenceInOutSequence sequence : sequences) {
+                for (int i = 0; i < sequence.size(); ++i) {
+                    for (byte[] blob : blobs(sequence.get(i), outputsCount)) {
+                        written = pad(out, written);
+                        out.write(blob);
+                        written += blob.length;
+                    }
+                }
+            }
+        }
+        if (!tmpFile.renameTo(file)) {
+            tmpFile.delete();
+            throw new IOException("Failed to rename " + tmpFile + " to " + file);
+        }
+    }
+
+    private static byte[][] blobs(InferenceInOut inOut, int outputsCount) {
+        byte[][] blobs = new byte[inOut.mInputs.length + outputsCount][];
+        System.arraycopy(inOut.mInputs, 0, blobs, 0, inOut.mInputs.length);
+        if (outputsCount > 0) {
+            System.arraycopy(inOut.mExpectedOutputs, 0, blobs, inOut.mInputs.length,
+                    outputsCount);
+        }
+        return blobs;
+    }
+
+    private static long align(long offset) {
+        return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+    }
+
+    /** Writes zeros up to the next blob boundary, returns the new offset. */
+    private static long pad(OutputStream out, long offset) throws IOException {
+        long aligned = align(offset);
+        for (long i = offset; i < aligned; ++i) {
+            out.write(0);
+        }
+        return aligned;
+    }
+}
@@ -0,0 +1,73 @@
+#!/usr/bin/python3
+""" Unpack a tensors.dump container written by DumpAllTensors
+
+Writes every tensor to its own file, named like the dumps used to be:
+dump_<seq>_seq_<inference>_tensor_<tensor>, and lists the index.
+
+Usage:
+./extract_tensor_dump.py tensors.dump output_dir
+./extract_tensor_dump.py --list tensors.dump
+"""
+
+import os
+import struct
+import sys
+import zlib
+
+FILE_MAGIC = b'NNTDUMP1'
+INDEX_MAGIC = b'NNTINDEX'
+ENTRY_FORMAT = '<IIIIQQQII'
+FOOTER_FORMAT = '<QI8s'
+
+
+def read_index(f):
+  f.seek(0)
+  if f.read(len(FILE_MAGIC)) != FILE_MAGIC:
+    raise ValueError('Not a tensor dump')
+  footer_size = struct.calcsize(FOOTER_FORMAT)
+  f.seek(-footer_size, os.SEEK_END)
+  index_offset, count, magic = struct.unpack(FOOTER_FORMAT, f.read(footer_size))
+  if magic != INDEX_MAGIC:
+    raise ValueError('Tensor dump index missing, the dump did not finish')
+  f.seek(index_offset)
+  entry_size = struct.calcsize(ENTRY_FORMAT)
+  entries = []
+  for _ in range(count):
+    (seq, inference, tensor, tflite_type, offset, stored_bytes, nbytes,
+     compressed, name_length) = struct.unpack(ENTRY_FORMAT, f.read(entry_size))
+    name = f.read(name_length).decode('utf-8')
+    entries.append((seq, inference, tensor, tflite_type, offset, stored_bytes,
+                    nbytes, compressed, name))
+  return entries
+
+
+def read_tensor(f, entry):
+  _, _, _, _, offset, stored_bytes, nbytes, compressed, _ = entry
+  f.seek(offset)
+  data = f.read(stored_bytes)
+  if compressed:
+    data = zlib.decompress(data)
+  if len(data) != nbytes:
+    raise ValueError('Truncated tensor in dump')
+  return data
+
+
+if __name__ == '__main__':
+  if len(sys.argv) != 3:
+    print(__doc__)
+    sys.exit(1)
+
+  if sys.argv[1] == '--list':
+    with open(sys.argv[2], 'rb') as f:
+      for entry in read_index(f):
+        print('seq %d inference %d tensor %d type %d bytes %d %s' %
+              (entry[0], entry[1], entry[2], entry[3], entry[6], entry[8]))
+    sys.exit(0)
+
+  with open(sys.argv[1], 'rb') as f:
+    os.makedirs(sys.argv[2], exist_ok=True)
+    for entry in read_index(f):
+      path = os.path.join(sys.argv[2], 'dump_%.3d_seq_%.3d_tensor_%.3d' %
+                          (entry[0], entry[1], entry[2]))
+      with open(path, 'wb') as out:
+        out.write(read_tensor(f, entry))